@@ -10,11 +10,12 @@ void onTurnOn(const MeoFeatureCall& call) {
     Serial.println("Viet Ngu");
     // Trigger turn on Module LED
     digitalWrite(LED_BUILTIN, HIGH);
-    for (const auto& kv : call.params) {
+    for (JsonPairConst kv : call.params) {
         Serial.print("  ");
-        Serial.print(kv.first);
+        Serial.print(kv.key().c_str());
         Serial.print(" = ");
-        Serial.println(kv.second);
+        serializeJson(kv.value(), Serial);
+        Serial.println();
     }
     meo.sendFeatureResponse(call, true, "Turned on");
 }
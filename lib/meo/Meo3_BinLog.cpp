@@ -0,0 +1,280 @@
+#include "Meo3_BinLog.h"
+#include <stdio.h>
+
+void MeoBinLog::_put(MeoBinLogRecord& r, const char* v) {
+    if (!v) v = "(null)";
+    size_t room = MEO_BINLOG_ARG_BYTES - r.used;
+    if (r.argc >= MEO_BINLOG_MAX_ARGS || room == 0) {
+        r.truncated = 1;
+        return;
+    }
+    size_t n = strnlen(v, room - 1);
+    if (v[n]) r.truncated = 1;
+    r.types[r.argc++] = MEO_BINARG_STR;
+    memcpy(r.args + r.used, v, n);
+    r.args[r.used + n] = '\0';
+    r.used += (uint8_t)(n + 1);
+}
+
+bool MeoBinLog::pop(MeoBinLogRecord& out) {
+    uint32_t pos = _tail.load(std::memory_order_relaxed);
+    Slot& s = _slots[pos & MASK];
+    if (s.seq.load(std::memory_order_acquire) != pos + 1) return false; // empty or still being written
+    out = s.rec;
+    s.seq.store(pos + MEO_BINLOG_SLOTS, std::memory_order_release);
+    _tail.store(pos + 1, std::memory_order_relaxed);
+    return true;
+}
+
+size_t MeoBinLog::drain(const MeoLogFunction& logger, size_t max) {
+    MeoBinLogRecord r;
+    size_t n = 0;
+    while (n < max && pop(r)) {
+        n++;
+        if (!logger) continue;
+        char line[MEO_LOG_LINE_BYTES];
+        format(r, line, sizeof(line));
+        logger(meoLogLevelName(r.level), line);
+    }
+    return n;
+}
+
+MeoBinLogStats MeoBinLog::stats() const {
+    MeoBinLogStats s;
+    s.written = _head.load(std::memory_order_relaxed);
+    s.dropped = _dropped.load(std::memory_order_relaxed);
+    s.truncated = _truncated.load(std::memory_order_relaxed);
+    s.drained = _tail.load(std::memory_order_relaxed);
+    return s;
+}
+
+namespace {
+
+// Cursor over the recorded arguments
+struct ArgReader {
+    const MeoBinLogRecord& r;
+    uint8_t index = 0;
+    size_t  at = 0;
+
+    bool next(uint8_t& type, const uint8_t*& value) {
+        if (index >= r.argc) return false;
+        type = r.types[index++];
+        value = r.args + at;
+        switch (type) {
+            case MEO_BINARG_I32:
+            case MEO_BINARG_U32: at += 4; break;
+            case MEO_BINARG_STR: at += strlen((const char*)value) + 1; break;
+            default:             at += 8; break;
+        }
+        return true;
+    }
+};
+
+bool isInteger(uint8_t type) {
+    return type == MEO_BINARG_I32 || type == MEO_BINARG_U32 || type == MEO_BINARG_I64 ||
+           type == MEO_BINARG_U64 || type == MEO_BINARG_PTR;
+}
+
+int64_t signedValue(uint8_t type, const uint8_t* v) {
+    switch (type) {
+        case MEO_BINARG_I32: { int32_t x; memcpy(&x, v, 4); return x; }
+        case MEO_BINARG_U32: { uint32_t x; memcpy(&x, v, 4); return x; }
+        default:             { int64_t x; memcpy(&x, v, 8); return x; }
+    }
+}
+
+} // namespace
+
+size_t MeoBinLog::format(const MeoBinLogRecord& r, char* out, size_t len) {
+    if (!out || len == 0) return 0;
+    int w = snprintf(out, len, "[%s] ", r.tag ? r.tag : "");
+    size_t n = w < 0 ? 0 : ((size_t)w < len ? (size_t)w : len - 1);
+    ArgReader args{r};
+    const char* f = r.fmt ? r.fmt : "";
+
+    while (*f && n + 1 < len) {
+        if (*f != '%') {
+            out[n++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            out[n++] = '%';
+            f += 2;
+            continue;
+        }
+        // Rebuild the conversion with the length the recorded type needs
+        char spec[24];
+        size_t k = 0;
+        spec[k++] = *f++;
+        while (*f && strchr("-+ #0", *f)) { if (k < 6) spec[k++] = *f; f++; }
+        while (*f >= '0' && *f <= '9') { if (k < 10) spec[k++] = *f; f++; }
+        if (*f == '.') {
+            spec[k++] = *f++;
+            while (*f >= '0' && *f <= '9') { if (k < 14) spec[k++] = *f; f++; }
+        }
+        while (*f && strchr("hlLqjzt", *f)) f++;
+        char conv = *f;
+        if (!conv) break;
+        f++;
+
+        uint8_t type = 0;
+        const uint8_t* v = nullptr;
+        bool have = args.next(type, v);
+        int m = -1;
+        if (have && strchr("diuxXoc", conv) && isInteger(type)) {
+            if (conv == 'c') {
+                spec[k++] = 'c';
+                spec[k] = '\0';
+                m = snprintf(out + n, len - n, spec, (int)signedValue(type, v));
+            } else {
+                // 32-bit arguments keep their width, so %x of -1 is ffffffff as before
+                bool wide = type != MEO_BINARG_I32 && type != MEO_BINARG_U32;
+                if (wide) {
+                    spec[k++] = 'l';
+                    spec[k++] = 'l';
+                }
+                spec[k++] = conv;
+                spec[k] = '\0';
+                int64_t x = signedValue(type, v);
+                bool sign = conv == 'd' || conv == 'i';
+                if (wide) {
+                    m = sign ? snprintf(out + n, len - n, spec, (long long)x)
+                             : snprintf(out + n, len - n, spec, (unsigned long long)x);
+                } else {
+                    m = sign ? snprintf(out + n, len - n, spec, (int)x)
+                             : snprintf(out + n, len - n, spec, (unsigned)x);
+                }
+            }
+        } else if (have && strchr("fFeEgGaA", conv) && type == MEO_BINARG_F64) {
+            double d;
+            memcpy(&d, v, 8);
+            spec[k++] = conv;
+            spec[k] = '\0';
+            m = snprintf(out + n, len - n, spec, d);
+        } else if (have && conv == 's' && type == MEO_BINARG_STR) {
+            spec[k++] = 's';
+            spec[k] = '\0';
+            m = snprintf(out + n, len - n, spec, (const char*)v);
+        } else if (have && conv == 'p' && isInteger(type)) {
+            m = snprintf(out + n, len - n, "0x%llx", (unsigned long long)signedValue(type, v));
+        } else {
+            m = snprintf(out + n, len - n, "?"); // missing or mismatched argument
+        }
+        if (m > 0) n += (size_t)m < len - n ? (size_t)m : len - n - 1;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+// ---- upload batches ----
+
+void MeoBinLogBatch::begin(uint32_t dropped) {
+    _len = 0;
+    _count = 0;
+    _lastUs = 0;
+    _stringCount = 0;
+    _byte('M');
+    _byte('L');
+    _byte(0x01);
+    _varint(dropped);
+}
+
+bool MeoBinLogBatch::add(const MeoBinLogRecord& r) {
+    // Undo everything (including new strings) if the record does not fit
+    size_t len = _len;
+    uint8_t strings = _stringCount;
+
+    // Table entries go before the record that uses them
+    uint32_t tagId = 0, fmtId = 0;
+    uint32_t ids[MEO_BINLOG_MAX_ARGS];
+    bool ok = _string(r.tag ? r.tag : "", true, tagId) && _string(r.fmt ? r.fmt : "", true, fmtId);
+    ArgReader scan{r};
+    uint8_t type;
+    const uint8_t* v;
+    for (uint8_t i = 0; ok && scan.next(type, v); ++i) {
+        ids[i] = UINT32_MAX; // inline
+        if (type == MEO_BINARG_STR && _stringCount < MEO_BINLOG_BATCH_STRINGS) {
+            ok = _string((const char*)v, false, ids[i]);
+        }
+    }
+
+    ok = ok && _byte(0x02) && _varint(_count ? (uint32_t)(r.us - _lastUs) : r.us) &&
+         _byte((uint8_t)(r.level | (r.truncated ? 0x80 : 0))) && _varint(tagId) &&
+         _varint(fmtId) && _byte(r.argc);
+    ArgReader args{r};
+    for (uint8_t i = 0; ok && args.next(type, v); ++i) {
+        if (type == MEO_BINARG_STR && ids[i] != UINT32_MAX) {
+            ok = _byte(MEO_BINARG_STR_ID) && _varint(ids[i]);
+            continue;
+        }
+        ok = _byte(type);
+        if (!ok) break;
+        switch (type) {
+            case MEO_BINARG_I32:
+            case MEO_BINARG_I64: {
+                int64_t x = signedValue(type, v);
+                ok = _varint(((uint64_t)x << 1) ^ (uint64_t)(x >> 63));
+                break;
+            }
+            case MEO_BINARG_F64:
+                for (uint8_t k = 0; ok && k < 8; ++k) ok = _byte(v[k]); // little-endian targets
+                break;
+            case MEO_BINARG_STR: {
+                size_t n = strlen((const char*)v);
+                ok = _varint(n) && _len + n <= sizeof(_buf);
+                if (ok) {
+                    memcpy(_buf + _len, v, n);
+                    _len += n;
+                }
+                break;
+            }
+            default:
+                ok = _varint((uint64_t)signedValue(type, v));
+                break;
+        }
+    }
+    if (!ok) {
+        _len = len;
+        _stringCount = strings;
+        return false;
+    }
+    _lastUs = r.us;
+    _count++;
+    return true;
+}
+
+bool MeoBinLogBatch::_string(const char* s, bool stable, uint32_t& id) {
+    size_t n = strlen(s);
+    for (uint8_t i = 0; i < _stringCount; ++i) {
+        const Entry& e = _strings[i];
+        if ((stable && e.ptr == s) || (e.len == n && memcmp(_buf + e.at, s, n) == 0)) {
+            id = i;
+            return true;
+        }
+    }
+    if (_stringCount >= MEO_BINLOG_BATCH_STRINGS) return false;
+    if (!_byte(0x01) || !_varint(n) || _len + n > sizeof(_buf)) return false;
+    Entry& e = _strings[_stringCount];
+    e.ptr = stable ? s : nullptr;
+    e.at = (uint16_t)_len;
+    e.len = (uint16_t)n;
+    memcpy(_buf + _len, s, n);
+    _len += n;
+    id = _stringCount++;
+    return true;
+}
+
+bool MeoBinLogBatch::_byte(uint8_t b) {
+    if (_len >= sizeof(_buf)) return false;
+    _buf[_len++] = b;
+    return true;
+}
+
+bool MeoBinLogBatch::_varint(uint64_t v) {
+    do {
+        uint8_t b = v & 0x7F;
+        v >>= 7;
+        if (!_byte(v ? (uint8_t)(b | 0x80) : b)) return false;
+    } while (v);
+    return true;
+}
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "Meo3_Log.h"
+
+// Ring slots (power of two); each holds one log call
+#ifndef MEO_BINLOG_SLOTS
+#define MEO_BINLOG_SLOTS 64
+#endif
+
+// Raw argument bytes per record; longer string arguments are cut
+#ifndef MEO_BINLOG_ARG_BYTES
+#define MEO_BINLOG_ARG_BYTES 64
+#endif
+
+#ifndef MEO_BINLOG_MAX_ARGS
+#define MEO_BINLOG_MAX_ARGS 8
+#endif
+
+// Upload batch payload; must fit MEO_QUEUE_MAX_RECORD with the log topic
+#ifndef MEO_BINLOG_BATCH_BYTES
+#define MEO_BINLOG_BATCH_BYTES 384
+#endif
+
+// Records formatted or encoded per MeoDevice::loop()
+#ifndef MEO_BINLOG_DRAIN_BUDGET
+#define MEO_BINLOG_DRAIN_BUDGET 16
+#endif
+
+// A partly filled upload batch goes out after this long
+#ifndef MEO_BINLOG_UPLOAD_MS
+#define MEO_BINLOG_UPLOAD_MS 2000
+#endif
+
+// Distinct format/tag strings per upload batch
+#ifndef MEO_BINLOG_BATCH_STRINGS
+#define MEO_BINLOG_BATCH_STRINGS 24
+#endif
+
+// Argument types as recorded (and as they appear in upload batches)
+enum MeoBinArg : uint8_t {
+    MEO_BINARG_I32 = 1,
+    MEO_BINARG_U32 = 2,
+    MEO_BINARG_I64 = 3,
+    MEO_BINARG_U64 = 4,
+    MEO_BINARG_F64 = 5,
+    MEO_BINARG_STR = 6, // copied, NUL-terminated
+    MEO_BINARG_PTR = 7,
+    MEO_BINARG_STR_ID = 8, // upload batches only: string table id
+};
+
+// One deferred log call: pointers to the (static) format and tag, raw arguments
+struct MeoBinLogRecord {
+    const char* fmt;
+    const char* tag;
+    uint32_t    us;        // micros() at the call
+    uint8_t     level;     // MEO_LOG_LEVEL_*
+    uint8_t     argc;
+    uint8_t     used;      // bytes of args[]
+    uint8_t     truncated; // a string was cut or arguments did not fit
+    uint8_t     types[MEO_BINLOG_MAX_ARGS];
+    uint8_t     args[MEO_BINLOG_ARG_BYTES];
+};
+
+struct MeoBinLogStats {
+    uint32_t written = 0;   // records taken by the ring
+    uint32_t dropped = 0;   // calls lost because the ring was full
+    uint32_t truncated = 0; // records with a cut string or missing arguments
+    uint32_t drained = 0;   // records formatted or encoded by the consumer
+    uint32_t batches = 0;   // upload batches published (MeoDevice upload mode)
+    uint32_t unsent = 0;    // records lost on upload: no link, or larger than a batch
+};
+
+/**
+ * MeoBinLog: deferred logging, formatting happens off the hot path.
+ * - write() stores the format pointer, micros() and the raw arguments in a fixed
+ *   slot; no vsnprintf, no Serial, no locks (bounded MPMC slot sequence, any task
+ *   may log, one consumer pops)
+ * - The format must be a string literal: only its pointer is kept. String
+ *   arguments are copied, so stack buffers and topics are safe to pass
+ * - A full ring drops the call and counts it
+ */
+class MeoBinLog {
+public:
+    MeoBinLog() {
+        for (uint32_t i = 0; i < MEO_BINLOG_SLOTS; ++i) _slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+    MeoBinLog(const MeoBinLog&) = delete;
+    MeoBinLog& operator=(const MeoBinLog&) = delete;
+
+    template <typename... Args>
+    bool write(uint8_t level, const char* tag, const char* fmt, Args... args) {
+        uint32_t pos;
+        Slot* s = _claim(pos);
+        if (!s) return false;
+        MeoBinLogRecord& r = s->rec;
+        r.fmt = fmt;
+        r.tag = tag;
+        r.us = micros();
+        r.level = level;
+        r.argc = 0;
+        r.used = 0;
+        r.truncated = 0;
+        int expand[] = {0, (_put(r, args), 0)...};
+        (void)expand;
+        if (r.truncated) _truncated.fetch_add(1, std::memory_order_relaxed);
+        s->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: oldest record, false if none is complete yet
+    bool pop(MeoBinLogRecord& out);
+
+    // Consumer: up to `max` records formatted to `logger`; a null logger discards
+    size_t drain(const MeoLogFunction& logger, size_t max);
+
+    // "[TAG] message" as vsnprintf would have produced it; returns the length
+    static size_t format(const MeoBinLogRecord& r, char* out, size_t len);
+
+    MeoBinLogStats stats() const;
+    bool empty() const {
+        return _tail.load(std::memory_order_relaxed) == _head.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr uint32_t MASK = MEO_BINLOG_SLOTS - 1;
+    static_assert((MEO_BINLOG_SLOTS & MASK) == 0, "MEO_BINLOG_SLOTS must be a power of two");
+
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        MeoBinLogRecord       rec;
+    };
+
+    Slot _slots[MEO_BINLOG_SLOTS];
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0}; // single consumer
+    std::atomic<uint32_t> _dropped{0};
+    std::atomic<uint32_t> _truncated{0};
+
+    Slot* _claim(uint32_t& pos) {
+        pos = _head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& s = _slots[pos & MASK];
+            int32_t diff = (int32_t)(s.seq.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return &s;
+            } else if (diff < 0) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            } else {
+                pos = _head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    static void _raw(MeoBinLogRecord& r, uint8_t type, const void* v, size_t n) {
+        if (r.argc >= MEO_BINLOG_MAX_ARGS || r.used + n > MEO_BINLOG_ARG_BYTES) {
+            r.truncated = 1;
+            return;
+        }
+        r.types[r.argc++] = type;
+        memcpy(r.args + r.used, v, n);
+        r.used += (uint8_t)n;
+    }
+    static void _put(MeoBinLogRecord& r, int v)                { _raw(r, MEO_BINARG_I32, &v, 4); }
+    static void _put(MeoBinLogRecord& r, unsigned v)           { _raw(r, MEO_BINARG_U32, &v, 4); }
+    static void _put(MeoBinLogRecord& r, long v)               { int64_t x = v; _raw(r, MEO_BINARG_I64, &x, 8); }
+    static void _put(MeoBinLogRecord& r, unsigned long v)      { uint64_t x = v; _raw(r, MEO_BINARG_U64, &x, 8); }
+    static void _put(MeoBinLogRecord& r, long long v)          { _raw(r, MEO_BINARG_I64, &v, 8); }
+    static void _put(MeoBinLogRecord& r, unsigned long long v) { _raw(r, MEO_BINARG_U64, &v, 8); }
+    static void _put(MeoBinLogRecord& r, double v)             { _raw(r, MEO_BINARG_F64, &v, 8); }
+    static void _put(MeoBinLogRecord& r, const void* v)        { uint64_t x = (uintptr_t)v; _raw(r, MEO_BINARG_PTR, &x, 8); }
+    static void _put(MeoBinLogRecord& r, char* v)              { _put(r, (const char*)v); }
+    static void _put(MeoBinLogRecord& r, const char* v);
+};
+
+/**
+ * MeoBinLogBatch: drained records in the compact upload format (tools/meo_log_decode.py).
+ * - "ML" 0x01, varint ring drops since the previous batch, then entries:
+ *   0x01 varint len, bytes            string table entry; ids count from 0
+ *   0x02 varint dt_us, u8 level|0x80 if truncated, varint tag id, varint fmt id,
+ *        u8 argc, per argument u8 type + value
+ * - Values: zigzag varint (I32/I64), varint (U32/U64/PTR), 8 bytes LE (F64),
+ *   varint id (STR_ID), or varint len + bytes (STR, once the table is full)
+ * - Formats, tags and string arguments go through the table, so a topic that
+ *   repeats costs its bytes once per batch; dt_us is relative to the previous
+ *   record, the first record of a batch carries its absolute micros()
+ */
+class MeoBinLogBatch {
+public:
+    void begin(uint32_t dropped);
+    // false when the record does not fit (send the batch, begin() and retry)
+    bool add(const MeoBinLogRecord& r);
+
+    bool           empty() const { return _count == 0; }
+    uint16_t       count() const { return _count; }
+    size_t         size() const  { return _len; }
+    const uint8_t* data() const  { return _buf; }
+
+private:
+    uint8_t     _buf[MEO_BINLOG_BATCH_BYTES];
+    size_t      _len = 0;
+    uint16_t    _count = 0;
+    uint32_t    _lastUs = 0;
+    struct Entry {
+        const char* ptr; // static format/tag, nullptr for copied arguments
+        uint16_t    at;  // bytes in _buf
+        uint16_t    len;
+    };
+    Entry       _strings[MEO_BINLOG_BATCH_STRINGS];
+    uint8_t     _stringCount = 0;
+
+    bool _byte(uint8_t b);
+    bool _varint(uint64_t v);
+    // Table id for s, defining it if new; `stable` strings may match by pointer
+    bool _string(const char* s, bool stable, uint32_t& id);
+};
+
+// _log/_logf backend: the binary ring when attached, else format now
+template <typename... Args>
+inline void meoLogEmit(const MeoLogFunction& logger, MeoBinLog* bin, const char* level,
+                       const char* tag, const char* fmt, Args... args) {
+    if (bin) {
+        bin->write((uint8_t)meoLogLevelOf(level), tag, fmt, args...);
+    } else {
+        meoLogf(logger, level, tag, fmt, args...);
+    }
+}
+
+inline void meoLogEmitMsg(const MeoLogFunction& logger, MeoBinLog* bin, const char* level,
+                          const char* tag, const char* msg) {
+    if (bin) {
+        bin->write((uint8_t)meoLogLevelOf(level), tag, "%s", msg); // msg may not outlive the call
+    } else {
+        meoLog(logger, level, tag, msg);
+    }
+}
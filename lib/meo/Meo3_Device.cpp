@@ -1,85 +1,323 @@
 #include "Meo3_Device.h"
 #include <ArduinoJson.h>
+#include <new>
 #include <string.h>
 #include <string>
 #include <stdarg.h>
 #include <esp_system.h>
+#if !defined(ESP_PLATFORM)
+#include <stdlib.h>
+#include <sys/stat.h>
 
-MeoDevice::MeoDevice() {}
+// Same size as the meostate partition in partitions_meo.csv
+static const size_t MEO_STATE_NATIVE_BYTES = 0x10000;
+#endif
+
+MeoDevice::MeoDevice() {
+    // Snapshot order follows registration; per-feature invoke counts come last
+    _mid.uptime        = _metrics.addGauge("uptime_s");
+    _mid.publishOk     = _metrics.addCounter("pub_ok");
+    _mid.publishFailed = _metrics.addCounter("pub_fail");
+    _mid.bytesOut      = _metrics.addCounter("bytes_out");
+    _mid.bytesIn       = _metrics.addCounter("bytes_in");
+    _mid.reconnects    = _metrics.addCounter("reconnects");
+    _mid.freeHeap      = _metrics.addGauge("heap_free");
+    _mid.largestBlock  = _metrics.addGauge("heap_block");
+    _mid.rssi          = _metrics.addGauge("rssi");
+    _mid.unhandled     = _metrics.addCounter("invoke_unhandled");
+    _mid.dropped       = _metrics.addCounter("invoke_dropped");
+    _mid.handlerUs     = _metrics.addHistogram("handler_us");
+    _mid.reconnectMs   = _metrics.addHistogram("reconnect_ms");
+    _mid.loopUs        = _metrics.addHistogram("loop_us");
+    for (MeoMetricId& id : _invokeMetric) id = -1;
+}
+
+MeoDevice::~MeoDevice() {
+    for (uint8_t i = 0; i < _eventCount; ++i) delete _eventFilters[i];
+    delete _logBatch;
+    delete _binLog;
+    delete _txRing;
+    delete _rxRing;
+    delete _invokes;
+}
 
 void MeoDevice::setLogger(MeoLogFunction logger) {
     _logger = logger;
     // Forward logger to submodules
     _mqtt.setLogger(logger);
+    _cloud.setLogger(logger);
+    _wifi.setLogger(logger);
     _prov.setLogger(logger);
 }
 
 void MeoDevice::setDebugTags(const char* tagsCsv) {
-    if (!tagsCsv) { _debugTags[0] = '\0'; return; }
-    strncpy(_debugTags, tagsCsv, sizeof(_debugTags) - 1);
-    _debugTags[sizeof(_debugTags) - 1] = '\0';
+    // Parsed once here; log calls only test a bit
+    _debugMask = meoLogTagMask(tagsCsv);
+    meoLogSetDefaultTags(_debugMask); // MeoLog/MeoLogf
     // Forward to submodules
-    _mqtt.setDebugTags(tagsCsv);
-    _prov.setDebugTags(tagsCsv);
+    _mqtt.setDebugMask(_debugMask);
+    _cloud.setDebugMask(_debugMask);
+    _wifi.setDebugMask(_debugMask);
+    _prov.setDebugMask(_debugMask);
+}
+
+void MeoDevice::setBinaryLogging(bool enabled, bool upload) {
+    MeoBinLog* old = _binLog;
+    _binLog = enabled ? (old ? old : new MeoBinLog()) : nullptr;
+    // Detach the submodules before the ring goes away
+    _mqtt.setBinaryLog(_binLog);
+    _cloud.setBinaryLog(_binLog);
+    _wifi.setBinaryLog(_binLog);
+    _prov.setBinaryLog(_binLog);
+    if (old != _binLog) delete old;
+
+    if (enabled && upload && !_logBatch) {
+        _logBatch = new MeoBinLogBatch();
+        _logDropsSent = _binLog->stats().dropped;
+        _logBatch->begin(0);
+    } else if (!(enabled && upload)) {
+        delete _logBatch;
+        _logBatch = nullptr;
+    }
+}
+
+MeoBinLogStats MeoDevice::binaryLogStats() const {
+    MeoBinLogStats s = _binLog ? _binLog->stats() : MeoBinLogStats();
+    s.batches = _logStats.batches;
+    s.unsent = _logStats.unsent;
+    return s;
 }
 
 void MeoDevice::setDeviceInfo(const char* model,
                               const char* manufacturer) {
     _model = model;
     _manufacturer = manufacturer;
-    _logf("DEBUG", "DEVICE", "Device info set: model=%s manufacturer=%s", 
-        _model ? _model : "", _manufacturer ? _manufacturer : "");
-    
+    if (_logger && _debugTagEnabled(MEO_LOG_DEVICE)) {
+        _logf("DEBUG", "DEVICE", "Device info set: model=%s manufacturer=%s",
+              _model ? _model : "", _manufacturer ? _manufacturer : "");
+    }
 }
 
 void MeoDevice::beginWifi(const char* ssid, const char* pass) {
-    _wifiSsid = ssid;
-    _wifiPass = pass;
-
-    _logf("INFO", "DEVICE", "Connecting WiFi SSID=%s", ssid ? ssid : "");
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(_wifiSsid, _wifiPass);
-
-    uint32_t start = millis();
-    while (WiFi.status() != WL_CONNECTED && (millis() - start) < 15000) {
-        delay(100);
+    // Storage first so the cached AP (BSSID/channel) can skip the scan
+    if (_storage.begin()) _wifi.begin(&_storage);
+    if (!_wifi.connect(ssid, pass)) {
+        _log("ERROR", "DEVICE", "Invalid WiFi SSID/password");
     }
-    _wifiReady = (WiFi.status() == WL_CONNECTED);
-    _logf(_wifiReady ? "INFO" : "ERROR", "DEVICE", "WiFi %s", _wifiReady ? "connected" : "failed");
+    // Association and DHCP continue in the background; see loop()
 }
 
-void MeoDevice::setGateway(const char* host, uint16_t mqttPort) {
+void MeoDevice::setGateway(const char* host, uint16_t mqttPort, MeoMqttSecurity security) {
     _gatewayHost = host;
     _mqttPort = mqttPort;
+    _mqttSecurity = security;
     _logf("INFO", "DEVICE", "Gateway set: %s:%u", host ? host : "", mqttPort);
 }
 
+void MeoDevice::setCloudGateway(const char* host, uint16_t mqttPort, MeoMqttSecurity security) {
+    _cloudHost = (host && *host) ? host : nullptr;
+    _cloudPort = mqttPort;
+    _cloudSecurity = security;
+    _logf("INFO", "DEVICE", "Cloud gateway set: %s:%u", host ? host : "", mqttPort);
+}
+
 void MeoDevice::setCloudCompatibleInfo(const char* productId, const char* buildInfo) {
     _prov.setCloudCompatibleInfo(productId, buildInfo);
     // mark device as cloud-compatible when a productId is provided
     _cloudCompatible = (productId && productId[0]);
 }
 
+void MeoDevice::setMacAddress(const uint8_t mac[6]) {
+    if (!mac) { _macOverride = false; return; }
+    memcpy(_mac, mac, sizeof(_mac));
+    _macOverride = true;
+}
+
 bool MeoDevice::addFeatureEvent(const char* name) {
     if (!name || !*name || _eventCount >= MEO_MAX_FEATURE_EVENTS) return false;
-    _eventNames[_eventCount++] = name;
-    if (_logger && _debugTagEnabled("DEVICE")) {
+    _eventNames[_eventCount] = name;
+    _eventTopics[_eventCount][0] = '\0';
+    _eventRoutes[_eventCount] = MeoEventRoute::EDGE_FIRST;
+    // Pre-build the topic now if identity is already known (otherwise start() does it)
+    if (_topics.isReady()) {
+        _topics.buildEventTopic(name, _eventTopics[_eventCount], MEO_TOPIC_MAX_LEN);
+    }
+    _eventCount++;
+    if (_logger && _debugTagEnabled(MEO_LOG_DEVICE)) {
         _logf("DEBUG", "DEVICE", "Feature event added: %s", name);
     }
     return true;
 }
 
-bool MeoDevice::addFeatureMethod(const char* name, MeoFeatureCallback cb) {
-    if (!name || !*name || !cb || _methodCount >= MEO_MAX_FEATURE_METHODS) return false;
-    _methodNames[_methodCount]    = name;
-    _methodHandlers[_methodCount] = cb;
-    _methodCount++;
-    if (_logger && _debugTagEnabled("DEVICE")) {
+bool MeoDevice::addFeatureEvent(const char* name, const MeoEventPolicy& policy) {
+    if (!addFeatureEvent(name)) return false;
+    _eventFilters[_eventCount - 1] = new MeoEventFilter(policy);
+    return true;
+}
+
+MeoEventPolicyStats MeoDevice::eventPolicyStats(const char* name) const {
+    MeoEventPolicyStats total;
+    for (uint8_t i = 0; i < _eventCount; ++i) {
+        if (!_eventFilters[i] || (name && strcmp(_eventNames[i], name) != 0)) continue;
+        const MeoEventPolicyStats& s = _eventFilters[i]->stats();
+        total.sent += s.sent;
+        total.suppressed += s.suppressed;
+        total.heartbeats += s.heartbeats;
+    }
+    return total;
+}
+
+MeoEventFilter* MeoDevice::_eventFilter(const char* eventName) const {
+    for (uint8_t i = 0; i < _eventCount; ++i) {
+        if (_eventNames[i] == eventName || strcmp(_eventNames[i], eventName) == 0) return _eventFilters[i];
+    }
+    return nullptr;
+}
+
+bool MeoDevice::setEventRoute(const char* name, MeoEventRoute route) {
+    if (!name) return false;
+    for (uint8_t i = 0; i < _eventCount; ++i) {
+        if (strcmp(_eventNames[i], name) == 0) {
+            _eventRoutes[i] = route;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MeoDevice::addFeatureMethod(const char* name, MeoFeatureHandler fn, void* ctx) {
+    if (!fn || !_methods.add(name, fn, ctx)) {
+        _logf("ERROR", "DEVICE", "Cannot add feature method %s (%u/%u)", name ? name : "",
+              (unsigned)_methods.size(), (unsigned)_methods.capacity());
+        return false;
+    }
+    // Counted under "invokes":{name:n}; past MEO_METRICS_MAX the method just goes uncounted
+    _invokeMetric[_methods.find(name)->order] = _metrics.addCounter("invokes", name);
+    if (_logger && _debugTagEnabled(MEO_LOG_DEVICE)) {
         _logf("DEBUG", "DEVICE", "Feature method added: %s", name);
     }
     return true;
 }
 
+bool MeoDevice::addFeatureMethod(const char* name, MeoFeatureCallback cb) {
+    if (!cb) return false;
+    // One allocation at registration; dispatch goes through the plain thunk
+    MeoFeatureCallback* heapCb = new MeoFeatureCallback(std::move(cb));
+    if (!addFeatureMethod(name, &_callbackThunk, heapCb)) {
+        delete heapCb;
+        return false;
+    }
+    return true;
+}
+
+void MeoDevice::_callbackThunk(const MeoFeatureCall& call, void* ctx) {
+    (*reinterpret_cast<MeoFeatureCallback*>(ctx))(call);
+}
+
+bool MeoDevice::enableAsyncInvoke(uint32_t stackBytes, uint8_t priority, int core) {
+    if (_asyncInvoke) return true;
+    _invokes = new (std::nothrow) MeoInvokeQueue();
+    if (!_invokes) {
+        _log("ERROR", "DEVICE", "Invoke queue: out of memory");
+        return false;
+    }
+    if (!meoStartTask("meo_invoke", &_invokeWorker, this, stackBytes, priority, core)) {
+        _log("ERROR", "DEVICE", "Invoke worker task start failed");
+        delete _invokes;
+        _invokes = nullptr;
+        return false;
+    }
+    _asyncInvoke = true;
+    _logf("INFO", "DEVICE", "Async invoke enabled (queue %u)", (unsigned)MEO_INVOKE_QUEUE_DEPTH);
+    return true;
+}
+
+bool MeoDevice::setFeatureConcurrency(const char* name, uint8_t maxInFlight) {
+    const auto* method = _methods.find(name);
+    if (!_invokes) {
+        _logf("WARN", "DEVICE", "Concurrency for %s ignored: enableAsyncInvoke() first", name ? name : "");
+        return false;
+    }
+    return method && _invokes->setLimit(method, maxInFlight);
+}
+
+void MeoDevice::_invokeWorker(void* ctx) {
+    MeoDevice* self = reinterpret_cast<MeoDevice*>(ctx);
+    MeoInvokeRecord rec;
+    for (;;) {
+        if (!self->_invokes->pop(rec)) continue;
+        if (self->_runInvoke(rec.key, rec.feature, rec.params, rec.paramsLen, rec.token)) {
+            self->_invokes->defer(rec.token);
+        } else {
+            self->_invokes->release(rec.token);
+        }
+    }
+}
+
+// Runs a copied invoke; returns true if the handler deferred its response (needs a token)
+bool MeoDevice::_runInvoke(const void* key, const char* feature, char* params, size_t paramsLen,
+                           uint32_t token) {
+    typedef decltype(_methods)::Entry Method;
+    const Method* method = reinterpret_cast<const Method*>(key);
+
+    // The caller owns the copy, so params are parsed in place again
+    StaticJsonDocument<512> doc;
+    MeoParamIndex index;
+    MeoFeatureCall call;
+    call.deviceId    = _deviceId.c_str();
+    call.featureName = feature;
+    call.token       = token;
+    if (paramsLen && deserializeJson(doc, params, paramsLen) == DeserializationError::Ok) {
+        call.params = doc.as<JsonObjectConst>();
+    }
+    index.build(call.params);
+    call.index = &index;
+
+    uint32_t t0 = micros();
+    method->handler(call, method->ctx);
+    _metrics.record(_mid.handlerUs, micros() - t0);
+    return call.deferred;
+}
+
+bool MeoDevice::_enqueueInvoke(const MeoFeatureCall& call, const void* method) {
+    char params[MEO_INVOKE_MAX_PAYLOAD];
+    size_t len = 0;
+    if (!call.params.isNull()) {
+        len = measureJson(call.params);
+        if (len < sizeof(params)) serializeJson(call.params, params, sizeof(params));
+    }
+
+    MeoInvokePush r = MeoInvokePush::TOO_LARGE;
+    if (len < sizeof(params)) {
+        if (_asyncInvoke) {
+            r = _invokes->push(method, call.featureName, params, len);
+        } else {
+            // Threaded mode without worker: hand over to loop() on the app task
+            char head[sizeof(void*) + MEO_INVOKE_MAX_FEATURE_NAME];
+            size_t nameLen = strlen(call.featureName) + 1;
+            if (nameLen <= MEO_INVOKE_MAX_FEATURE_NAME) {
+                memcpy(head, &method, sizeof(void*));
+                memcpy(head + sizeof(void*), call.featureName, nameLen);
+                r = _rxRing->push(head, sizeof(void*) + nameLen, params, len) ? MeoInvokePush::OK
+                                                                               : MeoInvokePush::FULL;
+            }
+        }
+    }
+    if (r == MeoInvokePush::OK) {
+        if (_logger && _debugTagEnabled(MEO_LOG_DEVICE)) {
+            _logf("DEBUG", "DEVICE", "Queued invoke %s (depth %u)", call.featureName,
+                  (unsigned)invokeStats().depth);
+        }
+        return true;
+    }
+    const char* reason = (r == MeoInvokePush::BUSY) ? "Busy"
+                       : (r == MeoInvokePush::FULL) ? "Invoke queue full"
+                       : "Params too large";
+    _logf("WARN", "DEVICE", "Invoke %s rejected: %s", call.featureName, reason);
+    sendFeatureResponse(call, false, reason);
+    return false;
+}
+
 bool MeoDevice::start() {
     // Storage
     if (!_storage.begin()) {
@@ -90,25 +328,20 @@ bool MeoDevice::start() {
     // BLE + Provisioning (model/manufacturer read-only via BLE)
     _ble.begin(_model);
     _prov.setLogger(_logger);
-    _prov.setDebugTags(_debugTags);
+    _prov.setDebugMask(_debugMask);
     _prov.begin(&_ble, &_storage, _model, _manufacturer);
     _prov.setAutoRebootOnProvision(true, 500);
-    _prov.setRuntimeStatus(_wifiReady ? "connected" : "disconnected", "disconnected");
+    _prov.setRuntimeStatus(_wifi.isConnected() ? "connected" : "disconnected", "disconnected");
     _prov.startAdvertising();
     _log("INFO", "DEVICE", "BLE provisioning started");
 
     // If WiFi not configured up-front, try load from storage (set via BLE)
-    if (!_wifiReady && (!_wifiSsid || !_wifiPass)) {
+    _wifi.begin(&_storage);
+    if (!_wifi.hasTarget()) {
         std::string ssid, pass;
         if (_storage.loadString("wifi_ssid", ssid) && _storage.loadString("wifi_pass", pass)) {
             _logf("INFO", "DEVICE", "WiFi creds loaded from storage: SSID=%s", ssid.c_str());
-            WiFi.mode(WIFI_STA);
-            WiFi.begin(ssid.c_str(), pass.c_str());
-            uint32_t start = millis();
-            while (WiFi.status() != WL_CONNECTED && (millis() - start) < 15000) {
-                delay(100);
-            }
-            _wifiReady = (WiFi.status() == WL_CONNECTED);
+            _wifi.connect(ssid.c_str(), pass.c_str());
         }
     }
 
@@ -118,209 +351,711 @@ bool MeoDevice::start() {
     _storage.loadString("user_id", _userId);
     // device_id from ESP MAC (Ethernet MAC preferred)
     uint8_t mac_raw[6] = {0};
-    esp_err_t r = esp_read_mac(mac_raw, ESP_MAC_ETH);
-    if (r != ESP_OK) {
+    if (_macOverride) {
+        memcpy(mac_raw, _mac, sizeof(mac_raw));
+    } else if (esp_read_mac(mac_raw, ESP_MAC_ETH) != ESP_OK) {
         esp_read_mac(mac_raw, ESP_MAC_WIFI_STA);
     }
     char macbuf[13]; // 12 hex chars + null
     snprintf(macbuf, sizeof(macbuf), "%02X%02X%02X%02X%02X%02X",
                 mac_raw[0], mac_raw[1], mac_raw[2], mac_raw[3], mac_raw[4], mac_raw[5]);
     _deviceId = std::string(macbuf);
-    if (_logger && _debugTagEnabled("DEVICE")) {
+    if (_logger && _debugTagEnabled(MEO_LOG_DEVICE)) {
         _logf("DEBUG", "DEVICE", "Generated device_id from MAC: %s", macbuf);
     }
+    if (!_buildTopics()) {
+        _log("ERROR", "DEVICE", "MQTT topics exceed MEO_TOPIC_MAX_LEN");
+        return false;
+    }
     _logf("INFO", "DEVICE", "Credentials %s", hasCredentials() ? "present" : "missing");
 
-    // Only proceed if both WiFi and credentials are ready
-    if (!_wifiReady || !hasCredentials()) {
-        _prov.setRuntimeStatus(_wifiReady ? "connected" : "disconnected", "disconnected");
+    // Only proceed if both WiFi and credentials are configured
+    if (!_wifi.hasTarget() || !hasCredentials()) {
+        _prov.setRuntimeStatus(_wifi.isConnected() ? "connected" : "disconnected", "disconnected");
         _log("WARN", "DEVICE", "Waiting for WiFi/credentials via BLE provisioning");
         return false;
     }
 
     // PATCH: stop BLE advertising once WiFi is connected (if BLE was already advertising)
-    // if (_wifiReady) {
+    // if (_wifi.isConnected()) {
     //     _prov.stopAdvertising();
     //     _log("INFO", "DEVICE", "WiFi connected; stopped BLE advertising");
     // }
 
-    // MQTT connect + declare
-    return _connectMqttAndDeclare();
+    // WiFi association, MQTT connect + declare happen in loop(), without blocking the sketch
+    _configureMqtt();
+    if (_netTaskWanted && !_netTaskRunning) {
+        _netTaskRunning = true; // route publishes to the ring before the task runs
+        if (!meoStartTask("meo_net", &_netTask, this, _netStackBytes, _netPriority, _netCore)) {
+            _netTaskRunning = false;
+            _log("ERROR", "DEVICE", "Network task start failed; staying inline");
+        } else {
+            _logf("INFO", "DEVICE", "Network task on core %d", _netCore);
+        }
+    }
+    return true;
 }
 
 void MeoDevice::loop() {
+    uint32_t t0 = micros();
     // _prov.loop(); // BLE provisioning loop unused because after mqtt connect success we stop advertising
-    _mqtt.loop();
+    if (_netTaskRunning) {
+        // Network I/O lives on its own task; only run handlers here
+        _drainRxRing();
+    } else {
+        _wifi.loop();
+        _mqttStep();
+    }
+
+    // Batch window: the oldest pending event has waited long enough
+    if (_batchWindowMs && !_batch.empty() && millis() - _batch.firstMs() >= _batchWindowMs) {
+        flush();
+    }
+
+    // Deferred log records: formatted or uploaded here, off the logging call
+    if (_binLog) _drainBinLog();
+
+    // Coalesced NVS writes (provisioning, cached AP) go out once they settle
+    _storage.loop();
+    // State log compaction: one record copy or one sector erase per call
+    _state.loop();
+
+    if (_metricsIntervalMs && millis() - _metricsLastMs >= _metricsIntervalMs) {
+        _metricsLastMs = millis();
+        publishMetrics();
+    }
 
     // Update BLE status on change
-    static wl_status_t lastWifi = WL_IDLE_STATUS;
     wl_status_t nowWifi = WiFi.status();
-    if (nowWifi != lastWifi) {
-        _prov.setRuntimeStatus(nowWifi == WL_CONNECTED ? "connected" : "disconnected",
-                               _mqtt.isConnected() ? "connected" : "disconnected");
-        lastWifi = nowWifi;
-        if (_logger && _debugTagEnabled("DEVICE")) {
+    if (nowWifi != _lastWifiStatus) {
+        _lastWifiStatus = nowWifi;
+        _updateBleStatus();
+        if (_logger && _debugTagEnabled(MEO_LOG_DEVICE)) {
             _logf("DEBUG", "DEVICE", "Status WiFi=%s MQTT=%s",
                   nowWifi == WL_CONNECTED ? "connected" : "disconnected",
-                  _mqtt.isConnected() ? "connected" : "disconnected");
+                  isMqttConnected() ? "connected" : "disconnected");
         }
     }
+    _metrics.record(_mid.loopUs, micros() - t0);
+}
+
+bool MeoDevice::publishMetrics() {
+    if (!_topics.isReady()) return false;
+    // Sampled gauges, and the links' byte counts mirrored into counters
+    _metrics.set(_mid.uptime, (int32_t)(millis() / 1000));
+    _metrics.set(_mid.bytesOut, (int32_t)(_mqtt.bytesSent() + (_cloudHost ? _cloud.bytesSent() : 0)));
+    _metrics.set(_mid.bytesIn, (int32_t)(_mqtt.bytesReceived() + (_cloudHost ? _cloud.bytesReceived() : 0)));
+    _metrics.set(_mid.dropped, (int32_t)(_mqtt.requestsDropped() + (_cloudHost ? _cloud.requestsDropped() : 0)));
+    _metrics.set(_mid.freeHeap, (int32_t)ESP.getFreeHeap());
+    _metrics.set(_mid.largestBlock, (int32_t)ESP.getMaxAllocHeap());
+    _metrics.set(_mid.rssi, WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0);
+
+    // Histogram windows reset as they are written: with no link they keep collecting
+    if (!_netTaskRunning && !_anyLinkUp()) return false;
+
+    // One message per MEO_METRICS_JSON_BYTES; a large registry (many invoked
+    // methods) continues in further messages
+    char json[MEO_METRICS_JSON_BYTES];
+    uint8_t cursor = 0;
+    uint8_t parts = 0;
+    do {
+        size_t len = _metrics.snapshot(json, sizeof(json), cursor);
+        if (len == 0) {
+            _log("WARN", "DEVICE", "Metric does not fit MEO_METRICS_JSON_BYTES");
+            return false;
+        }
+        if (_logger && _debugTagEnabled(MEO_LOG_DEVICE)) {
+            _logf("DEBUG", "DEVICE", "Publish metrics part=%u len=%u", (unsigned)parts, (unsigned)len);
+        }
+        if (!_publishUnqueued(_topics.metrics(), (const uint8_t*)json, len)) return false;
+        parts++;
+    } while (cursor != 0);
+    return true;
+}
+
+bool MeoDevice::publishEvent(const char* eventName, const MeoEventFields& fields) {
+    uint32_t t0 = micros();
+    char scratch[MEO_TOPIC_MAX_LEN];
+    MeoEventRoute route = MeoEventRoute::EDGE_FIRST;
+    const char* topic = _eventTopic(eventName, scratch, sizeof(scratch), route);
+    if (!topic) return false;
 
-    // Lazy reconnect when WiFi + creds available
-    if (!_mqtt.isConnected() && _wifiReady && hasCredentials()) {
-        _log("WARN", "DEVICE", "MQTT disconnected; attempting reconnect");
-        _connectMqttAndDeclare();
+    if (_logger && _debugTagEnabled(MEO_LOG_DEVICE)) {
+        _logf("DEBUG", "DEVICE", "Publish event %s fields=%u", eventName, (unsigned)fields.count());
     }
+    bool ok;
+    MeoEventFilter* filter = _eventFilter(eventName);
+    if (filter) {
+        MeoLockGuard lk(_filterLock);
+        uint32_t now = millis();
+        if (filter->check(fields, now)) {
+            ok = _sendEvent(eventName, topic, route, fields);
+            if (ok) filter->commit(fields, now); // a failed publish is compared again next time
+        } else {
+            filter->suppressed();
+            ok = true;
+            if (_logger && _debugTagEnabled(MEO_LOG_DEVICE)) {
+                _logf("DEBUG", "DEVICE", "Suppressed event %s (policy)", eventName);
+            }
+        }
+    } else {
+        ok = _sendEvent(eventName, topic, route, fields);
+    }
+    _publishLatency.record(micros() - t0);
+    return ok;
+}
+
+bool MeoDevice::_sendEvent(const char* eventName, const char* topic, MeoEventRoute route,
+                           const MeoEventFields& fields) {
+    bool ok = false;
+    // Events routed to the cloud keep their own topic; batches only go edge-first
+    if (_batchWindowMs && route == MeoEventRoute::EDGE_FIRST && _batchEvent(eventName, fields, ok)) return ok;
+    return _publishOrQueue(topic, fields, route);
 }
 
 bool MeoDevice::publishEvent(const char* eventName,
                              const char* const* keys,
                              const char* const* values,
                              uint8_t count) {
-    if (!_mqtt.isConnected()) return false;
-    std::string base = "meo/";
-    if (_userId.length()) base += _userId + "/";
-    std::string topic = base + _deviceId + "/event";
-
-    StaticJsonDocument<512> doc;
+    MeoStaticEventFields<MEO_MAX_EVENT_FIELDS> fields;
     for (uint8_t i = 0; i < count; ++i) {
-        doc[keys[i]] = values[i];
-    }
-
-    char buf[512];
-    size_t len = serializeJson(doc, buf, sizeof(buf));
-    if (len == 0) return false;
-
-    if (_logger && _debugTagEnabled("DEVICE")) {
-        _logf("DEBUG", "DEVICE", "Publish event %s len=%u", eventName, (unsigned)len);
+        if (!fields.add(keys[i], values[i])) return false;
     }
-    return _mqtt.publish(topic.c_str(), (const uint8_t*)buf, len, false);
+    return publishEvent(eventName, fields);
 }
 
 bool MeoDevice::publishEvent(const char* eventName, const MeoEventPayload& payload) {
-    if (!_mqtt.isConnected()) return false;
-    std::string base = "meo/";
-    if (_userId.length()) base += _userId + "/";
-    std::string topic = base + _deviceId + "/event/" + eventName;
-
-    StaticJsonDocument<512> doc;
+    MeoStaticEventFields<MEO_MAX_EVENT_FIELDS> fields;
     for (const auto& kv : payload) {
-        doc[kv.first] = kv.second;
+        if (!fields.add(kv.first.c_str(), kv.second.c_str())) return false;
     }
+    return publishEvent(eventName, fields);
+}
 
-    char buf[512];
-    size_t len = serializeJson(doc, buf, sizeof(buf));
-    if (len == 0) return false;
+void MeoDevice::setPayloadEncoding(MeoPayloadEncoding enc) {
+    _encoding = enc;
+    _mqtt.setPayloadEncoding(enc);
+    _cloud.setPayloadEncoding(enc);
+    MeoLockGuard lk(_batchLock);
+    _flushBatch();
+    _batch.setEncoding(enc);
+}
+
+void MeoDevice::setEventBatching(uint32_t windowMs, size_t maxBytes) {
+    MeoLockGuard lk(_batchLock);
+    _flushBatch();
+    _batch.setLimit(maxBytes);
+    _batchWindowMs = windowMs;
+}
+
+bool MeoDevice::flush() {
+    MeoLockGuard lk(_batchLock);
+    return _flushBatch();
+}
+
+// true if the batch took care of the event (ok = accepted); false = publish it alone
+bool MeoDevice::_batchEvent(const char* eventName, const MeoEventFields& fields, bool& ok) {
+    if (!_batchTopic[0]) return false;
+    MeoLockGuard lk(_batchLock);
+    uint32_t now = millis();
+    if (!_batch.add(eventName, fields, now)) {
+        if (_batch.empty()) {
+            // Larger than a whole batch
+            _batchStats.unbatched++;
+            return false;
+        }
+        // Budget reached: send what we have and start a new batch with this event
+        _flushBatch();
+        if (!_batch.add(eventName, fields, now)) {
+            _batchStats.unbatched++;
+            return false;
+        }
+    }
+    _batchStats.events++;
+    ok = true;
+    return true;
+}
 
-    if (_logger && _debugTagEnabled("DEVICE")) {
-        _logf("DEBUG", "DEVICE", "Publish event %s len=%u", eventName, (unsigned)len);
+bool MeoDevice::_flushBatch() {
+    if (_batch.empty()) return true;
+    size_t len = 0;
+    const char* payload = _batch.finish(len);
+    uint16_t count = _batch.count();
+    bool ok = _publishOrQueueRaw(_batchTopic, (const uint8_t*)payload, len, MeoEventRoute::EDGE_FIRST);
+    _batch.clear();
+    _batchStats.batches++;
+    _batchStats.bytes += (uint32_t)len;
+    if (_logger && _debugTagEnabled(MEO_LOG_DEVICE)) {
+        _logf(ok ? "DEBUG" : "WARN", "DEVICE", "Batch of %u events len=%u%s", (unsigned)count, (unsigned)len,
+              ok ? "" : " (dropped)");
     }
-    return _mqtt.publish(topic.c_str(), (const uint8_t*)buf, len, false);
+    return ok;
 }
 
 bool MeoDevice::sendFeatureResponse(const char* featureName,
                                     bool success,
-                                    const char* message) {
-    if (!_mqtt.isConnected()) return false;
-    std::string base = "meo/";
-    if (_userId.length()) base += _userId + "/";
-    std::string topic = base + _deviceId + "/event/feature_response";
-
-    StaticJsonDocument<512> doc;
-    doc["feature_name"] = featureName;
-    doc["device_id"]    = _deviceId.c_str();
-    doc["success"]      = success;
-    if (message) doc["message"] = message;
+                                    const char* message,
+                                    uint32_t token) {
+    if (!_topics.isReady()) return false;
+    // Only the answer to a deferred invoke frees its slot; anything else (inline
+    // answers, Busy/Full rejections) never touches the queue accounting
+    if (token && (!_invokes || !_invokes->complete(token))) {
+        _logf("WARN", "DEVICE", "Response for %s: invoke token %lu not deferred", featureName ? featureName : "",
+              (unsigned long)token);
+    }
 
-    char buf[512];
-    size_t len = serializeJson(doc, buf, sizeof(buf));
-    if (len == 0) return false;
+    MeoStaticEventFields<4> fields;
+    fields.add("feature_name", featureName);
+    fields.add("device_id", _deviceId.c_str());
+    fields.add("success", success);
+    if (message) fields.add("message", message);
 
-    if (_logger && _debugTagEnabled("DEVICE")) {
+    if (_logger && _debugTagEnabled(MEO_LOG_DEVICE)) {
         _logf("DEBUG", "DEVICE", "Publish feature_response for %s", featureName);
     }
-    return _mqtt.publish(topic.c_str(), (const uint8_t*)buf, len, false);
+    // Answer on the link the invoke came in on when the handler runs inline;
+    // deferred and queued responses take the default route
+    bool inlineCall = !_asyncInvoke && !_netTaskRunning;
+    uint16_t correlationLen = 0;
+    const uint8_t* correlation = (inlineCall && _replyLink) ? _replyLink->correlationData(correlationLen) : nullptr;
+    const char* responseTopic = (inlineCall && _replyLink) ? _replyLink->responseTopic() : nullptr;
+    if (responseTopic || correlationLen) {
+        // MQTT 5 request/response: reply where the requester asked, echoing its correlation data
+        MeoPublishProps props;
+        props.correlation = correlationLen ? correlation : nullptr;
+        props.correlationLen = correlationLen;
+        props.addUser("feature_name", featureName);
+        MeoLockGuard lk(_txLock);
+        return _replyLink->publish(responseTopic ? responseTopic : _topics.featureResponse(), fields, false, &props);
+    }
+    MeoEventRoute route = (inlineCall && _replyLink == &_cloud) ? MeoEventRoute::CLOUD_FIRST
+                                                            : MeoEventRoute::EDGE_FIRST;
+    return _publishOrQueue(_topics.featureResponse(), fields, route, _responseQos1);
 }
 
 bool MeoDevice::sendFeatureResponse(const MeoFeatureCall& call,
                                     bool success,
                                     const char* message) {
-    return sendFeatureResponse(call.featureName.c_str(), success, message);
+    return sendFeatureResponse(call.featureName, success, message, call.deferred ? call.token : 0);
 }
 
-void MeoDevice::_updateBleStatus() {
-    const char* wifi = (WiFi.status() == WL_CONNECTED) ? "connected" : "disconnected";
-    const char* mqtt = _mqtt.isConnected() ? "connected" : "disconnected";
-    _prov.setRuntimeStatus(wifi, mqtt);
+void MeoDevice::setOfflineQueue(bool enabled, MeoQueuePolicy policy, uint16_t replayPerSecond) {
+    _queueEnabled = enabled;
+    _replayPerSecond = replayPerSecond;
+    _queue.setPolicy(policy);
+    if (!enabled) _queue.clear();
 }
 
-bool MeoDevice::_connectMqttAndDeclare() {
-    // Configure transport (host/port + credentials)
-    _mqtt.configure(_gatewayHost, _mqttPort);
-    _mqtt.setCredentials(_deviceId.c_str(), _transmitKey.c_str());
-    _mqtt.setLogger(_logger);
-    _mqtt.setDebugTags(_debugTags);
-
-    // LWT: status offline retained
-    {
-        std::string base = "meo/";
-        if (_userId.length()) base += _userId + "/";
-        std::string willTopic = base + _deviceId + "/status";
-        _mqtt.setWill(willTopic.c_str(), "offline", 0, false);
+bool MeoDevice::enableOfflineSpill(const char* partitionLabel) {
+#if defined(ESP_PLATFORM)
+    if (!_spillFlash.begin(partitionLabel) || !_spill.begin(&_spillFlash)) {
+        _logf("ERROR", "DEVICE", "Offline spill partition '%s' unavailable", partitionLabel ? partitionLabel : "");
+        return false;
     }
+    _queue.setSpill(&_spill);
+    _logf("INFO", "DEVICE", "Offline spill on '%s' (%u KB)", partitionLabel, (unsigned)(_spillFlash.size() / 1024));
+    return true;
+#else
+    (void)partitionLabel;
+    return false;
+#endif
+}
 
-    if (!_mqtt.connect()) {
-        _log("ERROR", "DEVICE", "MQTT connect failed");
+bool MeoDevice::enableStateStore(const char* partitionLabel) {
+    if (!partitionLabel || !*partitionLabel) return false;
+#if defined(ESP_PLATFORM)
+    bool mounted = _stateFlash.begin(partitionLabel);
+#else
+    const char* dir = getenv("MEO_NATIVE_NVS");
+    std::string path = (dir && *dir) ? dir : ".meo_nvs";
+    mkdir(path.c_str(), 0755);
+    path = path + "/" + partitionLabel + ".flash";
+    bool mounted = _stateFlash.begin(path.c_str(), MEO_STATE_NATIVE_BYTES);
+#endif
+    if (!mounted || !_state.begin(&_stateFlash)) {
+        _logf("ERROR", "DEVICE", "State store partition '%s' unavailable", partitionLabel);
         return false;
     }
-    _log("INFO", "DEVICE", "MQTT connected");
+    MeoLogStoreStats st = _state.stats();
+    _logf("INFO", "DEVICE", "State store on '%s' (%u KB, %u keys, erases %lu..%lu%s)", partitionLabel,
+          (unsigned)(_stateFlash.size() / 1024), (unsigned)_state.keys(), (unsigned long)st.minErases,
+          (unsigned long)st.maxErases, st.torn ? ", torn record skipped" : "");
+    return true;
+}
 
-    // Subscribe to feature invokes and wire handler
-    {
-        std::string base = "meo/";
-        if (_userId.length()) base += _userId + "/";
-        std::string topic;
-        if (_cloudCompatible) {
-            // cloud-compatible: single topic where payload contains feature name
-            topic = base + _deviceId + "/feature";
-        } else {
-            // edge-compatible: topic encodes feature name in topic path
-            topic = base + _deviceId + "/feature/+/invoke";
+bool MeoDevice::_publishOrQueue(const char* topic, const MeoEventFields& fields, MeoEventRoute route,
+                                bool qos1) {
+    if (_netTaskRunning) return _enqueueTx(topic, fields, route, qos1);
+    // May run on the invoke worker: the lock keeps PubSubClient and the queue single-user
+    MeoLockGuard lk(_txLock);
+    // Keep ordering: once something is queued, new messages queue behind it
+    if (_anyLinkUp() && _queue.empty()) {
+        if (_publishRouted(route, topic, &fields, nullptr, 0, qos1)) return true;
+        if (!qos1) return false;
+        // QoS 1 window full: fall through and queue
+    }
+    if (!_queueEnabled) return false;
+
+    uint8_t buf[MEO_QUEUE_MAX_RECORD];
+    size_t len = fields.serialize(_encoding, buf, sizeof(buf));
+    if (len == 0) return false;
+    bool ok = _queue.push(topic, buf, len);
+    if (_logger && _debugTagEnabled(MEO_LOG_DEVICE)) {
+        _logf("DEBUG", "DEVICE", "Queued %s len=%u depth=%u%s", topic, (unsigned)len,
+              (unsigned)_queue.count(), ok ? "" : " (dropped)");
+    }
+    return ok;
+}
+
+void MeoDevice::_drainBinLog() {
+    if (!_logBatch) {
+        _binLog->drain(_logger, MEO_BINLOG_DRAIN_BUDGET);
+        return;
+    }
+    MeoBinLogRecord rec;
+    for (uint8_t i = 0; i < MEO_BINLOG_DRAIN_BUDGET && _binLog->pop(rec); ++i) {
+        if (_logBatch->empty()) _logBatchMs = millis();
+        if (_logBatch->add(rec)) continue;
+        _uploadBinLog();
+        _logBatchMs = millis();
+        if (!_logBatch->add(rec)) _logStats.unsent++; // does not fit even an empty batch
+    }
+    if (!_logBatch->empty() && millis() - _logBatchMs >= MEO_BINLOG_UPLOAD_MS) _uploadBinLog();
+}
+
+bool MeoDevice::_uploadBinLog() {
+    bool ok = _topics.isReady() && _publishUnqueued(_topics.log(), _logBatch->data(), _logBatch->size());
+    if (ok) {
+        _logStats.batches++;
+    } else {
+        _logStats.unsent += _logBatch->count();
+    }
+    uint32_t dropped = _binLog->stats().dropped;
+    _logBatch->begin(dropped - _logDropsSent);
+    _logDropsSent = dropped;
+    return ok;
+}
+
+// Log batches and metrics snapshots are not worth the offline queue: no link, not sent
+bool MeoDevice::_publishUnqueued(const char* topic, const uint8_t* payload, size_t len) {
+    if (_netTaskRunning) return _enqueueTxRaw(topic, payload, len, MeoEventRoute::EDGE_FIRST, false);
+    MeoLockGuard lk(_txLock);
+    return _anyLinkUp() && _publishRouted(MeoEventRoute::EDGE_FIRST, topic, nullptr, payload, len);
+}
+
+// _publishOrQueue() for a payload that is already serialized
+bool MeoDevice::_publishOrQueueRaw(const char* topic, const uint8_t* payload, size_t len, MeoEventRoute route) {
+    if (_netTaskRunning) return _enqueueTxRaw(topic, payload, len, route, false);
+    MeoLockGuard lk(_txLock);
+    if (_anyLinkUp() && _queue.empty()) return _publishRouted(route, topic, nullptr, payload, len);
+    if (!_queueEnabled) return false;
+    return _queue.push(topic, payload, len);
+}
+
+bool MeoDevice::_anyLinkUp() {
+    return _mqtt.isConnected() || (_cloudHost && _cloud.isConnected());
+}
+
+// Publish `fields` (streamed) or a serialized payload on the links `route` picks;
+// false if no chosen link took it. QoS 1 completes asynchronously on each link.
+bool MeoDevice::_publishRouted(MeoEventRoute route, const char* topic, const MeoEventFields* fields,
+                               const uint8_t* payload, size_t len, bool qos1) {
+    bool dual = _cloudHost != nullptr;
+    MeoMqttClient& first  = (dual && route == MeoEventRoute::CLOUD_FIRST) ? _cloud : _mqtt;
+    MeoMqttClient& second = (&first == &_mqtt) ? _cloud : _mqtt;
+    auto send = [&](MeoMqttClient& link) {
+        if (!link.isConnected()) return false;
+        if (qos1) {
+            return (fields ? link.publishQos1(topic, *fields) : link.publishQos1(topic, payload, len)) != 0;
         }
-        _mqtt.subscribe(topic.c_str());
-        _mqtt.setMessageHandler(&_mqttThunk, this);
-        if (_logger && _debugTagEnabled("DEVICE")) {
-            _logf("DEBUG", "DEVICE", "Subscribed to %s", topic.c_str());
+        return fields ? link.publish(topic, *fields, false) : link.publish(topic, payload, len, false);
+    };
+    bool sent = send(first);
+    if (dual && (route == MeoEventRoute::BOTH || !sent)) sent = send(second) || sent;
+    _metrics.add(sent ? _mid.publishOk : _mid.publishFailed);
+    return sent;
+}
+
+void MeoDevice::_replayQueued() {
+    size_t budget = (size_t)-1;
+    uint32_t now = millis();
+    if (_replayPerSecond) {
+        // Token bucket with a one-second burst
+        uint32_t elapsed = now - _replayLastMs;
+        if (elapsed > 1000) elapsed = 1000;
+        budget = (size_t)elapsed * _replayPerSecond / 1000;
+        if (budget == 0) return;
+    }
+    _replayLastMs = now;
+    size_t sent = _queue.drain(&_queueSendThunk, this, budget);
+    if (sent && _logger && _debugTagEnabled(MEO_LOG_DEVICE)) {
+        _logf("DEBUG", "DEVICE", "Replayed %u queued messages, %u left", (unsigned)sent, (unsigned)_queue.count());
+    }
+}
+
+bool MeoDevice::_queueSendThunk(const char* topic, const uint8_t* payload, size_t len, void* ctx) {
+    MeoDevice* self = reinterpret_cast<MeoDevice*>(ctx);
+    return self && self->_publishRouted(MeoEventRoute::EDGE_FIRST, topic, nullptr, payload, len);
+}
+
+bool MeoDevice::enableNetworkTask(uint32_t stackBytes, uint8_t priority, int core) {
+    if (_netTaskRunning) return false; // must be chosen before start()
+    if (!_txRing) _txRing = new (std::nothrow) MeoSpscRing<MEO_NET_TX_RING>();
+    if (!_rxRing) _rxRing = new (std::nothrow) MeoSpscRing<MEO_NET_RX_RING>();
+    if (!_txRing || !_rxRing) {
+        _log("ERROR", "DEVICE", "Network task queues: out of memory; staying inline");
+        return false;
+    }
+    _netTaskWanted = true;
+    _netStackBytes = stackBytes;
+    _netPriority = priority;
+    _netCore = core;
+    return true;
+}
+
+void MeoDevice::_netTask(void* ctx) {
+    MeoDevice* self = reinterpret_cast<MeoDevice*>(ctx);
+    for (;;) {
+        self->_netStep();
+        meoSleepMs(1);
+    }
+}
+
+void MeoDevice::_netStep() {
+    _wifi.loop();
+    MeoLockGuard lk(_txLock);
+    _drainTxRing();
+    _mqttStep();
+}
+
+void MeoDevice::_mqttStep() {
+    MeoLockGuard lk(_txLock);
+    _mqtt.loop();
+    if (_cloudHost) _cloud.loop();
+    _mqttUp.store(_mqtt.isConnected(), std::memory_order_relaxed);
+    _cloudUp.store(_cloudHost && _cloud.isConnected(), std::memory_order_relaxed);
+
+    // Forward messages queued while offline
+    if (_anyLinkUp() && !_queue.empty()) {
+        _replayQueued();
+    }
+}
+
+bool MeoDevice::_enqueueTx(const char* topic, const MeoEventFields& fields, MeoEventRoute route, bool qos1) {
+    uint8_t payload[MEO_QUEUE_MAX_RECORD];
+    size_t len = fields.serialize(_encoding, payload, sizeof(payload));
+    if (len == 0) return false;
+    return _enqueueTxRaw(topic, payload, len, route, qos1);
+}
+
+bool MeoDevice::_enqueueTxRaw(const char* topic, const uint8_t* payload, size_t len, MeoEventRoute route,
+                              bool qos1) {
+    char head[TX_HEAD + MEO_TOPIC_MAX_LEN];
+    size_t topicLen = strlen(topic) + 1;
+    if (topicLen > MEO_TOPIC_MAX_LEN) return false;
+    uint32_t now = micros();
+    memcpy(head, &now, sizeof(now));
+    head[sizeof(now)] = (char)((uint8_t)route | (qos1 ? TX_QOS1 : 0));
+    memcpy(head + TX_HEAD, topic, topicLen);
+
+    MeoLockGuard lk(_txProduceLock);
+    if (!_txRing->push(head, TX_HEAD + topicLen, payload, len)) {
+        _txDrops++;
+        return false;
+    }
+    return true;
+}
+
+// Network task: publish (or queue for later) everything the app enqueued
+void MeoDevice::_drainTxRing() {
+    char rec[TX_HEAD + MEO_TOPIC_MAX_LEN + MEO_QUEUE_MAX_RECORD];
+    while (!_txRing->empty()) {
+        size_t n = _txRing->pop(rec, sizeof(rec));
+        if (n <= TX_HEAD) continue;
+        uint32_t enqueuedUs;
+        memcpy(&enqueuedUs, rec, sizeof(enqueuedUs));
+        uint8_t routeByte = (uint8_t)rec[sizeof(uint32_t)];
+        MeoEventRoute route = (MeoEventRoute)(routeByte & ~TX_QOS1);
+        bool qos1 = (routeByte & TX_QOS1) != 0;
+        const char* topic = rec + TX_HEAD;
+        size_t topicLen = strnlen(topic, n - TX_HEAD) + 1;
+        if (TX_HEAD + topicLen > n) continue;
+        const uint8_t* payload = (const uint8_t*)topic + topicLen;
+        size_t payloadLen = n - TX_HEAD - topicLen;
+
+        // Same ordering rule as inline mode: once something is queued, queue behind it
+        if (_anyLinkUp() && _queue.empty() && _publishRouted(route, topic, nullptr, payload, payloadLen, qos1)) {
+            _txQueueLatency.record(micros() - enqueuedUs);
+            continue;
         }
+        if (_queueEnabled) _queue.push(topic, payload, payloadLen);
     }
+}
 
-    // Publish online status
-    {
-        std::string base = "meo/";
-        if (_userId.length()) base += _userId + "/";
-        std::string statusTopic = base + _deviceId + "/status";
-        _mqtt.publish(statusTopic.c_str(), "online", true);
+// App task: run invokes handed over by the network task
+void MeoDevice::_drainRxRing() {
+    char rec[sizeof(void*) + MEO_INVOKE_MAX_FEATURE_NAME + MEO_INVOKE_MAX_PAYLOAD];
+    while (!_rxRing->empty()) {
+        size_t n = _rxRing->pop(rec, sizeof(rec));
+        if (n <= sizeof(void*)) continue;
+        const void* key;
+        memcpy(&key, rec, sizeof(void*));
+        char* feature = rec + sizeof(void*);
+        size_t nameLen = strnlen(feature, n - sizeof(void*)) + 1;
+        if (sizeof(void*) + nameLen > n) continue;
+        // Deferral has no bookkeeping here: without the worker there are no limits to hold
+        _runInvoke(key, feature, feature + nameLen, n - sizeof(void*) - nameLen);
     }
+}
+
+// loop() (WiFi changes) and the MQTT state callback (network task in threaded mode)
+void MeoDevice::_updateBleStatus() {
+    const char* wifi = (WiFi.status() == WL_CONNECTED) ? "connected" : "disconnected";
+    const char* mqtt = isMqttConnected() ? "connected" : "disconnected";
+    MeoLockGuard lk(_statusLock);
+    _prov.setRuntimeStatus(wifi, mqtt);
+}
+
+bool MeoDevice::_buildTopics() {
+    if (!_topics.begin(_userId.c_str(), _deviceId.c_str())) return false;
+    for (uint8_t i = 0; i < _eventCount; ++i) {
+        if (!_topics.buildEventTopic(_eventNames[i], _eventTopics[i], MEO_TOPIC_MAX_LEN)) return false;
+    }
+    return _topics.buildEventTopic("batch", _batchTopic, sizeof(_batchTopic));
+}
+
+const char* MeoDevice::_eventTopic(const char* eventName, char* scratch, size_t scratchLen,
+                                   MeoEventRoute& route) const {
+    if (!eventName || !_topics.isReady()) return nullptr;
+    // Registered events use their pre-built topic
+    for (uint8_t i = 0; i < _eventCount; ++i) {
+        if (_eventNames[i] == eventName || strcmp(_eventNames[i], eventName) == 0) {
+            route = _eventRoutes[i];
+            return _eventTopics[i];
+        }
+    }
+    // Unregistered event: build on the caller's stack
+    return _topics.buildEventTopic(eventName, scratch, scratchLen) ? scratch : nullptr;
+}
 
-    // Declare
-    _publishDeclare();
+void MeoDevice::_configureMqtt() {
+    _configureLink(_mqtt, _gatewayHost, _mqttPort, _mqttSecurity);
+    _mqtt.setSessionHandler(&_mqttSessionThunk, this);
+    _mqtt.setStateHandler(&_mqttStateThunk, this);
+    _mqtt.setAutoConnect(true);
+    if (!_cloudHost) return;
 
-    _updateBleStatus();
+    // Second link: own socket, buffers, session and subscriptions
+    _configureLink(_cloud, _cloudHost, _cloudPort, _cloudSecurity);
+    _cloud.setSessionHandler(&_cloudSessionThunk, this);
+    _cloud.setStateHandler(&_cloudStateThunk, this);
+    _cloud.setAutoConnect(true);
+}
+
+void MeoDevice::_configureLink(MeoMqttClient& link, const char* host, uint16_t port, MeoMqttSecurity security) {
+    // Configure transport (host/port + socket kind + credentials)
+    link.configure(host, port);
+    link.setSecurity(security);
+    link.setTlsSessionStore(_persistTls ? &_storage : nullptr, (&link == &_cloud) ? "tls_cloud" : "tls_gw");
+    link.setCredentials(_deviceId.c_str(), _transmitKey.c_str());
+    link.setLogger(_logger);
+    link.setDebugMask(_debugMask);
+
+    // LWT: status offline (the cached topic outlives the client's pointer to it)
+    link.setWill(_topics.status(), "offline", 0, false);
+}
+
+bool MeoDevice::_onMqttSession(MeoMqttClient& link, MeoMqttState step) {
+    const char* name = (&link == &_cloud) ? "Cloud" : "MQTT";
+    if (step == MeoMqttState::SUBSCRIBED) {
+        // cloud-compatible: single topic where payload contains feature name
+        // edge-compatible: topic encodes feature name in topic path
+        const char* topic = _cloudCompatible ? _topics.feature() : _topics.featureInvoke();
+        link.setMessageHandler((&link == &_cloud) ? &_cloudThunk : &_mqttThunk, this);
+        if (!link.subscribe(topic)) return false;
+        if (link.usesMqtt5()) {
+            // Most frequent first: the broker may grant fewer aliases than we register
+            link.clearTopicAliases();
+            if (_batchWindowMs) link.addTopicAlias(_batchTopic);
+            for (uint8_t i = 0; i < _eventCount; ++i) link.addTopicAlias(_eventTopics[i]);
+            link.addTopicAlias(_topics.featureResponse());
+        }
+        if (_logger && _debugTagEnabled(MEO_LOG_DEVICE)) {
+            _logf("DEBUG", "DEVICE", "%s subscribed to %s", name, topic);
+        }
+        return true;
+    }
+
+    // DECLARED: announce ourselves; queued events replay from loop() afterwards
+    if (!link.publish(_topics.status(), "online", true)) return false;
+    if (!_publishDeclare(link)) return false;
+    _logf("INFO", "DEVICE", "%s ready after %lu attempt(s)", name, (unsigned long)link.connectAttempts());
     return true;
 }
 
-bool MeoDevice::_publishDeclare() {
-    if (!_mqtt.isConnected()) return false;
+bool MeoDevice::_mqttSessionThunk(MeoMqttState step, void* ctx) {
+    MeoDevice* self = reinterpret_cast<MeoDevice*>(ctx);
+    return self && self->_onMqttSession(self->_mqtt, step);
+}
+
+bool MeoDevice::_cloudSessionThunk(MeoMqttState step, void* ctx) {
+    MeoDevice* self = reinterpret_cast<MeoDevice*>(ctx);
+    return self && self->_onMqttSession(self->_cloud, step);
+}
+
+void MeoDevice::_cloudStateThunk(MeoMqttState from, MeoMqttState to, uint32_t elapsedMs, void* ctx) {
+    MeoDevice* self = reinterpret_cast<MeoDevice*>(ctx);
+    if (!self) return;
+    self->_trackOutage(self->_cloudOutage, from, to);
+    self->_cloudUp.store(self->_cloud.isConnected(), std::memory_order_relaxed);
+    if (!self->_logger || !self->_debugTagEnabled(MEO_LOG_DEVICE)) return;
+    self->_logf("DEBUG", "DEVICE", "Cloud %s -> %s after %lu ms",
+                meoMqttStateName(from), meoMqttStateName(to), (unsigned long)elapsedMs);
+}
+
+void MeoDevice::_mqttStateThunk(MeoMqttState from, MeoMqttState to, uint32_t elapsedMs, void* ctx) {
+    MeoDevice* self = reinterpret_cast<MeoDevice*>(ctx);
+    if (!self) return;
+    self->_trackOutage(self->_mqttOutage, from, to);
+    self->_mqttUp.store(self->_mqtt.isConnected(), std::memory_order_relaxed);
+    // BLE status only tracks "ready" vs "not ready"
+    if (from == MeoMqttState::DECLARED || to == MeoMqttState::DECLARED) {
+        self->_updateBleStatus();
+    }
+    if (to == MeoMqttState::DECLARED && self->_timeToMqttReadyMs == 0 && self->_wifi.startedMs()) {
+        self->_timeToMqttReadyMs = millis() - self->_wifi.startedMs();
+        self->_logf("INFO", "DEVICE", "Ready: WiFi IP %lu ms, MQTT ready %lu ms",
+                    (unsigned long)self->_wifi.timeToIpMs(), (unsigned long)self->_timeToMqttReadyMs);
+    }
+    if (self->_mqttStateHandler) self->_mqttStateHandler(from, to, elapsedMs);
+}
 
-    std::string base = "meo/";
-    if (_userId.length()) base += _userId + "/";
-    std::string topic = base + _deviceId + "/declare";
-    StaticJsonDocument<1024> doc;
+// Reconnect = back to DECLARED after losing it; duration spans the whole outage
+void MeoDevice::_trackOutage(LinkOutage& outage, MeoMqttState from, MeoMqttState to) {
+    if (from == MeoMqttState::DECLARED) {
+        outage.down = true;
+        outage.sinceMs = millis();
+    } else if (to == MeoMqttState::DECLARED && outage.down) {
+        outage.down = false;
+        _metrics.add(_mid.reconnects);
+        _metrics.record(_mid.reconnectMs, millis() - outage.sinceMs);
+    }
+}
+
+bool MeoDevice::_publishDeclare(MeoMqttClient& link) {
+    if (!link.isConnected() || !_topics.isReady()) return false;
+
+    const char* topic = _topics.declare();
+    // Names are stored as pointers, so the document only needs room for the slots
+    StaticJsonDocument<JSON_OBJECT_SIZE(3) + JSON_OBJECT_SIZE(4)
+                       + JSON_ARRAY_SIZE(MEO_MAX_FEATURE_EVENTS)
+                       + JSON_ARRAY_SIZE(MEO_MAX_FEATURE_METHODS) + 64> doc;
 
     JsonObject info = doc.createNestedObject("device_info");
     info["model"]        = _model ? _model : "";
     info["manufacturer"] = _manufacturer ? _manufacturer : "";
     info["connection"]   = "LAN";
+    info["encoding"]     = meoEncodingName(_encoding);
 
     JsonArray events = doc.createNestedArray("events");
     for (uint8_t i = 0; i < _eventCount; ++i) {
@@ -328,25 +1063,39 @@ bool MeoDevice::_publishDeclare() {
     }
 
     JsonArray methods = doc.createNestedArray("methods");
-    for (uint8_t i = 0; i < _methodCount; ++i) {
-        methods.add(_methodNames[i]);
+    for (size_t i = 0; i < _methods.size(); ++i) {
+        methods.add(_methods.at(i).name);
     }
 
-    char buf[1024];
-    size_t len = serializeJson(doc, buf, sizeof(buf));
-    if (len == 0) return false;
+    if (doc.overflowed()) {
+        _log("ERROR", "DEVICE", "Declare document overflow");
+        return false;
+    }
 
-    if (_logger && _debugTagEnabled("DEVICE")) {
-        _logf("DEBUG", "DEVICE", "Publish declare len=%u", (unsigned)len);
+    if (_logger && _debugTagEnabled(MEO_LOG_DEVICE)) {
+        _logf("DEBUG", "DEVICE", "Publish declare len=%u (%s)",
+              (unsigned)(_encoding == MeoPayloadEncoding::MSGPACK ? measureMsgPack(doc) : measureJson(doc)),
+              meoEncodingName(_encoding));
     }
-    return _mqtt.publish(topic.c_str(), (const uint8_t*)buf, len, false);
+    if (_encoding == MeoPayloadEncoding::MSGPACK) return link.publishMsgPack(topic, doc, false);
+    return link.publishJson(topic, doc, false);
 }
 
 // Static -> instance adapter
 void MeoDevice::_mqttThunk(const char* topic, const uint8_t* payload, unsigned int length, void* ctx) {
     MeoDevice* self = reinterpret_cast<MeoDevice*>(ctx);
     if (!self) return;
+    self->_replyLink = &self->_mqtt;
     self->_dispatchInvoke(topic, payload, length);
+    self->_replyLink = nullptr;
+}
+
+void MeoDevice::_cloudThunk(const char* topic, const uint8_t* payload, unsigned int length, void* ctx) {
+    MeoDevice* self = reinterpret_cast<MeoDevice*>(ctx);
+    if (!self) return;
+    self->_replyLink = &self->_cloud;
+    self->_dispatchInvoke(topic, payload, length);
+    self->_replyLink = nullptr;
 }
 
 void MeoDevice::_dispatchInvoke(const char* topic, const uint8_t* payload, unsigned int length) {
@@ -354,100 +1103,77 @@ void MeoDevice::_dispatchInvoke(const char* topic, const uint8_t* payload, unsig
     // 1) Topic-encoded: meo/{...}/{device_id}/feature/{featureName}/invoke
     // 2) Payload-encoded (cloud-compatible): meo/{...}/{device_id}/feature with JSON { "feature"|"feature_name": "name", "params": {...} }
 
-    char featureName[64] = {0};
-    bool featureFromTopic = false;
+    char topicName[64] = {0};
+    const char* featureName = nullptr;
 
     const char* featureMarker = strstr(topic, "/feature/");
     const char* invokeMarker  = strstr(topic, "/invoke");
     if (featureMarker && invokeMarker && invokeMarker > featureMarker) {
         featureMarker += 9; // strlen("/feature/")
         size_t nameLen = (size_t)(invokeMarker - featureMarker);
-        if (nameLen > 0 && nameLen < sizeof(featureName)) {
-            memcpy(featureName, featureMarker, nameLen);
-            featureName[nameLen] = '\0';
-            featureFromTopic = true;
+        if (nameLen > 0 && nameLen < sizeof(topicName)) {
+            memcpy(topicName, featureMarker, nameLen);
+            featureName = topicName;
         }
     }
 
-    // Parse minimal JSON regardless of form to extract params (and possibly feature name)
+    // PubSubClient builds outgoing packets in the buffer the payload arrived in, so a
+    // handler that publishes would overwrite params still in use: copy once, then parse
+    // the copy in place (strings in the document point into it, no further copies).
+    // Either encoding is accepted whatever setPayloadEncoding() chose.
+    if (length >= sizeof(_invokeScratch)) {
+        _logf("WARN", "DEVICE", "Invoke of %u bytes exceeds MEO_INVOKE_SCRATCH_BYTES", length);
+        if (featureName) sendFeatureResponse(featureName, false, "Params too large");
+        return;
+    }
+    memcpy(_invokeScratch, payload, length);
+    _invokeScratch[length] = '\0';
     StaticJsonDocument<512> doc;
-    DeserializationError err = deserializeJson(doc, payload, length);
-    bool jsonOk = (err == DeserializationError::Ok);
-    if (!jsonOk && !featureFromTopic) return; // if no JSON and feature not in topic, nothing to do
+    DeserializationError err = meoIsMsgPackMap(payload, length) ? deserializeMsgPack(doc, _invokeScratch, length)
+                                                                : deserializeJson(doc, _invokeScratch, length);
+    bool parsed = (err == DeserializationError::Ok);
+    if (!parsed && !featureName) return; // if nothing parsed and feature not in topic, nothing to do
 
     // If payload provides feature name (cloud-compatible form), accept keys "feature" or "feature_name"
-    if (!featureFromTopic && jsonOk) {
-        if (doc.containsKey("feature") && doc["feature"].is<const char*>()) {
-            strncpy(featureName, doc["feature"].as<const char*>(), sizeof(featureName)-1);
-        } else if (doc.containsKey("feature_name") && doc["feature_name"].is<const char*>()) {
-            strncpy(featureName, doc["feature_name"].as<const char*>(), sizeof(featureName)-1);
-        }
+    if (!featureName && parsed) {
+        featureName = doc["feature"].as<const char*>();
+        if (!featureName) featureName = doc["feature_name"].as<const char*>();
     }
 
-    if (featureName[0] == '\0') return; // no feature name discovered
+    if (!featureName || !*featureName) return; // no feature name discovered
+
+    const auto* method = _methods.find(featureName);
 
-    // Build MeoFeatureCall
     MeoFeatureCall call;
-    call.deviceId    = _deviceId;
+    call.deviceId    = _deviceId.c_str();
     call.featureName = featureName;
-
-    // Extract params: prefer explicit "params" object, otherwise include other top-level keys except feature keys
-    if (jsonOk) {
-        if (doc.containsKey("params") && doc["params"].is<JsonObject>()) {
-            for (JsonPair kv : doc["params"].as<JsonObject>()) {
-                call.params[kv.key().c_str()] = kv.value().as<const char*>();
-            }
-        } else {
-            for (JsonPair kv : doc.as<JsonObject>()) {
-                const char* k = kv.key().c_str();
-                if (strcmp(k, "feature") == 0 || strcmp(k, "feature_name") == 0) continue;
-                call.params[k] = kv.value().as<const char*>();
-            }
-        }
+    // Prefer explicit "params" object, otherwise the top-level object
+    if (parsed) {
+        JsonObjectConst params = doc["params"].as<JsonObjectConst>();
+        call.params = params.isNull() ? doc.as<JsonObjectConst>() : params;
+    }
+    MeoParamIndex index;
+    if (method && !(_asyncInvoke || _netTaskRunning)) {
+        index.build(call.params);
+        call.index = &index;
     }
 
-    // Dispatch to registered handler
-    for (uint8_t i = 0; i < _methodCount; ++i) {
-        if (strcmp(featureName, _methodNames[i]) == 0) {
-            if (_logger && _debugTagEnabled("DEVICE")) {
-                _logf("DEBUG", "DEVICE", "Invoke %s with %u params", featureName, (unsigned)call.params.size());
-            }
-            if (_methodHandlers[i]) {
-                _methodHandlers[i](call);
-            }
-            return;
+    if (method) _metrics.add(_invokeMetric[method->order]);
+    if (method && (_asyncInvoke || _netTaskRunning)) {
+        _enqueueInvoke(call, method);
+        return;
+    }
+    if (method) {
+        if (_logger && _debugTagEnabled(MEO_LOG_DEVICE)) {
+            _logf("DEBUG", "DEVICE", "Invoke %s with %u params", featureName, (unsigned)call.params.size());
         }
+        uint32_t t0 = micros();
+        method->handler(call, method->ctx);
+        _metrics.record(_mid.handlerUs, micros() - t0);
+        return;
     }
 
     // No handler: optionally negative response
+    _metrics.add(_mid.unhandled);
     sendFeatureResponse(call, false, "No handler registered");
 }
-
-bool MeoDevice::_debugTagEnabled(const char* tag) const {
-    if (!_debugTags[0]) return false; // no debug tags -> no DEBUG logs
-    // simple substring match in CSV
-    const char* p = strstr(_debugTags, tag);
-    if (!p) return false;
-    // ensure token boundary (start or preceded by comma) and followed by comma or end
-    bool leftOk  = (p == _debugTags) || (*(p - 1) == ',');
-    const char* end = p + strlen(tag);
-    bool rightOk = (*end == '\0') || (*end == ',');
-    return leftOk && rightOk;
-}
-
-void MeoDevice::_log(const char* level, const char* tag, const char* msg) const {
-    if (!_logger) return;
-    char buf[256];
-    snprintf(buf, sizeof(buf), "[%s] %s", tag ? tag : "DEVICE", msg ? msg : "");
-    _logger(level, buf);
-}
-
-void MeoDevice::_logf(const char* level, const char* tag, const char* fmt, ...) const {
-    if (!_logger) return;
-    char msg[192];
-    va_list ap;
-    va_start(ap, fmt);
-    vsnprintf(msg, sizeof(msg), fmt, ap);
-    va_end(ap);
-    _log(level, tag, msg);
-}
\ No newline at end of file
@@ -5,74 +5,243 @@
 #include <string>
 
 #include "Meo3_Type.h"   // MeoFeatureCall, MeoEventPayload, MeoFeatureCallback, MeoConnectionType, MeoLogFunction
+#include "Meo3_BinLog.h" // MeoLogTag, compile-time levels, deferred binary log
+#include "Meo3_Topic.h"  // MeoTopicCache
+#include "Meo3_EventFields.h" // MeoEventFields, MeoStaticEventFields
+#include "feature/Meo3_MethodTable.h" // MeoMethodTable (hashed method dispatch)
+#include "feature/Meo3_InvokeQueue.h" // MeoInvokeQueue (async feature execution)
+#include "feature/Meo3_EventPolicy.h" // MeoEventFilter (deadband / report intervals)
+#include "os/Meo3_Os.h"
+#include "os/Meo3_SpscRing.h"             // MeoSpscRing (network task queues)
+#include "metrics/Meo3_Histogram.h"      // MeoLatencyHistogram
+#include "metrics/Meo3_Metrics.h"        // MeoMetrics (periodic /metrics snapshots)
 #include "storage/Meo3_Storage.h"
+#include "storage/Meo3_LogStore.h"    // MeoLogStore (high-frequency state)
 #include "ble/Meo3_Ble.h"
 #include "provision/Meo3_BleProvision.h"
 #include "mqtt/Meo3_Mqtt.h"              // MeoMqttClient transport
+#include "wifi/Meo3_Wifi.h"              // MeoWifiManager (event-driven station)
+#include "queue/Meo3_EventQueue.h"        // MeoEventQueue (offline store-and-forward)
+#include "queue/Meo3_FlashSpill.h"
+#include "queue/Meo3_EventBatch.h"        // MeoEventBatch (event coalescing)
 
 #ifndef MEO_MAX_FEATURE_EVENTS
 #define MEO_MAX_FEATURE_EVENTS 8
 #endif
 #ifndef MEO_MAX_FEATURE_METHODS
-#define MEO_MAX_FEATURE_METHODS 8
+#define MEO_MAX_FEATURE_METHODS 64
 #endif
+// Largest invoke payload dispatched; it is copied once so handlers may publish freely
+#ifndef MEO_INVOKE_SCRATCH_BYTES
+#define MEO_INVOKE_SCRATCH_BYTES 512
+#endif
+// Network task queues (bytes, power of two): app -> network publishes, network -> app invokes
+#ifndef MEO_NET_TX_RING
+#define MEO_NET_TX_RING 4096
+#endif
+#ifndef MEO_NET_RX_RING
+#define MEO_NET_RX_RING 2048
+#endif
+
+// Observer for MQTT connection state changes (elapsedMs = time spent in `from`)
+typedef void (*MeoMqttStateCallback)(MeoMqttState from, MeoMqttState to, uint32_t elapsedMs);
 
 class MeoDevice {
 public:
     MeoDevice();
+    ~MeoDevice();
 
     // Logging
     void setLogger(MeoLogFunction logger);
-    // CSV of tags to enable DEBUG logs for (e.g. "DEVICE,MQTT,PROV")
+    // CSV of tags to enable DEBUG logs for (e.g. "DEVICE,MQTT,WIFI,PROV")
     void setDebugTags(const char* tagsCsv);
+    // Deferred logging: log calls only record the format pointer, micros() and the raw
+    // arguments in a lock-free ring; loop() formats them to the logger, or with upload
+    // sends compact binary batches to <base>/log (tools/meo_log_decode.py). Call before
+    // start(). DEBUG lines still need a logger set and their tag enabled.
+    void setBinaryLogging(bool enabled, bool upload = false);
+    MeoBinLogStats binaryLogStats() const;
 
     // Device info for declare and BLE RO fields
     void setDeviceInfo(const char* model, const char* manufacturer);
 
-    // Optional: provide WiFi upfront; otherwise BLE provisioning can set it
+    // Optional: provide WiFi upfront; otherwise BLE provisioning can set it.
+    // Returns immediately; the connection comes up from loop().
     void beginWifi(const char* ssid, const char* pass);
 
-    // MQTT broker (gateway)
-    void setGateway(const char* host, uint16_t mqttPort = 1883);
+    // MQTT broker (gateway). AUTO security: TLS on 8883, plain TCP otherwise
+    void setGateway(const char* host, uint16_t mqttPort = 1883,
+                    MeoMqttSecurity security = MeoMqttSecurity::AUTO);
+    // Optional second broker (usually the cloud), connected alongside the gateway.
+    // Both links take invokes and get the declare; events follow their route.
+    // Call before start().
+    void setCloudGateway(const char* host, uint16_t mqttPort = 8883,
+                         MeoMqttSecurity security = MeoMqttSecurity::AUTO);
 
     void setCloudCompatibleInfo(const char* productId, const char* buildInfo);
 
+    // MQTT 5 on both links (falls back to 3.1.1 per broker): event and feature_response
+    // topics become topic aliases, and an invoke carrying a response topic / correlation
+    // data is answered there with the same correlation data
+    void setMqttProtocol(MeoMqttProtocol protocol) {
+        _mqtt.setProtocol(protocol);
+        _cloud.setProtocol(protocol);
+    }
+
+    // Payload encoding on both links (default JSON): events, batches, feature responses and
+    // the declare, whose device_info.encoding names it. Invokes are accepted in either
+    // encoding. On MQTT 5, MessagePack publishes carry Content Type "application/msgpack".
+    // Call before start().
+    void setPayloadEncoding(MeoPayloadEncoding enc);
+    MeoPayloadEncoding payloadEncoding() const { return _encoding; }
+
+    // Derive device_id from this MAC instead of the chip's (simulators running
+    // many devices in one process). Call before start().
+    void setMacAddress(const uint8_t mac[6]);
+
     // Features (simple API)
     bool addFeatureEvent(const char* name);
-    bool addFeatureMethod(const char* name, MeoFeatureCallback cb);
+    // Same, with a reporting policy applied inside publishEvent() (deadbands, min/max
+    // interval, send-on-change); a suppressed event returns true. Copied to the heap once.
+    bool addFeatureEvent(const char* name, const MeoEventPolicy& policy);
+    // Policy counters of one registered event, or summed over all events (nullptr)
+    MeoEventPolicyStats eventPolicyStats(const char* name = nullptr) const;
+    // Route for a registered event when a cloud gateway is set (default EDGE_FIRST)
+    bool setEventRoute(const char* name, MeoEventRoute route);
+    bool addFeatureMethod(const char* name, MeoFeatureHandler fn, void* ctx = nullptr);
+    bool addFeatureMethod(const char* name, MeoFeatureCallback cb); // copies cb to the heap once
+
+    // Async dispatch: invokes are queued (MEO_INVOKE_QUEUE_DEPTH) and run on a worker
+    // task, so slow handlers do not stall MQTT keepalive. Call before start().
+    // Allocates the queue (about 4.5 KB at the defaults); false if out of memory
+    bool enableAsyncInvoke(uint32_t stackBytes = 6144, uint8_t priority = 1, int core = -1);
+    // Max invokes of one feature queued/running/deferred at once (0 = unlimited);
+    // extra invokes get a "Busy" feature_response. Call after enableAsyncInvoke()
+    bool setFeatureConcurrency(const char* name, uint8_t maxInFlight);
+    MeoInvokeStats invokeStats() const { return _invokes ? _invokes->stats() : MeoInvokeStats(); }
+
+    // Threaded mode: a task pinned to `core` owns WiFi/MQTT/TLS. publishEvent() and
+    // sendFeatureResponse() only enqueue; handlers still run from loop() (or the
+    // async worker). MQTT state callbacks then run on the network task. Call before start().
+    // Allocates the two queues (MEO_NET_TX_RING + MEO_NET_RX_RING); false if out of memory
+    bool enableNetworkTask(uint32_t stackBytes = 8192, uint8_t priority = 2, int core = 0);
+    bool networkTaskRunning() const { return _netTaskRunning; }
+
+    // Latency metrics: publishEvent() call time, and (threaded) enqueue -> socket write.
+    // Recorded lock-free from any task; each call moves out the window since the last one
+    void takePublishLatency(MeoLatencyHistogram& out) { _publishLatency.take(out); }
+    void takeTxQueueLatency(MeoLatencyHistogram& out) { _txQueueLatency.take(out); }
+    uint32_t txRingDrops() const { return _txDrops; }
+
+    // Fleet metrics: counters, gauges and histograms recorded lock-free on the hot paths
+    // (publishes, bytes, invokes per feature, handler/loop time, reconnects, heap, RSSI),
+    // published as one JSON snapshot on <base>/metrics every intervalMs (0 = off).
+    // Snapshots are not queued offline. Apps may register their own via metrics().
+    void setMetricsInterval(uint32_t intervalMs) { _metricsIntervalMs = intervalMs; }
+    bool publishMetrics();
+    MeoMetrics& metrics() { return _metrics; }
 
     // Lifecycle
-    bool start();    // Load creds; BLE provisioning if needed; MQTT connect; declare
-    void loop();     // BLE status, MQTT loop, lazy reconnect
+    bool start();    // Load creds; BLE provisioning if needed; arm MQTT auto-connect
+    void loop();     // BLE status, MQTT connect/reconnect (non-blocking), offline replay
+
+    // MQTT reconnect tuning: backoff ceiling doubles per failure from minMs to maxMs
+    void setMqttBackoff(uint32_t minMs, uint32_t maxMs) { _mqtt.setBackoff(minMs, maxMs); }
+    // Upper bound for each blocking connect step (TLS connect, CONNACK wait)
+    void setMqttAttemptBudget(uint32_t ms) { _mqtt.setAttemptBudget(ms); }
+    void setMqttStateHandler(MeoMqttStateCallback cb) { _mqttStateHandler = cb; }
+    // Custom MQTT transport (see MeoMqttClient::setTransport); nullptr = built-in TLS
+    void setMqttTransport(Client* client) { _mqtt.setTransport(client); }
+    MeoMqttState mqttState() const { return _mqtt.state(); }
+    // Socket connect time / heap cost per kind (plain vs TLS), per link
+    const MeoTransportStats& mqttTransportStats(bool tls) const  { return _mqtt.transportStats(tls); }
+    const MeoTransportStats& cloudTransportStats(bool tls) const { return _cloud.transportStats(tls); }
+    // TLS links resume their last session on reconnect. With this on (before start())
+    // the sessions are also kept in NVS, so a reboot resumes too; those keys hold secrets
+    void persistTlsSessions(bool enable) { _persistTls = enable; }
+    // Feature responses at QoS 1 (retransmitted until PUBACK); events stay QoS 0.
+    // Responses that find the inflight window full go to the offline queue.
+    void setResponseQos(uint8_t qos) { _responseQos1 = qos >= 1; }
+    const MeoInflightStats& mqttInflightStats() const  { return _mqtt.inflightStats(); }
+    const MeoInflightStats& cloudInflightStats() const { return _cloud.inflightStats(); }
+    // MQTT bytes written / read on the gateway link
+    uint32_t mqttBytesSent() const     { return _mqtt.bytesSent(); }
+    uint32_t mqttBytesReceived() const { return _mqtt.bytesReceived(); }
+    uint32_t mqttConnectAttempts() const { return _mqtt.connectAttempts(); }
+
+    // Bring-up metrics, measured from the WiFi connect request (0 until reached)
+    uint32_t wifiTimeToIpMs() const    { return _wifi.timeToIpMs(); }
+    uint32_t timeToMqttReadyMs() const { return _timeToMqttReadyMs; }
+    bool     wifiFastReconnect() const { return _wifi.fastConnectUsed(); }
 
     // Publish helpers
+    // Typed fields (preferred): no heap, numbers/bools emitted as JSON literals
+    bool publishEvent(const char* eventName, const MeoEventFields& fields);
+    // String-valued compatibility overloads (values emitted as JSON strings)
     bool publishEvent(const char* eventName,
                       const char* const* keys,
                       const char* const* values,
                       uint8_t count);
     bool publishEvent(const char* eventName, const MeoEventPayload& payload);
 
-    // Send feature response
+    // Batching: EDGE_FIRST events are collected into one JSON array on <base>/event/batch,
+    // each entry {"event","ts" (ms since boot),"data"}. A batch goes out when the oldest
+    // event is windowMs old (checked in loop()), when the next event would exceed
+    // maxBytes, or on flush(). windowMs = 0 turns batching off (pending events are flushed).
+    void setEventBatching(uint32_t windowMs, size_t maxBytes = MEO_EVENT_BATCH_BYTES);
+    bool flush();
+    const MeoEventBatchStats& eventBatchStats() const { return _batchStats; }
+
+    // Offline store-and-forward: while MQTT is down, events and feature responses
+    // are queued (publish calls return true) and replayed in order after reconnect.
+    // replayPerSecond = 0 replays everything on the first connected loop().
+    void setOfflineQueue(bool enabled,
+                         MeoQueuePolicy policy = MeoQueuePolicy::DROP_OLDEST,
+                         uint16_t replayPerSecond = 10);
+    // Spill RAM overflow to a flash data partition (see partitions_meo.csv); ESP32 only
+    bool enableOfflineSpill(const char* partitionLabel = "meolog");
+    MeoQueueStats offlineQueueStats() const { return _queue.stats(); }
+
+    // Send feature response. `token` (from call.defer()) finishes that deferred invoke;
+    // 0 leaves the async accounting alone (inline answers, rejections)
     bool sendFeatureResponse(const char* featureName,
                              bool success,
-                             const char* message);
+                             const char* message,
+                             uint32_t token = 0);
     bool sendFeatureResponse(const MeoFeatureCall& call,
                              bool success,
                              const char* message);
 
     // Status
     bool hasCredentials() const { return _deviceId.length() && _transmitKey.length(); }
-    bool isMqttConnected() { return _mqtt.isConnected(); }
+    // Settings are cached in RAM and written to NVS by loop() in batches;
+    // commitStorage() writes pending changes now (e.g. before ESP.restart())
+    bool commitStorage() { return _storage.commit(); }
+    MeoStorageStats storageStats() const { return _storage.stats(); }
+    // Wear-leveled store for values saved every few seconds (energy totals,
+    // positions) on its own data partition (see partitions_meo.csv); compacted by loop().
+    // Host builds keep it in $MEO_NATIVE_NVS/<label>.flash
+    bool enableStateStore(const char* partitionLabel = "meostate");
+    MeoLogStore& stateStore() { return _state; }
+    // Safe from any task: the task that owns the links publishes their state
+    bool isMqttConnected() const { return _mqttUp.load(std::memory_order_relaxed); }
+    bool isCloudConnected() const { return _cloudUp.load(std::memory_order_relaxed); }
+    MeoMqttState cloudMqttState() const { return _cloud.state(); }
 
 private:
+    // src/bench drives the private declare/dispatch paths directly
+    friend class MeoBench;
+
     // Config
     const char* _model;
     const char* _manufacturer;
 
-    const char* _wifiSsid;
-    const char* _wifiPass;
     const char* _gatewayHost;
     uint16_t    _mqttPort = 1883;
+    MeoMqttSecurity _mqttSecurity = MeoMqttSecurity::AUTO;
+    const char* _cloudHost = nullptr;
+    uint16_t    _cloudPort = 8883;
+    MeoMqttSecurity _cloudSecurity = MeoMqttSecurity::AUTO;
 
     // Identity (from BLE/app)
     std::string  _deviceId;
@@ -80,38 +249,169 @@ private:
     std::string  _transmitKey;
     bool         _cloudCompatible = false; // true when cloud-compatible product/build info set
 
+    // Topics (built once identity is known)
+    MeoTopicCache _topics;
+
     // Registries (simple arrays)
     const char* _eventNames[MEO_MAX_FEATURE_EVENTS];
+    char        _eventTopics[MEO_MAX_FEATURE_EVENTS][MEO_TOPIC_MAX_LEN];
+    MeoEventRoute _eventRoutes[MEO_MAX_FEATURE_EVENTS];
+    MeoEventFilter* _eventFilters[MEO_MAX_FEATURE_EVENTS] = {nullptr}; // events with a policy
     uint8_t     _eventCount = 0;
+    MeoMutex    _filterLock; // held across check -> publish -> commit
 
-    const char*        _methodNames[MEO_MAX_FEATURE_METHODS];
-    MeoFeatureCallback _methodHandlers[MEO_MAX_FEATURE_METHODS];
-    uint8_t            _methodCount = 0;
+    MeoMethodTable<MeoFeatureHandler, MEO_MAX_FEATURE_METHODS> _methods;
 
     // Modules
     MeoStorage      _storage;
+    MeoLogStore     _state;
+#if defined(ESP_PLATFORM)
+    MeoPartitionFlash _stateFlash;
+#else
+    MeoFileFlash    _stateFlash;
+#endif
     MeoBle          _ble;
     MeoBleProvision _prov;
-    MeoMqttClient   _mqtt;
+    MeoMqttClient   _mqtt;   // gateway (edge) link
+    MeoMqttClient   _cloud;  // optional second link, see setCloudGateway()
+    MeoMqttClient*  _replyLink = nullptr; // link of the invoke being handled inline
+    // Invoke being dispatched, copied out of PubSubClient's buffer (which publishing
+    // reuses); MeoFeatureCall views point here. Only touched under _txLock.
+    char            _invokeScratch[MEO_INVOKE_SCRATCH_BYTES];
+    bool            _responseQos1 = false;
+    bool            _persistTls = false;
+    MeoPayloadEncoding _encoding = MeoPayloadEncoding::JSON;
+
+    // Offline queue
+    MeoEventQueue _queue;
+    MeoFlashSpill _spill;
+#if defined(ESP_PLATFORM)
+    MeoPartitionFlash _spillFlash;
+#endif
+    bool          _queueEnabled = true;
+
+    // Async invoke worker; _txLock serializes MQTT use between loop() and the worker
+    MeoInvokeQueue* _invokes = nullptr; // allocated by enableAsyncInvoke()
+    bool           _asyncInvoke = false;
+    MeoMutex       _txLock;
+
+    // Network task (threaded mode)
+    bool     _netTaskWanted = false;
+    volatile bool _netTaskRunning = false;
+    uint32_t _netStackBytes = 8192;
+    uint8_t  _netPriority = 2;
+    int      _netCore = 0;
+    static constexpr size_t TX_HEAD = sizeof(uint32_t) + 1; // tx record: micros + route
+    static constexpr uint8_t TX_QOS1 = 0x80;                // route byte flag
+    // Allocated by enableNetworkTask(): inline mode does not carry them
+    MeoSpscRing<MEO_NET_TX_RING>* _txRing = nullptr; // [u32 micros][u8 route|qos][topic\0][payload]
+    MeoSpscRing<MEO_NET_RX_RING>* _rxRing = nullptr; // [method*][feature\0][params]
+    MeoMutex _txProduceLock;                // app + invoke worker may both publish
+    uint32_t _txDrops = 0;
+    MeoMetricHistogram _publishLatency;     // app, invoke worker and net task all publish
+    MeoMetricHistogram _txQueueLatency;
+    // Link state as last seen by the task running _mqttStep(); read by any task
+    std::atomic<bool> _mqttUp{false};
+    std::atomic<bool> _cloudUp{false};
+    MeoMutex _statusLock;                   // BLE runtime status: app and net task update it
+
+    // Metrics registry and the ids of the built-in metrics
+    MeoMetrics _metrics;
+    struct MetricIds {
+        MeoMetricId uptime, publishOk, publishFailed, bytesOut, bytesIn, reconnects;
+        MeoMetricId freeHeap, largestBlock, rssi, unhandled, dropped, handlerUs, reconnectMs, loopUs;
+    } _mid;
+    MeoMetricId _invokeMetric[MEO_MAX_FEATURE_METHODS]; // per method, registration order
+    uint32_t    _metricsIntervalMs = 0;
+    uint32_t    _metricsLastMs = 0;
+    struct LinkOutage {
+        bool     down = false; // was DECLARED, not back yet
+        uint32_t sinceMs = 0;
+    };
+    LinkOutage  _mqttOutage;
+    LinkOutage  _cloudOutage;
+
+    // Event batching; _batchLock is taken before _txLock, never after
+    MeoEventBatch _batch;
+    uint32_t      _batchWindowMs = 0;
+    char          _batchTopic[MEO_TOPIC_MAX_LEN] = {0};
+    MeoMutex      _batchLock;
+    MeoEventBatchStats _batchStats;
+    uint16_t      _replayPerSecond = 10;
+    uint32_t      _replayLastMs = 0;
 
     // State
-    bool _wifiReady = false;
+    MeoWifiManager _wifi;
+    uint32_t _timeToMqttReadyMs = 0;
+    wl_status_t _lastWifiStatus = WL_IDLE_STATUS; // last status pushed to BLE
+    uint8_t  _mac[6] = {0};
+    bool     _macOverride = false;
 
     // Logging
-    MeoLogFunction _logger = nullptr;
-    char           _debugTags[96] = {0}; // CSV list of enabled DEBUG tags
+    MeoLogFunction  _logger = nullptr;
+    uint32_t        _debugMask = 0;       // MeoLogTag bits, resolved by setDebugTags()
+    MeoBinLog*      _binLog = nullptr;    // deferred mode: log calls go to this ring
+    MeoBinLogBatch* _logBatch = nullptr;  // upload mode: batch being filled
+    uint32_t        _logBatchMs = 0;      // millis() of its first record
+    uint32_t        _logDropsSent = 0;    // ring drops already reported upstream
+    MeoBinLogStats  _logStats;            // upload counters
 
     // Internals
     void _updateBleStatus();
-    bool _connectMqttAndDeclare();
-    bool _publishDeclare();
+    bool _buildTopics();
+    const char* _eventTopic(const char* eventName, char* scratch, size_t scratchLen,
+                            MeoEventRoute& route) const;
+    MeoMqttStateCallback _mqttStateHandler = nullptr;
+
+    void _configureMqtt();
+    void _configureLink(MeoMqttClient& link, const char* host, uint16_t port, MeoMqttSecurity security);
+    bool _onMqttSession(MeoMqttClient& link, MeoMqttState step);
+    static bool _mqttSessionThunk(MeoMqttState step, void* ctx);
+    static bool _cloudSessionThunk(MeoMqttState step, void* ctx);
+    static void _mqttStateThunk(MeoMqttState from, MeoMqttState to, uint32_t elapsedMs, void* ctx);
+    static void _cloudStateThunk(MeoMqttState from, MeoMqttState to, uint32_t elapsedMs, void* ctx);
+    bool _publishDeclare(MeoMqttClient& link);
+    MeoEventFilter* _eventFilter(const char* eventName) const;
+    bool _sendEvent(const char* eventName, const char* topic, MeoEventRoute route, const MeoEventFields& fields);
+    bool _publishOrQueue(const char* topic, const MeoEventFields& fields,
+                         MeoEventRoute route = MeoEventRoute::EDGE_FIRST, bool qos1 = false);
+    bool _publishOrQueueRaw(const char* topic, const uint8_t* payload, size_t len, MeoEventRoute route);
+    bool _batchEvent(const char* eventName, const MeoEventFields& fields, bool& ok);
+    bool _flushBatch();
+    void _drainBinLog();
+    bool _uploadBinLog();
+    bool _publishUnqueued(const char* topic, const uint8_t* payload, size_t len);
+    void _trackOutage(LinkOutage& outage, MeoMqttState from, MeoMqttState to);
+    bool _anyLinkUp();
+    bool _publishRouted(MeoEventRoute route, const char* topic, const MeoEventFields* fields,
+                        const uint8_t* payload, size_t len, bool qos1 = false);
+    void _replayQueued();
+    static void _callbackThunk(const MeoFeatureCall& call, void* ctx);
+    static void _invokeWorker(void* ctx);
+    bool _runInvoke(const void* key, const char* feature, char* params, size_t paramsLen, uint32_t token = 0);
+    bool _enqueueInvoke(const MeoFeatureCall& call, const void* method);
+    static void _netTask(void* ctx);
+    void _netStep();
+    void _mqttStep();
+    bool _enqueueTx(const char* topic, const MeoEventFields& fields, MeoEventRoute route, bool qos1);
+    bool _enqueueTxRaw(const char* topic, const uint8_t* payload, size_t len, MeoEventRoute route, bool qos1);
+    void _drainTxRing();
+    void _drainRxRing();
+    static bool _queueSendThunk(const char* topic, const uint8_t* payload, size_t len, void* ctx);
 
     // MQTT message adapter: parse invoke and dispatch MeoFeatureCall
     static void _mqttThunk(const char* topic, const uint8_t* payload, unsigned int length, void* ctx);
+    static void _cloudThunk(const char* topic, const uint8_t* payload, unsigned int length, void* ctx);
     void _dispatchInvoke(const char* topic, const uint8_t* payload, unsigned int length);
 
     // Logging helpers
-    bool _debugTagEnabled(const char* tag) const;
-    void _log(const char* level, const char* tag, const char* msg) const;
-    void _logf(const char* level, const char* tag, const char* fmt, ...) const;
+    bool _debugTagEnabled(uint32_t tag) const { return meoLogDebugOn(_debugMask, tag); }
+    void _log(const char* level, const char* tag, const char* msg) const {
+        if (meoLogCompiled(level) && _logger) meoLogEmitMsg(_logger, _binLog, level, tag ? tag : "DEVICE", msg);
+    }
+    // Template so a level below MEO_LOG_LEVEL removes the call with its arguments
+    template <typename... Args>
+    void _logf(const char* level, const char* tag, const char* fmt, Args... args) const {
+        if (meoLogCompiled(level) && _logger) meoLogEmit(_logger, _binLog, level, tag ? tag : "DEVICE", fmt, args...);
+    }
 };
\ No newline at end of file
@@ -0,0 +1,258 @@
+#include "Meo3_EventFields.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+// Bounded buffer sink; with a null buffer it only counts bytes
+struct BufferSink {
+    char*  buf;
+    size_t cap;
+    size_t len = 0;
+    bool   overflow = false;
+
+    BufferSink(char* b, size_t c) : buf(b), cap(c) {}
+
+    void put(const char* s, size_t n) {
+        if (buf) {
+            if (len + n > cap) { overflow = true; return; }
+            memcpy(buf + len, s, n);
+        }
+        len += n;
+    }
+    void put(char c) { put(&c, 1); }
+};
+
+// Forwards to a caller-provided streaming sink
+struct StreamSink {
+    MeoByteSink& target;
+    size_t       len = 0;
+
+    explicit StreamSink(MeoByteSink& t) : target(t) {}
+
+    void put(const char* s, size_t n) { target.append(s, n); len += n; }
+    void put(char c) { put(&c, 1); }
+};
+
+template <typename Sink>
+void emitInt(Sink& out, long long v) {
+    char tmp[21];
+    char* p = tmp + sizeof(tmp);
+    unsigned long long u = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+    do { *--p = (char)('0' + (u % 10)); u /= 10; } while (u);
+    if (v < 0) *--p = '-';
+    out.put(p, (size_t)(tmp + sizeof(tmp) - p));
+}
+
+template <typename Sink>
+void emitFloat(Sink& out, float v) {
+    if (isnan(v) || isinf(v)) { out.put("null", 4); return; }
+    char tmp[24];
+    int n = snprintf(tmp, sizeof(tmp), "%.7g", (double)v);
+    if (n > 0) out.put(tmp, (size_t)n);
+}
+
+template <typename Sink>
+void emitString(Sink& out, const char* s) {
+    static const char hex[] = "0123456789abcdef";
+    out.put('"');
+    const char* run = s;
+    for (; *s; ++s) {
+        unsigned char c = (unsigned char)*s;
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        out.put(run, (size_t)(s - run));
+        run = s + 1;
+        switch (c) {
+            case '"':  out.put("\\\"", 2); break;
+            case '\\': out.put("\\\\", 2); break;
+            case '\n': out.put("\\n", 2);  break;
+            case '\r': out.put("\\r", 2);  break;
+            case '\t': out.put("\\t", 2);  break;
+            default: {
+                char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0F]};
+                out.put(esc, sizeof(esc));
+            }
+        }
+    }
+    out.put(run, (size_t)(s - run));
+    out.put('"');
+}
+
+template <typename Sink>
+void emitObject(Sink& out, const MeoEventFields& fields) {
+    out.put('{');
+    for (uint8_t i = 0; i < fields.count(); ++i) {
+        const MeoEventField& f = fields.at(i);
+        if (i) out.put(',');
+        emitString(out, f.key);
+        out.put(':');
+        switch (f.type) {
+            case MeoEventField::INT:   emitInt(out, f.i); break;
+            case MeoEventField::FLOAT: emitFloat(out, f.f); break;
+            case MeoEventField::BOOL:  f.b ? out.put("true", 4) : out.put("false", 5); break;
+            case MeoEventField::STRING:
+                if (f.s) emitString(out, f.s);
+                else     out.put("null", 4);
+                break;
+        }
+    }
+    out.put('}');
+}
+
+// ---- MessagePack ----
+
+// Tag byte followed by the low `bytes` bytes of v, big-endian
+template <typename Sink>
+void mpTagged(Sink& out, uint8_t tag, uint64_t v, int bytes) {
+    char tmp[9];
+    tmp[0] = (char)tag;
+    for (int i = 0; i < bytes; ++i) tmp[1 + i] = (char)(v >> (8 * (bytes - 1 - i)));
+    out.put(tmp, (size_t)bytes + 1);
+}
+
+template <typename Sink>
+void mpInt(Sink& out, long long v) {
+    if (v >= 0) {
+        uint64_t u = (uint64_t)v;
+        if (u < 0x80)             out.put((char)u);                 // positive fixint
+        else if (u <= 0xFF)       mpTagged(out, 0xCC, u, 1);
+        else if (u <= 0xFFFF)     mpTagged(out, 0xCD, u, 2);
+        else if (u <= 0xFFFFFFFF) mpTagged(out, 0xCE, u, 4);
+        else                      mpTagged(out, 0xCF, u, 8);
+        return;
+    }
+    if (v >= -32)              out.put((char)(int8_t)v);            // negative fixint
+    else if (v >= -128)        mpTagged(out, 0xD0, (uint64_t)v, 1);
+    else if (v >= -32768)      mpTagged(out, 0xD1, (uint64_t)v, 2);
+    else if (v >= -2147483648LL) mpTagged(out, 0xD2, (uint64_t)v, 4);
+    else                       mpTagged(out, 0xD3, (uint64_t)v, 8);
+}
+
+template <typename Sink>
+void mpFloat(Sink& out, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    mpTagged(out, 0xCA, bits, 4);
+}
+
+template <typename Sink>
+void mpString(Sink& out, const char* s) {
+    size_t n = strlen(s);
+    if (n < 32)           out.put((char)(0xA0 | n));
+    else if (n <= 0xFF)   mpTagged(out, 0xD9, n, 1);
+    else if (n <= 0xFFFF) mpTagged(out, 0xDA, n, 2);
+    else                  mpTagged(out, 0xDB, n, 4);
+    out.put(s, n);
+}
+
+template <typename Sink>
+void mpObject(Sink& out, const MeoEventFields& fields) {
+    uint8_t n = fields.count();
+    if (n < 16) out.put((char)(0x80 | n));
+    else        mpTagged(out, 0xDE, n, 2);
+    for (uint8_t i = 0; i < n; ++i) {
+        const MeoEventField& f = fields.at(i);
+        mpString(out, f.key);
+        switch (f.type) {
+            case MeoEventField::INT:   mpInt(out, f.i); break;
+            case MeoEventField::FLOAT: mpFloat(out, f.f); break;
+            case MeoEventField::BOOL:  out.put((char)(f.b ? 0xC3 : 0xC2)); break;
+            case MeoEventField::STRING:
+                if (f.s) mpString(out, f.s);
+                else     out.put((char)0xC0);
+                break;
+        }
+    }
+}
+
+} // namespace
+
+MeoEventField* MeoEventFields::_next(const char* key, MeoEventField::Type type) {
+    if (!key || _count >= _capacity) return nullptr;
+    MeoEventField* f = &_fields[_count++];
+    f->key  = key;
+    f->type = type;
+    return f;
+}
+
+bool MeoEventFields::add(const char* key, long long value) {
+    MeoEventField* f = _next(key, MeoEventField::INT);
+    if (!f) return false;
+    f->i = value;
+    return true;
+}
+
+bool MeoEventFields::add(const char* key, float value) {
+    MeoEventField* f = _next(key, MeoEventField::FLOAT);
+    if (!f) return false;
+    f->f = value;
+    return true;
+}
+
+bool MeoEventFields::add(const char* key, bool value) {
+    MeoEventField* f = _next(key, MeoEventField::BOOL);
+    if (!f) return false;
+    f->b = value;
+    return true;
+}
+
+bool MeoEventFields::add(const char* key, const char* value) {
+    MeoEventField* f = _next(key, MeoEventField::STRING);
+    if (!f) return false;
+    f->s = value;
+    return true;
+}
+
+size_t MeoEventFields::measureJson() const {
+    BufferSink counter(nullptr, 0);
+    emitObject(counter, *this);
+    return counter.len;
+}
+
+size_t MeoEventFields::serializeJson(char* out, size_t outLen) const {
+    if (!out || outLen == 0) return 0;
+    BufferSink sink(out, outLen - 1); // keep room for NUL
+    emitObject(sink, *this);
+    if (sink.overflow) { out[0] = '\0'; return 0; }
+    out[sink.len] = '\0';
+    return sink.len;
+}
+
+size_t MeoEventFields::writeJson(MeoByteSink& sink) const {
+    StreamSink out(sink);
+    emitObject(out, *this);
+    return out.len;
+}
+
+size_t MeoEventFields::measureMsgPack() const {
+    BufferSink counter(nullptr, 0);
+    mpObject(counter, *this);
+    return counter.len;
+}
+
+size_t MeoEventFields::serializeMsgPack(uint8_t* out, size_t outLen) const {
+    if (!out || outLen == 0) return 0;
+    BufferSink sink(reinterpret_cast<char*>(out), outLen);
+    mpObject(sink, *this);
+    return sink.overflow ? 0 : sink.len;
+}
+
+size_t MeoEventFields::writeMsgPack(MeoByteSink& sink) const {
+    StreamSink out(sink);
+    mpObject(out, *this);
+    return out.len;
+}
+
+size_t MeoEventFields::measure(MeoPayloadEncoding enc) const {
+    return enc == MeoPayloadEncoding::MSGPACK ? measureMsgPack() : measureJson();
+}
+
+size_t MeoEventFields::serialize(MeoPayloadEncoding enc, uint8_t* out, size_t outLen) const {
+    if (enc == MeoPayloadEncoding::MSGPACK) return serializeMsgPack(out, outLen);
+    return serializeJson(reinterpret_cast<char*>(out), outLen);
+}
+
+size_t MeoEventFields::write(MeoPayloadEncoding enc, MeoByteSink& sink) const {
+    return enc == MeoPayloadEncoding::MSGPACK ? writeMsgPack(sink) : writeJson(sink);
+}
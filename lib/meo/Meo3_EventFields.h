@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MEO_MAX_EVENT_FIELDS
+#define MEO_MAX_EVENT_FIELDS 16
+#endif
+
+// Wire encoding of structured payloads (events, declare, responses, invokes)
+enum class MeoPayloadEncoding : uint8_t {
+    JSON = 0,
+    MSGPACK    // MessagePack: same maps and keys, binary numbers, no escaping
+};
+
+// Name announced in the declare's device_info.encoding
+inline const char* meoEncodingName(MeoPayloadEncoding enc) {
+    return enc == MeoPayloadEncoding::MSGPACK ? "msgpack" : "json";
+}
+// MQTT 5 Content Type property
+inline const char* meoContentType(MeoPayloadEncoding enc) {
+    return enc == MeoPayloadEncoding::MSGPACK ? "application/msgpack" : "application/json";
+}
+// A MessagePack map starts with 0x80-0x8f, 0xde or 0xdf; a JSON object with '{' or whitespace
+inline bool meoIsMsgPackMap(const uint8_t* payload, size_t len) {
+    return len && ((payload[0] & 0xF0) == 0x80 || payload[0] == 0xDE || payload[0] == 0xDF);
+}
+
+// One typed event field; keys and string values are borrowed, not copied
+struct MeoEventField {
+    enum Type : uint8_t { INT, FLOAT, BOOL, STRING };
+
+    const char* key;
+    Type        type;
+    union {
+        int64_t     i;
+        float       f;
+        bool        b;
+        const char* s;
+    };
+};
+
+// Byte sink for streaming serialization (e.g. straight into an MQTT publish)
+class MeoByteSink {
+public:
+    virtual ~MeoByteSink() {}
+    virtual void append(const char* data, size_t len) = 0;
+};
+
+/**
+ * MeoEventFields: fixed-capacity typed event payload.
+ * - No heap: fields live in the storage of MeoStaticEventFields<N>
+ * - Numbers and booleans are emitted as JSON numbers/literals, strings are escaped
+ * - MessagePack output is the same map: ints in the smallest type, floats as float 32
+ * - Keys and string values must stay valid until the event is published
+ *
+ *   MeoStaticEventFields<2> ev;
+ *   ev.add("temperature", 23.5f);
+ *   ev.add("humidity", 51);
+ *   meo.publishEvent("humid_temp_update", ev);
+ */
+class MeoEventFields {
+public:
+    MeoEventFields(const MeoEventFields&) = delete;
+    MeoEventFields& operator=(const MeoEventFields&) = delete;
+
+    // Returns false when the builder is full or key is null
+    bool add(const char* key, int value)           { return add(key, (long long)value); }
+    bool add(const char* key, unsigned int value)  { return add(key, (long long)value); }
+    bool add(const char* key, long value)          { return add(key, (long long)value); }
+    bool add(const char* key, unsigned long value) { return add(key, (long long)value); }
+    bool add(const char* key, long long value);
+    bool add(const char* key, float value);
+    bool add(const char* key, double value)        { return add(key, (float)value); }
+    bool add(const char* key, bool value);
+    bool add(const char* key, const char* value);  // nullptr is emitted as JSON null
+
+    void    clear()          { _count = 0; }
+    uint8_t count() const    { return _count; }
+    uint8_t capacity() const { return _capacity; }
+    const MeoEventField& at(uint8_t i) const { return _fields[i]; }
+
+    // JSON object size in bytes (without NUL)
+    size_t measureJson() const;
+    // Write the JSON object into `out` (NUL-terminated); returns 0 if it does not fit
+    size_t serializeJson(char* out, size_t outLen) const;
+    // Stream the JSON object into `sink`; returns bytes written (== measureJson())
+    size_t writeJson(MeoByteSink& sink) const;
+
+    // MessagePack map size, serialization (no NUL; 0 if it does not fit) and streaming
+    size_t measureMsgPack() const;
+    size_t serializeMsgPack(uint8_t* out, size_t outLen) const;
+    size_t writeMsgPack(MeoByteSink& sink) const;
+
+    // Either encoding (JSON output is NUL-terminated, so needs one spare byte)
+    size_t measure(MeoPayloadEncoding enc) const;
+    size_t serialize(MeoPayloadEncoding enc, uint8_t* out, size_t outLen) const;
+    size_t write(MeoPayloadEncoding enc, MeoByteSink& sink) const;
+
+protected:
+    MeoEventFields(MeoEventField* storage, uint8_t capacity)
+        : _fields(storage), _capacity(capacity) {}
+
+private:
+    MeoEventField* _fields;
+    uint8_t        _capacity;
+    uint8_t        _count = 0;
+
+    MeoEventField* _next(const char* key, MeoEventField::Type type);
+};
+
+template <uint8_t N = MEO_MAX_EVENT_FIELDS>
+class MeoStaticEventFields : public MeoEventFields {
+public:
+    MeoStaticEventFields() : MeoEventFields(_storage, N) {}
+
+private:
+    MeoEventField _storage[N];
+};
@@ -0,0 +1,80 @@
+#include "Meo3_Log.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+struct TagName {
+    const char* name;
+    uint32_t    bit;
+};
+
+const TagName TAGS[] = {
+    {"DEVICE", MEO_LOG_DEVICE},
+    {"MQTT",   MEO_LOG_MQTT},
+    {"WIFI",   MEO_LOG_WIFI},
+    {"PROV",   MEO_LOG_PROV},
+};
+
+uint32_t defaultMask = 0;
+
+uint32_t tagBit(const char* tag, size_t len) {
+    for (const TagName& t : TAGS) {
+        if (strlen(t.name) == len && strncmp(t.name, tag, len) == 0) return t.bit;
+    }
+    return 0;
+}
+
+} // namespace
+
+uint32_t meoLogTagMask(const char* tagsCsv) {
+    uint32_t mask = 0;
+    if (!tagsCsv) return 0;
+    const char* p = tagsCsv;
+    while (*p) {
+        while (*p == ' ') ++p;
+        const char* end = p;
+        while (*end && *end != ',') ++end;
+        const char* last = end;
+        while (last > p && last[-1] == ' ') --last;
+        mask |= tagBit(p, (size_t)(last - p));
+        p = *end ? end + 1 : end;
+    }
+    return mask;
+}
+
+uint32_t meoLogTagBit(const char* tag) {
+    return tag ? tagBit(tag, strlen(tag)) : 0;
+}
+
+void meoLog(const MeoLogFunction& logger, const char* level, const char* tag, const char* msg) {
+    if (!logger) return;
+    char line[MEO_LOG_LINE_BYTES];
+    snprintf(line, sizeof(line), "[%s] %s", tag ? tag : "", msg ? msg : "");
+    logger(level, line);
+}
+
+void meoLogf(const MeoLogFunction& logger, const char* level, const char* tag, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    meoLogv(logger, level, tag, fmt, ap);
+    va_end(ap);
+}
+
+void meoLogv(const MeoLogFunction& logger, const char* level, const char* tag, const char* fmt, va_list ap) {
+    if (!logger) return;
+    // Prefix and message share one buffer: no second copy
+    char line[MEO_LOG_LINE_BYTES];
+    int n = snprintf(line, sizeof(line), "[%s] ", tag ? tag : "");
+    if (n < 0) return;
+    if ((size_t)n < sizeof(line)) vsnprintf(line + n, sizeof(line) - (size_t)n, fmt ? fmt : "", ap);
+    logger(level, line);
+}
+
+void meoLogSetDefaultTags(uint32_t mask) {
+    defaultMask = mask;
+}
+
+uint32_t meoLogDefaultTags() {
+    return defaultMask;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stdint.h>
+#include "Meo3_Type.h" // MeoLogFunction
+
+// Compile-time floor: calls below MEO_LOG_LEVEL are removed by the compiler,
+// format strings included. Release builds: -D MEO_LOG_LEVEL=MEO_LOG_LEVEL_INFO
+#define MEO_LOG_LEVEL_DEBUG 0
+#define MEO_LOG_LEVEL_INFO  1
+#define MEO_LOG_LEVEL_WARN  2
+#define MEO_LOG_LEVEL_ERROR 3
+#define MEO_LOG_LEVEL_NONE  4
+
+#ifndef MEO_LOG_LEVEL
+#ifdef NDEBUG
+#define MEO_LOG_LEVEL MEO_LOG_LEVEL_INFO
+#else
+#define MEO_LOG_LEVEL MEO_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+// One formatted line: "[TAG] message", truncated beyond this
+#ifndef MEO_LOG_LINE_BYTES
+#define MEO_LOG_LINE_BYTES 224
+#endif
+
+// DEBUG tag bits; setDebugTags() turns its CSV into a mask once
+enum MeoLogTag : uint32_t {
+    MEO_LOG_DEVICE = 1u << 0,
+    MEO_LOG_MQTT   = 1u << 1,
+    MEO_LOG_WIFI   = 1u << 2,
+    MEO_LOG_PROV   = 1u << 3,
+};
+
+// "DEBUG"/"INFO"/"WARN"/"ERROR" by first letter; anything else counts as ERROR
+constexpr int meoLogLevelOf(const char* level) {
+    return !level ? MEO_LOG_LEVEL_ERROR
+         : level[0] == 'D' ? MEO_LOG_LEVEL_DEBUG
+         : level[0] == 'I' ? MEO_LOG_LEVEL_INFO
+         : level[0] == 'W' ? MEO_LOG_LEVEL_WARN
+         : MEO_LOG_LEVEL_ERROR;
+}
+
+inline const char* meoLogLevelName(int level) {
+    switch (level) {
+        case MEO_LOG_LEVEL_DEBUG: return "DEBUG";
+        case MEO_LOG_LEVEL_INFO:  return "INFO";
+        case MEO_LOG_LEVEL_WARN:  return "WARN";
+        default:                  return "ERROR";
+    }
+}
+
+// Folds to a constant for a string literal, so dead calls drop out
+constexpr bool meoLogCompiled(const char* level) {
+    return MEO_LOG_LEVEL == MEO_LOG_LEVEL_DEBUG || meoLogLevelOf(level) >= MEO_LOG_LEVEL;
+}
+
+// DEBUG for tag compiled in and enabled in mask; constant false in release builds
+constexpr bool meoLogDebugOn(uint32_t mask, uint32_t tag) {
+    return MEO_LOG_LEVEL == MEO_LOG_LEVEL_DEBUG && (mask & tag) != 0;
+}
+
+/**
+ * Shared logging core behind every component's _log/_logf and Meo3_Logger.h.
+ * - Level gating is compile time (meoLogCompiled), DEBUG tag gating is one AND
+ *   against the mask from meoLogTagMask(), both done by the caller before formatting
+ * - meoLogf formats once into a single MEO_LOG_LINE_BYTES stack buffer
+ */
+uint32_t meoLogTagMask(const char* tagsCsv); // unknown names are ignored
+uint32_t meoLogTagBit(const char* tag);      // 0 for an unknown tag
+
+void meoLog(const MeoLogFunction& logger, const char* level, const char* tag, const char* msg);
+void meoLogf(const MeoLogFunction& logger, const char* level, const char* tag, const char* fmt, ...);
+void meoLogv(const MeoLogFunction& logger, const char* level, const char* tag, const char* fmt, va_list ap);
+
+// Mask used by MeoLog/MeoLogf (Meo3_Logger.h); MeoDevice::setDebugTags() sets it too
+void     meoLogSetDefaultTags(uint32_t mask);
+uint32_t meoLogDefaultTags();
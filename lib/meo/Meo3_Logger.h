@@ -1,21 +1,32 @@
+#pragma once
+
 #include <Arduino.h>
-#include <WiFi.h>
-#include <string>
+#include "Meo3_Log.h"
 
-void MeoLog(const char* level, const char* tag, const char* msg) {
-    char buf[256];
-    snprintf(buf, sizeof(buf), "[%s] %s", tag ? tag : "DEVICE", msg ? msg : "");
+/**
+ * MeoLog / MeoLogf: log straight to Serial, for code without a MeoLogFunction.
+ * - Same core as the library: levels below MEO_LOG_LEVEL compile out, DEBUG
+ *   needs its tag in meoLogDefaultTags() (set by MeoDevice::setDebugTags)
+ */
+inline void meoSerialLogger(const char* level, const char* line) {
     Serial.print("[");
     Serial.print(level);
     Serial.print("] ");
-    Serial.println(buf);
+    Serial.println(line);
+}
+
+inline bool meoSerialLogOn(const char* level, const char* tag) {
+    if (!meoLogCompiled(level)) return false;
+    if (meoLogLevelOf(level) != MEO_LOG_LEVEL_DEBUG) return true;
+    uint32_t mask = meoLogDefaultTags();
+    return mask && meoLogDebugOn(mask, meoLogTagBit(tag ? tag : "DEVICE"));
 }
 
-void MeoLogf(const char* level, const char* tag, const char* fmt, ...) {
-    char msg[192];
-    va_list ap;
-    va_start(ap, fmt);
-    vsnprintf(msg, sizeof(msg), fmt, ap);
-    va_end(ap);
-    MeoLog(level, tag, msg);
-}
\ No newline at end of file
+inline void MeoLog(const char* level, const char* tag, const char* msg) {
+    if (meoSerialLogOn(level, tag)) meoLog(&meoSerialLogger, level, tag ? tag : "DEVICE", msg);
+}
+
+template <typename... Args>
+inline void MeoLogf(const char* level, const char* tag, const char* fmt, Args... args) {
+    if (meoSerialLogOn(level, tag)) meoLogf(&meoSerialLogger, level, tag ? tag : "DEVICE", fmt, args...);
+}
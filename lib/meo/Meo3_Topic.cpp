@@ -0,0 +1,42 @@
+#include "Meo3_Topic.h"
+#include <stdio.h>
+#include <string.h>
+
+bool MeoTopicCache::begin(const char* userId, const char* deviceId) {
+    _ready = false;
+    if (!deviceId || !deviceId[0]) return false;
+
+    int n = (userId && userId[0])
+          ? snprintf(_base, sizeof(_base), "meo/%s/%s", userId, deviceId)
+          : snprintf(_base, sizeof(_base), "meo/%s", deviceId);
+    if (n <= 0 || (size_t)n >= sizeof(_base)) return false;
+    _baseLen = (size_t)n;
+
+    _ready = _withSuffix(_status, "/status")
+          && _withSuffix(_declare, "/declare")
+          && _withSuffix(_feature, "/feature")
+          && _withSuffix(_featureInvoke, "/feature/+/invoke")
+          && _withSuffix(_featureResponse, "/event/feature_response")
+          && _withSuffix(_log, "/log")
+          && _withSuffix(_metrics, "/metrics");
+    return _ready;
+}
+
+bool MeoTopicCache::buildEventTopic(const char* eventName, char* out, size_t outLen) const {
+    if (!_ready || !eventName || !out || outLen == 0) return false;
+    size_t nameLen = strlen(eventName);
+    // base + "/event/" + name + NUL
+    if (_baseLen + 7 + nameLen + 1 > outLen) return false;
+    memcpy(out, _base, _baseLen);
+    memcpy(out + _baseLen, "/event/", 7);
+    memcpy(out + _baseLen + 7, eventName, nameLen + 1);
+    return true;
+}
+
+bool MeoTopicCache::_withSuffix(char* out, const char* suffix) const {
+    size_t suffixLen = strlen(suffix);
+    if (_baseLen + suffixLen + 1 > MEO_TOPIC_MAX_LEN) return false;
+    memcpy(out, _base, _baseLen);
+    memcpy(out + _baseLen, suffix, suffixLen + 1);
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MEO_TOPIC_MAX_LEN
+#define MEO_TOPIC_MAX_LEN 128
+#endif
+
+/**
+ * MeoTopicCache: fixed-capacity MQTT topic strings for one device.
+ * - Built once from user/device identity: meo/{userId}/{deviceId}/...
+ *   (the user segment is omitted when no user id is provisioned)
+ * - Hot paths (publish, declare, response) read ready-made C strings,
+ *   so no std::string concatenation or heap allocation per message
+ * - Returned pointers stay valid until the next begin()
+ */
+class MeoTopicCache {
+public:
+    MeoTopicCache() = default;
+
+    // Build every per-device topic; returns false if identity is missing
+    // or any topic would exceed MEO_TOPIC_MAX_LEN.
+    bool begin(const char* userId, const char* deviceId);
+    bool isReady() const { return _ready; }
+
+    const char* base() const            { return _base; }            // meo/{user}/{device}
+    const char* status() const          { return _status; }          // .../status
+    const char* declare() const         { return _declare; }         // .../declare
+    const char* feature() const         { return _feature; }         // .../feature (cloud-compatible)
+    const char* featureInvoke() const   { return _featureInvoke; }   // .../feature/+/invoke (edge)
+    const char* featureResponse() const { return _featureResponse; } // .../event/feature_response
+    const char* log() const             { return _log; }             // .../log (binary log batches)
+    const char* metrics() const         { return _metrics; }         // .../metrics (snapshots)
+
+    // Write "{base}/event/{eventName}" into `out`; returns false on truncation.
+    bool buildEventTopic(const char* eventName, char* out, size_t outLen) const;
+
+private:
+    bool   _ready = false;
+    size_t _baseLen = 0;
+
+    char _base[MEO_TOPIC_MAX_LEN]            = {0};
+    char _status[MEO_TOPIC_MAX_LEN]          = {0};
+    char _declare[MEO_TOPIC_MAX_LEN]         = {0};
+    char _feature[MEO_TOPIC_MAX_LEN]         = {0};
+    char _featureInvoke[MEO_TOPIC_MAX_LEN]   = {0};
+    char _featureResponse[MEO_TOPIC_MAX_LEN] = {0};
+    char _log[MEO_TOPIC_MAX_LEN]             = {0};
+    char _metrics[MEO_TOPIC_MAX_LEN]         = {0};
+
+    bool _withSuffix(char* out, const char* suffix) const;
+};
@@ -1,10 +1,19 @@
 #pragma once
 
 #include <Arduino.h>
+#include <ArduinoJson.h>
+#include <stdlib.h>
+#include <string.h>
 #include <string>
 #include <functional>
 #include <map>
 #include <vector>
+#include "feature/Meo3_MethodTable.h" // meoFnv1a
+
+// Invoke params indexed by MeoParamIndex; any further params are found by a scan
+#ifndef MEO_INVOKE_MAX_PARAMS
+#define MEO_INVOKE_MAX_PARAMS 16
+#endif
 
 // Connection type mirrors org.thingai.meo.define.MConnectionType
 enum class MeoConnectionType : int {
@@ -17,6 +26,13 @@ enum class MeoConnectionType : int {
 };
 
 // Device info – maps conceptually to MDevice fields
+// Which broker an event goes to when MeoDevice holds a gateway and a cloud link
+enum class MeoEventRoute : uint8_t {
+    EDGE_FIRST = 0, // gateway; cloud only while the gateway is down (default)
+    CLOUD_FIRST,    // cloud; gateway only while the cloud is down
+    BOTH            // gateway first (lowest latency), then cloud
+};
+
 struct MeoDeviceInfo {
     std::string model;
     std::string manufacturer;
@@ -29,16 +45,136 @@ struct MeoDeviceInfo {
 // Simple key-value payload type for events/feature params
 using MeoEventPayload = std::map<std::string, std::string>;  // later we can switch to ArduinoJson
 
-// Represent a feature invocation from the gateway
+/**
+ * MeoParamIndex: hash index over one invoke's params, built once per dispatch.
+ * - FNV-1a of each key into 2 x MEO_INVOKE_MAX_PARAMS slots (linear probing);
+ *   strcmp only on a hash match, so a getter costs one hash and usually one compare
+ * - Keys are views into the parsed document; no heap
+ */
+class MeoParamIndex {
+public:
+    void build(JsonObjectConst params) {
+        memset(_slots, 0, sizeof(_slots));
+        _count = 0;
+        _partial = false;
+        for (JsonPairConst kv : params) {
+            if (_count >= MEO_INVOKE_MAX_PARAMS) {
+                _partial = true;
+                break;
+            }
+            const char* key = kv.key().c_str();
+            uint32_t h = meoFnv1a(key, strlen(key));
+            size_t i = h & MASK;
+            while (_slots[i]) i = (i + 1) & MASK;
+            _entries[_count] = {h, key, kv.value()};
+            _slots[i] = ++_count; // 0 = empty slot
+        }
+        _params = params;
+    }
+
+    // Null variant when missing; a repeated key resolves to its first occurrence
+    JsonVariantConst find(const char* key) const {
+        if (!key) return JsonVariantConst();
+        uint32_t h = meoFnv1a(key, strlen(key));
+        for (size_t i = h & MASK; _slots[i]; i = (i + 1) & MASK) {
+            const Entry& e = _entries[_slots[i] - 1];
+            if (e.hash == h && strcmp(e.key, key) == 0) return e.value;
+        }
+        return _partial ? _params[key] : JsonVariantConst();
+    }
+
+private:
+    static constexpr size_t SLOTS = 2 * MEO_INVOKE_MAX_PARAMS;
+    static constexpr size_t MASK  = SLOTS - 1;
+    static_assert((SLOTS & MASK) == 0, "MEO_INVOKE_MAX_PARAMS must be a power of two");
+
+    struct Entry {
+        uint32_t         hash;
+        const char*      key;
+        JsonVariantConst value;
+    };
+    Entry           _entries[MEO_INVOKE_MAX_PARAMS];
+    uint8_t         _slots[SLOTS];
+    uint8_t         _count = 0;
+    bool            _partial = false; // more params than MEO_INVOKE_MAX_PARAMS
+    JsonObjectConst _params;
+};
+
+/**
+ * MeoFeatureCall: a feature invocation from the gateway, as a view.
+ * - Strings point into MeoDevice's copy of the invoke (parsed in place there, so
+ *   publishing from the handler cannot overwrite them); valid only for the duration
+ *   of the handler: copy anything you keep
+ * - Typed getters accept JSON literals and numeric/boolean strings ("42", "true");
+ *   lookups go through a MeoParamIndex when the dispatcher built one
+ * - params is the "params" object, or the whole payload when there is none;
+ *   iterate with: for (JsonPairConst kv : call.params)
+ */
 struct MeoFeatureCall {
-    std::string deviceId;
-    std::string featureName;
-    MeoEventPayload params;   // raw string values; user can parse as needed
-    // requestId removed to simplify API and payloads
+    const char*     deviceId = "";
+    const char*     featureName = "";
+    JsonObjectConst params;
+    const MeoParamIndex* index = nullptr; // set by the dispatcher; nullptr = scan params
+    uint32_t        token = 0; // async worker: this invoke's in-flight slot
+    mutable bool    deferred = false;
+
+    // Async dispatch only: keep this invoke in flight after the handler returns and
+    // finish it later with MeoDevice::sendFeatureResponse(featureName, ok, msg, token).
+    // Returns that token; 0 when the call cannot be deferred (inline dispatch), in
+    // which case answer before returning
+    uint32_t defer() const {
+        deferred = token != 0;
+        return token;
+    }
+
+    JsonVariantConst param(const char* key) const { return index ? index->find(key) : params[key]; }
+    bool has(const char* key) const { return !param(key).isNull(); }
+
+    long getInt(const char* key, long def = 0) const {
+        JsonVariantConst v = param(key);
+        if (v.is<long>())  return v.as<long>();
+        if (v.is<float>()) return (long)v.as<float>();
+        if (v.is<bool>())  return v.as<bool>() ? 1 : 0;
+        const char* s = v.as<const char*>();
+        if (!s || !*s) return def;
+        char* end = nullptr;
+        long n = strtol(s, &end, 10);
+        return (end && *end == '\0') ? n : def;
+    }
+
+    float getFloat(const char* key, float def = 0.0f) const {
+        JsonVariantConst v = param(key);
+        if (v.is<float>()) return v.as<float>();
+        if (v.is<bool>())  return v.as<bool>() ? 1.0f : 0.0f;
+        const char* s = v.as<const char*>();
+        if (!s || !*s) return def;
+        char* end = nullptr;
+        float f = strtof(s, &end);
+        return (end && *end == '\0') ? f : def;
+    }
+
+    bool getBool(const char* key, bool def = false) const {
+        JsonVariantConst v = param(key);
+        if (v.is<bool>())  return v.as<bool>();
+        if (v.is<float>()) return v.as<float>() != 0.0f;
+        const char* s = v.as<const char*>();
+        if (!s) return def;
+        if (!strcmp(s, "true") || !strcmp(s, "1") || !strcmp(s, "on"))   return true;
+        if (!strcmp(s, "false") || !strcmp(s, "0") || !strcmp(s, "off")) return false;
+        return def;
+    }
+
+    // nullptr/def for missing or non-string values
+    const char* getString(const char* key, const char* def = nullptr) const {
+        const char* s = param(key).as<const char*>();
+        return s ? s : def;
+    }
 };
 
 // Callback type for feature handlers
 using MeoFeatureCallback = std::function<void(const MeoFeatureCall&)>;
+// Allocation-free handler form: plain function + user context
+typedef void (*MeoFeatureHandler)(const MeoFeatureCall& call, void* ctx);
 
 // Registry of supported features
 struct MeoFeatureRegistry {
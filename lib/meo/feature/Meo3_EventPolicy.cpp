@@ -0,0 +1,100 @@
+#include "Meo3_EventPolicy.h"
+#include <math.h>
+#include <string.h>
+
+bool MeoEventFilter::check(const MeoEventFields& fields, uint32_t nowMs) {
+    _heartbeat = false;
+    if (!_hasLast) return true; // first value always goes out
+    uint32_t elapsed = nowMs - _lastMs;
+    if (_policy.minIntervalMs && elapsed < _policy.minIntervalMs) return false;
+
+    bool onChange = _policy.onChange || _policy.absolute > 0 || _policy.percent > 0 || _policy.fieldCount;
+    if (!onChange || _changed(fields)) return true;
+    if (_policy.maxIntervalMs && elapsed >= _policy.maxIntervalMs) {
+        _heartbeat = true;
+        return true;
+    }
+    return false;
+}
+
+void MeoEventFilter::commit(const MeoEventFields& fields, uint32_t nowMs) {
+    _stats.sent++;
+    if (_heartbeat) _stats.heartbeats++;
+    _heartbeat = false;
+    _hasLast = true;
+    _lastMs = nowMs;
+
+    uint8_t n = fields.count() < MEO_EVENT_POLICY_FIELDS ? fields.count() : MEO_EVENT_POLICY_FIELDS;
+    for (uint8_t i = 0; i < n; ++i) {
+        const MeoEventField& f = fields.at(i);
+        Last& l = _last[i];
+        l.keyHash = _hash(f.key);
+        l.type = f.type;
+        switch (f.type) {
+            case MeoEventField::INT:    l.i = f.i; break;
+            case MeoEventField::FLOAT:  l.f = f.f; break;
+            case MeoEventField::BOOL:   l.b = f.b; break;
+            case MeoEventField::STRING: l.sHash = f.s ? _hash(f.s) : 0; break;
+        }
+    }
+    _lastCount = n;
+}
+
+bool MeoEventFilter::_changed(const MeoEventFields& fields) const {
+    // Fields past the limit have no last value to compare with: assume they moved
+    if (fields.count() > MEO_EVENT_POLICY_FIELDS) return true;
+    uint8_t n = fields.count();
+    if (n != _lastCount) return true;
+    for (uint8_t i = 0; i < n; ++i) {
+        const MeoEventField& f = fields.at(i);
+        uint32_t h = _hash(f.key);
+        // Same order as last time is the common case
+        const Last* l = _last[i].keyHash == h ? &_last[i] : nullptr;
+        for (uint8_t j = 0; !l && j < _lastCount; ++j) {
+            if (_last[j].keyHash == h) l = &_last[j];
+        }
+        if (!l || l->type != f.type) return true;
+        switch (f.type) {
+            case MeoEventField::INT:
+                if (_numberMoved(f.key, (double)f.i, (double)l->i)) return true;
+                break;
+            case MeoEventField::FLOAT:
+                if (_numberMoved(f.key, f.f, l->f)) return true;
+                break;
+            case MeoEventField::BOOL:
+                if (f.b != l->b) return true;
+                break;
+            case MeoEventField::STRING:
+                if ((f.s ? _hash(f.s) : 0) != l->sHash) return true;
+                break;
+        }
+    }
+    return false;
+}
+
+bool MeoEventFilter::_numberMoved(const char* key, double value, double last) const {
+    float absolute = _policy.absolute;
+    float percent = _policy.percent;
+    for (uint8_t i = 0; i < _policy.fieldCount; ++i) {
+        if (_policy.fields[i].key && strcmp(_policy.fields[i].key, key) == 0) {
+            absolute = _policy.fields[i].absolute;
+            percent = _policy.fields[i].percent;
+            break;
+        }
+    }
+    if (isnan(value) || isnan(last)) return isnan(value) != isnan(last);
+    double diff = fabs(value - last);
+    if (absolute <= 0 && percent <= 0) return diff != 0; // plain send-on-change
+    if (absolute > 0 && diff >= absolute) return true;
+    return percent > 0 && diff > 0 && diff >= fabs(last) * percent / 100.0;
+}
+
+// FNV-1a
+uint32_t MeoEventFilter::_hash(const char* s) {
+    uint32_t h = 2166136261u;
+    for (; *s; ++s) {
+        h ^= (uint8_t)*s;
+        h *= 16777619u;
+    }
+    return h;
+}
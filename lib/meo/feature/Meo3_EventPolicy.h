@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../Meo3_EventFields.h"
+
+// Fields per event whose last sent value is remembered; an event with more
+// fields cannot be compared and always counts as changed
+#ifndef MEO_EVENT_POLICY_FIELDS
+#define MEO_EVENT_POLICY_FIELDS 8
+#endif
+
+// Deadband of one numeric field, overriding the event-wide default
+struct MeoFieldDeadband {
+    const char* key;
+    float       absolute; // publish when |value - last sent| >= absolute (0 = unused)
+    float       percent;  // ... or >= percent of |last sent| (0 = unused)
+};
+
+/**
+ * MeoEventPolicy: when a registered event is actually published.
+ * - minIntervalMs: never more often than this (0 = no limit)
+ * - maxIntervalMs: heartbeat, publish anyway once this long has passed (0 = off)
+ * - onChange: only publish when a field changed; numeric fields must move past their
+ *   deadband, strings/bools on any difference. A deadband implies onChange.
+ * - Intervals are checked when publishEvent() is called, there is no timer
+ */
+struct MeoEventPolicy {
+    uint32_t minIntervalMs = 0;
+    uint32_t maxIntervalMs = 0;
+    bool     onChange = false;
+    float    absolute = 0;    // default deadband for numeric fields
+    float    percent = 0;
+    const MeoFieldDeadband* fields = nullptr; // per-field overrides; pointer kept
+    uint8_t  fieldCount = 0;
+};
+
+struct MeoEventPolicyStats {
+    uint32_t sent = 0;       // passed the policy (including first value and heartbeats)
+    uint32_t suppressed = 0; // dropped as redundant or too early
+    uint32_t heartbeats = 0; // sent only because maxIntervalMs ran out
+};
+
+/**
+ * MeoEventFilter: MeoEventPolicy plus the last values sent for one event.
+ * - check() decides, commit() records what actually went out, so a failed
+ *   publish is retried on the next call instead of being forgotten
+ * - Fields are matched by key; a new or missing key counts as a change
+ * - Not thread-safe: the owner serializes calls
+ */
+class MeoEventFilter {
+public:
+    explicit MeoEventFilter(const MeoEventPolicy& policy) : _policy(policy) {}
+
+    bool check(const MeoEventFields& fields, uint32_t nowMs);
+    void commit(const MeoEventFields& fields, uint32_t nowMs);
+    void suppressed() { _stats.suppressed++; }
+
+    const MeoEventPolicy&      policy() const { return _policy; }
+    const MeoEventPolicyStats& stats() const  { return _stats; }
+
+private:
+    struct Last {
+        uint32_t keyHash;
+        MeoEventField::Type type;
+        union {
+            float    f;
+            int64_t  i;
+            bool     b;
+            uint32_t sHash; // strings are compared by hash
+        };
+    };
+
+    MeoEventPolicy      _policy;
+    MeoEventPolicyStats _stats;
+    Last     _last[MEO_EVENT_POLICY_FIELDS];
+    uint8_t  _lastCount = 0;
+    bool     _hasLast = false;
+    bool     _heartbeat = false; // the pending check() passed on maxIntervalMs alone
+    uint32_t _lastMs = 0;
+
+    bool _changed(const MeoEventFields& fields) const;
+    bool _numberMoved(const char* key, double value, double last) const;
+    static uint32_t _hash(const char* s);
+};
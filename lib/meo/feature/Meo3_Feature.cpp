@@ -1,5 +1,4 @@
 #include "Meo3_Feature.h"
-#include <string>
 
 MeoFeature::MeoFeature() {}
 
@@ -7,71 +6,53 @@ void MeoFeature::attach(MeoMqttClient* transport, const char* userId, const char
     _mqtt = transport;
     _userId = userId;
     _deviceId = deviceId;
+    _topics.begin(userId, deviceId);
     if (_mqtt) {
         _mqtt->setMessageHandler(&MeoFeature::onRawMessage, this);
     }
 }
 
 bool MeoFeature::beginFeatureSubscribe(FeatureCallback cb, void* ctx) {
-    if (!_mqtt || !_mqtt->isConnected() || !_deviceId) return false;
+    if (!_mqtt || !_mqtt->isConnected() || !_topics.isReady()) return false;
     _cb = cb;
     _cbCtx = ctx;
 
     // Subscribe to all feature invokes for this device, prefixed by optional user id
-    std::string base = "meo/";
-    if (_userId && _userId[0]) base += std::string(_userId) + "/";
-    std::string topic = base + std::string(_deviceId) + "/feature/+/invoke";
-    return _mqtt->subscribe(topic.c_str());
+    return _mqtt->subscribe(_topics.featureInvoke());
 }
 
 bool MeoFeature::publishEvent(const char* eventName,
                               const char* const* keys,
                               const char* const* values,
                               uint8_t count) {
-    if (!_mqtt || !_mqtt->isConnected() || !_deviceId) return false;
+    if (!_mqtt || !_mqtt->isConnected() || !_topics.isReady()) return false;
 
-    std::string base = "meo/";
-    if (_userId && _userId[0]) base += std::string(_userId) + "/";
-    std::string topic = base + std::string(_deviceId) + "/event/" + eventName;
+    char topic[MEO_TOPIC_MAX_LEN];
+    if (!_topics.buildEventTopic(eventName, topic, sizeof(topic))) return false;
 
-    StaticJsonDocument<BUF_SIZE> doc;
+    MeoStaticEventFields<MEO_MAX_EVENT_FIELDS> fields;
     for (uint8_t i = 0; i < count; ++i) {
-        doc[keys[i]] = values[i];
+        if (!fields.add(keys[i], values[i])) return false;
     }
-
-    size_t len = serializeJson(doc, _buf, sizeof(_buf));
-    if (len == 0) return false;
-
-    return _mqtt->publish(topic.c_str(), (const uint8_t*)_buf, len, false);
+    return _mqtt->publish(topic, fields, false);
 }
 
 bool MeoFeature::sendFeatureResponse(const char* featureName,
                                      bool success,
                                      const char* message) {
-    if (!_mqtt || !_mqtt->isConnected() || !_deviceId) return false;
-
-    std::string base = "meo/";
-    if (_userId && _userId[0]) base += std::string(_userId) + "/";
-    std::string topic = base + std::string(_deviceId) + "/event/feature_response";
-
-    StaticJsonDocument<BUF_SIZE> doc;
-    doc["feature_name"] = featureName;
-    doc["device_id"]    = _deviceId;
-    doc["success"]      = success;
-    if (message) doc["message"] = message;
-
-    size_t len = serializeJson(doc, _buf, sizeof(_buf));
-    if (len == 0) return false;
-
-    return _mqtt->publish(topic.c_str(), (const uint8_t*)_buf, len, false);
+    if (!_mqtt || !_mqtt->isConnected() || !_topics.isReady()) return false;
+
+    MeoStaticEventFields<4> fields;
+    fields.add("feature_name", featureName);
+    fields.add("device_id", _deviceId);
+    fields.add("success", success);
+    if (message) fields.add("message", message);
+    return _mqtt->publish(_topics.featureResponse(), fields, false);
 }
 
 bool MeoFeature::publishStatus(const char* status) {
-    if (!_mqtt || !_mqtt->isConnected() || !_deviceId) return false;
-    std::string base = "meo/";
-    if (_userId && _userId[0]) base += std::string(_userId) + "/";
-    std::string topic = base + std::string(_deviceId) + "/status";
-    return _mqtt->publish(topic.c_str(), status, true);
+    if (!_mqtt || !_mqtt->isConnected() || !_topics.isReady()) return false;
+    return _mqtt->publish(_topics.status(), status, true);
 }
 
 void MeoFeature::onRawMessage(const char* topic, const uint8_t* payload, unsigned int length, void* ctx) {
@@ -96,9 +77,10 @@ void MeoFeature::_dispatchFeatureInvoke(const char* topic, const uint8_t* payloa
     memcpy(featureName, featureMarker, nameLen);
     featureName[nameLen] = '\0';
 
-    // Parse minimal JSON
+    // Parse minimal JSON or MessagePack
     StaticJsonDocument<BUF_SIZE> doc;
-    DeserializationError err = deserializeJson(doc, payload, length);
+    DeserializationError err = meoIsMsgPackMap(payload, length) ? deserializeMsgPack(doc, payload, length)
+                                                                : deserializeJson(doc, payload, length);
     if (err) return;
 
     // Build param arrays (keys/values) with a small cap
@@ -3,6 +3,7 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include "../mqtt/Meo3_Mqtt.h"
+#include "../Meo3_Topic.h"
 
 /**
  * MeoFeature: device-level MQTT feature/event layer built on MeoMqtt.
@@ -11,7 +12,8 @@
  * - Publishes status:       meo/{device_id}/status (online/offline LWT recommended in base)
  * - Sends feature responses: meo/{device_id}/event/feature_response
  *
- * Keeps RAM low: single reusable buffer and small JSON docs.
+ * Keeps RAM low: outgoing payloads are streamed by the transport, incoming
+ * invokes are parsed into one small JSON doc.
  */
 class MeoFeature {
 public:
@@ -54,10 +56,10 @@ private:
     MeoMqttClient* _mqtt = nullptr;
     const char*    _userId = nullptr;
     const char*    _deviceId = nullptr;
+    MeoTopicCache  _topics;
 
-    // Reusable JSON buffer
+    // Incoming invoke JSON capacity
     static constexpr size_t BUF_SIZE = 512;
-    char _buf[BUF_SIZE];
 
     // Feature callback and context
     FeatureCallback _cb = nullptr;
@@ -0,0 +1,140 @@
+#include "Meo3_InvokeQueue.h"
+#include <string.h>
+
+bool MeoInvokeQueue::setLimit(const void* key, uint8_t maxInFlight) {
+    if (!key) return false;
+    MeoLockGuard lk(_lock);
+    Limit* l = _findLimit(key);
+    if (!l) {
+        if (_limitCount >= MEO_INVOKE_MAX_LIMITS) return false;
+        l = &_limits[_limitCount++];
+        l->key = key;
+        l->inFlight = 0;
+    }
+    l->max = maxInFlight;
+    return true;
+}
+
+MeoInvokePush MeoInvokeQueue::push(const void* key, const char* feature, const char* params, size_t paramsLen) {
+    if (!feature) return MeoInvokePush::TOO_LARGE;
+    size_t nameLen = strlen(feature);
+    if (nameLen >= MEO_INVOKE_MAX_FEATURE_NAME || paramsLen >= MEO_INVOKE_MAX_PAYLOAD) {
+        return MeoInvokePush::TOO_LARGE;
+    }
+
+    {
+        MeoLockGuard lk(_lock);
+        Active* a = _findActive(0);
+        if (_count >= MEO_INVOKE_QUEUE_DEPTH || !a) {
+            _stats.rejectedFull++;
+            return MeoInvokePush::FULL;
+        }
+        Limit* l = _findLimit(key);
+        if (l && l->max && l->inFlight >= l->max) {
+            _stats.rejectedBusy++;
+            return MeoInvokePush::BUSY;
+        }
+
+        if (++_nextToken == 0) _nextToken = 1;
+        a->token = _nextToken;
+        a->key = key;
+        a->stage = Stage::QUEUED;
+
+        MeoInvokeRecord& r = _slots[(_head + _count) % MEO_INVOKE_QUEUE_DEPTH];
+        r.key = key;
+        r.token = a->token;
+        memcpy(r.feature, feature, nameLen + 1);
+        if (paramsLen) memcpy(r.params, params, paramsLen);
+        r.params[paramsLen] = '\0';
+        r.paramsLen = (uint16_t)paramsLen;
+
+        _count++;
+        _inFlight++;
+        if (l) l->inFlight++;
+        _stats.enqueued++;
+        if (_count > _stats.maxDepth) _stats.maxDepth = (uint32_t)_count;
+    }
+    _ready.give();
+    return MeoInvokePush::OK;
+}
+
+bool MeoInvokeQueue::pop(MeoInvokeRecord& out, uint32_t timeoutMs) {
+    if (!_ready.take(timeoutMs)) return false;
+    MeoLockGuard lk(_lock);
+    if (_count == 0) return false;
+    out = _slots[_head];
+    _head = (_head + 1) % MEO_INVOKE_QUEUE_DEPTH;
+    _count--;
+    Active* a = _findActive(out.token);
+    if (a) a->stage = Stage::RUNNING;
+    return true;
+}
+
+void MeoInvokeQueue::release(uint32_t token) {
+    MeoLockGuard lk(_lock);
+    Active* a = _findActive(token);
+    if (a && (a->stage == Stage::RUNNING || a->stage == Stage::ANSWERED)) _finish(*a);
+}
+
+void MeoInvokeQueue::defer(uint32_t token) {
+    MeoLockGuard lk(_lock);
+    Active* a = _findActive(token);
+    if (!a) return;
+    if (a->stage == Stage::ANSWERED) {
+        // Answered from another task before the handler returned
+        _finish(*a);
+    } else if (a->stage == Stage::RUNNING) {
+        a->stage = Stage::DEFERRED;
+        _deferred++;
+    }
+}
+
+bool MeoInvokeQueue::complete(uint32_t token) {
+    MeoLockGuard lk(_lock);
+    Active* a = token ? _findActive(token) : nullptr;
+    if (a && a->stage == Stage::RUNNING) {
+        a->stage = Stage::ANSWERED;
+        return true;
+    }
+    if (a && a->stage == Stage::DEFERRED) {
+        _deferred--;
+        _finish(*a);
+        return true;
+    }
+    _stats.unknownToken++;
+    return false;
+}
+
+MeoInvokeStats MeoInvokeQueue::stats() const {
+    MeoLockGuard lk(_lock);
+    MeoInvokeStats s = _stats;
+    s.depth    = (uint32_t)_count;
+    s.inFlight = _inFlight;
+    s.deferred = _deferred;
+    return s;
+}
+
+MeoInvokeQueue::Limit* MeoInvokeQueue::_findLimit(const void* key) {
+    for (size_t i = 0; i < _limitCount; ++i) {
+        if (_limits[i].key == key) return &_limits[i];
+    }
+    return nullptr;
+}
+
+// token 0 finds a free slot
+MeoInvokeQueue::Active* MeoInvokeQueue::_findActive(uint32_t token) {
+    for (Active& a : _active) {
+        if (a.token == token) return &a;
+    }
+    return nullptr;
+}
+
+void MeoInvokeQueue::_finish(Active& a) {
+    Limit* l = _findLimit(a.key);
+    if (l && l->inFlight) l->inFlight--;
+    if (_inFlight) _inFlight--;
+    _stats.completed++;
+    a.token = 0;
+    a.key = nullptr;
+    a.stage = Stage::FREE;
+}
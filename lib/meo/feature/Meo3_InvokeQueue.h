@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../os/Meo3_Os.h"
+
+// Invokes waiting for the worker task
+#ifndef MEO_INVOKE_QUEUE_DEPTH
+#define MEO_INVOKE_QUEUE_DEPTH 8
+#endif
+// Largest params JSON carried by one queued invoke
+#ifndef MEO_INVOKE_MAX_PAYLOAD
+#define MEO_INVOKE_MAX_PAYLOAD 384
+#endif
+#ifndef MEO_INVOKE_MAX_FEATURE_NAME
+#define MEO_INVOKE_MAX_FEATURE_NAME 64
+#endif
+// Features with their own concurrency limit
+#ifndef MEO_INVOKE_MAX_LIMITS
+#define MEO_INVOKE_MAX_LIMITS 16
+#endif
+// Invokes queued, running or deferred at once; pushes past it are rejected as full
+#ifndef MEO_INVOKE_MAX_INFLIGHT
+#define MEO_INVOKE_MAX_INFLIGHT 16
+#endif
+
+struct MeoInvokeStats {
+    uint32_t enqueued     = 0;
+    uint32_t completed    = 0;
+    uint32_t rejectedFull = 0; // queue at MEO_INVOKE_QUEUE_DEPTH or MEO_INVOKE_MAX_INFLIGHT
+    uint32_t rejectedBusy = 0; // feature at its concurrency limit
+    uint32_t unknownToken = 0; // complete() for a token that is not deferred (twice, or never)
+    uint32_t depth        = 0;
+    uint32_t maxDepth     = 0;
+    uint32_t inFlight     = 0; // queued + running + deferred
+    uint32_t deferred     = 0;
+};
+
+// One queued invoke; `key` identifies the method (opaque to the queue), `token` this invoke
+struct MeoInvokeRecord {
+    const void* key = nullptr;
+    uint32_t    token = 0;
+    char        feature[MEO_INVOKE_MAX_FEATURE_NAME];
+    char        params[MEO_INVOKE_MAX_PAYLOAD];
+    uint16_t    paramsLen = 0;
+};
+
+enum class MeoInvokePush : uint8_t {
+    OK = 0,
+    FULL,
+    BUSY,
+    TOO_LARGE
+};
+
+/**
+ * MeoInvokeQueue: bounded multi-producer queue of feature invokes for a worker task.
+ * - Records are copied into fixed slots: no heap, no views into the MQTT buffer
+ * - Every pushed invoke gets a token (never 0) and holds an in-flight slot, counted
+ *   against its key's limit, until the worker release()s it or, once defer()red,
+ *   complete(token) finishes it. Unknown tokens change nothing, so a response can
+ *   only ever free its own invoke
+ * - complete() may run before the worker's defer() (answer from another task while
+ *   the handler is still returning); the slot is then freed by defer()
+ * - Thread-safe via Meo3_Os primitives (FreeRTOS or std::thread)
+ */
+class MeoInvokeQueue {
+public:
+    MeoInvokeQueue() = default;
+
+    // 0 = unlimited; false if the limit table is full
+    bool setLimit(const void* key, uint8_t maxInFlight);
+
+    MeoInvokePush push(const void* key, const char* feature, const char* params, size_t paramsLen);
+
+    // Block until an invoke is available (or timeout); false on timeout
+    bool pop(MeoInvokeRecord& out, uint32_t timeoutMs = MEO_WAIT_FOREVER);
+
+    // Worker, after the handler of `token` returned: release() if it answered
+    // synchronously, defer() if it will answer later through complete()
+    void release(uint32_t token);
+    void defer(uint32_t token);
+    // Deferred answer sent; false (and nothing freed) if `token` is not in flight
+    // or was already completed
+    bool complete(uint32_t token);
+
+    MeoInvokeStats stats() const;
+
+private:
+    struct Limit {
+        const void* key;
+        uint8_t     max;      // 0 = unlimited
+        uint8_t     inFlight;
+    };
+    enum class Stage : uint8_t { FREE = 0, QUEUED, RUNNING, ANSWERED, DEFERRED };
+    struct Active {
+        uint32_t    token;
+        const void* key;
+        Stage       stage;
+    };
+
+    mutable MeoMutex _lock;
+    MeoSignal        _ready;
+
+    MeoInvokeRecord _slots[MEO_INVOKE_QUEUE_DEPTH];
+    size_t          _head = 0;
+    size_t          _count = 0;
+
+    Limit    _limits[MEO_INVOKE_MAX_LIMITS] = {};
+    size_t   _limitCount = 0;
+    Active   _active[MEO_INVOKE_MAX_INFLIGHT] = {};
+    uint32_t _inFlight = 0;
+    uint32_t _deferred = 0;
+    uint32_t _nextToken = 0;
+    MeoInvokeStats _stats;
+
+    Limit*  _findLimit(const void* key);
+    Active* _findActive(uint32_t token);
+    void    _finish(Active& a);
+};
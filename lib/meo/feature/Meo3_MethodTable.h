@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// FNV-1a over `len` bytes; used to pre-hash method names once at registration
+inline uint32_t meoFnv1a(const char* s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * MeoMethodTable: fixed-capacity name -> handler map for feature methods.
+ * - Open addressing (linear probing) over 2x Capacity slots, rounded to a power of two,
+ *   so lookups stay O(1) as the method count grows
+ * - Full 32-bit hash compared first; strcmp only on hash match (collision fallback)
+ * - Names are not copied (string literals / long-lived storage expected)
+ * - Registration order is kept for declare
+ */
+template <typename Handler, size_t Capacity>
+class MeoMethodTable {
+public:
+    static_assert(Capacity > 0 && Capacity < 0x8000, "MeoMethodTable capacity out of range");
+
+    struct Entry {
+        uint32_t    hash;
+        const char* name;    // nullptr = empty slot
+        Handler     handler;
+        void*       ctx;
+        uint16_t    order;   // registration index, for per-method side tables
+    };
+
+    MeoMethodTable() { clear(); }
+
+    // false if full, name empty or already registered
+    bool add(const char* name, Handler handler, void* ctx) {
+        if (!name || !*name || _count >= Capacity) return false;
+        size_t len = strlen(name);
+        uint32_t h = meoFnv1a(name, len);
+        size_t i = h & MASK;
+        while (_slots[i].name) {
+            if (_slots[i].hash == h && strcmp(_slots[i].name, name) == 0) return false;
+            i = (i + 1) & MASK;
+        }
+        _slots[i].hash    = h;
+        _slots[i].name    = name;
+        _slots[i].handler = handler;
+        _slots[i].ctx     = ctx;
+        _slots[i].order   = (uint16_t)_count;
+        _order[_count++]  = (uint16_t)i;
+        return true;
+    }
+
+    // `name` need not be NUL-terminated
+    const Entry* find(const char* name, size_t len) const {
+        if (!name || _count == 0) return nullptr;
+        uint32_t h = meoFnv1a(name, len);
+        size_t i = h & MASK;
+        while (_slots[i].name) {
+            const Entry& e = _slots[i];
+            if (e.hash == h && strncmp(e.name, name, len) == 0 && e.name[len] == '\0') return &e;
+            i = (i + 1) & MASK;
+        }
+        return nullptr;
+    }
+    const Entry* find(const char* name) const { return name ? find(name, strlen(name)) : nullptr; }
+
+    void clear() {
+        memset(_slots, 0, sizeof(_slots));
+        _count = 0;
+    }
+
+    size_t size() const { return _count; }
+    static constexpr size_t capacity() { return Capacity; }
+    // i-th entry in registration order
+    const Entry& at(size_t i) const { return _slots[_order[i]]; }
+
+private:
+    static constexpr size_t _pow2(size_t n) { return n <= 1 ? 1 : 2 * _pow2((n + 1) / 2); }
+    static constexpr size_t SLOTS = _pow2(Capacity * 2);
+    static constexpr size_t MASK  = SLOTS - 1;
+
+    Entry    _slots[SLOTS];
+    uint16_t _order[Capacity];
+    size_t   _count = 0;
+};
@@ -0,0 +1,59 @@
+#include "Meo3_Histogram.h"
+#include <stdio.h>
+#include <string.h>
+
+void MeoLatencyHistogram::record(uint32_t us) {
+    _buckets[bucketOf(us)]++;
+    _count++;
+    _sumUs += us;
+    if (us > _maxUs) _maxUs = us;
+}
+
+void MeoLatencyHistogram::reset() {
+    memset(_buckets, 0, sizeof(_buckets));
+    _count = 0;
+    _maxUs = 0;
+    _sumUs = 0;
+}
+
+void MeoLatencyHistogram::load(const uint32_t buckets[BUCKETS], uint64_t sumUs, uint32_t maxUs) {
+    _count = 0;
+    for (uint8_t i = 0; i < BUCKETS; ++i) {
+        _buckets[i] = buckets[i];
+        _count += buckets[i];
+    }
+    _sumUs = sumUs;
+    _maxUs = maxUs;
+}
+
+uint32_t MeoLatencyHistogram::bucketUpperUs(uint8_t i) {
+    if (i == 0) return 0;
+    if (i >= BUCKETS - 1) return 0xFFFFFFFFu;
+    return (1u << i) - 1;
+}
+
+uint32_t MeoLatencyHistogram::percentileUs(uint8_t pct) const {
+    if (_count == 0) return 0;
+    if (pct > 100) pct = 100;
+    uint64_t rank = ((uint64_t)_count * pct + 99) / 100;
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (uint8_t i = 0; i < BUCKETS; ++i) {
+        seen += _buckets[i];
+        if (seen >= rank) {
+            uint32_t upper = bucketUpperUs(i);
+            return upper < _maxUs ? upper : _maxUs;
+        }
+    }
+    return _maxUs;
+}
+
+size_t MeoLatencyHistogram::formatJson(char* out, size_t outLen) const {
+    if (!out || outLen == 0) return 0;
+    int n = snprintf(out, outLen, "{\"n\":%lu,\"mean\":%lu,\"p50\":%lu,\"p90\":%lu,\"p99\":%lu,\"max\":%lu}",
+                     (unsigned long)_count, (unsigned long)meanUs(),
+                     (unsigned long)percentileUs(50), (unsigned long)percentileUs(90),
+                     (unsigned long)percentileUs(99), (unsigned long)_maxUs);
+    if (n < 0 || (size_t)n >= outLen) { out[0] = '\0'; return 0; }
+    return (size_t)n;
+}
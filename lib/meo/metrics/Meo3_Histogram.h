@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * MeoLatencyHistogram: fixed log2 histogram of durations in microseconds.
+ * - Bucket 0 holds 0 us, bucket i holds [2^(i-1), 2^i) us; the last bucket is open-ended
+ * - record() is O(1) and allocation-free; one writer task, readers may see a
+ *   slightly stale snapshot
+ * - Percentiles are reported as the upper bound of the bucket they fall in
+ */
+class MeoLatencyHistogram {
+public:
+    static constexpr uint8_t BUCKETS = 24; // last bucket: >= ~4.2 s
+
+    void record(uint32_t us);
+    void reset();
+
+    uint32_t count() const { return _count; }
+    uint32_t maxUs() const { return _maxUs; }
+    uint32_t meanUs() const { return _count ? (uint32_t)(_sumUs / _count) : 0; }
+    uint64_t sumUs() const  { return _sumUs; }
+    uint32_t bucket(uint8_t i) const { return i < BUCKETS ? _buckets[i] : 0; }
+    uint32_t percentileUs(uint8_t pct) const;
+
+    static uint32_t bucketUpperUs(uint8_t i);
+    static uint8_t  bucketOf(uint32_t us) {
+        uint8_t i = us ? (uint8_t)(32 - __builtin_clz(us)) : 0;
+        return i < BUCKETS ? i : BUCKETS - 1;
+    }
+    // Replace the contents with buckets collected elsewhere (MeoMetricHistogram)
+    void load(const uint32_t buckets[BUCKETS], uint64_t sumUs, uint32_t maxUs);
+
+    // {"n":..,"mean":..,"p50":..,"p90":..,"p99":..,"max":..}; returns length, 0 if it did not fit
+    size_t formatJson(char* out, size_t outLen) const;
+
+private:
+    uint32_t _buckets[BUCKETS] = {0};
+    uint32_t _count = 0;
+    uint32_t _maxUs = 0;
+    uint64_t _sumUs = 0;
+};
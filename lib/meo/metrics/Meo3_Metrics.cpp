@@ -0,0 +1,173 @@
+#include "Meo3_Metrics.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+void MeoMetricHistogram::record(uint32_t v) {
+    _buckets[MeoLatencyHistogram::bucketOf(v)].fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(v, std::memory_order_relaxed);
+    uint32_t seen = _max.load(std::memory_order_relaxed);
+    while (v > seen && !_max.compare_exchange_weak(seen, v, std::memory_order_relaxed)) {
+    }
+}
+
+void MeoMetricHistogram::take(MeoLatencyHistogram& out) {
+    uint32_t buckets[MeoLatencyHistogram::BUCKETS];
+    for (uint8_t i = 0; i < MeoLatencyHistogram::BUCKETS; ++i) {
+        buckets[i] = _buckets[i].exchange(0, std::memory_order_relaxed);
+    }
+    uint32_t sum = _sum.exchange(0, std::memory_order_relaxed);
+    uint32_t max = _max.exchange(0, std::memory_order_relaxed);
+    out.load(buckets, sum, max);
+}
+
+void MeoMetricHistogram::peek(MeoLatencyHistogram& out) const {
+    uint32_t buckets[MeoLatencyHistogram::BUCKETS];
+    for (uint8_t i = 0; i < MeoLatencyHistogram::BUCKETS; ++i) {
+        buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+    }
+    out.load(buckets, _sum.load(std::memory_order_relaxed), _max.load(std::memory_order_relaxed));
+}
+
+void MeoMetricHistogram::drop(const MeoLatencyHistogram& seen) {
+    for (uint8_t i = 0; i < MeoLatencyHistogram::BUCKETS; ++i) {
+        _buckets[i].fetch_sub(seen.bucket(i), std::memory_order_relaxed);
+    }
+    _sum.fetch_sub((uint32_t)seen.sumUs(), std::memory_order_relaxed);
+    // A larger max recorded since the copy stays for the next window
+    uint32_t max = seen.maxUs();
+    _max.compare_exchange_strong(max, 0, std::memory_order_relaxed);
+}
+
+MeoMetricId MeoMetrics::addCounter(const char* name, const char* label) {
+    return _add(name, label, MeoMetricKind::COUNTER);
+}
+
+MeoMetricId MeoMetrics::addGauge(const char* name) {
+    return _add(name, nullptr, MeoMetricKind::GAUGE);
+}
+
+MeoMetricId MeoMetrics::addHistogram(const char* name) {
+    return _add(name, nullptr, MeoMetricKind::HISTOGRAM);
+}
+
+MeoMetricId MeoMetrics::_add(const char* name, const char* label, MeoMetricKind kind) {
+    if (!name || !*name || _count >= MEO_METRICS_MAX + MEO_METRICS_HISTOGRAMS) return -1;
+    bool histogram = kind == MeoMetricKind::HISTOGRAM;
+    if (histogram ? _histogramCount >= MEO_METRICS_HISTOGRAMS : _valueCount >= MEO_METRICS_MAX) return -1;
+    Entry& e = _entries[_count];
+    e.name = name;
+    e.label = label;
+    e.kind = kind;
+    e.slot = histogram ? _histogramCount++ : _valueCount++;
+    return (MeoMetricId)_count++;
+}
+
+namespace {
+
+// Bounded appender: remembers overflow instead of checking every snprintf;
+// mark()/undo() take back a metric that did not fit whole
+struct Out {
+    char*  buf;
+    size_t len;
+    size_t at = 0;
+    bool   full = false;
+    size_t saved = 0;
+
+    void put(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        if (full) return;
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(buf + at, len - at, fmt, ap);
+        va_end(ap);
+        if (n < 0 || (size_t)n >= len - at) full = true;
+        else at += (size_t)n;
+    }
+    void mark() { saved = at; }
+    void undo() {
+        at = saved;
+        buf[at] = '\0';
+        full = false;
+    }
+};
+
+} // namespace
+
+size_t MeoMetrics::snapshot(char* out, size_t outLen, uint8_t& cursor) {
+    if (!out || outLen < 4) return 0;
+    // Output order: registration order, with labelled counters grouped under the
+    // first entry of their name
+    uint8_t order[MEO_METRICS_MAX + MEO_METRICS_HISTOGRAMS];
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < _count; ++i) {
+        const Entry& e = _entries[i];
+        if (!e.label) {
+            order[n++] = i;
+            continue;
+        }
+        bool first = true;
+        for (uint8_t j = 0; j < i && first; ++j) {
+            first = !(_entries[j].label && strcmp(_entries[j].name, e.name) == 0);
+        }
+        if (!first) continue;
+        for (uint8_t j = i; j < _count; ++j) {
+            if (_entries[j].label && strcmp(_entries[j].name, e.name) == 0) order[n++] = j;
+        }
+    }
+    if (cursor >= n) cursor = 0;
+
+    // Room is kept for closing an open object and the snapshot itself
+    Out o{out, outLen - 2};
+    const char* sep = "";
+    const char* open = nullptr; // name of the labelled object being written
+    const char* inner = "";
+    uint8_t p = cursor;
+    o.put("{");
+    for (; p < n; ++p) {
+        const Entry& e = _entries[order[p]];
+        o.mark();
+        const char* wasOpen = open;
+        if (open && (!e.label || strcmp(open, e.name) != 0)) {
+            o.put("}");
+            open = nullptr;
+        }
+        if (e.kind == MeoMetricKind::HISTOGRAM) {
+            MeoLatencyHistogram h;
+            _histograms[e.slot].peek(h);
+            char json[96];
+            if (h.count() == 0 || h.formatJson(json, sizeof(json)) == 0) strcpy(json, "{\"n\":0}");
+            o.put("%s\"%s\":%s", sep, e.name, json);
+            if (!o.full) _histograms[e.slot].drop(h);
+        } else if (!e.label) {
+            uint32_t v = _values[e.slot].load(std::memory_order_relaxed);
+            if (e.kind == MeoMetricKind::GAUGE) o.put("%s\"%s\":%ld", sep, e.name, (long)(int32_t)v);
+            else                                o.put("%s\"%s\":%lu", sep, e.name, (unsigned long)v);
+        } else {
+            if (!open) {
+                o.put("%s\"%s\":{", sep, e.name);
+                open = e.name;
+                inner = "";
+            }
+            uint32_t v = _values[e.slot].load(std::memory_order_relaxed);
+            if (v) {
+                o.put("%s\"%s\":%lu", inner, e.label, (unsigned long)v);
+                inner = ",";
+            }
+        }
+        if (o.full) {
+            o.undo();
+            open = wasOpen;
+            break;
+        }
+        sep = ",";
+    }
+    if (p == cursor && p < n) {
+        out[0] = '\0'; // not even one metric fits
+        return 0;
+    }
+    cursor = p < n ? p : 0;
+    o.len += 2;
+    if (open) o.put("}");
+    o.put("}");
+    return o.at;
+}
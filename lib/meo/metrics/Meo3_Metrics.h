@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include "Meo3_Histogram.h"
+
+// Counters and gauges per registry (MeoDevice uses ~10 plus one per feature method)
+#ifndef MEO_METRICS_MAX
+#define MEO_METRICS_MAX 48
+#endif
+
+#ifndef MEO_METRICS_HISTOGRAMS
+#define MEO_METRICS_HISTOGRAMS 4
+#endif
+
+// Snapshot message on <base>/metrics; must fit MEO_QUEUE_MAX_RECORD (threaded mode).
+// A registry that does not fit is sent as several messages
+#ifndef MEO_METRICS_JSON_BYTES
+#define MEO_METRICS_JSON_BYTES 512
+#endif
+
+// Index into a MeoMetrics registry; -1 when registration failed (recording is then a no-op)
+typedef int8_t MeoMetricId;
+
+enum class MeoMetricKind : uint8_t {
+    COUNTER,   // cumulative since boot, unsigned
+    GAUGE,     // last value set, signed
+    HISTOGRAM, // log2 buckets, reset by each snapshot
+};
+
+/**
+ * MeoMetricHistogram: MeoLatencyHistogram's buckets as relaxed atomics.
+ * - record() from any task: a few atomic adds and a CAS loop for the max, no lock
+ * - take() moves the window into a plain histogram and starts a new one; a record
+ *   racing it may be split across the two windows
+ * - peek() copies the window without resetting it; drop() then removes exactly
+ *   what was copied, keeping records made in between
+ */
+class MeoMetricHistogram {
+public:
+    void record(uint32_t v);
+    void take(MeoLatencyHistogram& out);
+    void peek(MeoLatencyHistogram& out) const;
+    void drop(const MeoLatencyHistogram& seen);
+
+private:
+    std::atomic<uint32_t> _buckets[MeoLatencyHistogram::BUCKETS] = {};
+    std::atomic<uint32_t> _sum{0}; // per window, so 32 bits are enough
+    std::atomic<uint32_t> _max{0};
+};
+
+/**
+ * MeoMetrics: fixed-memory registry of counters, gauges and histograms.
+ * - add*() at setup (not thread-safe); names and labels are not copied
+ * - add()/set()/record() are lock-free and allocation-free from any task
+ * - Counters sharing a name with different labels form one object in the
+ *   snapshot, e.g. "invokes":{"led":3,"fan":1}; zero entries are left out
+ * - A snapshot larger than the caller's buffer is split: each part is a complete
+ *   JSON object, and a labelled object may continue in the next part
+ */
+class MeoMetrics {
+public:
+    MeoMetricId addCounter(const char* name, const char* label = nullptr);
+    MeoMetricId addGauge(const char* name);
+    MeoMetricId addHistogram(const char* name);
+
+    void add(MeoMetricId id, uint32_t n = 1) {
+        if (_valid(id, true)) _values[_entries[id].slot].fetch_add(n, std::memory_order_relaxed);
+    }
+    // Gauges, or counters mirrored from somewhere else (e.g. socket byte counts)
+    void set(MeoMetricId id, int32_t v) {
+        if (_valid(id, true)) _values[_entries[id].slot].store((uint32_t)v, std::memory_order_relaxed);
+    }
+    void record(MeoMetricId id, uint32_t v) {
+        if (_valid(id, false)) _histograms[_entries[id].slot].record(v);
+    }
+    uint32_t value(MeoMetricId id) const {
+        return _valid(id, true) ? _values[_entries[id].slot].load(std::memory_order_relaxed) : 0;
+    }
+
+    // Compact JSON of the metrics in registration order, starting at `cursor` (0 for
+    // a new snapshot) and stopping before the first one that does not fit. `cursor`
+    // is left at that metric, or 0 once the snapshot is complete. Histograms are
+    // emitted as MeoLatencyHistogram::formatJson (or {"n":0}) and reset only once
+    // written. Returns the length; 0 if not even one metric fits in outLen.
+    size_t snapshot(char* out, size_t outLen, uint8_t& cursor);
+
+    uint8_t size() const { return _count; }
+
+private:
+    struct Entry {
+        const char*   name;
+        const char*   label;
+        MeoMetricKind kind;
+        uint8_t       slot; // into _values or _histograms
+    };
+    Entry                 _entries[MEO_METRICS_MAX + MEO_METRICS_HISTOGRAMS];
+    std::atomic<uint32_t> _values[MEO_METRICS_MAX] = {};
+    MeoMetricHistogram    _histograms[MEO_METRICS_HISTOGRAMS];
+    uint8_t               _count = 0;
+    uint8_t               _valueCount = 0;
+    uint8_t               _histogramCount = 0;
+
+    bool _valid(MeoMetricId id, bool value) const {
+        return id >= 0 && id < _count && (_entries[id].kind != MeoMetricKind::HISTOGRAM) == value;
+    }
+    MeoMetricId _add(const char* name, const char* label, MeoMetricKind kind);
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * MeoBackoff: exponential reconnect backoff with jitter.
+ * - Ceiling doubles per consecutive failure, from minMs up to maxMs
+ * - "Equal jitter": the delay is uniform in [ceiling/2, ceiling], so a fleet
+ *   that lost the broker at the same moment does not come back in lockstep
+ * - Randomness is passed in, keeping this deterministic under test
+ */
+class MeoBackoff {
+public:
+    MeoBackoff(uint32_t minMs = 1000, uint32_t maxMs = 60000) { configure(minMs, maxMs); }
+
+    void configure(uint32_t minMs, uint32_t maxMs) {
+        _minMs = minMs ? minMs : 1;
+        _maxMs = maxMs < _minMs ? _minMs : maxMs;
+    }
+
+    // Delay before the next attempt; call once per failed attempt
+    uint32_t next(uint32_t random32) {
+        uint32_t ceiling = _minMs;
+        for (uint8_t i = 0; i < _failures && ceiling < _maxMs; ++i) {
+            ceiling = (ceiling > _maxMs / 2) ? _maxMs : ceiling * 2;
+        }
+        if (ceiling > _maxMs) ceiling = _maxMs;
+        if (_failures < 31) _failures++;
+        uint32_t half = ceiling / 2;
+        return half + random32 % (ceiling - half + 1);
+    }
+
+    void    reset()          { _failures = 0; }
+    uint8_t failures() const { return _failures; }
+
+private:
+    uint32_t _minMs = 1000;
+    uint32_t _maxMs = 60000;
+    uint8_t  _failures = 0;
+};
@@ -1,8 +1,54 @@
 #include "Meo3_Mqtt.h"
 #include <WiFi.h>
 #include <stdarg.h>
+#include <esp_system.h>
 
-MeoMqttClient* MeoMqttClient::_self = nullptr;
+thread_local MeoMqttClient* MeoMqttClient::_dispatching = nullptr;
+
+namespace {
+
+// Small stack buffer between serializers and PubSubClient::write, so the
+// socket sees a few larger writes instead of one per character.
+class ChunkWriter : public Print, public MeoByteSink {
+public:
+    explicit ChunkWriter(Print& out) : _out(out) {}
+    ~ChunkWriter() { flush(); }
+
+    size_t write(uint8_t c) override {
+        if (_len == sizeof(_buf)) flush();
+        _buf[_len++] = c;
+        return 1;
+    }
+    size_t write(const uint8_t* data, size_t len) override {
+        size_t left = len;
+        while (left) {
+            if (_len == sizeof(_buf)) flush();
+            size_t n = sizeof(_buf) - _len;
+            if (n > left) n = left;
+            memcpy(_buf + _len, data, n);
+            _len += n;
+            data += n;
+            left -= n;
+        }
+        return len;
+    }
+    void append(const char* data, size_t len) override {
+        write((const uint8_t*)data, len);
+    }
+    void flush() {
+        if (_len) _written += _out.write(_buf, _len);
+        _len = 0;
+    }
+    size_t written() const { return _written; }
+
+private:
+    Print&        _out;
+    uint8_t       _buf[MEO_MQTT_STREAM_CHUNK];
+    size_t        _len = 0;
+    size_t        _written = 0;
+};
+
+} // namespace
 
 
 // ISRG Root X1 - Let's Encrypt Root CA
@@ -40,13 +86,16 @@ const char* rootCa = "-----BEGIN CERTIFICATE-----\n"
 
 
 MeoMqttClient::MeoMqttClient() {
-    _self = this; // one active instance
-    _wifiClient.setCACert(rootCa);
-    _mqtt.setClient(_wifiClient);
+    _tlsClient.setCACert(rootCa);
+    _tap.setInner(_transport);
+    _tap.setAckHandler(&MeoMqttClient::_ackThunk, this);
+    _mqtt.setClient(_tap);
     _mqtt.setBufferSize(1024);
     _mqtt.setKeepAlive(15);
-    _mqtt.setSocketTimeout(15);
+    _mqtt.setSocketTimeout(_socketTimeoutS);
     _mqtt.setCallback(&MeoMqttClient::_pubsubThunk);
+    _mqtt5.setClient(&_tap);
+    _mqtt5.setMessageHandler(&MeoMqttClient::_mqtt5Thunk, this);
 }
 
 void MeoMqttClient::setLogger(MeoLogFunction logger) {
@@ -54,16 +103,14 @@ void MeoMqttClient::setLogger(MeoLogFunction logger) {
 }
 
 void MeoMqttClient::setDebugTags(const char* tagsCsv) {
-    if (!tagsCsv) { _debugTags[0] = '\0'; return; }
-    strncpy(_debugTags, tagsCsv, sizeof(_debugTags) - 1);
-    _debugTags[sizeof(_debugTags) - 1] = '\0';
+    _debugMask = meoLogTagMask(tagsCsv);
 }
 
 void MeoMqttClient::configure(const char* host, uint16_t port) {
     _host = host;
     _port = port;
     _mqtt.setServer(_host, _port);
-    if (_logger && _debugTagEnabled("MQTT")) {
+    if (_logger && _debugTagEnabled(MEO_LOG_MQTT)) {
         _logf("DEBUG", "MQTT", "Configured broker %s:%u", host ? host : "", port);
     }
 }
@@ -71,19 +118,42 @@ void MeoMqttClient::configure(const char* host, uint16_t port) {
 void MeoMqttClient::setCredentials(const char* deviceId, const char* transmitKey) {
     _deviceId = deviceId;
     _txKey = transmitKey;
-    if (_logger && _debugTagEnabled("MQTT")) {
+    if (_logger && _debugTagEnabled(MEO_LOG_MQTT)) {
         _logf("DEBUG", "MQTT", "Credentials set: deviceId=%s", deviceId ? deviceId : "");
     }
 }
 
 void MeoMqttClient::setBufferSize(uint16_t bytes) {
     _mqtt.setBufferSize(bytes);
+    _mqtt5.setBufferSize(bytes);
 }
 void MeoMqttClient::setKeepAlive(uint16_t seconds) {
     _mqtt.setKeepAlive(seconds);
+    _mqtt5.setKeepAlive(seconds);
 }
 void MeoMqttClient::setSocketTimeout(uint16_t seconds) {
+    _socketTimeoutS = seconds;
     _mqtt.setSocketTimeout(seconds);
+    _mqtt5.setSocketTimeout(seconds);
+}
+
+void MeoMqttClient::setProtocol(MeoMqttProtocol protocol) {
+    _protocol = protocol;
+    _v5Refused = false;
+}
+
+void MeoMqttClient::setTransport(Client* client) {
+    _sessionClose();
+    _transport->stop();
+    _custom = client;
+    _transport = client ? client : &_plainClient;
+    _tap.setInner(_transport);
+}
+
+bool MeoMqttClient::usesTls() const {
+    if (_custom) return false;
+    if (_security == MeoMqttSecurity::AUTO) return _port == 8883;
+    return _security == MeoMqttSecurity::TLS;
 }
 
 void MeoMqttClient::setWill(const char* topic, const char* payload, uint8_t qos, bool retain) {
@@ -94,106 +164,425 @@ void MeoMqttClient::setWill(const char* topic, const char* payload, uint8_t qos,
 }
 
 bool MeoMqttClient::connect() {
-    if (WiFi.status() != WL_CONNECTED) {
+    if (!_linkUp()) {
         _log("ERROR", "MQTT", "WiFi not connected");
         return false;
     }
-    if (_mqtt.connected()) return true;
+    if (_sessionUp()) return true;
 
-    String clientId = _deviceId ? String("meo-") + _deviceId
-                                : String("meo-device-") + String((uint32_t)millis());
+    _selectTransport();
+    bool ok = _mqttConnect();
+    _log(ok ? "INFO" : "ERROR", "MQTT", ok ? "Connected" : "Connect failed");
+    return ok;
+}
 
-    bool ok = false;
-    if (_willTopic) {
-        ok = _mqtt.connect(clientId.c_str(),
-                           "edgemqtt", _txKey,
-                           _willTopic, _willQos, _willRetain, _willPayload);
-    } else {
-        ok = _mqtt.connect(clientId.c_str(), "edgemqtt", _txKey);
+void MeoMqttClient::setAutoConnect(bool enable) {
+    _autoConnect = enable;
+    if (!enable && _state != MeoMqttState::SUBSCRIBED && _state != MeoMqttState::DECLARED) {
+        _setState(MeoMqttState::IDLE);
     }
+}
 
-    _log("DEBUG", clientId.c_str(), _txKey);
-    _log(ok ? "INFO" : "ERROR", "MQTT", ok ? "Connected" : "Connect failed");
-    return ok;
+void MeoMqttClient::setSessionHandler(OnSessionFn fn, void* ctx) {
+    _onSession = fn;
+    _onSessionCtx = ctx;
+}
+
+void MeoMqttClient::setStateHandler(OnStateFn fn, void* ctx) {
+    _onState = fn;
+    _onStateCtx = ctx;
+}
+
+void MeoMqttClient::setBackoff(uint32_t minMs, uint32_t maxMs) {
+    _backoff.configure(minMs, maxMs);
+}
+
+void MeoMqttClient::setAttemptBudget(uint32_t ms) {
+    _attemptBudgetMs = ms ? ms : 1;
 }
 
 void MeoMqttClient::loop() {
-    if (_mqtt.connected()) {
-        _mqtt.loop();
+    if (_sessionUp()) {
+        MeoMqttClient* outer = _dispatching; // a handler may loop() another client
+        _dispatching = this;
+        if (_v5) _mqtt5.loop();
+        else     _mqtt.loop();
+        _dispatching = outer;
+    }
+    // Outside _mqtt.loop(): completion callbacks may publish
+    if (_window.inflight()) _window.poll(millis(), &MeoMqttClient::_sendRaw, this);
+    if (!_autoConnect) return;
+
+    switch (_state) {
+        case MeoMqttState::IDLE:
+            if (_linkUp()) _beginAttempt();
+            break;
+        case MeoMqttState::BACKOFF:
+            if ((int32_t)(millis() - _nextAttemptMs) >= 0 && _linkUp()) {
+                _beginAttempt();
+            }
+            break;
+        case MeoMqttState::TCP:
+        case MeoMqttState::TLS:
+            _stepTransport();
+            break;
+        case MeoMqttState::CONNECT:
+            _stepConnect();
+            break;
+        case MeoMqttState::SUBSCRIBED:
+            _stepSession(MeoMqttState::DECLARED);
+            break;
+        case MeoMqttState::DECLARED:
+            if (!_sessionUp()) _fail("Connection lost");
+            break;
     }
 }
 
 bool MeoMqttClient::isConnected() {
-    return _mqtt.connected();
+    return _sessionUp();
 }
 
 bool MeoMqttClient::publish(const char* topic, const uint8_t* payload, size_t len, bool retained) {
-    if (!_mqtt.connected()) return false;
-    if (_logger && _debugTagEnabled("MQTT")) {
+    if (!_sessionUp()) return false;
+    if (_logger && _debugTagEnabled(MEO_LOG_MQTT)) {
         _logf("DEBUG", "MQTT", "Publish %s len=%u retained=%d", topic ? topic : "", (unsigned)len, retained);
     }
+    if (_v5) {
+        MeoPublishProps typed;
+        return _mqtt5.publish(topic, payload, len, retained, _typed(nullptr, typed, _encoding));
+    }
     return _mqtt.publish(topic, payload, len, retained);
 }
 
 bool MeoMqttClient::publish(const char* topic, const char* payload, bool retained) {
-    if (!_mqtt.connected()) return false;
-    if (_logger && _debugTagEnabled("MQTT")) {
+    if (!_sessionUp()) return false;
+    if (_logger && _debugTagEnabled(MEO_LOG_MQTT)) {
         _logf("DEBUG", "MQTT", "Publish %s str retained=%d", topic ? topic : "", retained);
     }
+    if (_v5) return _mqtt5.publish(topic, (const uint8_t*)payload, payload ? strlen(payload) : 0, retained);
     return _mqtt.publish(topic, payload, retained);
 }
 
+bool MeoMqttClient::publish(const char* topic, const MeoEventFields& fields, bool retained,
+                            const MeoPublishProps* props) {
+    size_t len = fields.measure(_encoding);
+    MeoPublishProps typed;
+    if (!_beginStream(topic, len, retained, _typed(props, typed, _encoding))) return false;
+    ChunkWriter out(_v5 ? (Print&)_tap : (Print&)_mqtt);
+    fields.write(_encoding, out);
+    out.flush();
+    return _endStream(topic, len, out.written());
+}
+
+bool MeoMqttClient::publishJson(const char* topic, const JsonDocument& doc, bool retained) {
+    size_t len = measureJson(doc);
+    if (!_beginStream(topic, len, retained)) return false;
+    ChunkWriter out(_v5 ? (Print&)_tap : (Print&)_mqtt);
+    serializeJson(doc, out);
+    out.flush();
+    return _endStream(topic, len, out.written());
+}
+
+bool MeoMqttClient::publishMsgPack(const char* topic, const JsonDocument& doc, bool retained) {
+    size_t len = measureMsgPack(doc);
+    MeoPublishProps typed;
+    if (!_beginStream(topic, len, retained, _typed(nullptr, typed, MeoPayloadEncoding::MSGPACK))) return false;
+    ChunkWriter out(_v5 ? (Print&)_tap : (Print&)_mqtt);
+    serializeMsgPack(doc, out);
+    out.flush();
+    return _endStream(topic, len, out.written());
+}
+
+uint16_t MeoMqttClient::publishQos1(const char* topic, const uint8_t* payload, size_t len, bool retained,
+                                    MeoPublishDoneFn done, void* ctx) {
+    if (!_sessionUp()) return 0;
+    uint16_t id = _window.add(topic, payload, len, retained, done, ctx, &MeoMqttClient::_sendRaw, this);
+    if (_logger && _debugTagEnabled(MEO_LOG_MQTT)) {
+        _logf(id ? "DEBUG" : "WARN", "MQTT", "Publish %s len=%u qos=1 id=%u%s", topic ? topic : "",
+              (unsigned)len, id, id ? "" : " (rejected)");
+    }
+    return id;
+}
+
+uint16_t MeoMqttClient::publishQos1(const char* topic, const MeoEventFields& fields, bool retained,
+                                    MeoPublishDoneFn done, void* ctx) {
+    if (!_sessionUp()) return 0;
+    // Serialized into the window slot before anything is written, so this is safe from a handler
+    uint16_t id = _window.add(topic, fields, retained, done, ctx, &MeoMqttClient::_sendRaw, this);
+    if (_logger && _debugTagEnabled(MEO_LOG_MQTT)) {
+        _logf(id ? "DEBUG" : "WARN", "MQTT", "Publish %s qos=1 id=%u%s", topic ? topic : "",
+              id, id ? "" : " (rejected)");
+    }
+    return id;
+}
+
 bool MeoMqttClient::subscribe(const char* topic, uint8_t qos) {
-    if (!_mqtt.connected()) return false;
-    bool ok = _mqtt.subscribe(topic, qos);
-    if (_logger && _debugTagEnabled("MQTT")) {
+    if (!_sessionUp()) return false;
+    bool ok = _v5 ? _mqtt5.subscribe(topic, qos) : _mqtt.subscribe(topic, qos);
+    if (_logger && _debugTagEnabled(MEO_LOG_MQTT)) {
         _logf(ok ? "DEBUG" : "ERROR", "MQTT", "%s subscribe %s",
               ok ? "OK" : "FAIL", topic ? topic : "");
     }
     return ok;
 }
 
+bool MeoMqttClient::_beginStream(const char* topic, size_t len, bool retained, const MeoPublishProps* props) {
+    if (!_sessionUp() || !topic) return false;
+    if (_logger && _debugTagEnabled(MEO_LOG_MQTT)) {
+        _logf("DEBUG", "MQTT", "Publish %s len=%u retained=%d (stream)", topic, (unsigned)len, retained);
+    }
+    if (_v5) return _mqtt5.beginPublish(topic, len, retained, props);
+    return _mqtt.beginPublish(topic, (unsigned int)len, retained);
+}
+
+// MQTT 5: `props` plus a Content Type for MessagePack payloads
+const MeoPublishProps* MeoMqttClient::_typed(const MeoPublishProps* props, MeoPublishProps& scratch,
+                                             MeoPayloadEncoding enc) const {
+    if (!_v5 || enc != MeoPayloadEncoding::MSGPACK) return props;
+    if (props) scratch = *props;
+    scratch.contentType = meoContentType(enc);
+    return &scratch;
+}
+
+bool MeoMqttClient::_endStream(const char* topic, size_t expected, size_t written) {
+    if (written != expected) {
+        // The broker is still waiting for the declared length; the session is unusable
+        _logf("ERROR", "MQTT", "Short write on %s (%u/%u); dropping connection",
+              topic ? topic : "", (unsigned)written, (unsigned)expected);
+        _sessionClose();
+        return false;
+    }
+    return _v5 || _mqtt.endPublish() == 1;
+}
+
 void MeoMqttClient::setMessageHandler(OnMessageFn fn, void* ctx) {
     _onMessage = fn;
     _onMessageCtx = ctx;
 }
 
+bool MeoMqttClient::_mqttConnect() {
+    String clientId = _deviceId ? String("meo-") + _deviceId
+                                : String("meo-device-") + String((uint32_t)millis());
+    _v5 = _protocol == MeoMqttProtocol::V5 && !_v5Refused;
+    if (_window.mqtt5() != _v5) {
+        // Inflight packets are encoded for the other protocol level
+        _window.failAll();
+        _window.setMqtt5(_v5);
+    }
+    if (_v5) {
+        MeoMqtt5Result r = _mqtt5.connect(_host, _port, clientId.c_str(), "edgemqtt", _txKey,
+                                          _willTopic, _willQos, _willRetain, _willPayload);
+        if (r == MeoMqtt5Result::OK) {
+            _logf("INFO", "MQTT", "MQTT 5 session, %u topic aliases", (unsigned)_mqtt5.aliasMaximum());
+            return true;
+        }
+        if (r != MeoMqtt5Result::UNSUPPORTED) return false;
+        // PubSubClient reopens the socket below
+        _log("WARN", "MQTT", "Broker refused MQTT 5; falling back to 3.1.1");
+        _v5Refused = true;
+        _v5 = false;
+        _window.failAll();
+        _window.setMqtt5(false);
+    }
+    if (_willTopic) {
+        return _mqtt.connect(clientId.c_str(),
+                             "edgemqtt", _txKey,
+                             _willTopic, _willQos, _willRetain, _willPayload);
+    }
+    return _mqtt.connect(clientId.c_str(), "edgemqtt", _txKey);
+}
+
+void MeoMqttClient::_setState(MeoMqttState next) {
+    if (next == _state) return;
+    uint32_t now = millis();
+    MeoMqttState prev = _state;
+    uint32_t elapsed = now - _stateSinceMs;
+    _state = next;
+    _stateSinceMs = now;
+    if (_logger && _debugTagEnabled(MEO_LOG_MQTT)) {
+        _logf("DEBUG", "MQTT", "State %s -> %s (%lu ms)",
+              meoMqttStateName(prev), meoMqttStateName(next), (unsigned long)elapsed);
+    }
+    if (_onState) _onState(prev, next, elapsed, _onStateCtx);
+}
+
+void MeoMqttClient::_beginAttempt() {
+    _attempts++;
+    _attemptStartMs = millis();
+    bool tls = _selectTransport();
+    // MeoTlsClient performs TCP connect and TLS handshake in one call
+    _setState(tls ? MeoMqttState::TLS : MeoMqttState::TCP);
+}
+
+// Pick the socket per attempt, so a security change applies on the next connect
+bool MeoMqttClient::_selectTransport() {
+    bool tls = usesTls();
+    Client* next = _custom ? _custom : tls ? (Client*)&_tlsClient : (Client*)&_plainClient;
+    if (next != _transport) {
+        _transport->stop();
+        _transport = next;
+        _tap.setInner(_transport);
+    }
+    return tls;
+}
+
+bool MeoMqttClient::_linkUp() const {
+    return _custom || WiFi.status() == WL_CONNECTED;
+}
+
+void MeoMqttClient::_stepTransport() {
+    if (!_linkUp()) { _fail("WiFi not connected"); return; }
+    if (_custom) {
+        if (!_custom->connect(_host, _port)) { _fail("Transport connect failed"); return; }
+        _setState(MeoMqttState::CONNECT);
+        return;
+    }
+
+    bool tls = (_transport == &_tlsClient);
+    MeoTransportStats& stats = tls ? _tlsStats : _plainStats;
+    uint32_t heapBefore = ESP.getFreeHeap();
+    uint32_t t0 = micros();
+    bool ok;
+    if (tls) {
+        _tlsClient.setHandshakeTimeout((_attemptBudgetMs + 999) / 1000);
+        ok = _tlsClient.connect(_host, _port, (int32_t)_attemptBudgetMs);
+    } else {
+        ok = _plainClient.connect(_host, _port, (int32_t)_attemptBudgetMs);
+        if (ok) _plainClient.setNoDelay(true); // small MQTT packets: don't wait on Nagle
+    }
+    uint32_t us = micros() - t0;
+    if (!ok) {
+        stats.failures++;
+        _fail(tls ? "TLS connect failed" : "TCP connect failed");
+        return;
+    }
+    stats.connects++;
+    bool resumed = tls && _tlsClient.lastResumed();
+    if (resumed) stats.resumed++;
+    stats.lastConnectMs = us / 1000;
+    stats.connectUs.record(us);
+    stats.lastHeapBytes = (int32_t)(heapBefore - ESP.getFreeHeap());
+    if (stats.lastHeapBytes > stats.maxHeapBytes) stats.maxHeapBytes = stats.lastHeapBytes;
+    _logf("INFO", "MQTT", "%s up in %lu ms%s, heap %ld B", tls ? "TLS" : "TCP",
+          (unsigned long)stats.lastConnectMs, resumed ? " (resumed)" : "", (long)stats.lastHeapBytes);
+    _setState(MeoMqttState::CONNECT);
+}
+
+void MeoMqttClient::_stepConnect() {
+    // The socket is already open, so PubSubClient only exchanges CONNECT/CONNACK;
+    // bound the CONNACK wait by the attempt budget. The session keeps the configured
+    // socket timeout: PubSubClient also waits that long on a packet that stalls midway
+    uint16_t seconds = (uint16_t)((_attemptBudgetMs + 999) / 1000);
+    _mqtt.setSocketTimeout(seconds);
+    _mqtt5.setSocketTimeout(seconds);
+    bool ok = _mqttConnect();
+    _mqtt.setSocketTimeout(_socketTimeoutS);
+    _mqtt5.setSocketTimeout(_socketTimeoutS);
+    if (!ok) {
+        _logf("ERROR", "MQTT", "CONNECT rejected (%s=%d)", _v5 ? "reason" : "state",
+              _v5 ? (int)_mqtt5.reasonCode() : _mqtt.state());
+        _fail("MQTT connect failed");
+        return;
+    }
+    _log("INFO", "MQTT", "Connected");
+    _window.rewind(); // resend what the last session never acknowledged
+    _stepSession(MeoMqttState::SUBSCRIBED);
+}
+
+void MeoMqttClient::_stepSession(MeoMqttState next) {
+    if (!_sessionUp()) { _fail("Connection lost"); return; }
+    if (_onSession && !_onSession(next, _onSessionCtx)) {
+        _fail(next == MeoMqttState::SUBSCRIBED ? "Subscribe failed" : "Declare failed");
+        return;
+    }
+    if (next == MeoMqttState::DECLARED) {
+        _lastConnectMs = millis() - _attemptStartMs;
+        _backoff.reset();
+    }
+    _setState(next);
+}
+
+bool MeoMqttClient::_sessionUp() {
+    return _v5 ? _mqtt5.connected() : _mqtt.connected();
+}
+
+void MeoMqttClient::_sessionClose() {
+    if (_v5) _mqtt5.disconnect();
+    else if (_mqtt.connected()) _mqtt.disconnect();
+}
+
+void MeoMqttClient::_fail(const char* reason) {
+    _sessionClose();
+    _tap.stop();
+    uint32_t delayMs = _backoff.next(esp_random());
+    _nextAttemptMs = millis() + delayMs;
+    _logf("WARN", "MQTT", "%s; retry in %lu ms", reason, (unsigned long)delayMs);
+    _setState(MeoMqttState::BACKOFF);
+}
+
+const char* meoMqttStateName(MeoMqttState state) {
+    switch (state) {
+        case MeoMqttState::IDLE:       return "IDLE";
+        case MeoMqttState::BACKOFF:    return "BACKOFF";
+        case MeoMqttState::TCP:        return "TCP";
+        case MeoMqttState::TLS:        return "TLS";
+        case MeoMqttState::CONNECT:    return "CONNECT";
+        case MeoMqttState::SUBSCRIBED: return "SUBSCRIBED";
+        case MeoMqttState::DECLARED:   return "DECLARED";
+    }
+    return "?";
+}
+
 void MeoMqttClient::_pubsubThunk(char* topic, uint8_t* payload, unsigned int length) {
-    if (_self) _self->_invokeMessageHandler(topic, payload, length);
+    if (_dispatching) _dispatching->_invokeMessageHandler(topic, payload, length);
 }
 
 void MeoMqttClient::_invokeMessageHandler(char* topic, uint8_t* payload, unsigned int length) {
     if (_onMessage) {
-        if (_logger && _debugTagEnabled("MQTT")) {
+        if (_logger && _debugTagEnabled(MEO_LOG_MQTT)) {
             _logf("DEBUG", "MQTT", "Incoming %s len=%u", topic ? topic : "", length);
         }
         _onMessage(topic, payload, length, _onMessageCtx);
     }
 }
 
-bool MeoMqttClient::_debugTagEnabled(const char* tag) const {
-    if (!_debugTags[0]) return false;
-    const char* p = strstr(_debugTags, tag);
-    if (!p) return false;
-    bool leftOk  = (p == _debugTags) || (*(p - 1) == ',');
-    const char* end = p + strlen(tag);
-    bool rightOk = (*end == '\0') || (*end == ',');
-    return leftOk && rightOk;
+void MeoMqttClient::_mqtt5Thunk(char* topic, uint8_t* payload, unsigned int length,
+                                const MeoMqtt5Request& request, void* ctx) {
+    MeoMqttClient* self = static_cast<MeoMqttClient*>(ctx);
+    // A request whose reply address does not fit is dropped, not run: its answer could
+    // not reach the requester (or be matched by it), which then times out instead
+    if ((request.responseTopic && request.responseTopicLen >= sizeof(self->_replyTopic)) ||
+        (request.correlation && request.correlationLen > sizeof(self->_correlation))) {
+        self->_requestsDropped++;
+        self->_logf("WARN", "MQTT", "Request on %s dropped: response topic %u B, correlation %u B (max %u/%u)",
+                    topic ? topic : "", (unsigned)request.responseTopicLen, (unsigned)request.correlationLen,
+                    (unsigned)(sizeof(self->_replyTopic) - 1), (unsigned)sizeof(self->_correlation));
+        return;
+    }
+    // Copied: the handler may answer after publishing something else
+    if (request.responseTopic) {
+        memcpy(self->_replyTopic, request.responseTopic, request.responseTopicLen);
+        self->_replyTopic[request.responseTopicLen] = '\0';
+    }
+    if (request.correlation) {
+        memcpy(self->_correlation, request.correlation, request.correlationLen);
+        self->_correlationLen = request.correlationLen;
+    }
+    self->_invokeMessageHandler(topic, payload, length);
+    self->_replyTopic[0] = '\0';
+    self->_correlationLen = 0;
 }
 
-void MeoMqttClient::_log(const char* level, const char* tag, const char* msg) const {
-    if (!_logger) return;
-    char buf[256];
-    snprintf(buf, sizeof(buf), "[%s] %s", tag ? tag : "MQTT", msg ? msg : "");
-    _logger(level, buf);
+void MeoMqttClient::_ackThunk(uint16_t packetId, uint8_t reason, void* ctx) {
+    MeoMqttClient* self = static_cast<MeoMqttClient*>(ctx);
+    if (!self->_window.ack(packetId, reason)) return;
+    if (reason >= 0x80) self->_logf("WARN", "MQTT", "PUBACK %u refused (reason 0x%02X)", packetId, reason);
 }
 
-void MeoMqttClient::_logf(const char* level, const char* tag, const char* fmt, ...) const {
-    if (!_logger) return;
-    char msg[192];
-    va_list ap;
-    va_start(ap, fmt);
-    vsnprintf(msg, sizeof(msg), fmt, ap);
-    va_end(ap);
-    _log(level, tag, msg);
-}
\ No newline at end of file
+// PubSubClient::write goes straight to the socket without touching its buffer
+bool MeoMqttClient::_sendRaw(const uint8_t* packet, size_t len, void* ctx) {
+    MeoMqttClient* self = static_cast<MeoMqttClient*>(ctx);
+    if (!self->_sessionUp()) return false;
+    if (self->_v5) return self->_tap.write(packet, len) == len;
+    return self->_mqtt.write(packet, len) == len;
+}
@@ -1,25 +1,88 @@
 #pragma once
 
 #include <Arduino.h>
-#include <WiFiClientSecure.h>
+#include <WiFiClient.h>
 #include <PubSubClient.h>
+#include <ArduinoJson.h>
 #include "../Meo3_Type.h" // MeoLogFunction
+#include "../Meo3_BinLog.h" // meoLogEmit, MeoLogTag
+#include "../Meo3_EventFields.h"
+#include "Meo3_Backoff.h"
+#include "Meo3_MqttQos.h"
+#include "Meo3_Mqtt5.h"
+#include "Meo3_TlsClient.h"
+#include "../metrics/Meo3_Histogram.h"
+
+// Bytes buffered on the stack while streaming a payload into the socket
+#ifndef MEO_MQTT_STREAM_CHUNK
+#define MEO_MQTT_STREAM_CHUNK 64
+#endif
+
+// Connection lifecycle driven by MeoMqttClient::loop() when auto-connect is on
+enum class MeoMqttState : uint8_t {
+    IDLE = 0,    // not connecting (auto-connect off or WiFi down)
+    BACKOFF,     // waiting for the next attempt
+    TCP,         // opening a plain TCP socket
+    TLS,         // opening a TLS socket (TCP connect + handshake in one step)
+    CONNECT,     // MQTT CONNECT/CONNACK
+    SUBSCRIBED,  // session up, subscriptions done
+    DECLARED     // session up, device declared: ready
+};
+
+const char* meoMqttStateName(MeoMqttState state);
+
+// Socket used by the built-in transport
+enum class MeoMqttSecurity : uint8_t {
+    AUTO = 0, // TLS on port 8883, plain TCP otherwise
+    PLAIN,    // WiFiClient: trusted LAN gateway, no handshake, no mbedTLS heap
+    TLS       // MeoTlsClient with the embedded root CA; reconnects resume the last session
+};
+
+// Transport connects of one kind (plain or TLS)
+struct MeoTransportStats {
+    uint32_t connects = 0;        // sockets opened (TCP + handshake done)
+    uint32_t failures = 0;
+    uint32_t resumed = 0;         // TLS connects that resumed the saved session
+    uint32_t lastConnectMs = 0;   // TCP connect, plus the TLS handshake for TLS
+    int32_t  lastHeapBytes = 0;   // free heap lost across the connect (session buffers)
+    int32_t  maxHeapBytes = 0;
+    MeoLatencyHistogram connectUs;
+};
 
 /**
  * MeoMqtt: minimal MQTT transport wrapper around PubSubClient.
  * - Keeps RAM/flash low
  * - Clean separation from device/feature logic
  * - Delivers raw messages via a lightweight function pointer callback
+ * - Many instances per process (simulators, multi-broker hosts)
+ * - Streams structured payloads straight into the socket (beginPublish/endPublish),
+ *   so payload size is not bounded by setBufferSize()
+ * - Optional auto-connect: loop() runs one bounded step of the connection state
+ *   machine per call, with exponential backoff + jitter between failed attempts
+ * - QoS 1 publishes with a bounded inflight window; PubSubClient only sends QoS 0,
+ *   so those packets are encoded here and PUBACKs are picked off the socket by a tap
+ * - Optional MQTT 5 session (MeoMqtt5) with topic aliases and request/response
+ *   properties; PubSubClient stays the 3.1.1 path and the fallback
  */
 class MeoMqttClient {
 public:
+    // topic/payload live in the client's receive buffer and are valid only during the call.
+    // PubSubClient builds outgoing packets in that same buffer, so a handler must copy
+    // whatever it still needs before it publishes
     typedef void (*OnMessageFn)(const char* topic, const uint8_t* payload, unsigned int length, void* ctx);
+    // Called on entering SUBSCRIBED (subscribe now) and DECLARED (announce now);
+    // returning false drops the session and backs off
+    typedef bool (*OnSessionFn)(MeoMqttState step, void* ctx);
+    // Called on every state change; elapsedMs is the time spent in `from`
+    typedef void (*OnStateFn)(MeoMqttState from, MeoMqttState to, uint32_t elapsedMs, void* ctx);
 
     MeoMqttClient();
 
     // Logging
     void setLogger(MeoLogFunction logger);
     void setDebugTags(const char* tagsCsv); // enables DEBUG for "MQTT" when tag present
+    void setDebugMask(uint32_t mask) { _debugMask = mask; } // MeoLogTag bits
+    void setBinaryLog(MeoBinLog* log) { _binLog = log; }    // nullptr: format on the spot
 
     // Configure broker host and port
     void configure(const char* host, uint16_t port = 1883);
@@ -32,12 +95,52 @@ public:
     void setKeepAlive(uint16_t seconds);    // default 15
     void setSocketTimeout(uint16_t seconds);// default 15
 
+    // Built-in socket: plain TCP or TLS, chosen at each connect (default AUTO)
+    void setSecurity(MeoMqttSecurity mode) { _security = mode; }
+    bool usesTls() const;
+    // Also keep the TLS session under `key` (kept by pointer), so the first connect
+    // after a reboot resumes too. nullptr: RAM only (the default)
+    void setTlsSessionStore(MeoStorage* storage, const char* key) { _tlsClient.session().setStore(storage, key); }
+
+    // Wire protocol, default 3.1.1. With V5 each connect offers MQTT 5 until a broker
+    // refuses it; from then on this client stays on 3.1.1 (setProtocol() re-arms V5).
+    void setProtocol(MeoMqttProtocol protocol);
+    bool usesMqtt5() const { return _v5; } // protocol of the current (or last) session
+    // MQTT 5: after its first publish on a connection, `topic` is sent as a 2-byte alias
+    // (up to the broker's Topic Alias Maximum). The pointer is kept.
+    bool addTopicAlias(const char* topic) { return _mqtt5.addTopicAlias(topic); }
+    void clearTopicAliases()              { _mqtt5.clearTopicAliases(); }
+    uint16_t topicAliasMaximum() const    { return _v5 ? _mqtt5.aliasMaximum() : 0; }
+
+    // Encoding of structured publishes (fields, QoS 1 fields); byte payloads handed to
+    // publish()/publishQos1() are taken to be in it too. On MQTT 5, MessagePack
+    // publishes carry Content Type "application/msgpack".
+    void setPayloadEncoding(MeoPayloadEncoding enc) { _encoding = enc; _window.setEncoding(enc); }
+    MeoPayloadEncoding payloadEncoding() const      { return _encoding; }
+
+    // Replace the built-in socket with another Client (Ethernet, tests,
+    // benchmarks); nullptr restores it. Custom transports skip the WiFi check.
+    void setTransport(Client* client);
+
     // Optional Last Will
     void setWill(const char* topic, const char* payload, uint8_t qos = 0, bool retain = true);
 
-    // Connect to broker; returns true on success
+    // Connect to broker (blocking); returns true on success
     bool connect();
 
+    // Non-blocking connection management, driven by loop()
+    void setAutoConnect(bool enable);
+    void setSessionHandler(OnSessionFn fn, void* ctx);
+    void setStateHandler(OnStateFn fn, void* ctx);
+    void setBackoff(uint32_t minMs, uint32_t maxMs);  // default 1 s .. 60 s
+    void setAttemptBudget(uint32_t ms);               // per connect step, default 8 s
+
+    MeoMqttState state() const       { return _state; }
+    uint32_t connectAttempts() const { return _attempts; }
+    uint32_t lastConnectMs() const   { return _lastConnectMs; } // attempt start -> DECLARED
+    // Connect time and heap cost of the built-in transport, per kind
+    const MeoTransportStats& transportStats(bool tls) const { return tls ? _tlsStats : _plainStats; }
+
     // Must be called frequently to process incoming/outgoing MQTT traffic
     void loop();
 
@@ -46,10 +149,34 @@ public:
     // Raw publish/subscribe
     bool publish(const char* topic, const uint8_t* payload, size_t len, bool retained = false);
     bool publish(const char* topic, const char* payload, bool retained = false);
+    // Streaming publish: length is measured first, then the payload (JSON or MessagePack,
+    // see setPayloadEncoding) is written straight to the socket.
+    // `props` (correlation data, user properties) only go out on MQTT 5 sessions.
+    bool publish(const char* topic, const MeoEventFields& fields, bool retained = false,
+                 const MeoPublishProps* props = nullptr);
+    bool publishJson(const char* topic, const JsonDocument& doc, bool retained = false);
+    bool publishMsgPack(const char* topic, const JsonDocument& doc, bool retained = false);
+    // QoS 1: returns the packet id (0 = window full, payload too large or not connected).
+    // `done` runs from loop() once the PUBACK arrives or retries run out.
+    uint16_t publishQos1(const char* topic, const uint8_t* payload, size_t len, bool retained = false,
+                         MeoPublishDoneFn done = nullptr, void* ctx = nullptr);
+    uint16_t publishQos1(const char* topic, const MeoEventFields& fields, bool retained = false,
+                         MeoPublishDoneFn done = nullptr, void* ctx = nullptr);
+    const MeoInflightStats& inflightStats() const { return _window.stats(); }
     bool subscribe(const char* topic, uint8_t qos = 0);
 
     // Set message handler (function pointer)
     void setMessageHandler(OnMessageFn fn, void* ctx);
+    // MQTT 5 request properties of the message being handled; valid only inside the handler
+    const char* responseTopic() const { return _replyTopic[0] ? _replyTopic : nullptr; }
+    const uint8_t* correlationData(uint16_t& len) const { len = _correlationLen; return _correlation; }
+    // MQTT 5 requests not handed to the handler: response topic over MEO_MQTT5_REPLY_TOPIC - 1
+    // or correlation data over MEO_MQTT5_CORRELATION bytes
+    uint32_t requestsDropped() const { return _requestsDropped; }
+
+    // MQTT bytes on the wire, both directions (TLS overhead not included)
+    uint32_t bytesSent() const     { return _tap.bytesOut(); }
+    uint32_t bytesReceived() const { return _tap.bytesIn(); }
 
     // Accessors
     const char* host() const { return _host; }
@@ -67,21 +194,81 @@ private:
     uint8_t      _willQos = 0;
     bool         _willRetain = true;
 
-    WiFiClientSecure   _wifiClient;
+    WiFiClient         _plainClient;
+    MeoTlsClient       _tlsClient;  // mbedTLS buffers are only allocated while connected
+    Client*      _custom = nullptr;     // setTransport()
+    Client*      _transport = &_plainClient; // socket of the current attempt
+    MeoMqttSecurity _security = MeoMqttSecurity::AUTO;
+    MeoTransportStats _plainStats;
+    MeoTransportStats _tlsStats;
+    MeoMqttTap   _tap;                  // between PubSubClient and _transport
     PubSubClient _mqtt;
+    MeoMqtt5     _mqtt5;
+    MeoMqttProtocol _protocol = MeoMqttProtocol::V3_1_1;
+    bool         _v5 = false;           // session speaks MQTT 5 (_mqtt5), else PubSubClient
+    bool         _v5Refused = false;    // broker turned level 5 down; stay on 3.1.1
+    char         _replyTopic[MEO_MQTT5_REPLY_TOPIC] = {0};
+    uint8_t      _correlation[MEO_MQTT5_CORRELATION];
+    uint16_t     _correlationLen = 0;
+    uint32_t     _requestsDropped = 0;
+    MeoInflightWindow _window;
+    MeoPayloadEncoding _encoding = MeoPayloadEncoding::JSON;
+
+    // Connection state machine
+    bool         _autoConnect = false;
+    MeoMqttState _state = MeoMqttState::IDLE;
+    uint32_t     _stateSinceMs = 0;
+    uint32_t     _attemptStartMs = 0;
+    uint32_t     _nextAttemptMs = 0;
+    uint32_t     _attemptBudgetMs = 8000;
+    uint16_t     _socketTimeoutS = 15;  // setSocketTimeout(); the CONNECT step lowers it briefly
+    uint32_t     _attempts = 0;
+    uint32_t     _lastConnectMs = 0;
+    MeoBackoff   _backoff;
+    OnSessionFn  _onSession = nullptr;
+    void*        _onSessionCtx = nullptr;
+    OnStateFn    _onState = nullptr;
+    void*        _onStateCtx = nullptr;
 
     OnMessageFn  _onMessage = nullptr;
     void*        _onMessageCtx = nullptr;
 
     // Logging
     MeoLogFunction _logger = nullptr;
-    char           _debugTags[96] = {0};
+    uint32_t       _debugMask = 0; // MeoLogTag bits, resolved by setDebugTags()
+    MeoBinLog*     _binLog = nullptr; // deferred mode: log calls go to this ring
 
-    static MeoMqttClient* _self;
+    // Client whose _mqtt.loop() is running on this thread; PubSubClient only
+    // calls back from inside loop(), so any number of clients can coexist
+    static thread_local MeoMqttClient* _dispatching;
     static void _pubsubThunk(char* topic, uint8_t* payload, unsigned int length);
     void _invokeMessageHandler(char* topic, uint8_t* payload, unsigned int length);
+    static void _mqtt5Thunk(char* topic, uint8_t* payload, unsigned int length,
+                            const MeoMqtt5Request& request, void* ctx);
+    static void _ackThunk(uint16_t packetId, uint8_t reason, void* ctx);
+    static bool _sendRaw(const uint8_t* packet, size_t len, void* ctx);
+    bool _mqttConnect();
+    bool _sessionUp();
+    void _sessionClose();
+    bool _selectTransport();
+    bool _linkUp() const;
+    void _setState(MeoMqttState next);
+    void _beginAttempt();
+    void _stepTransport();
+    void _stepConnect();
+    void _stepSession(MeoMqttState next);
+    void _fail(const char* reason);
+    bool _beginStream(const char* topic, size_t len, bool retained, const MeoPublishProps* props = nullptr);
+    bool _endStream(const char* topic, size_t expected, size_t written);
+    const MeoPublishProps* _typed(const MeoPublishProps* props, MeoPublishProps& scratch,
+                                  MeoPayloadEncoding enc) const;
 
-    bool _debugTagEnabled(const char* tag) const;
-    void _log(const char* level, const char* tag, const char* msg) const;
-    void _logf(const char* level, const char* tag, const char* fmt, ...) const;
+    bool _debugTagEnabled(uint32_t tag) const { return meoLogDebugOn(_debugMask, tag); }
+    void _log(const char* level, const char* tag, const char* msg) const {
+        if (meoLogCompiled(level) && _logger) meoLogEmitMsg(_logger, _binLog, level, tag ? tag : "MQTT", msg);
+    }
+    template <typename... Args>
+    void _logf(const char* level, const char* tag, const char* fmt, Args... args) const {
+        if (meoLogCompiled(level) && _logger) meoLogEmit(_logger, _binLog, level, tag ? tag : "MQTT", fmt, args...);
+    }
 };
\ No newline at end of file
@@ -0,0 +1,503 @@
+#include "Meo3_Mqtt5.h"
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+// MQTT 5 property identifiers used here
+constexpr uint8_t PROP_CONTENT_TYPE      = 0x03;
+constexpr uint8_t PROP_RESPONSE_TOPIC    = 0x08;
+constexpr uint8_t PROP_CORRELATION_DATA  = 0x09;
+constexpr uint8_t PROP_SERVER_KEEP_ALIVE = 0x13;
+constexpr uint8_t PROP_TOPIC_ALIAS_MAX   = 0x22;
+constexpr uint8_t PROP_TOPIC_ALIAS       = 0x23;
+constexpr uint8_t PROP_USER_PROPERTY     = 0x26;
+constexpr uint8_t PROP_MAX_PACKET_SIZE   = 0x27;
+
+constexpr uint8_t REASON_UNSUPPORTED_VERSION = 0x84;
+
+size_t varintSize(uint32_t v) {
+    return v < 128 ? 1 : v < 16384 ? 2 : v < 2097152 ? 3 : 4;
+}
+
+bool readVarint(const uint8_t*& p, const uint8_t* end, uint32_t& out) {
+    out = 0;
+    uint32_t mul = 1;
+    for (int i = 0; i < 4 && p < end; ++i) {
+        uint8_t b = *p++;
+        out += (uint32_t)(b & 0x7F) * mul;
+        if (!(b & 0x80)) return true;
+        mul *= 128;
+    }
+    return false;
+}
+
+uint16_t readU16(const uint8_t* p) { return (uint16_t)((p[0] << 8) | p[1]); }
+
+// Step over one property value; false if the id is unknown or the value is truncated
+bool skipProperty(uint8_t id, const uint8_t*& p, const uint8_t* end) {
+    size_t n;
+    switch (id) {
+        case 0x01: case 0x17: case 0x19: case 0x24: case 0x25: case 0x28: case 0x29: case 0x2A:
+            n = 1; break;
+        case 0x13: case 0x21: case 0x22: case 0x23:
+            n = 2; break;
+        case 0x02: case 0x11: case 0x18: case 0x27:
+            n = 4; break;
+        case 0x0B: {
+            uint32_t v;
+            return readVarint(p, end, v);
+        }
+        case 0x03: case 0x08: case 0x09: case 0x12: case 0x15: case 0x16: case 0x1A: case 0x1C: case 0x1F:
+            if (end - p < 2) return false;
+            n = 2 + readU16(p);
+            break;
+        case 0x26: { // string pair
+            if (end - p < 2) return false;
+            size_t k = 2 + readU16(p);
+            if ((size_t)(end - p) < k + 2) return false;
+            n = k + 2 + readU16(p + k);
+            break;
+        }
+        default:
+            return false;
+    }
+    if ((size_t)(end - p) < n) return false;
+    p += n;
+    return true;
+}
+
+// Packet header assembly: a small stack buffer in front of Client::write
+class Out {
+public:
+    explicit Out(Client& client) : _client(client) {}
+
+    void u8(uint8_t b) {
+        if (_len == sizeof(_buf)) flush();
+        _buf[_len++] = b;
+    }
+    void u16(uint16_t v) { u8((uint8_t)(v >> 8)); u8((uint8_t)v); }
+    void u32(uint32_t v) { u16((uint16_t)(v >> 16)); u16((uint16_t)v); }
+    void varint(uint32_t v) {
+        do {
+            uint8_t digit = v % 128;
+            v /= 128;
+            u8((uint8_t)(digit | (v ? 0x80 : 0)));
+        } while (v);
+    }
+    void bytes(const void* data, size_t len) {
+        const uint8_t* p = (const uint8_t*)data;
+        while (len) {
+            if (_len == sizeof(_buf)) flush();
+            size_t n = sizeof(_buf) - _len;
+            if (n > len) n = len;
+            memcpy(_buf + _len, p, n);
+            _len += n;
+            p += n;
+            len -= n;
+        }
+    }
+    void str(const char* s, size_t len) { u16((uint16_t)len); bytes(s, len); }
+    bool flush() {
+        if (_len && _client.write(_buf, _len) != _len) _ok = false;
+        _len = 0;
+        return _ok;
+    }
+
+private:
+    Client& _client;
+    uint8_t _buf[64];
+    size_t  _len = 0;
+    bool    _ok = true;
+};
+
+} // namespace
+
+MeoMqtt5::~MeoMqtt5() {
+    free(_buf);
+}
+
+void MeoMqtt5::setBufferSize(uint16_t bytes) {
+    _bufSize = bytes < 16 ? 16 : bytes;
+}
+
+MeoMqtt5Result MeoMqtt5::connect(const char* host, uint16_t port, const char* clientId,
+                                 const char* user, const char* pass,
+                                 const char* willTopic, uint8_t willQos, bool willRetain, const char* willPayload) {
+    if (!_client || !clientId) return MeoMqtt5Result::NO_SOCKET;
+    if (_bufAlloc != _bufSize) {
+        uint8_t* buf = (uint8_t*)realloc(_buf, _bufSize);
+        if (!buf) return MeoMqtt5Result::NO_SOCKET;
+        _buf = buf;
+        _bufAlloc = _bufSize;
+    }
+    if (!_client->connected() && (!host || !_client->connect(host, port))) return MeoMqtt5Result::NO_SOCKET;
+
+    _connected = false;
+    _pingOutstanding = false;
+    _aliasMax = 0;
+    _maxPacket = 0;
+    _sessionKeepAliveS = _keepAliveS;
+    _reason = 0;
+    for (bool& sent : _aliasSent) sent = false;
+
+    size_t idLen = strlen(clientId);
+    size_t wtLen = willTopic ? strlen(willTopic) : 0;
+    size_t wpLen = willPayload ? strlen(willPayload) : 0;
+    size_t userLen = user ? strlen(user) : 0;
+    size_t passLen = pass ? strlen(pass) : 0;
+
+    uint8_t flags = 0x02; // clean start
+    const uint32_t propLen = 5; // Maximum Packet Size = our receive buffer
+    uint32_t remaining = 10 + varintSize(propLen) + propLen + 2 + idLen;
+    if (willTopic) {
+        flags |= (uint8_t)(0x04 | ((willQos & 0x03) << 3) | (willRetain ? 0x20 : 0));
+        remaining += 1 + 2 + wtLen + 2 + wpLen; // empty will properties
+    }
+    if (user) { flags |= 0x80; remaining += 2 + userLen; }
+    if (pass) { flags |= 0x40; remaining += 2 + passLen; }
+
+    Out o(*_client);
+    o.u8(0x10);
+    o.varint(remaining);
+    o.str("MQTT", 4);
+    o.u8(5);
+    o.u8(flags);
+    o.u16(_keepAliveS);
+    o.varint(propLen);
+    o.u8(PROP_MAX_PACKET_SIZE);
+    o.u32(_bufAlloc);
+    o.str(clientId, idLen);
+    if (willTopic) {
+        o.varint(0);
+        o.str(willTopic, wtLen);
+        o.str(willPayload ? willPayload : "", wpLen);
+    }
+    if (user) o.str(user, userLen);
+    if (pass) o.str(pass, passLen);
+    if (!o.flush()) {
+        _client->stop();
+        return MeoMqtt5Result::NO_SOCKET;
+    }
+    _lastOutMs = millis();
+
+    uint8_t header;
+    uint32_t len;
+    bool fits;
+    if (!_readPacket(header, len, fits)) {
+        // A 3.1.1-only broker may simply hang up on protocol level 5
+        bool closed = !_client->connected();
+        _client->stop();
+        return closed ? MeoMqtt5Result::UNSUPPORTED : MeoMqtt5Result::TIMEOUT;
+    }
+    if ((header >> 4) != 2 || !fits || len < 2) {
+        _client->stop();
+        return MeoMqtt5Result::REFUSED;
+    }
+    _reason = _buf[1];
+    if (len == 2) {
+        // 3.1.1-shaped CONNACK: return code 1 = unacceptable protocol level
+        _client->stop();
+        return _reason == 0x01 ? MeoMqtt5Result::UNSUPPORTED : MeoMqtt5Result::REFUSED;
+    }
+    if (_reason != 0) {
+        _client->stop();
+        return _reason == REASON_UNSUPPORTED_VERSION ? MeoMqtt5Result::UNSUPPORTED : MeoMqtt5Result::REFUSED;
+    }
+
+    const uint8_t* p = _buf + 2;
+    const uint8_t* end = _buf + len;
+    uint32_t props;
+    if (readVarint(p, end, props) && props <= (uint32_t)(end - p)) {
+        end = p + props;
+        while (p < end) {
+            uint8_t id = *p++;
+            if (id == PROP_TOPIC_ALIAS_MAX && end - p >= 2) {
+                _aliasMax = readU16(p);
+            } else if (id == PROP_MAX_PACKET_SIZE && end - p >= 4) {
+                _maxPacket = ((uint32_t)readU16(p) << 16) | readU16(p + 2);
+            } else if (id == PROP_SERVER_KEEP_ALIVE && end - p >= 2) {
+                _sessionKeepAliveS = readU16(p); // binding for this session only
+            }
+            if (!skipProperty(id, p, end)) break;
+        }
+    }
+
+    _connected = true;
+    _lastInMs = millis();
+    return MeoMqtt5Result::OK;
+}
+
+bool MeoMqtt5::connected() {
+    if (!_client) return false;
+    if (_connected && !_client->connected()) {
+        _connected = false;
+        _client->stop();
+    }
+    return _connected;
+}
+
+void MeoMqtt5::disconnect() {
+    if (_connected) {
+        const uint8_t pkt[] = {0xE0, 0x00}; // normal disconnection
+        _write(pkt, sizeof(pkt));
+    }
+    _connected = false;
+    if (_client) _client->stop();
+}
+
+bool MeoMqtt5::loop() {
+    if (!connected()) return false;
+    uint32_t now = millis();
+    uint32_t keepAliveMs = (uint32_t)_sessionKeepAliveS * 1000;
+    if (keepAliveMs && (now - _lastInMs > keepAliveMs || now - _lastOutMs > keepAliveMs)) {
+        if (_pingOutstanding) {
+            _connected = false;
+            _client->stop();
+            return false;
+        }
+        const uint8_t ping[] = {0xC0, 0x00};
+        if (!_write(ping, sizeof(ping))) return false;
+        _pingOutstanding = true;
+        _lastInMs = now;
+    }
+    if (_client->available()) {
+        uint8_t header;
+        uint32_t len;
+        bool fits;
+        if (_readPacket(header, len, fits)) {
+            if (fits) _handle(header, len);
+        } else if (!_client->connected()) {
+            _connected = false;
+        }
+    }
+    return _connected;
+}
+
+bool MeoMqtt5::addTopicAlias(const char* topic) {
+    if (!topic || !*topic) return false;
+    for (uint8_t i = 0; i < _aliasCount; ++i) {
+        if (strcmp(_aliasTopics[i], topic) == 0) return true;
+    }
+    if (_aliasCount >= MEO_MQTT5_TOPIC_ALIASES) return false;
+    _aliasTopics[_aliasCount] = topic;
+    _aliasSent[_aliasCount] = false;
+    _aliasCount++;
+    return true;
+}
+
+void MeoMqtt5::clearTopicAliases() {
+    _aliasCount = 0;
+}
+
+bool MeoMqtt5::beginPublish(const char* topic, size_t payloadLen, bool retained, const MeoPublishProps* props) {
+    if (!topic || !connected()) return false;
+    int alias = _aliasFor(topic);
+    bool sendTopic = alias < 0 || !_aliasSent[alias];
+    size_t topicLen = sendTopic ? strlen(topic) : 0;
+
+    uint32_t propLen = alias >= 0 ? 3 : 0;
+    if (props) {
+        if (props->contentType) propLen += 3 + (uint32_t)strlen(props->contentType);
+        if (props->correlation) propLen += 3 + props->correlationLen;
+        for (uint8_t i = 0; i < props->userCount; ++i) {
+            propLen += 5 + (uint32_t)strlen(props->userKeys[i]) + (uint32_t)strlen(props->userValues[i]);
+        }
+    }
+    uint32_t remaining = (uint32_t)(2 + topicLen + varintSize(propLen) + propLen + payloadLen);
+    if (topicLen > 0xFFFF || (_maxPacket && 1 + varintSize(remaining) + remaining > _maxPacket)) return false;
+
+    Out o(*_client);
+    o.u8((uint8_t)(0x30 | (retained ? 0x01 : 0x00)));
+    o.varint(remaining);
+    o.str(topic, topicLen);
+    o.varint(propLen);
+    if (alias >= 0) {
+        o.u8(PROP_TOPIC_ALIAS);
+        o.u16((uint16_t)(alias + 1));
+    }
+    if (props) {
+        if (props->contentType) {
+            o.u8(PROP_CONTENT_TYPE);
+            o.str(props->contentType, strlen(props->contentType));
+        }
+        if (props->correlation) {
+            o.u8(PROP_CORRELATION_DATA);
+            o.u16(props->correlationLen);
+            o.bytes(props->correlation, props->correlationLen);
+        }
+        for (uint8_t i = 0; i < props->userCount; ++i) {
+            o.u8(PROP_USER_PROPERTY);
+            o.str(props->userKeys[i], strlen(props->userKeys[i]));
+            o.str(props->userValues[i], strlen(props->userValues[i]));
+        }
+    }
+    if (!o.flush()) {
+        // Part of a packet may be on the wire: the session cannot continue
+        _connected = false;
+        _client->stop();
+        return false;
+    }
+    if (alias >= 0) _aliasSent[alias] = true;
+    _lastOutMs = millis();
+    return true;
+}
+
+bool MeoMqtt5::publish(const char* topic, const uint8_t* payload, size_t len, bool retained,
+                       const MeoPublishProps* props) {
+    if (!beginPublish(topic, len, retained, props)) return false;
+    return len == 0 || _write(payload, len);
+}
+
+bool MeoMqtt5::subscribe(const char* topic, uint8_t qos) {
+    if (!topic || !connected()) return false;
+    size_t topicLen = strlen(topic);
+    if (topicLen > 0xFFFF) return false;
+    Out o(*_client);
+    o.u8(0x82);
+    o.varint((uint32_t)(2 + 1 + 2 + topicLen + 1));
+    o.u16(_packetId());
+    o.varint(0); // no properties
+    o.str(topic, topicLen);
+    o.u8(qos & 0x03);
+    if (!o.flush()) return false;
+    _lastOutMs = millis();
+    return true;
+}
+
+bool MeoMqtt5::_readByte(uint8_t& b, uint32_t deadlineMs) {
+    while (!_client->available()) {
+        if (!_client->connected() || (int32_t)(millis() - deadlineMs) >= 0) return false;
+        yield();
+    }
+    int c = _client->read();
+    if (c < 0) return false;
+    b = (uint8_t)c;
+    return true;
+}
+
+// Read one packet into _buf; `fits` is false when it was larger and got discarded
+bool MeoMqtt5::_readPacket(uint8_t& header, uint32_t& len, bool& fits) {
+    uint32_t deadline = millis() + _timeoutMs;
+    if (!_readByte(header, deadline)) return false;
+    len = 0;
+    uint32_t mul = 1;
+    for (int i = 0;; ++i) {
+        uint8_t b;
+        if (i == 4 || !_readByte(b, deadline)) return false;
+        len += (uint32_t)(b & 0x7F) * mul;
+        mul *= 128;
+        if (!(b & 0x80)) break;
+    }
+    fits = len <= _bufAlloc;
+    uint8_t sink[32];
+    uint32_t got = 0;
+    while (got < len) {
+        uint8_t first;
+        if (!_readByte(first, deadline)) return false;
+        if (fits) _buf[got] = first;
+        got++;
+        int avail = _client->available();
+        if (avail <= 0 || got == len) continue;
+        size_t want = len - got;
+        if ((size_t)avail < want) want = (size_t)avail;
+        if (!fits && want > sizeof(sink)) want = sizeof(sink);
+        int n = _client->read(fits ? _buf + got : sink, want);
+        if (n > 0) got += (uint32_t)n;
+    }
+    _lastInMs = millis();
+    return true;
+}
+
+void MeoMqtt5::_handle(uint8_t header, uint32_t len) {
+    switch (header >> 4) {
+        case 3:
+            _handlePublish(header, len);
+            break;
+        case 13: // PINGRESP
+            _pingOutstanding = false;
+            break;
+        case 14: // DISCONNECT from the broker
+            _reason = len ? _buf[0] : 0;
+            _connected = false;
+            _client->stop();
+            break;
+        default: // SUBACK, PUBACK (read by MeoMqttTap), AUTH
+            break;
+    }
+}
+
+void MeoMqtt5::_handlePublish(uint8_t header, uint32_t len) {
+    uint8_t qos = (header >> 1) & 0x03;
+    if (len < 3) return;
+    uint16_t topicLen = readU16(_buf);
+    uint32_t pos = 2u + topicLen;
+    uint16_t packetId = 0;
+    if (qos) {
+        if (pos + 2 > len) return;
+        packetId = readU16(_buf + pos);
+        pos += 2;
+    }
+    const uint8_t* p = _buf + pos;
+    const uint8_t* end = _buf + len;
+    uint32_t propLen;
+    if (pos >= len || !readVarint(p, end, propLen) || propLen > (uint32_t)(end - p)) return;
+    const uint8_t* propEnd = p + propLen;
+
+    MeoMqtt5Request request;
+    while (p < propEnd) {
+        uint8_t id = *p++;
+        if ((id == PROP_RESPONSE_TOPIC || id == PROP_CORRELATION_DATA) && propEnd - p >= 2) {
+            uint16_t n = readU16(p);
+            if (propEnd - p < 2 + n) return;
+            if (id == PROP_RESPONSE_TOPIC) {
+                request.responseTopic = (const char*)p + 2;
+                request.responseTopicLen = n;
+            } else {
+                request.correlation = p + 2;
+                request.correlationLen = n;
+            }
+            p += 2 + n;
+            continue;
+        }
+        if (!skipProperty(id, p, propEnd)) return;
+    }
+
+    // The byte after the topic (packet id or property length) has been parsed
+    char* topic = (char*)_buf + 2;
+    topic[topicLen] = '\0';
+    if (topicLen && _onMessage) {
+        _onMessage(topic, (uint8_t*)propEnd, (unsigned int)(end - propEnd), request, _onMessageCtx);
+    }
+    if (qos == 1) {
+        const uint8_t ack[] = {0x40, 0x02, (uint8_t)(packetId >> 8), (uint8_t)packetId};
+        _write(ack, sizeof(ack));
+    }
+}
+
+bool MeoMqtt5::_write(const uint8_t* data, size_t len) {
+    if (_client->write(data, len) != len) {
+        _connected = false;
+        _client->stop();
+        return false;
+    }
+    _lastOutMs = millis();
+    return true;
+}
+
+int MeoMqtt5::_aliasFor(const char* topic) const {
+    uint8_t usable = _aliasCount < _aliasMax ? _aliasCount : (uint8_t)_aliasMax;
+    for (uint8_t i = 0; i < usable; ++i) {
+        if (_aliasTopics[i] == topic) return i;
+    }
+    for (uint8_t i = 0; i < usable; ++i) {
+        if (strcmp(_aliasTopics[i], topic) == 0) return i;
+    }
+    return -1;
+}
+
+uint16_t MeoMqtt5::_packetId() {
+    uint16_t id = _nextPacketId++;
+    if (_nextPacketId == 0) _nextPacketId = 1;
+    return id;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+
+// Topics that can be registered for aliasing per client (the broker may grant fewer)
+#ifndef MEO_MQTT5_TOPIC_ALIASES
+#define MEO_MQTT5_TOPIC_ALIASES 16
+#endif
+// User properties carried by one outgoing PUBLISH
+#ifndef MEO_MQTT5_USER_PROPS
+#define MEO_MQTT5_USER_PROPS 2
+#endif
+// Response topic / correlation data kept while an incoming request is handled
+#ifndef MEO_MQTT5_REPLY_TOPIC
+#define MEO_MQTT5_REPLY_TOPIC 128
+#endif
+#ifndef MEO_MQTT5_CORRELATION
+#define MEO_MQTT5_CORRELATION 32
+#endif
+
+// Wire protocol of a MeoMqttClient session
+enum class MeoMqttProtocol : uint8_t {
+    V3_1_1 = 0, // PubSubClient
+    V5          // MeoMqtt5; falls back to 3.1.1 when the broker refuses protocol level 5
+};
+
+enum class MeoMqtt5Result : uint8_t {
+    OK = 0,
+    REFUSED,     // CONNACK with a failure reason (credentials, quota, ...)
+    UNSUPPORTED, // broker answered as 3.1.1 or closed without a CONNACK
+    NO_SOCKET,
+    TIMEOUT
+};
+
+// Extra properties on an outgoing PUBLISH (ignored on 3.1.1 sessions)
+struct MeoPublishProps {
+    const char*    contentType = nullptr;
+    const uint8_t* correlation = nullptr;
+    uint16_t       correlationLen = 0;
+    const char*    userKeys[MEO_MQTT5_USER_PROPS];
+    const char*    userValues[MEO_MQTT5_USER_PROPS];
+    uint8_t        userCount = 0;
+
+    bool addUser(const char* key, const char* value) {
+        if (!key || !value || userCount >= MEO_MQTT5_USER_PROPS) return false;
+        userKeys[userCount] = key;
+        userValues[userCount] = value;
+        userCount++;
+        return true;
+    }
+};
+
+// Request/response properties of an incoming PUBLISH; views into the receive buffer
+struct MeoMqtt5Request {
+    const char*    responseTopic = nullptr; // not NUL-terminated
+    uint16_t       responseTopicLen = 0;
+    const uint8_t* correlation = nullptr;
+    uint16_t       correlationLen = 0;
+};
+
+/**
+ * MeoMqtt5: minimal MQTT 5 client session over any Client.
+ * - CONNECT/CONNACK, SUBSCRIBE, QoS 0 PUBLISH in both directions, PINGREQ, DISCONNECT
+ *   (QoS 1 publishes go through MeoInflightWindow, encoded for level 5)
+ * - Topic aliases: registered topics are sent in full once per connection, then as
+ *   a 2-byte alias, up to the Topic Alias Maximum the broker grants in CONNACK
+ * - Content type, correlation data and user properties on outgoing publishes; response topic and
+ *   correlation data reported for incoming ones
+ * - Publishes are written straight to the socket, never through the receive buffer
+ */
+class MeoMqtt5 {
+public:
+    // topic is NUL-terminated in place; everything is valid only during the call
+    typedef void (*OnMessageFn)(char* topic, uint8_t* payload, unsigned int length,
+                                const MeoMqtt5Request& request, void* ctx);
+
+    ~MeoMqtt5();
+
+    void setClient(Client* client) { _client = client; }
+    void setMessageHandler(OnMessageFn fn, void* ctx) { _onMessage = fn; _onMessageCtx = ctx; }
+    void setBufferSize(uint16_t bytes);      // receive buffer, allocated at connect
+    void setKeepAlive(uint16_t seconds)     { _keepAliveS = seconds; }
+    void setSocketTimeout(uint16_t seconds) { _timeoutMs = (uint32_t)seconds * 1000; }
+
+    // Blocking CONNECT/CONNACK; opens the socket first if needed
+    MeoMqtt5Result connect(const char* host, uint16_t port, const char* clientId,
+                           const char* user, const char* pass,
+                           const char* willTopic, uint8_t willQos, bool willRetain, const char* willPayload);
+    bool connected();
+    void disconnect();
+    // Keepalive and at most one incoming packet per call
+    bool loop();
+
+    // Topics to alias on every connection (pointers kept, like host/credentials)
+    bool addTopicAlias(const char* topic);
+    void clearTopicAliases();
+
+    // QoS 0 PUBLISH header; the caller then writes exactly payloadLen bytes to the client
+    bool beginPublish(const char* topic, size_t payloadLen, bool retained, const MeoPublishProps* props);
+    bool publish(const char* topic, const uint8_t* payload, size_t len, bool retained,
+                 const MeoPublishProps* props = nullptr);
+    bool subscribe(const char* topic, uint8_t qos);
+
+    uint8_t  reasonCode() const    { return _reason; }   // last CONNACK reason
+    uint16_t aliasMaximum() const  { return _aliasMax; } // granted by the broker
+    uint32_t maxPacketSize() const { return _maxPacket; } // 0 = no limit announced
+    uint16_t keepAlive() const     { return _sessionKeepAliveS; } // in force: ours or the broker's
+
+private:
+    Client*     _client = nullptr;
+    OnMessageFn _onMessage = nullptr;
+    void*       _onMessageCtx = nullptr;
+
+    uint8_t*    _buf = nullptr;
+    uint16_t    _bufSize = 1024;
+    uint16_t    _bufAlloc = 0;
+    uint16_t    _keepAliveS = 15;        // setKeepAlive(), sent in every CONNECT
+    uint16_t    _sessionKeepAliveS = 15; // this session's: the broker's Server Keep Alive wins
+    uint32_t    _timeoutMs = 15000;
+
+    bool        _connected = false;
+    bool        _pingOutstanding = false;
+    uint32_t    _lastInMs = 0;
+    uint32_t    _lastOutMs = 0;
+    uint16_t    _nextPacketId = 1;
+    uint8_t     _reason = 0;
+    uint16_t    _aliasMax = 0;
+    uint32_t    _maxPacket = 0;
+
+    const char* _aliasTopics[MEO_MQTT5_TOPIC_ALIASES] = {nullptr};
+    bool        _aliasSent[MEO_MQTT5_TOPIC_ALIASES] = {false};
+    uint8_t     _aliasCount = 0;
+
+    bool     _readByte(uint8_t& b, uint32_t deadlineMs);
+    bool     _readPacket(uint8_t& header, uint32_t& len, bool& fits);
+    void     _handle(uint8_t header, uint32_t len);
+    void     _handlePublish(uint8_t header, uint32_t len);
+    bool     _write(const uint8_t* data, size_t len);
+    int      _aliasFor(const char* topic) const;
+    uint16_t _packetId();
+};
@@ -0,0 +1,273 @@
+#include "Meo3_MqttQos.h"
+#include <new>
+#include <string.h>
+
+namespace {
+
+// Writes a serializer's output straight into a slot
+class SlotSink : public MeoByteSink {
+public:
+    SlotSink(uint8_t* out, size_t cap) : _out(out), _cap(cap) {}
+    void append(const char* data, size_t len) override {
+        if (len > _cap - _len) len = _cap - _len;
+        memcpy(_out + _len, data, len);
+        _len += len;
+    }
+    size_t written() const { return _len; }
+
+private:
+    uint8_t* _out;
+    size_t   _cap;
+    size_t   _len = 0;
+};
+
+} // namespace
+
+// ---- MeoInflightWindow ----
+
+uint16_t MeoInflightWindow::add(const char* topic, const uint8_t* payload, size_t len, bool retained,
+                                MeoPublishDoneFn done, void* ctx, SendFn send, void* sendCtx) {
+    if (!payload && len) return 0;
+    size_t header = 0;
+    Slot* s = _claim(topic, len, retained, header);
+    if (!s) return 0;
+    if (len) memcpy(s->packet + header, payload, len);
+    return _commit(*s, done, ctx, send, sendCtx);
+}
+
+uint16_t MeoInflightWindow::add(const char* topic, const MeoEventFields& fields, bool retained,
+                                MeoPublishDoneFn done, void* ctx, SendFn send, void* sendCtx) {
+    size_t len = fields.measure(_encoding);
+    size_t header = 0;
+    Slot* s = _claim(topic, len, retained, header);
+    if (!s) return 0;
+    SlotSink sink(s->packet + header, len);
+    if (fields.write(_encoding, sink) != len || sink.written() != len) {
+        s->used = false;
+        _stats.rejected++;
+        return 0;
+    }
+    return _commit(*s, done, ctx, send, sendCtx);
+}
+
+// Find a free slot and encode fixed header, topic and packet id; the caller writes the payload
+MeoInflightWindow::Slot* MeoInflightWindow::_claim(const char* topic, size_t payloadLen, bool retained,
+                                                   size_t& headerLen) {
+    size_t topicLen = topic ? strlen(topic) : 0;
+    if (!_allocate()) {
+        _stats.rejected++;
+        return nullptr;
+    }
+    Slot* s = nullptr;
+    for (Slot& slot : _slots) {
+        if (!slot.used) { s = &slot; break; }
+    }
+    const char* contentType = (_mqtt5 && _encoding == MeoPayloadEncoding::MSGPACK)
+                                  ? meoContentType(_encoding) : nullptr;
+    size_t typeLen = contentType ? strlen(contentType) : 0;
+    size_t propLen = contentType ? 3 + typeLen : 0; // < 128: one length byte
+    uint32_t remaining = (uint32_t)(2 + topicLen + 2 + (_mqtt5 ? 1 + propLen : 0) + payloadLen);
+    size_t lenBytes = remaining < 128 ? 1 : remaining < 16384 ? 2 : 3;
+    if (!s || topicLen == 0 || topicLen > 0xFFFF || 1 + lenBytes + remaining > MEO_MQTT_INFLIGHT_PACKET) {
+        _stats.rejected++;
+        return nullptr;
+    }
+
+    uint8_t* p = s->packet;
+    size_t n = 0;
+    p[n++] = (uint8_t)(0x32 | (retained ? 0x01 : 0x00)); // PUBLISH, QoS 1
+    do {
+        uint8_t digit = remaining % 128;
+        remaining /= 128;
+        p[n++] = (uint8_t)(digit | (remaining ? 0x80 : 0));
+    } while (remaining);
+    p[n++] = (uint8_t)(topicLen >> 8);
+    p[n++] = (uint8_t)topicLen;
+    memcpy(p + n, topic, topicLen);
+    n += topicLen;
+    s->id = _allocId();
+    p[n++] = (uint8_t)(s->id >> 8);
+    p[n++] = (uint8_t)s->id;
+    if (_mqtt5) {
+        p[n++] = (uint8_t)propLen;
+        if (contentType) {
+            p[n++] = 0x03; // Content Type
+            p[n++] = (uint8_t)(typeLen >> 8);
+            p[n++] = (uint8_t)typeLen;
+            memcpy(p + n, contentType, typeLen);
+            n += typeLen;
+        }
+    }
+
+    s->used = true;
+    s->acked = false;
+    s->reason = 0;
+    s->tries = 0;
+    s->len = (uint16_t)(n + payloadLen);
+    headerLen = n;
+    return s;
+}
+
+uint16_t MeoInflightWindow::_commit(Slot& s, MeoPublishDoneFn done, void* ctx, SendFn send, void* sendCtx) {
+    s.done = done;
+    s.ctx = ctx;
+    s.firstMs = millis();
+    _stats.sent++;
+    _stats.inflight++;
+    if (_stats.inflight > _stats.maxInflight) _stats.maxInflight = _stats.inflight;
+    _transmit(s, s.firstMs, send, sendCtx);
+    return s.id;
+}
+
+bool MeoInflightWindow::ack(uint16_t packetId, uint8_t reason) {
+    for (Slot& s : _slots) {
+        if (s.used && !s.acked && s.id == packetId) {
+            s.acked = true;
+            s.reason = reason;
+            return true;
+        }
+    }
+    return false;
+}
+
+void MeoInflightWindow::poll(uint32_t nowMs, SendFn send, void* sendCtx) {
+    for (Slot& s : _slots) {
+        if (!s.used) continue;
+        if (s.acked) {
+            _complete(s);
+            continue;
+        }
+        // Out of retries or time, but the last transmission still gets its full
+        // retry period to be acked
+        bool spent = s.tries > MEO_MQTT_MAX_RETRIES ||
+                     nowMs - s.firstMs >= (uint32_t)MEO_MQTT_RETRY_MS * (MEO_MQTT_MAX_RETRIES + 1);
+        bool expired = spent && (s.tries == 0 || nowMs - s.sentMs >= (uint32_t)MEO_MQTT_RETRY_MS);
+        if (expired) {
+            _stats.failed++;
+            _finish(s, false);
+            continue;
+        }
+        if (s.tries == 0 || (!spent && (int32_t)(nowMs - s.sentMs) >= (int32_t)MEO_MQTT_RETRY_MS)) {
+            _transmit(s, nowMs, send, sendCtx);
+        }
+    }
+}
+
+void MeoInflightWindow::rewind() {
+    for (Slot& s : _slots) {
+        if (s.used && !s.acked && s.tries) s.sentMs = millis() - MEO_MQTT_RETRY_MS;
+    }
+}
+
+void MeoInflightWindow::failAll() {
+    for (Slot& s : _slots) {
+        if (!s.used) continue;
+        if (s.acked) {
+            _complete(s);
+            continue;
+        }
+        _stats.failed++;
+        _finish(s, false);
+    }
+}
+
+void MeoInflightWindow::_transmit(Slot& s, uint32_t nowMs, SendFn send, void* sendCtx) {
+    if (s.tries) s.packet[0] |= 0x08; // DUP
+    if (!send || !send(s.packet, s.len, sendCtx)) return; // link down: poll() tries again
+    if (s.tries) _stats.retransmits++;
+    s.tries++;
+    s.sentMs = nowMs;
+}
+
+// A PUBACK arrived: delivered, unless the broker refused it (reason >= 0x80)
+void MeoInflightWindow::_complete(Slot& s) {
+    if (s.reason >= 0x80) {
+        _stats.refused++;
+        _finish(s, false);
+        return;
+    }
+    _stats.acked++;
+    _finish(s, true);
+}
+
+void MeoInflightWindow::_finish(Slot& s, bool acked) {
+    MeoPublishDoneFn done = s.done;
+    void* ctx = s.ctx;
+    uint16_t id = s.id;
+    s.used = false;
+    s.done = nullptr;
+    _stats.inflight--;
+    // Slot is free before the callback, so it may publish again
+    if (done) done(id, acked, ctx);
+}
+
+bool MeoInflightWindow::_allocate() {
+    if (_arena) return true;
+    // nothrow: out of heap rejects the publish instead of aborting
+    _arena = new (std::nothrow) uint8_t[(size_t)MEO_MQTT_INFLIGHT * MEO_MQTT_INFLIGHT_PACKET];
+    if (!_arena) return false;
+    for (size_t i = 0; i < MEO_MQTT_INFLIGHT; ++i) _slots[i].packet = _arena + i * MEO_MQTT_INFLIGHT_PACKET;
+    return true;
+}
+
+uint16_t MeoInflightWindow::_allocId() {
+    for (;;) {
+        uint16_t id = _nextId++;
+        if (_nextId == 0) _nextId = 1;
+        bool taken = false;
+        for (const Slot& s : _slots) {
+            if (s.used && s.id == id) { taken = true; break; }
+        }
+        if (!taken) return id;
+    }
+}
+
+// ---- MeoMqttTap ----
+
+int MeoMqttTap::read() {
+    int c = _inner->read();
+    if (c >= 0) {
+        _bytesIn++;
+        _feed((uint8_t)c);
+    }
+    return c;
+}
+
+int MeoMqttTap::read(uint8_t* buf, size_t len) {
+    int n = _inner->read(buf, len);
+    if (n > 0) _bytesIn += (uint32_t)n;
+    for (int i = 0; i < n; ++i) _feed(buf[i]);
+    return n;
+}
+
+void MeoMqttTap::_feed(uint8_t b) {
+    switch (_parse) {
+        case Parse::TYPE:
+            _type = b >> 4;
+            _remaining = 0;
+            _lenMul = 1;
+            _lenBytes = 0;
+            _pos = 0;
+            _packetId = 0;
+            _reason = 0;
+            _parse = Parse::LENGTH;
+            break;
+        case Parse::LENGTH:
+            _remaining += (uint32_t)(b & 0x7F) * _lenMul;
+            _lenMul *= 128;
+            if (b & 0x80) {
+                // Remaining length is at most 4 bytes; anything longer means we lost framing
+                if (++_lenBytes >= 4) _parse = Parse::TYPE;
+                break;
+            }
+            _parse = _remaining ? Parse::BODY : Parse::TYPE;
+            break;
+        case Parse::BODY:
+            if (_pos < 2) _packetId = (uint16_t)((_packetId << 8) | b);
+            else if (_pos == 2) _reason = b; // MQTT 5: reason code follows the id
+            if (++_pos < _remaining) break;
+            if (_type == 4 && _remaining >= 2 && _onAck) _onAck(_packetId, _reason, _onAckCtx); // PUBACK
+            _parse = Parse::TYPE;
+            break;
+    }
+}
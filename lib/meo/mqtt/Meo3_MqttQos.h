@@ -0,0 +1,177 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+#include "../Meo3_EventFields.h"
+
+// Unacknowledged QoS 1 publishes per client (the pipelining window)
+#ifndef MEO_MQTT_INFLIGHT
+#define MEO_MQTT_INFLIGHT 8
+#endif
+// Largest encoded QoS 1 PUBLISH (header + topic + payload) kept for retransmit
+#ifndef MEO_MQTT_INFLIGHT_PACKET
+#define MEO_MQTT_INFLIGHT_PACKET 384
+#endif
+// Resend (DUP) an unacknowledged publish after this long
+#ifndef MEO_MQTT_RETRY_MS
+#define MEO_MQTT_RETRY_MS 5000
+#endif
+// Retransmits before the publish is reported as failed
+#ifndef MEO_MQTT_MAX_RETRIES
+#define MEO_MQTT_MAX_RETRIES 4
+#endif
+
+// Completion of a QoS 1 publish: acked = PUBACK received, false = gave up or refused
+typedef void (*MeoPublishDoneFn)(uint16_t packetId, bool acked, void* ctx);
+
+struct MeoInflightStats {
+    uint32_t sent = 0;         // accepted into the window
+    uint32_t acked = 0;
+    uint32_t retransmits = 0;  // resends with DUP set
+    uint32_t failed = 0;       // retries or time ran out
+    uint32_t refused = 0;      // PUBACK with an error reason code (MQTT 5, >= 0x80)
+    uint32_t rejected = 0;     // window full or packet too large
+    uint8_t  inflight = 0;
+    uint8_t  maxInflight = 0;
+};
+
+/**
+ * MeoInflightWindow: QoS 1 PUBLISH packets awaiting PUBACK.
+ * - Fixed slots (MEO_MQTT_INFLIGHT), each holding the encoded packet for retransmit;
+ *   the packet buffers are allocated on the first add(), so a link that never
+ *   publishes at QoS 1 costs no heap
+ * - Packet ids cycle through 1..65535, skipping ids still in flight
+ * - ack() only marks a slot; completion callbacks run from poll(), outside
+ *   PubSubClient's read path, so they may publish again
+ * - Retransmits with DUP after MEO_MQTT_RETRY_MS. Fails one retry period after
+ *   the last of MEO_MQTT_MAX_RETRIES resends, or after (MEO_MQTT_MAX_RETRIES + 1)
+ *   retry periods without a transmission going out (link down)
+ */
+class MeoInflightWindow {
+public:
+    typedef bool (*SendFn)(const uint8_t* packet, size_t len, void* ctx);
+
+    MeoInflightWindow() = default;
+    ~MeoInflightWindow() { delete[] _arena; }
+    MeoInflightWindow(const MeoInflightWindow&) = delete;
+    MeoInflightWindow& operator=(const MeoInflightWindow&) = delete;
+
+    // Encode a PUBLISH into a free slot and send it; returns its packet id,
+    // 0 if the window is full, the packet exceeds MEO_MQTT_INFLIGHT_PACKET or
+    // the packet buffers cannot be allocated.
+    // A failed first send is retried by poll().
+    uint16_t add(const char* topic, const uint8_t* payload, size_t len, bool retained,
+                 MeoPublishDoneFn done, void* ctx, SendFn send, void* sendCtx);
+    uint16_t add(const char* topic, const MeoEventFields& fields, bool retained,
+                 MeoPublishDoneFn done, void* ctx, SendFn send, void* sendCtx);
+
+    // PUBACK for `packetId` with its MQTT 5 reason code (0 on 3.1.1); a code of
+    // 0x80 or above completes the publish as not acked. False if not in flight
+    bool ack(uint16_t packetId, uint8_t reason = 0);
+    // Finish acked slots, retransmit overdue ones, expire the hopeless
+    void poll(uint32_t nowMs, SendFn send, void* sendCtx);
+    // New session: everything unacked is resent (DUP) on the next poll()
+    void rewind();
+    // Report every pending publish as failed and empty the window
+    void failAll();
+
+    // Encode for MQTT 5 (property block); packets already in flight keep theirs
+    void setMqtt5(bool on) { _mqtt5 = on; }
+    bool mqtt5() const     { return _mqtt5; }
+    // Encoding of add(fields); on MQTT 5 MessagePack packets carry a Content Type
+    void setEncoding(MeoPayloadEncoding enc) { _encoding = enc; }
+
+    bool full() const     { return _stats.inflight >= MEO_MQTT_INFLIGHT; }
+    uint8_t inflight() const { return _stats.inflight; }
+    const MeoInflightStats& stats() const { return _stats; }
+
+private:
+    struct Slot {
+        bool     used = false;
+        bool     acked = false;
+        uint8_t  reason = 0;     // PUBACK reason code
+        uint8_t  tries = 0;      // transmissions so far
+        uint16_t id = 0;
+        uint16_t len = 0;
+        uint32_t firstMs = 0;
+        uint32_t sentMs = 0;
+        MeoPublishDoneFn done = nullptr;
+        void*    ctx = nullptr;
+        uint8_t* packet = nullptr; // MEO_MQTT_INFLIGHT_PACKET bytes of _arena
+    };
+
+    Slot     _slots[MEO_MQTT_INFLIGHT];
+    uint8_t* _arena = nullptr; // packet buffers of all slots, allocated on first use
+    uint16_t _nextId = 1;
+    bool     _mqtt5 = false;
+    MeoPayloadEncoding _encoding = MeoPayloadEncoding::JSON;
+    MeoInflightStats _stats;
+
+    Slot*    _claim(const char* topic, size_t payloadLen, bool retained, size_t& headerLen);
+    uint16_t _commit(Slot& s, MeoPublishDoneFn done, void* ctx, SendFn send, void* sendCtx);
+    void     _transmit(Slot& s, uint32_t nowMs, SendFn send, void* sendCtx);
+    void     _complete(Slot& s);
+    void     _finish(Slot& s, bool acked);
+    uint16_t _allocId();
+    bool     _allocate();
+};
+
+/**
+ * MeoMqttTap: Client pass-through placed between PubSubClient and the socket.
+ * - Follows MQTT packet framing on the receive side and reports PUBACKs,
+ *   which PubSubClient 2.8 reads and drops, with their MQTT 5 reason code
+ * - Everything else is forwarded unchanged; bytes are counted both ways
+ */
+class MeoMqttTap : public Client {
+public:
+    // reason: PUBACK reason code, 0 (success) when the packet carries none
+    typedef void (*OnAckFn)(uint16_t packetId, uint8_t reason, void* ctx);
+
+    void setInner(Client* inner) { _inner = inner; _reset(); }
+    Client* inner() const { return _inner; }
+    void setAckHandler(OnAckFn fn, void* ctx) { _onAck = fn; _onAckCtx = ctx; }
+
+    int     connect(IPAddress ip, uint16_t port) override { _reset(); return _inner->connect(ip, port); }
+    int     connect(const char* host, uint16_t port) override { _reset(); return _inner->connect(host, port); }
+    size_t  write(uint8_t c) override { return write(&c, 1); }
+    size_t  write(const uint8_t* buf, size_t len) override {
+        size_t n = _inner->write(buf, len);
+        _bytesOut += n;
+        return n;
+    }
+    int     available() override { return _inner->available(); }
+    int     read() override;
+    int     read(uint8_t* buf, size_t len) override;
+    int     peek() override { return _inner->peek(); }
+    void    flush() override { _inner->flush(); }
+    void    stop() override { _inner->stop(); _reset(); }
+    uint8_t connected() override { return _inner->connected(); }
+    operator bool() override { return (bool)*_inner; }
+
+    using Print::write;
+
+    // Wire bytes since construction (MQTT framing included, TLS records not)
+    uint32_t bytesIn() const  { return _bytesIn; }
+    uint32_t bytesOut() const { return _bytesOut; }
+
+private:
+    enum class Parse : uint8_t { TYPE, LENGTH, BODY };
+
+    Client*  _inner = nullptr;
+    OnAckFn  _onAck = nullptr;
+    void*    _onAckCtx = nullptr;
+    uint32_t _bytesIn = 0;
+    uint32_t _bytesOut = 0;
+
+    Parse    _parse = Parse::TYPE;
+    uint8_t  _type = 0;
+    uint8_t  _lenBytes = 0;
+    uint32_t _remaining = 0;
+    uint32_t _lenMul = 1;
+    uint32_t _pos = 0;
+    uint16_t _packetId = 0;
+    uint8_t  _reason = 0;
+
+    void _reset() { _parse = Parse::TYPE; }
+    void _feed(uint8_t b);
+};
@@ -0,0 +1,278 @@
+#include "Meo3_TlsClient.h"
+#include <new>
+#include <string.h>
+
+MeoTlsClient::~MeoTlsClient() {
+    stop();
+}
+
+int MeoTlsClient::connect(IPAddress ip, uint16_t port) {
+    // The certificate must then name this address
+    String host = ip.toString();
+    return connect(host.c_str(), port, (int32_t)_handshakeMs);
+}
+
+int MeoTlsClient::read() {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+}
+
+int MeoTlsClient::peek() {
+    if (_peek < 0) {
+        uint8_t b;
+        if (read(&b, 1) == 1) _peek = b;
+    }
+    return _peek;
+}
+
+#if defined(ESP_PLATFORM)
+
+#include <mbedtls/version.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/x509_crt.h>
+#include <mbedtls/net_sockets.h>
+
+#if MBEDTLS_VERSION_MAJOR >= 3
+#define MEO_SSL_STATE(ssl) ((ssl).MBEDTLS_PRIVATE(state))
+#else
+#define MEO_SSL_STATE(ssl) ((ssl).state)
+#endif
+
+struct MeoTlsClient::Tls {
+    mbedtls_ssl_context      ssl;
+    mbedtls_ssl_config       conf;
+    mbedtls_x509_crt         ca;
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_entropy_context  entropy;
+
+    Tls() {
+        mbedtls_ssl_init(&ssl);
+        mbedtls_ssl_config_init(&conf);
+        mbedtls_x509_crt_init(&ca);
+        mbedtls_ctr_drbg_init(&drbg);
+        mbedtls_entropy_init(&entropy);
+    }
+    ~Tls() {
+        mbedtls_ssl_free(&ssl);
+        mbedtls_ssl_config_free(&conf);
+        mbedtls_x509_crt_free(&ca);
+        mbedtls_ctr_drbg_free(&drbg);
+        mbedtls_entropy_free(&entropy);
+    }
+
+    bool setup(const char* caPem, const char* host, WiFiClient* tcp) {
+        static const char pers[] = "meo_tls";
+        if (mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy,
+                                  (const unsigned char*)pers, sizeof(pers) - 1) != 0) return false;
+        if (mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                        MBEDTLS_SSL_PRESET_DEFAULT) != 0) return false;
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3)
+        // TLS 1.3 tickets arrive after the handshake; the resumption path here is 1.2's
+        mbedtls_ssl_conf_max_tls_version(&conf, MBEDTLS_SSL_VERSION_TLS1_2);
+#endif
+        if (!caPem || mbedtls_x509_crt_parse(&ca, (const unsigned char*)caPem, strlen(caPem) + 1) != 0) {
+            return false;
+        }
+        mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+        mbedtls_ssl_conf_ca_chain(&conf, &ca, nullptr);
+        mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+        mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+        if (mbedtls_ssl_setup(&ssl, &conf) != 0) return false;
+        if (mbedtls_ssl_set_hostname(&ssl, host) != 0) return false;
+        mbedtls_ssl_set_bio(&ssl, tcp, &send, &recv, nullptr);
+        return true;
+    }
+
+    // Non-blocking BIO over the WiFiClient: no bytes yet = WANT_READ
+    static int send(void* ctx, const unsigned char* buf, size_t len) {
+        WiFiClient* tcp = (WiFiClient*)ctx;
+        if (!tcp->connected()) return MBEDTLS_ERR_NET_CONN_RESET;
+        size_t n = tcp->write(buf, len);
+        return n ? (int)n : MBEDTLS_ERR_SSL_WANT_WRITE;
+    }
+    static int recv(void* ctx, unsigned char* buf, size_t len) {
+        WiFiClient* tcp = (WiFiClient*)ctx;
+        if (tcp->available() <= 0) return tcp->connected() ? MBEDTLS_ERR_SSL_WANT_READ : 0; // 0 = EOF
+        int n = tcp->read(buf, len);
+        return n > 0 ? n : MBEDTLS_ERR_SSL_WANT_READ;
+    }
+};
+
+static bool meoTlsPending(int ret) {
+    return ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE;
+}
+
+int MeoTlsClient::connect(const char* host, uint16_t port, int32_t timeoutMs) {
+    stop();
+    _resumed = false;
+    if (!host || !*host) return 0;
+    uint32_t budget = timeoutMs > 0 ? (uint32_t)timeoutMs : _handshakeMs;
+    if (!_tcp.connect(host, port, (int32_t)budget)) return 0;
+    _tls = new (std::nothrow) Tls();
+    if (!_tls || !_tls->setup(_ca, host, &_tcp) || !_handshake(host, port, budget)) {
+        stop();
+        return 0;
+    }
+    _saveSession(host, port);
+    return 1;
+}
+
+bool MeoTlsClient::_handshake(const char* host, uint16_t port, uint32_t timeoutMs) {
+    mbedtls_ssl_context& ssl = _tls->ssl;
+    bool offered = false;
+    size_t len;
+    const uint8_t* saved = _session.find(host, port, len);
+    if (saved) {
+        mbedtls_ssl_session s;
+        mbedtls_ssl_session_init(&s);
+        offered = mbedtls_ssl_session_load(&s, saved, len) == 0 && mbedtls_ssl_set_session(&ssl, &s) == 0;
+        mbedtls_ssl_session_free(&s);
+        if (!offered) _session.clear(); // saved by another mbedTLS build or config
+    }
+
+    // Stepped rather than mbedtls_ssl_handshake(): a resumed handshake goes from
+    // ServerHello straight to ChangeCipherSpec, a full one reads the certificate
+    bool full = false;
+    uint32_t start = millis();
+    while (MEO_SSL_STATE(ssl) != MBEDTLS_SSL_HANDSHAKE_OVER) {
+        if (MEO_SSL_STATE(ssl) == MBEDTLS_SSL_SERVER_CERTIFICATE) full = true;
+        int ret = mbedtls_ssl_handshake_step(&ssl);
+        if (ret == 0) continue;
+        if (!meoTlsPending(ret)) {
+            if (offered) _session.clear();
+            return false;
+        }
+        if (millis() - start >= timeoutMs) return false;
+        delay(1);
+    }
+    _resumed = offered && !full;
+    return true;
+}
+
+// Keep the session for the next connect; put() skips the write when a resumed
+// handshake left it unchanged
+void MeoTlsClient::_saveSession(const char* host, uint16_t port) {
+    mbedtls_ssl_session s;
+    mbedtls_ssl_session_init(&s);
+    if (mbedtls_ssl_get_session(&_tls->ssl, &s) == 0) {
+        size_t need = 0;
+        mbedtls_ssl_session_save(&s, nullptr, 0, &need);
+        uint8_t* buf = (need && need <= MEO_TLS_SESSION_BYTES) ? new (std::nothrow) uint8_t[need] : nullptr;
+        if (buf && mbedtls_ssl_session_save(&s, buf, need, &need) == 0) _session.put(host, port, buf, need);
+        if (buf) {
+            memset(buf, 0, need); // master secret
+            delete[] buf;
+        }
+    }
+    mbedtls_ssl_session_free(&s);
+}
+
+size_t MeoTlsClient::write(const uint8_t* buf, size_t len) {
+    if (!_tls || !buf) return 0;
+    size_t done = 0;
+    uint32_t start = millis();
+    while (done < len) {
+        int ret = mbedtls_ssl_write(&_tls->ssl, buf + done, len - done);
+        if (ret > 0) {
+            done += (size_t)ret;
+            continue;
+        }
+        if (!meoTlsPending(ret)) {
+            stop();
+            break;
+        }
+        if (millis() - start >= _handshakeMs) break;
+        delay(1);
+    }
+    return done;
+}
+
+int MeoTlsClient::available() {
+    int peeked = _peek >= 0 ? 1 : 0;
+    if (!_tls) return peeked;
+    if (mbedtls_ssl_get_bytes_avail(&_tls->ssl) == 0) {
+        // Decrypt the next record, if its bytes are in
+        int ret = mbedtls_ssl_read(&_tls->ssl, nullptr, 0);
+        if (ret < 0 && !meoTlsPending(ret)) {
+            stop(); // close_notify or a fatal alert
+            return peeked;
+        }
+    }
+    return peeked + (int)mbedtls_ssl_get_bytes_avail(&_tls->ssl);
+}
+
+int MeoTlsClient::read(uint8_t* buf, size_t len) {
+    if (!buf || !len) return -1;
+    size_t n = 0;
+    if (_peek >= 0) {
+        buf[n++] = (uint8_t)_peek;
+        _peek = -1;
+    }
+    if (n < len && _tls) {
+        int ret = mbedtls_ssl_read(&_tls->ssl, buf + n, len - n);
+        if (ret > 0) n += (size_t)ret;
+        else if (!meoTlsPending(ret)) stop(); // 0 / close_notify: peer closed
+    }
+    return n ? (int)n : -1;
+}
+
+void MeoTlsClient::stop() {
+    if (_tls) {
+        if (_tcp.connected()) mbedtls_ssl_close_notify(&_tls->ssl); // best effort
+        delete _tls;
+        _tls = nullptr;
+    }
+    _tcp.stop();
+    _peek = -1;
+}
+
+uint8_t MeoTlsClient::connected() {
+    if (_peek >= 0) return 1;
+    return _tls && (_tcp.connected() || mbedtls_ssl_get_bytes_avail(&_tls->ssl) > 0);
+}
+
+#else // host build: plain TCP, like the native WiFiClientSecure
+
+struct MeoTlsClient::Tls {};
+
+int MeoTlsClient::connect(const char* host, uint16_t port, int32_t timeoutMs) {
+    stop();
+    _resumed = false;
+    if (!host || !*host) return 0;
+    return _tcp.connect(host, port, timeoutMs > 0 ? timeoutMs : (int32_t)_handshakeMs);
+}
+
+size_t MeoTlsClient::write(const uint8_t* buf, size_t len) { return _tcp.write(buf, len); }
+
+int MeoTlsClient::available() {
+    return (_peek >= 0 ? 1 : 0) + _tcp.available();
+}
+
+int MeoTlsClient::read(uint8_t* buf, size_t len) {
+    if (!buf || !len) return -1;
+    size_t n = 0;
+    if (_peek >= 0) {
+        buf[n++] = (uint8_t)_peek;
+        _peek = -1;
+    }
+    if (n < len && _tcp.available() > 0) {
+        int ret = _tcp.read(buf + n, len - n);
+        if (ret > 0) n += (size_t)ret;
+    }
+    return n ? (int)n : -1;
+}
+
+void MeoTlsClient::stop() {
+    _tcp.stop();
+    _peek = -1;
+}
+
+uint8_t MeoTlsClient::connected() {
+    return _peek >= 0 || _tcp.connected();
+}
+
+#endif
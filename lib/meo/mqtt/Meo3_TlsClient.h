@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+#include <WiFiClient.h>
+#include "Meo3_TlsSession.h"
+
+/**
+ * MeoTlsClient: TLS 1.2 client socket (mbedTLS over a WiFiClient) that resumes sessions.
+ * - Replaces WiFiClientSecure so the session can be handed to mbedTLS before the
+ *   handshake: after each handshake the session (ticket or session id) is saved in
+ *   session(), and the next connect to the same host:port offers it. A server that
+ *   accepts skips the certificate exchange and key agreement (one round trip, no
+ *   RSA/ECDHE work); one that refuses gets a full handshake in the same connect
+ * - A handshake that fails while offering a session forgets it, so a bad cached
+ *   session costs one attempt
+ * - Server certificate checked against setCACert() and the host name (SNI)
+ * - mbedTLS contexts and record buffers are allocated per connection and freed by stop()
+ * - Host builds (no ESP_PLATFORM) have no TLS: plain TCP, never resumed
+ */
+class MeoTlsClient : public Client {
+public:
+    MeoTlsClient() {}
+    ~MeoTlsClient();
+    MeoTlsClient(const MeoTlsClient&) = delete;
+    MeoTlsClient& operator=(const MeoTlsClient&) = delete;
+
+    void setCACert(const char* pem) { _ca = pem; } // kept by pointer
+    void setHandshakeTimeout(uint32_t seconds) { _handshakeMs = seconds * 1000; }
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char* host, uint16_t port) override { return connect(host, port, (int32_t)_handshakeMs); }
+    // TCP connect and handshake, each bounded by timeoutMs
+    int connect(const char* host, uint16_t port, int32_t timeoutMs);
+
+    size_t  write(uint8_t c) override { return write(&c, 1); }
+    size_t  write(const uint8_t* buf, size_t len) override;
+    int     available() override;
+    int     read() override;
+    int     read(uint8_t* buf, size_t len) override;
+    int     peek() override;
+    void    flush() override {}
+    void    stop() override;
+    uint8_t connected() override;
+    operator bool() override { return connected(); }
+
+    int setNoDelay(bool nodelay) { return _tcp.setNoDelay(nodelay); }
+
+    // Last connect resumed the saved session (no certificate exchange)
+    bool lastResumed() const { return _resumed; }
+    MeoTlsSessionCache& session() { return _session; }
+
+    using Print::write;
+
+private:
+    struct Tls; // mbedTLS state of one connection
+    WiFiClient _tcp;
+    Tls*       _tls = nullptr;
+    const char* _ca = nullptr;
+    uint32_t   _handshakeMs = 8000;
+    bool       _resumed = false;
+    int        _peek = -1;
+    MeoTlsSessionCache _session;
+
+    bool _handshake(const char* host, uint16_t port, uint32_t timeoutMs);
+    void _saveSession(const char* host, uint16_t port);
+};
@@ -0,0 +1,84 @@
+#include "Meo3_TlsSession.h"
+#include "../storage/Meo3_Storage.h"
+#include <new>
+#include <string.h>
+
+static const size_t HEADER = 6; // u32 peer, u16 length (little endian)
+
+MeoTlsSessionCache::~MeoTlsSessionCache() {
+    if (_block) memset(_block, 0, HEADER + _len); // master secret
+    delete[] _block;
+}
+
+void MeoTlsSessionCache::setStore(MeoStorage* storage, const char* key) {
+    _storage = (storage && key && *key) ? storage : nullptr;
+    _key = _storage ? key : nullptr;
+    _loaded = false;
+}
+
+uint32_t MeoTlsSessionCache::_peerId(const char* host, uint16_t port) {
+    uint32_t h = 2166136261u;
+    while (host && *host) { h ^= (uint8_t)*host++; h *= 16777619u; }
+    h ^= (uint8_t)port;        h *= 16777619u;
+    h ^= (uint8_t)(port >> 8); h *= 16777619u;
+    return h;
+}
+
+uint32_t MeoTlsSessionCache::_peerOf() const {
+    return _block[0] | (uint32_t)_block[1] << 8 | (uint32_t)_block[2] << 16 | (uint32_t)_block[3] << 24;
+}
+
+bool MeoTlsSessionCache::_alloc() {
+    if (!_block) _block = new (std::nothrow) uint8_t[HEADER + MEO_TLS_SESSION_BYTES];
+    return _block != nullptr;
+}
+
+void MeoTlsSessionCache::_load() {
+    _loaded = true;
+    if (!_storage || _len || !_alloc()) return;
+    if (!_storage->loadBytes(_key, _block, HEADER + MEO_TLS_SESSION_BYTES)) return;
+    size_t len = _block[4] | (size_t)_block[5] << 8;
+    _len = (len > 0 && len <= MEO_TLS_SESSION_BYTES) ? len : 0;
+}
+
+const uint8_t* MeoTlsSessionCache::find(const char* host, uint16_t port, size_t& len) {
+    if (!_loaded) _load();
+    len = 0;
+    if (!_len) return nullptr;
+    if (_peerOf() != _peerId(host, port)) return nullptr;
+    len = _len;
+    return _block + HEADER;
+}
+
+bool MeoTlsSessionCache::put(const char* host, uint16_t port, const uint8_t* data, size_t len) {
+    if (!_loaded) _load();
+    if (!data || len == 0 || len > MEO_TLS_SESSION_BYTES || !_alloc()) return false;
+    uint32_t peer = _peerId(host, port);
+    if (_len == len && _peerOf() == peer && memcmp(_block + HEADER, data, len) == 0) {
+        return true; // resumed with the same session: nothing to write
+    }
+    for (int i = 0; i < 4; ++i) _block[i] = (uint8_t)(peer >> (8 * i));
+    _block[4] = (uint8_t)len;
+    _block[5] = (uint8_t)(len >> 8);
+    memcpy(_block + HEADER, data, len);
+    if (len < _len) memset(_block + HEADER + len, 0, _len - len);
+    _len = len;
+    _persist();
+    return true;
+}
+
+void MeoTlsSessionCache::clear() {
+    if (!_loaded) _load();
+    if (!_len) return;
+    memset(_block, 0, HEADER + _len);
+    _len = 0;
+    if (_storage) {
+        _storage->clearKey(_key);
+        _storeWrites++;
+    }
+}
+
+void MeoTlsSessionCache::_persist() {
+    if (!_storage) return;
+    if (_storage->saveBytes(_key, _block, HEADER + _len)) _storeWrites++;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+
+class MeoStorage;
+
+// Largest serialized session kept (mbedtls_ssl_session_save() output). With the
+// peer certificate kept, as the ESP-IDF default config does, this is about 1.2-1.8 KB
+#ifndef MEO_TLS_SESSION_BYTES
+#define MEO_TLS_SESSION_BYTES 2048
+#endif
+
+/**
+ * MeoTlsSessionCache: the last TLS session of one client, as opaque saved bytes.
+ * - Tied to the host:port it was negotiated with; another peer gets a miss
+ * - One heap block of MEO_TLS_SESSION_BYTES, allocated with the first session
+ * - Optional MeoStorage key: read on the first lookup after boot and written only
+ *   when the bytes change (full handshake, renewed ticket), so a reboot resumes too.
+ *   The key then holds the session's master secret in NVS
+ * - Not thread-safe: used by the task that owns the client
+ */
+class MeoTlsSessionCache {
+public:
+    MeoTlsSessionCache() {}
+    ~MeoTlsSessionCache();
+    MeoTlsSessionCache(const MeoTlsSessionCache&) = delete;
+    MeoTlsSessionCache& operator=(const MeoTlsSessionCache&) = delete;
+
+    // `key` (15 chars max) is kept by pointer; nullptr storage keeps sessions in RAM only
+    void setStore(MeoStorage* storage, const char* key);
+
+    // Saved session for host:port, or nullptr
+    const uint8_t* find(const char* host, uint16_t port, size_t& len);
+    // Keep a session (replaces the previous one); false if too large or out of heap
+    bool put(const char* host, uint16_t port, const uint8_t* data, size_t len);
+    // Forget the session, in RAM and in storage (e.g. the peer rejected it)
+    void clear();
+
+    bool   empty() const { return _len == 0; }
+    size_t size() const  { return _len; }
+    uint32_t storeWrites() const { return _storeWrites; }
+
+private:
+    MeoStorage* _storage = nullptr;
+    const char* _key = nullptr;
+    bool        _loaded = false; // storage read (once per boot)
+    uint8_t*    _block = nullptr; // [u32 peer][u16 len][session], as stored
+    size_t      _len = 0;
+    uint32_t    _storeWrites = 0;
+
+    static uint32_t _peerId(const char* host, uint16_t port);
+    uint32_t _peerOf() const; // peer of the kept session
+    bool _alloc();
+    void _load();
+    void _persist();
+};
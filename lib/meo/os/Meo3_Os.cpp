@@ -0,0 +1,74 @@
+#include "Meo3_Os.h"
+
+#if defined(ESP_PLATFORM)
+
+MeoMutex::MeoMutex() : _h(xSemaphoreCreateRecursiveMutex()) {}
+MeoMutex::~MeoMutex() { if (_h) vSemaphoreDelete(_h); }
+void MeoMutex::lock()   { xSemaphoreTakeRecursive(_h, portMAX_DELAY); }
+void MeoMutex::unlock() { xSemaphoreGiveRecursive(_h); }
+
+MeoSignal::MeoSignal() : _h(xSemaphoreCreateCounting(0xFFFF, 0)) {}
+MeoSignal::~MeoSignal() { if (_h) vSemaphoreDelete(_h); }
+void MeoSignal::give() { xSemaphoreGive(_h); }
+
+bool MeoSignal::take(uint32_t timeoutMs) {
+    TickType_t ticks = (timeoutMs == MEO_WAIT_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+    return xSemaphoreTake(_h, ticks) == pdTRUE;
+}
+
+bool meoStartTask(const char* name, MeoTaskFn fn, void* ctx,
+                  uint32_t stackBytes, uint8_t priority, int core) {
+    BaseType_t affinity = core < 0 ? tskNO_AFFINITY : (BaseType_t)core;
+    return xTaskCreatePinnedToCore(fn, name, stackBytes, ctx, priority, nullptr, affinity) == pdPASS;
+}
+
+void meoSleepMs(uint32_t ms) {
+    TickType_t ticks = pdMS_TO_TICKS(ms);
+    vTaskDelay(ticks ? ticks : 1);
+}
+
+#else
+
+#include <chrono>
+#include <thread>
+
+MeoMutex::MeoMutex() {}
+MeoMutex::~MeoMutex() {}
+void MeoMutex::lock()   { _m.lock(); }
+void MeoMutex::unlock() { _m.unlock(); }
+
+MeoSignal::MeoSignal() {}
+MeoSignal::~MeoSignal() {}
+
+void MeoSignal::give() {
+    {
+        std::lock_guard<std::mutex> lk(_m);
+        _count++;
+    }
+    _cv.notify_one();
+}
+
+bool MeoSignal::take(uint32_t timeoutMs) {
+    std::unique_lock<std::mutex> lk(_m);
+    auto ready = [this] { return _count > 0; };
+    if (timeoutMs == MEO_WAIT_FOREVER) {
+        _cv.wait(lk, ready);
+    } else if (!_cv.wait_for(lk, std::chrono::milliseconds(timeoutMs), ready)) {
+        return false;
+    }
+    _count--;
+    return true;
+}
+
+bool meoStartTask(const char* name, MeoTaskFn fn, void* ctx,
+                  uint32_t stackBytes, uint8_t priority, int core) {
+    (void)name; (void)stackBytes; (void)priority; (void)core;
+    std::thread(fn, ctx).detach();
+    return true;
+}
+
+void meoSleepMs(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms ? ms : 1));
+}
+
+#endif
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+// Timeout value for MeoSignal::take(): wait until signalled
+static constexpr uint32_t MEO_WAIT_FOREVER = 0xFFFFFFFFu;
+
+/**
+ * Meo3_Os: the few RTOS primitives the library needs.
+ * - FreeRTOS on ESP32, std::thread / std::mutex elsewhere, so queue and
+ *   dispatch logic can run and be tested on a host
+ */
+
+// Recursive mutex: the same task may re-lock (e.g. publish from inside a handler)
+class MeoMutex {
+public:
+    MeoMutex();
+    ~MeoMutex();
+    MeoMutex(const MeoMutex&) = delete;
+    MeoMutex& operator=(const MeoMutex&) = delete;
+
+    void lock();
+    void unlock();
+
+private:
+#if defined(ESP_PLATFORM)
+    SemaphoreHandle_t _h = nullptr;
+#else
+    std::recursive_mutex _m;
+#endif
+};
+
+class MeoLockGuard {
+public:
+    explicit MeoLockGuard(MeoMutex& m) : _m(m) { _m.lock(); }
+    ~MeoLockGuard() { _m.unlock(); }
+    MeoLockGuard(const MeoLockGuard&) = delete;
+    MeoLockGuard& operator=(const MeoLockGuard&) = delete;
+
+private:
+    MeoMutex& _m;
+};
+
+// Counting signal: give() from producers, take() blocks a consumer
+class MeoSignal {
+public:
+    MeoSignal();
+    ~MeoSignal();
+    MeoSignal(const MeoSignal&) = delete;
+    MeoSignal& operator=(const MeoSignal&) = delete;
+
+    void give();
+    // false on timeout
+    bool take(uint32_t timeoutMs);
+
+private:
+#if defined(ESP_PLATFORM)
+    SemaphoreHandle_t _h = nullptr;
+#else
+    std::mutex              _m;
+    std::condition_variable _cv;
+    uint32_t                _count = 0;
+#endif
+};
+
+typedef void (*MeoTaskFn)(void* ctx);
+
+// Start a detached task running fn(ctx); core < 0 means no affinity (ignored on host)
+bool meoStartTask(const char* name, MeoTaskFn fn, void* ctx,
+                  uint32_t stackBytes, uint8_t priority, int core = -1);
+
+// Block the calling task (at least one tick on FreeRTOS)
+void meoSleepMs(uint32_t ms);
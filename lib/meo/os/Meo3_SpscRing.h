@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * MeoSpscRing: lock-free single-producer / single-consumer queue of byte records.
+ * - One task pushes, one task pops; no locks, no heap
+ * - Record: [u16 len][bytes], padded to 2 bytes; records never straddle the end
+ *   of the buffer (a 0xFFFF marker skips the leftover space)
+ * - Size must be a power of two
+ */
+template <size_t Size>
+class MeoSpscRing {
+public:
+    static_assert(Size >= 16 && Size <= 0x8000 && (Size & (Size - 1)) == 0,
+                  "MeoSpscRing size must be a power of two in [16, 32768]");
+
+    // Producer: append one record built from two parts (e.g. header + body); false if full
+    bool push(const void* a, size_t aLen, const void* b = nullptr, size_t bLen = 0) {
+        size_t len = aLen + bLen;
+        if (len >= PAD) return false;
+        uint32_t need = (uint32_t)(HEADER + _align(len));
+        uint32_t h = _head.load(std::memory_order_relaxed);
+        uint32_t t = _tail.load(std::memory_order_acquire);
+        uint32_t freeBytes = (uint32_t)Size - (h - t);
+        uint32_t off = h & MASK;
+        uint32_t toEnd = (uint32_t)Size - off;
+
+        if (need > toEnd) {
+            if (need + toEnd > freeBytes) return false;
+            _writeU16(off, PAD);
+            h += toEnd;
+            off = 0;
+        } else if (need > freeBytes) {
+            return false;
+        }
+
+        _writeU16(off, (uint16_t)len);
+        if (aLen) memcpy(_buf + off + HEADER, a, aLen);
+        if (bLen) memcpy(_buf + off + HEADER + aLen, b, bLen);
+        _head.store(h + need, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: copy the oldest record into `out` and remove it. Returns its length;
+    // 0 when empty. A record larger than outLen is dropped (also returns 0).
+    size_t pop(void* out, size_t outLen) {
+        uint32_t t = _tail.load(std::memory_order_relaxed);
+        uint32_t h = _head.load(std::memory_order_acquire);
+        if (t == h) return 0;
+
+        uint32_t off = t & MASK;
+        uint16_t len = _readU16(off);
+        if (len == PAD) {
+            t += (uint32_t)Size - off;
+            off = 0;
+            len = _readU16(off);
+        }
+        size_t copied = 0;
+        if (len <= outLen) {
+            memcpy(out, _buf + off + HEADER, len);
+            copied = len;
+        }
+        _tail.store(t + (uint32_t)(HEADER + _align(len)), std::memory_order_release);
+        return copied;
+    }
+
+    bool empty() const {
+        return _tail.load(std::memory_order_acquire) == _head.load(std::memory_order_acquire);
+    }
+
+    // Bytes in use (approximate while the other side is active)
+    size_t used() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return Size; }
+
+private:
+    static constexpr uint32_t MASK   = (uint32_t)Size - 1;
+    static constexpr size_t   HEADER = 2;
+    static constexpr uint16_t PAD    = 0xFFFF;
+
+    uint8_t _buf[Size];
+    std::atomic<uint32_t> _head{0}; // written by the producer only
+    std::atomic<uint32_t> _tail{0}; // written by the consumer only
+
+    static size_t _align(size_t len) { return (len + 1) & ~(size_t)1; }
+    void     _writeU16(uint32_t off, uint16_t v) { _buf[off] = (uint8_t)v; _buf[off + 1] = (uint8_t)(v >> 8); }
+    uint16_t _readU16(uint32_t off) const { return (uint16_t)(_buf[off] | (_buf[off + 1] << 8)); }
+};
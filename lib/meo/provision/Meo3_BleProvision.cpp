@@ -1,5 +1,4 @@
 #include "Meo3_BleProvision.h"
-#include "Meo3_Logger.h"
 #include <stdarg.h>
 #include <esp_system.h>
 #include <string>
@@ -9,9 +8,7 @@ void MeoBleProvision::setLogger(MeoLogFunction logger) {
     _logger = logger;
 }
 void MeoBleProvision::setDebugTags(const char* tagsCsv) {
-    if (!tagsCsv) { _debugTags[0] = '\0'; return; }
-    strncpy(_debugTags, tagsCsv, sizeof(_debugTags) - 1);
-    _debugTags[sizeof(_debugTags) - 1] = '\0';
+    _debugMask = meoLogTagMask(tagsCsv);
 }
 
 bool MeoBleProvision::begin(MeoBle* ble, MeoStorage* storage, const char* devModel, const char* devManufacturer) {
@@ -30,7 +27,9 @@ bool MeoBleProvision::begin(MeoBle* ble, MeoStorage* storage, const char* devMod
 void MeoBleProvision::setCloudCompatibleInfo(const char* productId, const char* buildInfo) {
     _devProductIdStr = productId ? productId : "";
     _buildInfoStr    = buildInfo ? buildInfo : "";
-    MeoLogf("DEBUG", "PROV", "Cloud compatible info set: productId=%s buildInfo=%s", _devProductIdStr.c_str(), _buildInfoStr.c_str());
+    if (_logger && _debugTagEnabled(MEO_LOG_PROV)) {
+        _logf("DEBUG", "PROV", "Cloud compatible info set: productId=%s buildInfo=%s", _devProductIdStr.c_str(), _buildInfoStr.c_str());
+    }
     // If characteristics already created, update their values so central reads full strings
     if (_chProductId && !_devProductIdStr.empty()) _chProductId->setValue(_devProductIdStr);
     if (_chBuildInfo && !_buildInfoStr.empty())    _chBuildInfo->setValue(_buildInfoStr);
@@ -68,7 +67,8 @@ void MeoBleProvision::stopAdvertising()  { if (_ble) _ble->stopAdvertising();  }
 void MeoBleProvision::loop() {
     // Execute scheduled reboot
     if (_autoReboot && _rebootScheduled && millis() >= _rebootAtMs) {
-        MeoLog("INFO", "PROV", "Reboot now");
+        _log("INFO", "PROV", "Reboot now");
+        _storage->commit(); // credentials may still be waiting in the write-back cache
         delay(100);
         ESP.restart();
     }
@@ -100,19 +100,27 @@ void MeoBleProvision::_loadInitialValues() {
 
     if (_chModel) {
         _chModel->setValue(_devModel);
-        MeoLogf("DEBUG", "PROV", "model=%s", _devModel.c_str());
+        if (_logger && _debugTagEnabled(MEO_LOG_PROV)) {
+            _logf("DEBUG", "PROV", "model=%s", _devModel.c_str());
+        }
     }
     if (_chManuf) {
         _chManuf->setValue(_devManuf);
-        MeoLogf("DEBUG", "PROV", "manuf=%s", _devManuf.c_str());
+        if (_logger && _debugTagEnabled(MEO_LOG_PROV)) {
+            _logf("DEBUG", "PROV", "manuf=%s", _devManuf.c_str());
+        }
     }
     if (_chProductId) {
         _chProductId->setValue(_devProductIdStr);
-        MeoLogf("DEBUG", "PROV", "productId=%s", _devProductIdStr.c_str());
+        if (_logger && _debugTagEnabled(MEO_LOG_PROV)) {
+            _logf("DEBUG", "PROV", "productId=%s", _devProductIdStr.c_str());
+        }
     }
     if (_chBuildInfo) {
         _chBuildInfo->setValue(_buildInfoStr);
-        MeoLogf("DEBUG", "PROV", "buildInfo=%s", _buildInfoStr.c_str());
+        if (_logger && _debugTagEnabled(MEO_LOG_PROV)) {
+            _logf("DEBUG", "PROV", "buildInfo=%s", _buildInfoStr.c_str());
+        }
     }
 }
 
@@ -121,7 +129,7 @@ void MeoBleProvision::_scheduleRebootIfReady() {
     if (_ssidWritten && _passWritten && !_rebootScheduled) {
         _rebootScheduled = true;
         _rebootAtMs = millis() + _rebootDelayMs;
-        _logger("INFO", "Provisioning complete; scheduling reboot");
+        _log("INFO", "PROV", "Provisioning complete; scheduling reboot");
     }
 }
 
@@ -141,35 +149,25 @@ void MeoBleProvision::_onWrite(NimBLECharacteristic* ch) {
         _storage->saveString("wifi_ssid", s);
         _wifiSsidStr = s;
         _ssidWritten = true;
-        _logger("INFO", "SSID updated");
+        _log("INFO", "PROV", "SSID updated");
         _scheduleRebootIfReady();
         return;
     }
     if (uuid.equals(NimBLEUUID(CH_UUID_WIFI_PASS))) {
         _storage->saveString("wifi_pass", s);
         _passWritten = true;
-        _logger("INFO", "PASS updated");
+        _log("INFO", "PROV", "PASS updated");
         _scheduleRebootIfReady();
         return;
     }
     if (uuid.equals(NimBLEUUID(CH_UUID_USER_ID))) {
         _storage->saveString("user_id", s);
-        _logger("INFO", "User ID updated");
+        _log("INFO", "PROV", "User ID updated");
         return;
     }
     if (uuid.equals(NimBLEUUID(CH_UUID_TX_KEY))) {
         _storage->saveString("tx_key", s);
-        _logger("INFO", "Transmit Key updated");
+        _log("INFO", "PROV", "Transmit Key updated");
         return;
     }
 }
-
-bool MeoBleProvision::_debugTagEnabled(const char* tag) const {
-    if (!_debugTags[0]) return false;
-    const char* p = strstr(_debugTags, tag);
-    if (!p) return false;
-    bool leftOk  = (p == _debugTags) || (*(p - 1) == ',');
-    const char* end = p + strlen(tag);
-    bool rightOk = (*end == '\0') || (*end == ',');
-    return leftOk && rightOk;
-}
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "../storage/Meo3_Storage.h"
 #include "../ble/Meo3_Ble.h"
 #include "../Meo3_Type.h" // MeoLogFunction
+#include "../Meo3_BinLog.h" // meoLogEmit, MeoLogTag
 
 // Provisioning service UUID (stable across all devices)
 #define MEO_BLE_PROV_SERV_UUID      "9f27f7f0-0000-1000-8000-00805f9b34fb" // Service UUID
@@ -36,6 +37,8 @@ public:
     // Logging
     void setLogger(MeoLogFunction logger);
     void setDebugTags(const char* tagsCsv); // enables DEBUG for "PROV" when tag present
+    void setDebugMask(uint32_t mask) { _debugMask = mask; } // MeoLogTag bits
+    void setBinaryLog(MeoBinLog* log) { _binLog = log; }    // nullptr: format on the spot
 
     // Initialize with BLE and storage; model/manuf taken from device config (recommended)
     bool begin(MeoBle* ble, MeoStorage* storage, const char* devModel, const char* devManufacturer);
@@ -90,7 +93,8 @@ private:
 
     // Logging
     MeoLogFunction _logger = nullptr;
-    char           _debugTags[96] = {0};
+    uint32_t       _debugMask = 0; // MeoLogTag bits, resolved by setDebugTags()
+    MeoBinLog*     _binLog = nullptr; // deferred mode: log calls go to this ring
 
     // Internal lifecycle
     bool _createServiceAndCharacteristics();
@@ -98,7 +102,14 @@ private:
     void _loadInitialValues();
     void _updateStatus();
     void _scheduleRebootIfReady();
-    bool _debugTagEnabled(const char* tag) const;
+    bool _debugTagEnabled(uint32_t tag) const { return meoLogDebugOn(_debugMask, tag); }
+    void _log(const char* level, const char* tag, const char* msg) const {
+        if (meoLogCompiled(level) && _logger) meoLogEmitMsg(_logger, _binLog, level, tag ? tag : "PROV", msg);
+    }
+    template <typename... Args>
+    void _logf(const char* level, const char* tag, const char* fmt, Args... args) const {
+        if (meoLogCompiled(level) && _logger) meoLogEmit(_logger, _binLog, level, tag ? tag : "PROV", fmt, args...);
+    }
 
     // Write callbacks
     static void _onWriteStatic(NimBLECharacteristic* ch, void* ctx);
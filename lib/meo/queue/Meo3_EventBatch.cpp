@@ -0,0 +1,103 @@
+#include "Meo3_EventBatch.h"
+#include <stdio.h>
+#include <string.h>
+
+void MeoEventBatch::setLimit(size_t maxBytes) {
+    // Room for at least "[" + "]" and something in between
+    if (maxBytes > MEO_EVENT_BATCH_BYTES) maxBytes = MEO_EVENT_BATCH_BYTES;
+    if (maxBytes < 16) maxBytes = 16;
+    _limit = maxBytes;
+    clear();
+}
+
+bool MeoEventBatch::add(const char* eventName, const MeoEventFields& fields, uint32_t tsMs) {
+    if (!eventName) return false;
+    size_t nameLen = strlen(eventName);
+    bool ok = _encoding == MeoPayloadEncoding::MSGPACK ? _addMsgPack(eventName, nameLen, fields, tsMs)
+                                                       : _addJson(eventName, nameLen, fields, tsMs);
+    if (!ok) return false;
+    if (_count == 0) _firstMs = tsMs;
+    _count++;
+    return true;
+}
+
+bool MeoEventBatch::_addJson(const char* eventName, size_t nameLen, const MeoEventFields& fields,
+                             uint32_t tsMs) {
+    // Names are emitted verbatim; anything that would need escaping goes out unbatched
+    if (strpbrk(eventName, "\"\\")) return false;
+
+    char ts[11];
+    size_t tsLen = (size_t)snprintf(ts, sizeof(ts), "%lu", (unsigned long)tsMs);
+    size_t dataLen = fields.measureJson();
+    // '[' or ',' + {"event":" + name + ","ts": + ts + ,"data": + data + '}', then ']' on finish
+    size_t need = 1 + 10 + nameLen + 7 + tsLen + 8 + dataLen + 1;
+    if (_len + need + 1 > _limit) return false;
+
+    size_t start = _len;
+    _put(_count ? "," : "[", 1);
+    _put("{\"event\":\"", 10);
+    _put(eventName, nameLen);
+    _put("\",\"ts\":", 7);
+    _put(ts, tsLen);
+    _put(",\"data\":", 8);
+    if (fields.serializeJson(_buf + _len, sizeof(_buf) - _len) != dataLen) {
+        _len = start;
+        return false;
+    }
+    _len += dataLen;
+    _put("}", 1);
+    return true;
+}
+
+bool MeoEventBatch::_addMsgPack(const char* eventName, size_t nameLen, const MeoEventFields& fields,
+                                uint32_t tsMs) {
+    if (nameLen > 0xFF) return false;
+    size_t dataLen = fields.measureMsgPack();
+    // [array 16 header] + fixmap 3 + "event" + str name + "ts" + uint 32 + "data" + data
+    size_t nameHead = nameLen < 32 ? 1 : 2;
+    size_t need = (_count ? 0 : 3) + 1 + 6 + nameHead + nameLen + 3 + 5 + 5 + dataLen;
+    if (_len + need > _limit) return false;
+
+    size_t start = _len;
+    if (_count == 0) _put("\xDC\x00\x00", 3); // count patched by finish()
+    _put("\x83\xA5" "event", 7);
+    if (nameLen < 32) {
+        char h = (char)(0xA0 | nameLen);
+        _put(&h, 1);
+    } else {
+        char h[2] = {(char)0xD9, (char)nameLen};
+        _put(h, 2);
+    }
+    _put(eventName, nameLen);
+    char ts[8] = {(char)0xA2, 't', 's', (char)0xCE,
+                  (char)(tsMs >> 24), (char)(tsMs >> 16), (char)(tsMs >> 8), (char)tsMs};
+    _put(ts, sizeof(ts));
+    _put("\xA4" "data", 5);
+    if (fields.serializeMsgPack((uint8_t*)_buf + _len, _limit - _len) != dataLen) {
+        _len = start;
+        return false;
+    }
+    _len += dataLen;
+    return true;
+}
+
+const char* MeoEventBatch::finish(size_t& len) {
+    if (_count == 0) {
+        len = 0;
+        return _buf;
+    }
+    if (_encoding == MeoPayloadEncoding::MSGPACK) {
+        _buf[1] = (char)(_count >> 8);
+        _buf[2] = (char)_count;
+        len = _len;
+        return _buf;
+    }
+    _buf[_len] = ']';
+    len = _len + 1;
+    return _buf;
+}
+
+void MeoEventBatch::_put(const char* s, size_t n) {
+    memcpy(_buf + _len, s, n);
+    _len += n;
+}
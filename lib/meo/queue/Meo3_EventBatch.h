@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../Meo3_EventFields.h"
+
+// Largest batch payload; with the batch topic it must still fit MEO_QUEUE_MAX_RECORD
+// so a batch can wait in the offline queue or the network task's tx ring
+#ifndef MEO_EVENT_BATCH_BYTES
+#define MEO_EVENT_BATCH_BYTES 384
+#endif
+
+struct MeoEventBatchStats {
+    uint32_t events    = 0; // events that went out inside a batch
+    uint32_t batches   = 0; // batch messages emitted
+    uint32_t bytes     = 0; // batch payload bytes emitted
+    uint32_t unbatched = 0; // events too large for a batch, published on their own
+};
+
+/**
+ * MeoEventBatch: events coalesced into one array payload (JSON or MessagePack).
+ * - [{"event":"<name>","ts":<ms>,"data":{...}},...] built in place, no heap
+ * - MessagePack: the same entries in an array 16 whose count is filled in by finish()
+ * - ts is the caller's millis() when the event was added (device uptime)
+ * - The owner decides when to flush: window expiry, budget reached, or explicitly
+ */
+class MeoEventBatch {
+public:
+    // Payload budget, capped at MEO_EVENT_BATCH_BYTES
+    void   setLimit(size_t maxBytes);
+    size_t limit() const { return _limit; }
+    // Drops pending events
+    void   setEncoding(MeoPayloadEncoding enc) { _encoding = enc; clear(); }
+
+    // Append one event; false if it does not fit the remaining budget
+    // (flush and retry) or, on an empty batch, does not fit at all
+    bool add(const char* eventName, const MeoEventFields& fields, uint32_t tsMs);
+
+    // Close the array and return the payload; valid until clear()
+    const char* finish(size_t& len);
+    void clear() { _len = 0; _count = 0; }
+
+    bool     empty() const   { return _count == 0; }
+    uint16_t count() const   { return _count; }
+    size_t   bytes() const   { return _len; }
+    uint32_t firstMs() const { return _firstMs; } // ts of the oldest event
+
+private:
+    char     _buf[MEO_EVENT_BATCH_BYTES + 1]; // + NUL written by serializeJson
+    size_t   _limit = MEO_EVENT_BATCH_BYTES;
+    size_t   _len = 0;
+    uint16_t _count = 0;
+    uint32_t _firstMs = 0;
+    MeoPayloadEncoding _encoding = MeoPayloadEncoding::JSON;
+
+    bool _addJson(const char* eventName, size_t nameLen, const MeoEventFields& fields, uint32_t tsMs);
+    bool _addMsgPack(const char* eventName, size_t nameLen, const MeoEventFields& fields, uint32_t tsMs);
+    void _put(const char* s, size_t n);
+};
@@ -0,0 +1,163 @@
+#include "Meo3_EventQueue.h"
+#include <string.h>
+
+static uint16_t readU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static void writeU16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)(v >> 8);
+}
+
+bool MeoEventQueue::push(const char* topic, const uint8_t* payload, size_t len) {
+    if (!topic || (!payload && len)) return false;
+    size_t topicLen = strlen(topic) + 1;
+    size_t recLen = HEADER + topicLen + len;
+    if (recLen > MAX_RECORD || recLen > sizeof(_ram)) {
+        _stats.droppedNewest++;
+        return false;
+    }
+    if (!_makeRoom(recLen)) {
+        _stats.droppedNewest++;
+        return false;
+    }
+
+    uint8_t header[HEADER];
+    writeU16(header, (uint16_t)topicLen);
+    writeU16(header + 2, (uint16_t)len);
+    _ramPush(header, HEADER);
+    _ramPush((const uint8_t*)topic, topicLen);
+    if (len) _ramPush(payload, len);
+    _count++;
+    _stats.enqueued++;
+    return true;
+}
+
+size_t MeoEventQueue::drain(SendFn send, void* ctx, size_t maxMessages) {
+    if (!send) return 0;
+    uint8_t rec[MAX_RECORD];
+    size_t sent = 0;
+    while (sent < maxMessages) {
+        bool fromSpill = _spill && _spill->count() > 0;
+        size_t len = fromSpill ? _spill->front(rec, sizeof(rec)) : _ramFront(rec, sizeof(rec));
+        if (len == 0) {
+            if (fromSpill) {
+                // Unreadable spill record: skip it rather than stalling forever
+                _spill->pop();
+                _stats.spillErrors++;
+                continue;
+            }
+            break;
+        }
+
+        uint16_t topicLen   = readU16(rec);
+        uint16_t payloadLen = readU16(rec + 2);
+        if (HEADER + topicLen + payloadLen != len || topicLen == 0) {
+            if (fromSpill) { _spill->pop(); _stats.spillErrors++; continue; }
+            _ramPop(); // corrupted RAM record should never happen; drop it
+            continue;
+        }
+        const char* topic = (const char*)(rec + HEADER);
+        if (!send(topic, rec + HEADER + topicLen, payloadLen, ctx)) break;
+
+        if (fromSpill) _spill->pop();
+        else           _ramPop();
+        _stats.replayed++;
+        sent++;
+    }
+    return sent;
+}
+
+uint32_t MeoEventQueue::count() const {
+    return _count + (_spill ? _spill->count() : 0);
+}
+
+void MeoEventQueue::clear() {
+    _head = _tail = _used = 0;
+    _count = 0;
+    if (_spill) {
+        while (_spill->count() > 0) _spill->pop();
+    }
+}
+
+MeoQueueStats MeoEventQueue::stats() const {
+    MeoQueueStats s = _stats;
+    s.ramDepth   = _count;
+    s.spillDepth = _spill ? _spill->count() : 0;
+    return s;
+}
+
+bool MeoEventQueue::_makeRoom(size_t need) {
+    uint8_t rec[MAX_RECORD];
+    while (sizeof(_ram) - _used < need) {
+        if (_spill) {
+            size_t len = _ramFront(rec, sizeof(rec));
+            if (len && _spill->push(rec, len)) {
+                _ramPop();
+                _stats.spilled++;
+                continue;
+            }
+            // Spill full (or failing): fall back to the drop policy
+            if (_policy == MeoQueuePolicy::DROP_NEWEST) return false;
+            // Drop the oldest spilled records until the RAM front fits
+            // (flash frees space a whole sector at a time)
+            bool moved = false;
+            while (len && _spill->count() > 0) {
+                _spill->pop();
+                _stats.droppedOldest++;
+                if (_spill->push(rec, len)) {
+                    _ramPop();
+                    _stats.spilled++;
+                    moved = true;
+                    break;
+                }
+            }
+            if (moved) continue;
+            _stats.spillErrors++;
+        } else if (_policy == MeoQueuePolicy::DROP_NEWEST) {
+            return false;
+        }
+        if (_count == 0) return false;
+        _ramPop();
+        _stats.droppedOldest++;
+    }
+    return true;
+}
+
+size_t MeoEventQueue::_ramFront(uint8_t* out, size_t outLen) const {
+    if (_count == 0) return 0;
+    uint8_t header[HEADER];
+    _copyOut(_tail, header, HEADER);
+    size_t len = HEADER + readU16(header) + readU16(header + 2);
+    if (len > outLen) return 0;
+    _copyOut(_tail, out, len);
+    return len;
+}
+
+void MeoEventQueue::_ramPop() {
+    if (_count == 0) return;
+    uint8_t header[HEADER];
+    _copyOut(_tail, header, HEADER);
+    size_t len = HEADER + readU16(header) + readU16(header + 2);
+    _tail = (_tail + len) % sizeof(_ram);
+    _used -= len;
+    _count--;
+    if (_count == 0) _head = _tail = _used = 0;
+}
+
+void MeoEventQueue::_ramPush(const uint8_t* data, size_t len) {
+    size_t first = sizeof(_ram) - _head;
+    if (first > len) first = len;
+    memcpy(_ram + _head, data, first);
+    memcpy(_ram, data + first, len - first);
+    _head = (_head + len) % sizeof(_ram);
+    _used += len;
+}
+
+void MeoEventQueue::_copyOut(size_t offset, uint8_t* out, size_t len) const {
+    size_t first = sizeof(_ram) - offset;
+    if (first > len) first = len;
+    memcpy(out, _ram + offset, first);
+    memcpy(out + first, _ram, len - first);
+}
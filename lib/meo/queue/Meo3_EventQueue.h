@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// RAM reserved for queued messages (records are packed back to back)
+#ifndef MEO_QUEUE_RAM_BYTES
+#define MEO_QUEUE_RAM_BYTES 2048
+#endif
+// Largest topic + payload accepted for one queued message
+#ifndef MEO_QUEUE_MAX_RECORD
+#define MEO_QUEUE_MAX_RECORD 512
+#endif
+
+// What to give up when both RAM and spill storage are full
+enum class MeoQueuePolicy : uint8_t {
+    DROP_OLDEST = 0,
+    DROP_NEWEST = 1
+};
+
+struct MeoQueueStats {
+    uint32_t enqueued      = 0;
+    uint32_t replayed      = 0;
+    uint32_t droppedOldest = 0;
+    uint32_t droppedNewest = 0;
+    uint32_t spilled       = 0; // records moved from RAM to spill storage
+    uint32_t spillErrors   = 0;
+    uint32_t ramDepth      = 0;
+    uint32_t spillDepth    = 0;
+};
+
+// Overflow storage for records evicted from RAM; FIFO of opaque byte records
+class MeoQueueSpill {
+public:
+    virtual ~MeoQueueSpill() {}
+
+    virtual bool     push(const uint8_t* record, size_t len) = 0;
+    // Copy the oldest record into `out`; returns its length, 0 when empty
+    virtual size_t   front(uint8_t* out, size_t outLen) = 0;
+    virtual void     pop() = 0;
+    virtual uint32_t count() const = 0;
+};
+
+/**
+ * MeoEventQueue: store-and-forward queue of pre-serialized MQTT messages.
+ * - Fixed RAM ring; when full, the oldest RAM records move to an optional spill
+ *   (e.g. MeoFlashSpill) so ordering is kept: spill holds the oldest messages
+ * - When everything is full, MeoQueuePolicy decides which message is dropped
+ * - No Arduino/ESP dependencies; drain() hands messages to a send callback
+ */
+class MeoEventQueue {
+public:
+    // Returns false to stop draining (message stays queued)
+    typedef bool (*SendFn)(const char* topic, const uint8_t* payload, size_t len, void* ctx);
+
+    MeoEventQueue() = default;
+
+    void setPolicy(MeoQueuePolicy policy) { _policy = policy; }
+    void setSpill(MeoQueueSpill* spill)   { _spill = spill; }
+
+    // Copy one message into the queue; false if it was rejected
+    bool push(const char* topic, const uint8_t* payload, size_t len);
+
+    // Send up to `maxMessages` messages, oldest first; returns how many were sent
+    size_t drain(SendFn send, void* ctx, size_t maxMessages);
+
+    bool     empty() const { return count() == 0; }
+    uint32_t count() const;
+    void     clear();
+
+    MeoQueueStats stats() const;
+
+private:
+    // Record: [u16 topicLen incl. NUL][u16 payloadLen][topic\0][payload]
+    static constexpr size_t HEADER = 4;
+    static constexpr size_t MAX_RECORD = HEADER + MEO_QUEUE_MAX_RECORD;
+
+    uint8_t  _ram[MEO_QUEUE_RAM_BYTES];
+    size_t   _head = 0;  // next write offset
+    size_t   _tail = 0;  // oldest record offset
+    size_t   _used = 0;  // bytes in use
+    uint32_t _count = 0; // records in RAM
+
+    MeoQueuePolicy _policy = MeoQueuePolicy::DROP_OLDEST;
+    MeoQueueSpill* _spill = nullptr;
+    MeoQueueStats  _stats;
+
+    bool   _makeRoom(size_t need);
+    size_t _ramFront(uint8_t* out, size_t outLen) const;
+    void   _ramPop();
+    void   _ramPush(const uint8_t* data, size_t len);
+    void   _copyOut(size_t offset, uint8_t* out, size_t len) const;
+};
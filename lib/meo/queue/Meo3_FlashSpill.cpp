@@ -0,0 +1,89 @@
+#include "Meo3_FlashSpill.h"
+
+bool MeoFlashSpill::begin(MeoFlash* flash) {
+    _flash = flash;
+    _count = 0;
+    _headSector = _headOff = 0;
+    _tailSector = _tailOff = 0;
+    if (!_flash) return false;
+    _sectorSize = _flash->sectorSize();
+    _sectors = _flash->sectorCount();
+    if (_sectors < 2 || _sectorSize <= HEADER || _sectorSize > 0xFFFF) { _flash = nullptr; return false; }
+    if (!_flash->eraseSector(0)) { _flash = nullptr; return false; }
+    return true;
+}
+
+bool MeoFlashSpill::push(const uint8_t* record, size_t len) {
+    if (!_flash || !record || len == 0 || len > 0xFFFF) return false;
+    size_t need = HEADER + _align(len);
+    if (need > _sectorSize) return false;
+
+    if (_headOff + need > _sectorSize) {
+        size_t next = _next(_headSector);
+        // Never erase the sector still holding unread records
+        if (_count > 0 && next == _tailSector) return false;
+        if (!_flash->eraseSector(next)) return false;
+        _headSector = next;
+        _headOff = 0;
+    }
+    if (_count == 0) {
+        // Empty log: reading starts wherever the next record lands
+        _tailSector = _headSector;
+        _tailOff = _headOff;
+    }
+
+    uint8_t header[HEADER] = {
+        (uint8_t)(MAGIC & 0xFF), (uint8_t)(MAGIC >> 8),
+        (uint8_t)(len & 0xFF),   (uint8_t)(len >> 8)
+    };
+    // Payload first, header last, so a failed write never looks like a record
+    size_t at = _addr(_headSector, _headOff);
+    if (!_flash->write(at + HEADER, record, len) || !_flash->write(at, header, HEADER)) {
+        _headOff = _sectorSize; // partially programmed: continue in a fresh sector
+        return false;
+    }
+
+    _headOff += need;
+    _count++;
+    return true;
+}
+
+size_t MeoFlashSpill::front(uint8_t* out, size_t outLen) {
+    uint16_t len = 0;
+    if (!_seekTail(len) || len > outLen) return 0;
+    if (!_flash->read(_addr(_tailSector, _tailOff) + HEADER, out, len)) return 0;
+    return len;
+}
+
+void MeoFlashSpill::pop() {
+    uint16_t len = 0;
+    if (!_seekTail(len)) {
+        // Log is inconsistent: forget everything that was spilled
+        _count = 0;
+        return;
+    }
+    _tailOff += HEADER + _align(len);
+    _count--;
+    // Step past an end-of-sector gap now, so push() sees the sector as free
+    if (_count > 0) _seekTail(len);
+}
+
+bool MeoFlashSpill::_seekTail(uint16_t& lenOut) {
+    if (!_flash || _count == 0) return false;
+    // At most one skip: the writer only leaves a gap at the end of a sector
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (_tailOff + HEADER <= _sectorSize) {
+            uint8_t header[HEADER];
+            if (!_flash->read(_addr(_tailSector, _tailOff), header, HEADER)) return false;
+            uint16_t magic = (uint16_t)(header[0] | (header[1] << 8));
+            uint16_t len   = (uint16_t)(header[2] | (header[3] << 8));
+            if (magic == MAGIC && _tailOff + HEADER + _align(len) <= _sectorSize) {
+                lenOut = len;
+                return true;
+            }
+        }
+        _tailSector = _next(_tailSector);
+        _tailOff = 0;
+    }
+    return false;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Meo3_EventQueue.h"
+#include "../storage/Meo3_Flash.h"
+
+/**
+ * MeoFlashSpill: MeoEventQueue overflow stored as a circular record log on flash.
+ * - Records never straddle a sector; a sector is erased just before it is reused
+ * - Read/write positions live in RAM: the log is a buffer for outages, not a
+ *   durable store, and starts empty after every begin()
+ */
+class MeoFlashSpill : public MeoQueueSpill {
+public:
+    MeoFlashSpill() = default;
+
+    // Needs at least two sectors; returns false if the region is unusable
+    bool begin(MeoFlash* flash);
+
+    bool     push(const uint8_t* record, size_t len) override;
+    size_t   front(uint8_t* out, size_t outLen) override;
+    void     pop() override;
+    uint32_t count() const override { return _count; }
+
+private:
+    static constexpr uint16_t MAGIC  = 0x5AA5;
+    static constexpr size_t   HEADER = 4; // [u16 magic][u16 len]
+
+    MeoFlash* _flash = nullptr;
+    size_t    _sectorSize = 0;
+    size_t    _sectors = 0;
+    size_t    _headSector = 0, _headOff = 0; // next write position
+    size_t    _tailSector = 0, _tailOff = 0; // oldest record position
+    uint32_t  _count = 0;
+
+    static size_t _align(size_t len) { return (len + 3) & ~(size_t)3; }
+    size_t _next(size_t sector) const { return (sector + 1) % _sectors; }
+    size_t _addr(size_t sector, size_t off) const { return sector * _sectorSize + off; }
+    bool   _seekTail(uint16_t& lenOut);
+};
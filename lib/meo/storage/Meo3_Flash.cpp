@@ -0,0 +1,177 @@
+#include "Meo3_Flash.h"
+
+#if defined(ESP_PLATFORM)
+
+// ESP32-family SPI flash erase granularity
+static const size_t MEO_FLASH_SECTOR_SIZE = 4096;
+
+bool MeoPartitionFlash::begin(const char* label) {
+    _part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    return _part != nullptr;
+}
+
+size_t MeoPartitionFlash::size() const {
+    return _part ? _part->size : 0;
+}
+
+size_t MeoPartitionFlash::sectorSize() const {
+    return MEO_FLASH_SECTOR_SIZE;
+}
+
+bool MeoPartitionFlash::read(size_t offset, void* out, size_t len) {
+    if (!_part) return false;
+    return esp_partition_read(_part, offset, out, len) == ESP_OK;
+}
+
+bool MeoPartitionFlash::write(size_t offset, const void* data, size_t len) {
+    if (!_part) return false;
+    return esp_partition_write(_part, offset, data, len) == ESP_OK;
+}
+
+bool MeoPartitionFlash::eraseSector(size_t sectorIndex) {
+    if (!_part) return false;
+    return esp_partition_erase_range(_part, sectorIndex * MEO_FLASH_SECTOR_SIZE, MEO_FLASH_SECTOR_SIZE) == ESP_OK;
+}
+
+#else
+
+#include <string.h>
+
+bool MeoFileFlash::begin(const char* path, size_t size, size_t sectorSize) {
+    end();
+    if (!path || sectorSize == 0 || size < sectorSize) return false;
+    size -= size % sectorSize;
+    _sectorSize = sectorSize;
+    _image.assign(size, 0xFF);
+    _erases.assign(size / sectorSize, 0);
+    _wearPath = std::string(path) + ".wear";
+    _bytesWritten = _bytesRead = 0;
+    _violations = 0;
+    _powered = true;
+    _cutArmed = false;
+
+    bool fresh = true;
+    _file = fopen(path, "r+b");
+    if (_file) {
+        fresh = fread(_image.data(), 1, size, _file) != size || fgetc(_file) != EOF;
+    } else {
+        _file = fopen(path, "w+b");
+    }
+    if (!_file) return false;
+    if (fresh) {
+        // Missing, short or resized: a blank chip with no wear history
+        _image.assign(size, 0xFF);
+        fclose(_file);
+        _file = fopen(path, "w+b");
+        if (!_file || !_flush(0, size)) return false;
+        _saveWear();
+        return true;
+    }
+    FILE* w = fopen(_wearPath.c_str(), "rb");
+    if (w) {
+        if (fread(_erases.data(), sizeof(uint32_t), _erases.size(), w) != _erases.size()) {
+            _erases.assign(_erases.size(), 0);
+        }
+        fclose(w);
+    }
+    return true;
+}
+
+void MeoFileFlash::end() {
+    if (!_file) return;
+    _saveWear();
+    fclose(_file);
+    _file = nullptr;
+}
+
+bool MeoFileFlash::read(size_t offset, void* out, size_t len) {
+    if (!_file || !_powered || !out || offset + len > _image.size() || offset + len < offset) return false;
+    memcpy(out, _image.data() + offset, len);
+    _bytesRead += len;
+    return true;
+}
+
+bool MeoFileFlash::write(size_t offset, const void* data, size_t len) {
+    if (!_file || !_powered || !data || offset + len > _image.size() || offset + len < offset) return false;
+    size_t done = _budget(len);
+    const uint8_t* in = (const uint8_t*)data;
+    uint8_t* at = _image.data() + offset;
+    for (size_t i = 0; i < done; ++i) {
+        if ((at[i] & in[i]) != in[i]) _violations++;
+        at[i] &= in[i];
+    }
+    _bytesWritten += done;
+    return _flush(offset, done) && done == len;
+}
+
+bool MeoFileFlash::eraseSector(size_t sectorIndex) {
+    if (!_file || !_powered || sectorIndex >= _erases.size()) return false;
+    size_t offset = sectorIndex * _sectorSize;
+    // A cut part way leaves the start of the sector erased and the rest as it was
+    size_t done = _budget(_sectorSize);
+    memset(_image.data() + offset, 0xFF, done);
+    if (done == _sectorSize) _erases[sectorIndex]++;
+    return _flush(offset, done) && done == _sectorSize;
+}
+
+uint32_t MeoFileFlash::erases(size_t sectorIndex) const {
+    return sectorIndex < _erases.size() ? _erases[sectorIndex] : 0;
+}
+
+MeoFlashWear MeoFileFlash::wear() const {
+    MeoFlashWear w;
+    w.minErases = _erases.empty() ? 0 : UINT32_MAX;
+    for (uint32_t e : _erases) {
+        if (e < w.minErases) w.minErases = e;
+        if (e > w.maxErases) w.maxErases = e;
+        w.totalErases += e;
+    }
+    w.bytesWritten = _bytesWritten;
+    w.bytesRead = _bytesRead;
+    w.violations = _violations;
+    return w;
+}
+
+size_t MeoFileFlash::formatWearJson(char* out, size_t len, uint32_t ratedCycles) const {
+    if (!out || len == 0) return 0;
+    MeoFlashWear w = wear();
+    double mean = _erases.empty() ? 0.0 : (double)w.totalErases / _erases.size();
+    int n = snprintf(out, len,
+                     "{\"sectors\":%u,\"erase_min\":%lu,\"erase_max\":%lu,\"erase_mean\":%.1f,"
+                     "\"bytes_written\":%llu,\"violations\":%lu,\"rated_cycles\":%lu,\"life_used_pct\":%.4f}",
+                     (unsigned)_erases.size(), (unsigned long)w.minErases, (unsigned long)w.maxErases, mean,
+                     (unsigned long long)w.bytesWritten, (unsigned long)w.violations,
+                     (unsigned long)ratedCycles, ratedCycles ? 100.0 * w.maxErases / ratedCycles : 0.0);
+    if (n < 0 || (size_t)n >= len) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)n;
+}
+
+size_t MeoFileFlash::_budget(size_t len) {
+    if (!_cutArmed) return len;
+    if (len < _cutBudget) {
+        _cutBudget -= len;
+        return len;
+    }
+    size_t done = _cutBudget;
+    _cutArmed = false;
+    _powered = false;
+    return done;
+}
+
+bool MeoFileFlash::_flush(size_t offset, size_t len) {
+    if (len == 0) return true;
+    return fseek(_file, (long)offset, SEEK_SET) == 0 &&
+           fwrite(_image.data() + offset, 1, len, _file) == len && fflush(_file) == 0;
+}
+
+void MeoFileFlash::_saveWear() {
+    FILE* w = fopen(_wearPath.c_str(), "wb");
+    if (!w) return;
+    fwrite(_erases.data(), sizeof(uint32_t), _erases.size(), w);
+    fclose(w);
+}
+
+#endif
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * MeoFlash: raw erase/program/read access to a flash region.
+ * - NOR semantics: erase sets a whole sector to 0xFF, write can only clear bits
+ * - Offsets are relative to the start of the region
+ * - Platform-independent so log structures on top of it can run on the host
+ *   against an emulated region
+ */
+class MeoFlash {
+public:
+    virtual ~MeoFlash() {}
+
+    virtual size_t size() const = 0;
+    virtual size_t sectorSize() const = 0;
+
+    virtual bool read(size_t offset, void* out, size_t len) = 0;
+    virtual bool write(size_t offset, const void* data, size_t len) = 0;
+    virtual bool eraseSector(size_t sectorIndex) = 0;
+
+    size_t sectorCount() const { return sectorSize() ? size() / sectorSize() : 0; }
+};
+
+#if defined(ESP_PLATFORM)
+#include <esp_partition.h>
+
+// MeoFlash over an ESP-IDF data partition (see partitions_meo.csv)
+class MeoPartitionFlash : public MeoFlash {
+public:
+    MeoPartitionFlash() = default;
+
+    // Find a data partition by label (e.g. "meolog"); returns false if missing
+    bool begin(const char* label);
+
+    size_t size() const override;
+    size_t sectorSize() const override;
+
+    bool read(size_t offset, void* out, size_t len) override;
+    bool write(size_t offset, const void* data, size_t len) override;
+    bool eraseSector(size_t sectorIndex) override;
+
+private:
+    const esp_partition_t* _part = nullptr;
+};
+#else
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Wear and traffic seen by a MeoFileFlash since it was created (erases persist, see below)
+struct MeoFlashWear {
+    uint32_t minErases = 0;    // least-erased sector
+    uint32_t maxErases = 0;    // most-erased sector: the one that wears out first
+    uint64_t totalErases = 0;
+    uint64_t bytesWritten = 0; // bytes programmed (this run)
+    uint64_t bytesRead = 0;
+    uint32_t violations = 0;   // writes that tried to turn a 0 bit back into 1
+};
+
+/**
+ * MeoFileFlash: MeoFlash emulated in a file, for host builds and endurance runs.
+ * - NOR rules: a write ANDs into what is there; one that needs a 0 -> 1 bit counts
+ *   as a violation (a real chip would silently keep the 0)
+ * - Erase counts per sector are kept in "<path>.wear", so they add up across runs
+ * - cutPowerAfter(n): the operation that crosses n more programmed bytes stops
+ *   part way (an erase counts as a sector's worth) and every call fails until
+ *   powerOn(), like a brown-out
+ */
+class MeoFileFlash : public MeoFlash {
+public:
+    MeoFileFlash() = default;
+    ~MeoFileFlash() override { end(); }
+
+    // Open or create a region of `size` bytes; a file of another size starts over erased
+    bool begin(const char* path, size_t size, size_t sectorSize = 4096);
+    void end();
+
+    size_t size() const override { return _image.size(); }
+    size_t sectorSize() const override { return _sectorSize; }
+
+    bool read(size_t offset, void* out, size_t len) override;
+    bool write(size_t offset, const void* data, size_t len) override;
+    bool eraseSector(size_t sectorIndex) override;
+
+    void cutPowerAfter(size_t bytes) { _cutArmed = true; _cutBudget = bytes; }
+    void powerOn() { _cutArmed = false; _powered = true; }
+    bool powered() const { return _powered; }
+
+    uint32_t     erases(size_t sectorIndex) const;
+    MeoFlashWear wear() const;
+    // {"sectors":16,"erase_min":..,"erase_max":..,...,"life_used_pct":..} against the rated cycles
+    size_t formatWearJson(char* out, size_t len, uint32_t ratedCycles = 100000) const;
+
+private:
+    FILE*                 _file = nullptr;
+    std::vector<uint8_t>  _image; // whole region in RAM, written through to the file
+    std::vector<uint32_t> _erases;
+    std::string           _wearPath;
+    size_t                _sectorSize = 0;
+    uint64_t              _bytesWritten = 0;
+    uint64_t              _bytesRead = 0;
+    uint32_t              _violations = 0;
+    bool                  _powered = true;
+    bool                  _cutArmed = false;
+    size_t                _cutBudget = 0;
+
+    size_t _budget(size_t len); // bytes of `len` done before the power cut
+    bool   _flush(size_t offset, size_t len);
+    void   _saveWear();
+};
+#endif
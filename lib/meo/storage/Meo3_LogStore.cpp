@@ -0,0 +1,470 @@
+#include "Meo3_LogStore.h"
+#include <string.h>
+
+namespace {
+
+// CRC-32 (IEEE, reflected); records are small, so no table
+uint32_t crc32(uint32_t crc, const uint8_t* p, size_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        for (uint8_t k = 0; k < 8; ++k) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    return ~crc;
+}
+
+// Covers keyLen, len, key and value: everything but the magic and the CRC itself
+uint32_t recordCrc(const uint8_t* rec, size_t bodyLen) {
+    return crc32(crc32(0, rec + 1, 3), rec + 8, bodyLen);
+}
+
+bool blank(const uint8_t* p, size_t len) {
+    while (len--) {
+        if (*p++ != 0xFF) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool MeoLogStore::begin(MeoFlash* flash) {
+    MeoLockGuard lk(_lock);
+    _flash = nullptr;
+    _keyCount = 0;
+    _liveBytes = 0;
+    _free = _dirty = 0;
+    _seq = 0;
+    _headOpen = false;
+    _victim = -1;
+    _stats = MeoLogStoreStats();
+    if (!flash) return false;
+    _sectorSize = flash->sectorSize();
+    size_t count = flash->sectorCount();
+    _sectors = (uint16_t)(count < MEO_LOGSTORE_SECTORS ? count : MEO_LOGSTORE_SECTORS);
+    if (_sectors < 3 || _sectorSize < SECTOR_HEADER + 2 * RECORD_MAX || _sectorSize > 0xFFFF) return false;
+    _capacity = (size_t)(_sectors - 2) * (_sectorSize - SECTOR_HEADER - RECORD_MAX);
+
+    // Sector headers: erase count always, sequence once the sector has been opened
+    uint64_t wearSum = 0;
+    uint16_t wearKnown = 0;
+    bool known[MEO_LOGSTORE_SECTORS];
+    for (uint16_t s = 0; s < _sectors; ++s) {
+        uint32_t h[4];
+        if (!flash->read(_addr(s, 0), h, sizeof(h))) return false;
+        Sector& sec = _sector[s];
+        sec.seq = 0;
+        sec.erases = h[0];
+        sec.verified = false;
+        known[s] = h[1] == (SECTOR_MAGIC ^ h[0]);
+        if (!known[s]) {
+            sec.state = blank((const uint8_t*)h, sizeof(h)) ? FREE : DIRTY;
+        } else if (h[2] == 0xFFFFFFFFu && h[3] == 0xFFFFFFFFu) {
+            sec.state = FREE;
+        } else if (h[3] == ~h[2]) {
+            sec.state = USED;
+            sec.seq = h[2];
+            if (h[2] > _seq) _seq = h[2];
+        } else {
+            sec.state = DIRTY; // cut while being opened, or retired before an erase
+        }
+        if (known[s]) {
+            wearSum += sec.erases;
+            wearKnown++;
+        }
+        if (sec.state == FREE) _free++;
+        if (sec.state == DIRTY) _dirty++;
+    }
+    // Blank (never used, or cut mid-erase) and damaged headers lost their count:
+    // assume the average, which is 0 on a new chip
+    for (uint16_t s = 0; s < _sectors; ++s) {
+        if (!known[s]) _sector[s].erases = wearKnown ? (uint32_t)(wearSum / wearKnown) : 0;
+    }
+
+    // Replay oldest to newest; the last record of a key wins
+    uint16_t order[MEO_LOGSTORE_SECTORS];
+    uint16_t used = 0;
+    for (uint16_t s = 0; s < _sectors; ++s) {
+        if (_sector[s].state != USED) continue;
+        uint16_t i = used++;
+        while (i > 0 && _sector[order[i - 1]].seq > _sector[s].seq) {
+            order[i] = order[i - 1];
+            i--;
+        }
+        order[i] = s;
+    }
+    _flash = flash;
+    for (uint16_t i = 0; i < used; ++i) {
+        size_t end;
+        if (!_scan(order[i], end)) {
+            _flash = nullptr;
+            return false;
+        }
+        _head = order[i];
+        _headOff = end;
+        _headOpen = true;
+    }
+    return true;
+}
+
+bool MeoLogStore::put(const char* key, const void* value, size_t len) {
+    if (!key || (!value && len) || len > MEO_LOGSTORE_VALUE_MAX) return false;
+    size_t keyLen = strlen(key);
+    if (keyLen == 0 || keyLen > KEY_MAX) return false;
+    MeoLockGuard lk(_lock);
+    if (!_flash) return false;
+    int i = _find(key);
+    if (i >= 0 && _entries[i].len == len) {
+        // Rewriting the same value only wears the flash
+        uint8_t current[MEO_LOGSTORE_VALUE_MAX];
+        const Entry& e = _entries[i];
+        if (_flash->read(_addr(e.sector, e.offset + RECORD_HEADER + keyLen), current, len) &&
+            memcmp(current, value, len) == 0) {
+            _stats.unchanged++;
+            return true;
+        }
+    }
+    return _write(key, value, (uint16_t)len);
+}
+
+bool MeoLogStore::get(const char* key, void* out, size_t outLen, size_t* lenOut) {
+    if (!key || (!out && outLen)) return false;
+    MeoLockGuard lk(_lock);
+    int i = _find(key);
+    if (!_flash || i < 0 || _entries[i].len == REMOVED) return false;
+    const Entry& e = _entries[i];
+    if (e.len > outLen) return false;
+    if (e.len && !_flash->read(_addr(e.sector, e.offset + RECORD_HEADER + strlen(e.key)), out, e.len)) return false;
+    if (lenOut) *lenOut = e.len;
+    return true;
+}
+
+bool MeoLogStore::remove(const char* key) {
+    if (!key) return false;
+    MeoLockGuard lk(_lock);
+    int i = _find(key);
+    if (!_flash || i < 0 || _entries[i].len == REMOVED) return false;
+    return _write(key, nullptr, REMOVED);
+}
+
+bool MeoLogStore::contains(const char* key) {
+    if (!key) return false;
+    MeoLockGuard lk(_lock);
+    int i = _find(key);
+    return i >= 0 && _entries[i].len != REMOVED;
+}
+
+void MeoLogStore::loop() {
+    MeoLockGuard lk(_lock);
+    if (!_flash) return;
+    if (_victim < 0 && _dirty == 0) {
+        if (_free >= MEO_LOGSTORE_SPARE) return;
+        // Only start on a sector when the log holds at least a sector of stale records
+        uint16_t used = (uint16_t)(_sectors - _free - _dirty);
+        size_t written = (size_t)(used ? used - 1 : 0) * (_sectorSize - SECTOR_HEADER) +
+                         (_headOpen ? _headOff - SECTOR_HEADER : 0);
+        if (written < _liveBytes + _sectorSize) return;
+    }
+    _step();
+}
+
+bool MeoLogStore::compact() {
+    MeoLockGuard lk(_lock);
+    if (!_flash) return false;
+    // Sectors opened from here on hold the copies; stop before reaching them
+    uint32_t last = _seq;
+    for (uint32_t guard = 0; guard < (uint32_t)_sectors * (MEO_LOGSTORE_KEYS + 2); ++guard) {
+        int32_t oldest = _oldest();
+        if (_victim < 0 && _dirty == 0 && (oldest < 0 || _sector[oldest].seq > last)) return true;
+        if (!_step()) return false;
+    }
+    return false;
+}
+
+MeoLogStoreStats MeoLogStore::stats() {
+    MeoLockGuard lk(_lock);
+    MeoLogStoreStats s = _stats;
+    s.minErases = _sectors ? UINT32_MAX : 0;
+    for (uint16_t i = 0; i < _sectors; ++i) {
+        if (_sector[i].erases < s.minErases) s.minErases = _sector[i].erases;
+        if (_sector[i].erases > s.maxErases) s.maxErases = _sector[i].erases;
+    }
+    return s;
+}
+
+// Index every intact record of sector `s`; `end` is where the next append would go
+bool MeoLogStore::_scan(uint16_t s, size_t& end) {
+    uint8_t rec[RECORD_MAX];
+    size_t off = SECTOR_HEADER;
+    for (;;) {
+        size_t size = 0;
+        Read r = _readRecord(s, off, rec, size);
+        if (r == Read::FAILED) return false;
+        if (r == Read::END) break;
+        if (r == Read::DAMAGED) {
+            // Cut mid-write: skip it, later appends went (and go) after it
+            _stats.torn++;
+            off += size;
+            continue;
+        }
+        char key[KEY_MAX + 1];
+        memcpy(key, rec + RECORD_HEADER, rec[1]);
+        key[rec[1]] = '\0';
+        uint16_t len = (uint16_t)(rec[2] | (rec[3] << 8));
+        int i = _find(key);
+        if (i >= 0) {
+            _liveBytes -= _recordSize(rec[1], _entries[i].len);
+        } else if (len != REMOVED && _keyCount < MEO_LOGSTORE_KEYS) {
+            i = _keyCount++;
+            strcpy(_entries[i].key, key);
+        }
+        if (i >= 0) {
+            _liveBytes += size;
+            _entries[i].sector = s;
+            _entries[i].offset = (uint16_t)off;
+            _entries[i].len = len;
+        }
+        off += size;
+    }
+    end = off;
+    return true;
+}
+
+// DAMAGED sets `size` to the bytes the torn write may have touched: the whole
+// record once its header made it out, otherwise just the header
+MeoLogStore::Read MeoLogStore::_readRecord(uint16_t s, size_t off, uint8_t* rec, size_t& size) {
+    if (off + RECORD_HEADER > _sectorSize) return Read::END;
+    if (!_flash->read(_addr(s, off), rec, RECORD_HEADER)) return Read::FAILED;
+    if (blank(rec, RECORD_HEADER)) return Read::END;
+    uint8_t keyLen = rec[1];
+    uint16_t len = (uint16_t)(rec[2] | (rec[3] << 8));
+    size = RECORD_HEADER;
+    if (rec[0] != RECORD_MAGIC || keyLen == 0 || keyLen > KEY_MAX ||
+        (len != REMOVED && len > MEO_LOGSTORE_VALUE_MAX) ||
+        off + _recordSize(keyLen, len) > _sectorSize) {
+        return Read::DAMAGED;
+    }
+    size = _recordSize(keyLen, len);
+    size_t body = keyLen + (len == REMOVED ? 0 : len);
+    if (!_flash->read(_addr(s, off + RECORD_HEADER), rec + RECORD_HEADER, body)) return Read::FAILED;
+    uint32_t crc;
+    memcpy(&crc, rec + 4, 4);
+    return crc == recordCrc(rec, body) ? Read::RECORD : Read::DAMAGED;
+}
+
+int MeoLogStore::_find(const char* key) const {
+    for (uint8_t i = 0; i < _keyCount; ++i) {
+        if (strcmp(_entries[i].key, key) == 0) return i;
+    }
+    return -1;
+}
+
+bool MeoLogStore::_write(const char* key, const void* value, uint16_t len) {
+    size_t keyLen = strlen(key);
+    size_t size = _recordSize(keyLen, len);
+    int i = _find(key);
+    if (i < 0 && _keyCount >= MEO_LOGSTORE_KEYS) return false;
+    size_t old = i >= 0 ? _recordSize(keyLen, _entries[i].len) : 0;
+    if (_liveBytes - old + size > _capacity) return false;
+
+    uint8_t rec[RECORD_MAX];
+    size_t body = keyLen + (len == REMOVED ? 0 : len);
+    memset(rec, 0xFF, size); // padding stays erased
+    rec[0] = RECORD_MAGIC;
+    rec[1] = (uint8_t)keyLen;
+    rec[2] = (uint8_t)(len & 0xFF);
+    rec[3] = (uint8_t)(len >> 8);
+    memcpy(rec + RECORD_HEADER, key, keyLen);
+    if (len != REMOVED && len) memcpy(rec + RECORD_HEADER + keyLen, value, len);
+    uint32_t crc = recordCrc(rec, body);
+    memcpy(rec + 4, &crc, 4);
+
+    uint16_t sector;
+    size_t off;
+    if (!_append(rec, size, false, sector, off)) return false;
+    _stats.puts++;
+
+    // Compaction inside _append may have dropped removed keys and moved entries
+    i = _find(key);
+    if (i >= 0) {
+        _liveBytes -= _recordSize(keyLen, _entries[i].len);
+    } else {
+        i = _keyCount++;
+        strcpy(_entries[i].key, key);
+    }
+    _liveBytes += size;
+    _entries[i].sector = sector;
+    _entries[i].offset = (uint16_t)off;
+    _entries[i].len = len;
+    return true;
+}
+
+bool MeoLogStore::_append(const uint8_t* rec, size_t size, bool compacting, uint16_t& sector, size_t& off) {
+    if ((!_headOpen || _headOff + size > _sectorSize) && !_open(compacting)) return false;
+    // One write, header first: a cut leaves a record that fails its CRC, never a
+    // blank header in front of programmed bytes
+    if (!_flash->write(_addr(_head, _headOff), rec, size)) {
+        _headOff += size; // partially programmed: fails its CRC, skipped like a torn record
+        return false;
+    }
+    _stats.bytesWritten += size;
+    sector = _head;
+    off = _headOff;
+    _headOff += size;
+    return true;
+}
+
+// Make an erased sector the new head. A put() leaves the last one to compaction
+// and compacts in the foreground if that is all there is.
+bool MeoLogStore::_open(bool compacting) {
+    if (!compacting) {
+        bool stalled = false;
+        for (uint32_t guard = 0; _free < 2 && guard < (uint32_t)_sectors * (MEO_LOGSTORE_KEYS + 2); ++guard) {
+            stalled = true;
+            if (!_step()) break;
+        }
+        if (stalled) _stats.stalls++;
+        if (_free < 2) return false;
+    }
+    while (_free > 0) {
+        // Least-worn first; ties go to the lowest index
+        int32_t pick = -1;
+        for (uint16_t s = 0; s < _sectors; ++s) {
+            if (_sector[s].state == FREE && (pick < 0 || _sector[s].erases < _sector[pick].erases)) pick = s;
+        }
+        if (_prepare((uint16_t)pick)) {
+            _head = (uint16_t)pick;
+            _headOff = SECTOR_HEADER;
+            _headOpen = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MeoLogStore::_prepare(uint16_t s) {
+    Sector& sec = _sector[s];
+    if (!sec.verified) {
+        // Erased before begin(): make sure a cut erase did not leave old bytes behind
+        uint32_t h[2];
+        uint8_t chunk[64];
+        bool clean = _flash->read(_addr(s, 0), h, sizeof(h));
+        bool formatted = clean && h[1] == (SECTOR_MAGIC ^ h[0]);
+        for (size_t off = formatted ? 8 : 0; clean && off < _sectorSize; off += sizeof(chunk)) {
+            clean = _flash->read(_addr(s, off), chunk, sizeof(chunk)) && blank(chunk, sizeof(chunk));
+        }
+        if (!clean) {
+            if (!_erase(s)) return false;
+        } else if (!formatted) {
+            uint32_t head[2] = {sec.erases, SECTOR_MAGIC ^ sec.erases};
+            if (!_flash->write(_addr(s, 0), head, sizeof(head))) {
+                _setState(s, DIRTY);
+                return false;
+            }
+            _stats.bytesWritten += sizeof(head);
+        }
+        sec.verified = true;
+    }
+    uint32_t seq[2] = {_seq + 1, ~(_seq + 1)};
+    if (!_flash->write(_addr(s, 8), seq, sizeof(seq))) {
+        _setState(s, DIRTY);
+        return false;
+    }
+    _stats.bytesWritten += sizeof(seq);
+    _seq++;
+    sec.seq = _seq;
+    _setState(s, USED);
+    return true;
+}
+
+bool MeoLogStore::_erase(uint16_t s) {
+    Sector& sec = _sector[s];
+    if (!_flash->eraseSector(s)) {
+        _setState(s, DIRTY);
+        return false;
+    }
+    _stats.erases++;
+    sec.erases++;
+    // The magic is keyed with the count, so a half-erased header never passes
+    uint32_t head[2] = {sec.erases, SECTOR_MAGIC ^ sec.erases};
+    if (!_flash->write(_addr(s, 0), head, sizeof(head))) {
+        _setState(s, DIRTY);
+        return false;
+    }
+    _stats.bytesWritten += sizeof(head);
+    sec.verified = true;
+    _setState(s, FREE);
+    return true;
+}
+
+// One unit of compaction: erase a leftover sector, copy one live record out of
+// the victim, or erase the victim once nothing live is left in it
+bool MeoLogStore::_step() {
+    if (_victim < 0) {
+        for (uint16_t s = 0; s < _sectors; ++s) {
+            if (_sector[s].state == DIRTY) return _erase(s);
+        }
+        _victim = _oldest();
+        if (_victim < 0) return false;
+        _victimOff = SECTOR_HEADER;
+    }
+    uint16_t v = (uint16_t)_victim;
+    uint8_t rec[RECORD_MAX];
+    for (;;) {
+        size_t size = 0;
+        Read r = _readRecord(v, _victimOff, rec, size);
+        if (r == Read::FAILED) return false;
+        if (r == Read::END) break;
+        size_t off = _victimOff;
+        _victimOff += size;
+        if (r == Read::DAMAGED) continue;
+
+        char key[KEY_MAX + 1];
+        memcpy(key, rec + RECORD_HEADER, rec[1]);
+        key[rec[1]] = '\0';
+        int i = _find(key);
+        if (i < 0 || _entries[i].sector != v || _entries[i].offset != off) continue; // superseded
+        if (_entries[i].len == REMOVED) {
+            // Nothing older survives this sector, so the removal has done its job
+            _liveBytes -= size;
+            _entries[i] = _entries[--_keyCount];
+            continue;
+        }
+        uint16_t sector;
+        size_t to;
+        if (!_append(rec, size, true, sector, to)) {
+            _victimOff = off; // retry this record next time
+            return false;
+        }
+        _entries[i].sector = sector;
+        _entries[i].offset = (uint16_t)to;
+        _stats.relocated++;
+        return true;
+    }
+    _victim = -1;
+    // Retire it first: if the erase is cut, what is left must not replay as live
+    uint32_t retired = 0;
+    if (!_flash->write(_addr(v, 12), &retired, sizeof(retired))) return false;
+    _stats.bytesWritten += sizeof(retired);
+    _setState(v, DIRTY);
+    return _erase(v);
+}
+
+// Least recently opened sector other than the head
+int32_t MeoLogStore::_oldest() const {
+    int32_t oldest = -1;
+    for (uint16_t s = 0; s < _sectors; ++s) {
+        if (_sector[s].state != USED || (_headOpen && s == _head)) continue;
+        if (oldest < 0 || _sector[s].seq < _sector[oldest].seq) oldest = s;
+    }
+    return oldest;
+}
+
+void MeoLogStore::_setState(uint16_t s, State state) {
+    State was = _sector[s].state;
+    if (was == state) return;
+    if (was == FREE) _free--;
+    if (was == DIRTY) _dirty--;
+    if (state == FREE) _free++;
+    if (state == DIRTY) _dirty++;
+    _sector[s].state = state;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include "Meo3_Flash.h"
+#include "../os/Meo3_Os.h"
+
+// Keys the in-RAM index can hold (removed keys keep their slot until compacted)
+#ifndef MEO_LOGSTORE_KEYS
+#define MEO_LOGSTORE_KEYS 32
+#endif
+
+#ifndef MEO_LOGSTORE_VALUE_MAX
+#define MEO_LOGSTORE_VALUE_MAX 64
+#endif
+
+// Sectors used from the region; the rest of a larger partition is left alone
+#ifndef MEO_LOGSTORE_SECTORS
+#define MEO_LOGSTORE_SECTORS 64
+#endif
+
+// loop() compacts while fewer erased sectors than this are ready
+#ifndef MEO_LOGSTORE_SPARE
+#define MEO_LOGSTORE_SPARE 3
+#endif
+
+struct MeoLogStoreStats {
+    uint32_t puts = 0;         // put()/remove() records appended
+    uint32_t unchanged = 0;    // put() calls skipped: same value as the latest record
+    uint32_t relocated = 0;    // live records copied forward by compaction
+    uint32_t erases = 0;       // sectors erased since begin()
+    uint32_t stalls = 0;       // put() calls that had to compact or erase first
+    uint32_t torn = 0;         // damaged records found by begin() (power cut mid-write)
+    uint32_t bytesWritten = 0; // flash bytes programmed since begin()
+    uint32_t minErases = 0;    // per-sector erase counts, from the sector headers
+    uint32_t maxErases = 0;
+};
+
+/**
+ * MeoLogStore: wear-leveled key/value log for values that change often
+ * (energy totals, actuator positions), on its own flash region.
+ * - Every put() appends one CRC-checked record; an in-RAM index maps each key to
+ *   its latest record, so get() is one flash read and begin() one scan
+ * - Compaction copies the live records out of the oldest sector and erases it.
+ *   Sectors are reused oldest-first and the least-worn erased sector is opened
+ *   next, so erases spread over the whole region, static keys included
+ * - loop() compacts in the background, one record or one erase per call;
+ *   put() only compacts itself when the erased sectors run out
+ * - Power loss: a torn record fails its CRC and is ignored, so a key reads back
+ *   its previous value; a sector is only erased once its live records are copied
+ * - Thread-safe; keys up to 15 characters, values up to MEO_LOGSTORE_VALUE_MAX
+ */
+class MeoLogStore {
+public:
+    MeoLogStore() = default;
+
+    // Needs at least three sectors; rebuilds the index from whatever the region holds
+    bool begin(MeoFlash* flash);
+
+    bool   put(const char* key, const void* value, size_t len);
+    // Latest value of `key` into `out`; false if missing, removed or larger than outLen
+    bool   get(const char* key, void* out, size_t outLen, size_t* lenOut = nullptr);
+    bool   remove(const char* key);
+    bool   contains(const char* key);
+
+    template <typename T> bool putValue(const char* key, const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "plain data only");
+        return put(key, &value, sizeof(T));
+    }
+    template <typename T> bool getValue(const char* key, T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "plain data only");
+        size_t len = 0;
+        T v;
+        if (!get(key, &v, sizeof(T), &len) || len != sizeof(T)) return false;
+        value = v;
+        return true;
+    }
+
+    // Background compaction step; cheap when nothing is due
+    void loop();
+    // Compact until every used sector but the head has been rewritten
+    bool compact();
+
+    bool    ready() const { return _flash != nullptr; }
+    uint8_t keys() const { return _keyCount; }
+    MeoLogStoreStats stats();
+
+private:
+    static constexpr uint32_t SECTOR_MAGIC = 0x3153474Cu; // "LGS1"
+    static constexpr uint8_t  RECORD_MAGIC = 0xA7;
+    static constexpr size_t   SECTOR_HEADER = 16; // [u32 erases][u32 magic^erases][u32 seq][u32 ~seq]
+    static constexpr size_t   RECORD_HEADER = 8;  // [u8 magic][u8 keyLen][u16 len][u32 crc]
+    static constexpr size_t   KEY_MAX = 15;
+    static constexpr uint16_t REMOVED = 0xFFFF;   // len of a removal record
+    static constexpr size_t   RECORD_MAX = (RECORD_HEADER + KEY_MAX + MEO_LOGSTORE_VALUE_MAX + 3) & ~(size_t)3;
+
+    enum State : uint8_t { FREE, USED, DIRTY }; // DIRTY: erase before use
+    enum class Read : uint8_t { RECORD, END, DAMAGED, FAILED };
+
+    struct Sector {
+        uint32_t seq;      // order of opening, for USED
+        uint32_t erases;
+        State    state;
+        bool     verified; // erased by us, so known blank past the header
+    };
+    struct Entry {
+        char     key[KEY_MAX + 1];
+        uint16_t sector;
+        uint16_t offset;
+        uint16_t len;    // REMOVED once deleted
+    };
+
+    MeoFlash* _flash = nullptr;
+    size_t    _sectorSize = 0;
+    uint16_t  _sectors = 0;
+    Sector    _sector[MEO_LOGSTORE_SECTORS];
+    uint16_t  _free = 0;     // FREE sectors
+    uint16_t  _dirty = 0;    // DIRTY sectors
+    uint32_t  _seq = 0;      // last sequence handed out
+    uint16_t  _head = 0;     // sector being appended to
+    size_t    _headOff = 0;  // next append offset in it
+    bool      _headOpen = false;
+    size_t    _liveBytes = 0; // flash taken by the latest record of each key
+    size_t    _capacity = 0;
+
+    Entry     _entries[MEO_LOGSTORE_KEYS];
+    uint8_t   _keyCount = 0;
+
+    // Compaction in progress: the victim sector and the next record to look at
+    int32_t   _victim = -1;
+    size_t    _victimOff = 0;
+
+    MeoLogStoreStats _stats;
+    MeoMutex  _lock;
+
+    static size_t _align(size_t len) { return (len + 3) & ~(size_t)3; }
+    static size_t _recordSize(size_t keyLen, uint16_t len) {
+        return _align(RECORD_HEADER + keyLen + (len == REMOVED ? 0 : len));
+    }
+    size_t _addr(uint16_t sector, size_t off) const { return (size_t)sector * _sectorSize + off; }
+
+    bool   _scan(uint16_t s, size_t& end);
+    Read   _readRecord(uint16_t s, size_t off, uint8_t* rec, size_t& size);
+    int    _find(const char* key) const;
+    bool   _write(const char* key, const void* value, uint16_t len);
+    bool   _append(const uint8_t* rec, size_t size, bool compacting, uint16_t& sector, size_t& off);
+    bool   _open(bool compacting);
+    bool   _prepare(uint16_t s);
+    bool   _erase(uint16_t s);
+    bool   _step();
+    int32_t _oldest() const;
+    void   _setState(uint16_t s, State state);
+};
@@ -1,109 +1,369 @@
 #include "Meo3_Storage.h"
 
 static constexpr const char* MEO_PREFS_NAMESPACE = "meo";
+static constexpr const char* MEO_PREFS_BLOB      = "meo_cfg"; // the whole cache, one NVS entry
+static constexpr uint8_t     MEO_PREFS_VERSION   = 1;         // first byte of the blob
+
+namespace {
+
+constexpr size_t KEY_MAX = 15; // NVS key limit
+
+// Bytes of the entry at `e`: [u8 keyLen][key][u8 type][u16 len][value]
+size_t entrySize(const uint8_t* e) {
+    size_t keyLen = e[0];
+    return 1 + keyLen + 3 + (size_t)(e[keyLen + 2] | (e[keyLen + 3] << 8));
+}
+
+// A blob read back from NVS must walk cleanly to its end
+bool validImage(const uint8_t* image, size_t len) {
+    if (len == 0 || image[0] != MEO_PREFS_VERSION) return false;
+    size_t at = 1;
+    while (at < len) {
+        if (at + 4 > len || image[at] == 0 || image[at] > KEY_MAX) return false;
+        at += entrySize(image + at);
+    }
+    return at == len;
+}
+
+} // namespace
 
 MeoStorage::MeoStorage()
-: _initialized(false) {}
+: _initialized(false) {
+    _image[0] = MEO_PREFS_VERSION;
+    _used = 1;
+}
+
+MeoStorage::~MeoStorage() {
+    commit();
+}
 
 bool MeoStorage::begin() {
+    MeoLockGuard lk(_lock);
     if (_initialized) return true;
     // Preferences::begin returns bool on ESP32 Arduino core
-    bool ok = _prefs.begin(MEO_PREFS_NAMESPACE, /*readOnly*/ false);
-    _initialized = ok;
-    return ok;
+    if (!_prefs.begin(MEO_PREFS_NAMESPACE, /*readOnly*/ false)) return false;
+    _initialized = true;
+
+    // One lookup for the whole namespace; older firmware's per-key entries load on a miss
+    _stats.nvsReads++;
+    if (!_prefs.isKey(MEO_PREFS_BLOB)) return true;
+    _stats.nvsReads++;
+    size_t len = _prefs.getBytesLength(MEO_PREFS_BLOB);
+    if (len <= sizeof(_image) && _prefs.getBytes(MEO_PREFS_BLOB, _image, len) == len && validImage(_image, len)) {
+        _used = len;
+    } else {
+        _image[0] = MEO_PREFS_VERSION;
+        _used = 1;
+    }
+    return true;
 }
 
 bool MeoStorage::loadBytes(const char* key, uint8_t* buffer, size_t length) {
-    if (!_initialized || !key || !buffer || length == 0) return false;
-
-    size_t storedLen = _prefs.getBytesLength(key);
-    if (storedLen == 0) return false;            // key not found
-    if (storedLen > length) return false;        // caller buffer too small
-
-    size_t got = _prefs.getBytes(key, buffer, storedLen);
-    return (got == storedLen);
+    if (!key || !buffer || length == 0) return false;
+    MeoLockGuard lk(_lock);
+    size_t len;
+    const uint8_t* v = _find(key, BYTES, len);
+    if (!v || len == 0) return false;     // key not found
+    if (len > length) return false;       // caller buffer too small
+    memcpy(buffer, v, len);
+    return true;
 }
 
 bool MeoStorage::saveBytes(const char* key, const uint8_t* data, size_t length) {
-    if (!_initialized || !key || !data || length == 0) return false;
-    size_t written = _prefs.putBytes(key, data, length);
-    return (written == length);
+    if (!key || !data || length == 0) return false;
+    MeoLockGuard lk(_lock);
+    return _put(key, BYTES, data, length);
 }
 
 bool MeoStorage::loadString(const char* key, std::string& valueOut) {
-    if (!_initialized || !key) return false;
-    if (!_prefs.isKey(key)) return false;
-    valueOut = std::string(_prefs.getString(key, "").c_str());
+    if (!key) return false;
+    MeoLockGuard lk(_lock);
+    size_t len;
+    const char* v = (const char*)_find(key, STR, len);
+    if (!v) return false;
+    valueOut.assign(v, len);
     return true; // empty string is allowed if key exists
 }
 
 bool MeoStorage::saveString(const char* key, const std::string& value) {
-    if (!_initialized || !key) return false;
-
-    // Avoid flash wear by skipping redundant writes
-    if (_prefs.isKey(key)) {
-        if (_prefs.getString(key, "").equals(value.c_str())) return true;
-    }
-    size_t written = _prefs.putString(key, value.c_str());
-    return (written > 0);
+    if (!key) return false;
+    MeoLockGuard lk(_lock);
+    return _put(key, STR, value.data(), value.size());
 }
 
-// NEW: C-string helpers
 bool MeoStorage::saveCString(const char* key, const char* value) {
-    if (!_initialized || !key || !value) return false;
-
-    // Avoid redundant write
-    if (_prefs.isKey(key)) {
-        if (_prefs.getString(key, "").equals(value)) return true;
-    }
-    // Preferences::putString(const char* key, const char* value)
-    size_t written = _prefs.putString(key, value);
-    return (written > 0);
+    if (!key || !value) return false;
+    MeoLockGuard lk(_lock);
+    return _put(key, STR, value, strlen(value));
 }
 
 bool MeoStorage::loadCString(const char* key, char* buffer, size_t bufferLen) {
-    if (!_initialized || !key || !buffer || bufferLen == 0) return false;
-    if (!_prefs.isKey(key)) return false;
-
-    // Read to a temporary String to check size and avoid truncation
-    std::string s = _prefs.getString(key, "").c_str();
-    size_t needed = s.length() + 1; // include NUL terminator
-    if (needed > bufferLen) {
-        // Caller buffer too small
-        return false;
-    }
-    // Safe copy including terminator
-    memcpy(buffer, s.c_str(), needed);
+    if (!key || !buffer || bufferLen == 0) return false;
+    MeoLockGuard lk(_lock);
+    size_t len;
+    const char* v = (const char*)_find(key, STR, len);
+    if (!v || len + 1 > bufferLen) return false; // missing, or caller buffer too small
+    memcpy(buffer, v, len);
+    buffer[len] = '\0';
     return true;
 }
 
 bool MeoStorage::loadShort(const char* key, int16_t& valueOut) {
-    if (!_initialized || !key) return false;
-    if (!_prefs.isKey(key)) return false;
-    valueOut = _prefs.getShort(key, 0);
+    if (!key) return false;
+    MeoLockGuard lk(_lock);
+    size_t len;
+    const uint8_t* v = _find(key, I16, len);
+    if (!v || len != sizeof(int16_t)) return false;
+    memcpy(&valueOut, v, sizeof(int16_t));
     return true;
 }
 
 bool MeoStorage::saveShort(const char* key, int16_t value) {
-    if (!_initialized || !key) return false;
-
-    // Avoid redundant write
-    if (_prefs.isKey(key)) {
-        int16_t cur = _prefs.getShort(key, 0);
-        if (cur == value) return true;
-    }
-    size_t written = _prefs.putShort(key, value);
-    return (written == sizeof(int16_t));
+    if (!key) return false;
+    MeoLockGuard lk(_lock);
+    return _put(key, I16, &value, sizeof(value));
 }
 
 bool MeoStorage::clearKey(const char* key) {
-    if (!_initialized || !key) return false;
-    // Preferences::remove returns bool (true if key was removed)
-    return _prefs.remove(key);
+    if (!key) return false;
+    MeoLockGuard lk(_lock);
+    if (!_initialized) return false;
+    bool removed = _locate(key) < _used;
+    if (removed) {
+        _erase(key);
+        if (!_dirty) _dirtySinceMs = millis();
+        _dirty = true;
+    }
+    // A per-key entry from older firmware would otherwise come back on the next miss
+    if (!_missed(key)) {
+        _stats.nvsReads++;
+        if (_prefs.isKey(key)) {
+            _stats.nvsWrites++;
+            removed = _prefs.remove(key) || removed;
+        }
+    }
+    _remember(key);
+    _untrack(key);
+    if (removed && _commitDelayMs == 0) _commit();
+    return removed;
 }
 
 bool MeoStorage::clearAll() {
+    MeoLockGuard lk(_lock);
     if (!_initialized) return false;
+    _used = 1;
+    _dirty = false;
+    _missCount = 0;
+    _missNext = 0;
+    _perKeyCount = 0;
+    _stats.nvsWrites++;
     // Preferences::clear returns bool (true if any key was removed)
     return _prefs.clear();
-}
\ No newline at end of file
+}
+
+bool MeoStorage::commit() {
+    MeoLockGuard lk(_lock);
+    return _commit();
+}
+
+void MeoStorage::loop() {
+    MeoLockGuard lk(_lock);
+    if (!_dirty || millis() - _dirtySinceMs < _commitDelayMs) return;
+    if (!_commit()) _dirtySinceMs = millis(); // retry after another delay
+}
+
+bool MeoStorage::_commit() {
+    if (!_initialized) return false;
+    if (!_dirty) return true;
+    _stats.nvsWrites++;
+    if (_prefs.putBytes(MEO_PREFS_BLOB, _image, _used) != _used) return false;
+    _dirty = false;
+    // Per-key entries the blob now carries; removing one earlier could lose the key
+    for (uint8_t i = 0; i < _perKeyCount;) {
+        if (_locate(_perKey[i]) == _used) {
+            ++i;
+            continue;
+        }
+        _stats.nvsWrites++;
+        _prefs.remove(_perKey[i]);
+        if (i != --_perKeyCount) strcpy(_perKey[i], _perKey[_perKeyCount]);
+    }
+    return true;
+}
+
+const uint8_t* MeoStorage::_find(const char* key, Type type, size_t& len) {
+    if (!_initialized) return nullptr;
+    size_t at = _locate(key);
+    if (at == _used) return _legacy(key, type, len);
+    _stats.reads++;
+    const uint8_t* e = _image + at;
+    size_t keyLen = e[0];
+    if (e[keyLen + 1] != type) return nullptr;
+    len = (size_t)(e[keyLen + 2] | (e[keyLen + 3] << 8));
+    return e + keyLen + 4;
+}
+
+size_t MeoStorage::_locate(const char* key) const {
+    size_t keyLen = strlen(key);
+    size_t at = 1;
+    while (at < _used) {
+        if (_image[at] == keyLen && memcmp(_image + at + 1, key, keyLen) == 0) return at;
+        at += entrySize(_image + at);
+    }
+    return _used;
+}
+
+// Older firmware kept one NVS entry per key, as do saves that did not fit the image:
+// read it, and carry it into the blob if there is room
+const uint8_t* MeoStorage::_legacy(const char* key, Type type, size_t& len) {
+    if (_missed(key)) return nullptr;
+    _stats.nvsReads++;
+    if (!_prefs.isKey(key)) {
+        _remember(key);
+        return nullptr;
+    }
+    _stats.nvsReads++;
+    switch (type) {
+        case STR: {
+            String s = _prefs.getString(key, "");
+            _scratch.assign(s.c_str(), s.length());
+            break;
+        }
+        case I16: {
+            int16_t v = _prefs.getShort(key, 0);
+            _scratch.assign((const char*)&v, sizeof(v));
+            break;
+        }
+        case BYTES: {
+            size_t n = _prefs.getBytesLength(key);
+            _scratch.resize(n);
+            if (n == 0 || _prefs.getBytes(key, &_scratch[0], n) != n) return nullptr;
+            break;
+        }
+        default:
+            return nullptr;
+    }
+    _track(key);
+    _stats.reads++;
+    len = _scratch.size();
+    const uint8_t* v = _reserve(key, type, _scratch.data(), len);
+    return v ? v : (const uint8_t*)_scratch.data(); // image full: served from NVS each time
+}
+
+// save*: RAM only; unchanged values leave the cache clean
+bool MeoStorage::_put(const char* key, Type type, const void* value, size_t len) {
+    if (!_initialized) return false;
+    size_t at = _locate(key);
+    if (at < _used) {
+        const uint8_t* e = _image + at;
+        size_t keyLen = e[0];
+        size_t oldLen = (size_t)(e[keyLen + 2] | (e[keyLen + 3] << 8));
+        if (e[keyLen + 1] == type && oldLen == len && memcmp(e + keyLen + 4, value, len) == 0) return true;
+    }
+    size_t keyLen = strlen(key);
+    if (keyLen == 0 || keyLen > KEY_MAX || len > 0xFFFF) return false;
+    bool pending = _dirty;
+    if (!_reserve(key, type, value, len)) {
+        if (!_putPerKey(key, type, value, len)) return false;
+        _stats.writes++;
+        return true;
+    }
+    _stats.writes++;
+    if (pending) _stats.coalesced++;
+    return _commitDelayMs ? true : _commit();
+}
+
+// The image is full: write `key` as its own NVS entry now, and drop the cached
+// copy so it cannot shadow the new value
+bool MeoStorage::_putPerKey(const char* key, Type type, const void* value, size_t len) {
+    _stats.nvsWrites++;
+    size_t wrote = 0;
+    switch (type) {
+        case STR:   wrote = _prefs.putString(key, std::string((const char*)value, len).c_str()); break;
+        case I16:   wrote = _prefs.putShort(key, *(const int16_t*)value); break;
+        case BYTES: wrote = _prefs.putBytes(key, value, len); break;
+    }
+    if (wrote != len) return false;
+    _forget(key);
+    _track(key);
+    if (_locate(key) < _used) {
+        _erase(key);
+        if (!_dirty) _dirtySinceMs = millis();
+        _dirty = true;
+        _commit(); // on failure loop() retries; until then the old value survives a reset
+    }
+    return true;
+}
+
+// (Re)place the entry for `key` at the end of the image; copies `value` unless nullptr
+uint8_t* MeoStorage::_reserve(const char* key, Type type, const void* value, size_t len) {
+    size_t keyLen = strlen(key);
+    if (keyLen == 0 || keyLen > KEY_MAX || len > 0xFFFF) return nullptr;
+    size_t at = _locate(key);
+    size_t freed = at < _used ? entrySize(_image + at) : 0;
+    size_t need = 1 + keyLen + 3 + len;
+    if (_used - freed + need > sizeof(_image)) return nullptr; // keep the old value
+    _erase(key);
+    uint8_t* e = _image + _used;
+    e[0] = (uint8_t)keyLen;
+    memcpy(e + 1, key, keyLen);
+    e[keyLen + 1] = type;
+    e[keyLen + 2] = (uint8_t)(len & 0xFF);
+    e[keyLen + 3] = (uint8_t)(len >> 8);
+    if (value && len) memcpy(e + keyLen + 4, value, len);
+    _used += need;
+    _forget(key);
+    if (!_dirty) _dirtySinceMs = millis();
+    _dirty = true;
+    return e + keyLen + 4;
+}
+
+void MeoStorage::_erase(const char* key) {
+    size_t at = _locate(key);
+    if (at == _used) return;
+    size_t size = entrySize(_image + at);
+    memmove(_image + at, _image + at + size, _used - at - size);
+    _used -= size;
+}
+
+bool MeoStorage::_missed(const char* key) const {
+    for (uint8_t i = 0; i < _missCount; ++i) {
+        if (strcmp(_misses[i], key) == 0) return true;
+    }
+    return false;
+}
+
+void MeoStorage::_remember(const char* key) {
+    if (strlen(key) > KEY_MAX || _missed(key)) return;
+    // Oldest miss makes room: forgetting one only costs a lookup
+    uint8_t i = _missCount < MEO_STORAGE_MISSES ? _missCount++ : _missNext;
+    _missNext = (uint8_t)((i + 1) % MEO_STORAGE_MISSES);
+    strcpy(_misses[i], key);
+}
+
+void MeoStorage::_forget(const char* key) {
+    for (uint8_t i = 0; i < _missCount; ++i) {
+        if (strcmp(_misses[i], key) == 0) {
+            _misses[i][0] = '\0'; // never matches a real key
+            return;
+        }
+    }
+}
+
+void MeoStorage::_track(const char* key) {
+    for (uint8_t i = 0; i < _perKeyCount; ++i) {
+        if (strcmp(_perKey[i], key) == 0) return;
+    }
+    // Untracked entries stay in NVS, shadowed by the blob: harmless, just not reclaimed
+    if (_perKeyCount == MEO_STORAGE_PER_KEY || strlen(key) > KEY_MAX) return;
+    strcpy(_perKey[_perKeyCount++], key);
+}
+
+void MeoStorage::_untrack(const char* key) {
+    for (uint8_t i = 0; i < _perKeyCount; ++i) {
+        if (strcmp(_perKey[i], key) == 0) {
+            if (i != --_perKeyCount) strcpy(_perKey[i], _perKey[_perKeyCount]);
+            return;
+        }
+    }
+}
@@ -3,10 +3,56 @@
 #include <Arduino.h>
 #include <string>
 #include <Preferences.h>
+#include "../os/Meo3_Os.h"
 
+// RAM image of the namespace: every key, type and value, stored as one NVS blob
+#ifndef MEO_STORAGE_BYTES
+#define MEO_STORAGE_BYTES 512
+#endif
+
+// Dirty writes are committed by loop() once the oldest is this old; 0 = write-through
+#ifndef MEO_STORAGE_COMMIT_MS
+#define MEO_STORAGE_COMMIT_MS 1000
+#endif
+
+// Keys remembered as absent from NVS, so repeated misses stay in RAM
+#ifndef MEO_STORAGE_MISSES
+#define MEO_STORAGE_MISSES 8
+#endif
+
+// Per-key NVS entries remembered so they can be removed once the blob carries them
+#ifndef MEO_STORAGE_PER_KEY
+#define MEO_STORAGE_PER_KEY 8
+#endif
+
+struct MeoStorageStats {
+    uint32_t reads     = 0; // load* calls answered
+    uint32_t nvsReads  = 0; // NVS lookups (blob at begin, legacy keys on a miss)
+    uint32_t nvsWrites = 0; // NVS writes (blob commits, removes, clear)
+    uint32_t writes    = 0; // save* calls that changed a value
+    uint32_t coalesced = 0; // of those, absorbed into an already pending commit
+};
+
+/**
+ * MeoStorage: typed key/value store over one Preferences (NVS) namespace, cached in RAM.
+ * - begin() reads the whole namespace as a single blob; loads are served from RAM
+ *   with no NVS access and no Arduino String
+ * - Saves only touch RAM and mark the cache dirty; loop() commits after
+ *   MEO_STORAGE_COMMIT_MS (so a provisioning burst is one write), commit() now.
+ *   Unchanged values are not rewritten. A save sits in RAM for up to that delay
+ *   (about 1 s): a reset, crash or power cut before the commit loses it, so call
+ *   commit() before restarting on purpose
+ * - Keys written by older firmware (one NVS entry per key) are read once on a miss
+ *   and carried into the blob at the next commit; the old entry is removed only
+ *   after that commit succeeded
+ * - A save that does not fit MEO_STORAGE_BYTES is written straight to its own NVS
+ *   entry instead (older firmware's layout) and read back from there on each load
+ * - Thread-safe: BLE callbacks, the network task and loop() may share one instance
+ */
 class MeoStorage {
 public:
     MeoStorage();
+    ~MeoStorage(); // commits pending writes
 
     // Initialize underlying storage (Preferences/NVS)
     // For future extensibility, this could take a namespace, e.g., begin(const char* ns = "meo")
@@ -29,7 +75,47 @@ public:
     // Clear all stored keys/values
     bool clearAll();
 
+    // Write pending changes to NVS now (call before a deliberate restart)
+    bool commit();
+    // Commit once the oldest pending change is older than the commit delay
+    void loop();
+    void setCommitDelay(uint32_t ms) { _commitDelayMs = ms; }
+    bool dirty() const { return _dirty; }
+    MeoStorageStats stats() const { return _stats; }
+
 private:
+    enum Type : uint8_t { STR = 1, BYTES = 2, I16 = 3 };
+
     bool _initialized;
     Preferences _prefs;
-};
\ No newline at end of file
+    MeoMutex _lock;
+
+    // [u8 keyLen][key][u8 type][u16 len LE][value] per key, back to back
+    uint8_t  _image[MEO_STORAGE_BYTES];
+    size_t   _used = 0;
+    bool     _dirty = false;
+    uint32_t _dirtySinceMs = 0;
+    uint32_t _commitDelayMs = MEO_STORAGE_COMMIT_MS;
+    char     _misses[MEO_STORAGE_MISSES][16];
+    uint8_t  _missCount = 0;
+    uint8_t  _missNext = 0;
+    char     _perKey[MEO_STORAGE_PER_KEY][16]; // known to have their own NVS entry
+    uint8_t  _perKeyCount = 0;
+    std::string _scratch; // a per-key value that did not fit the image
+    MeoStorageStats _stats;
+
+    // Value of `key` if cached (or found in legacy NVS) with `type`; nullptr otherwise
+    const uint8_t* _find(const char* key, Type type, size_t& len);
+    size_t _locate(const char* key) const; // entry offset, or _used if absent
+    const uint8_t* _legacy(const char* key, Type type, size_t& len);
+    bool   _put(const char* key, Type type, const void* value, size_t len);
+    bool   _putPerKey(const char* key, Type type, const void* value, size_t len);
+    uint8_t* _reserve(const char* key, Type type, const void* value, size_t len);
+    void   _erase(const char* key);
+    bool   _missed(const char* key) const;
+    void   _remember(const char* key); // known absent from NVS
+    void   _forget(const char* key);
+    void   _track(const char* key); // has its own NVS entry
+    void   _untrack(const char* key);
+    bool   _commit();
+};
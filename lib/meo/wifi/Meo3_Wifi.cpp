@@ -0,0 +1,159 @@
+#include "Meo3_Wifi.h"
+#include <string.h>
+#include <stdarg.h>
+#include <esp_system.h>
+
+static constexpr const char* FAST_KEY = "wifi_fast";
+static constexpr uint8_t FAST_VERSION = 1;
+
+void MeoWifiManager::setDebugTags(const char* tagsCsv) {
+    _debugMask = meoLogTagMask(tagsCsv);
+}
+
+bool MeoWifiManager::connect(const char* ssid, const char* pass) {
+    if (!ssid || !*ssid || strlen(ssid) >= sizeof(_ssid)) return false;
+    if (pass && strlen(pass) >= sizeof(_pass)) return false;
+    strncpy(_ssid, ssid, sizeof(_ssid) - 1);
+    strncpy(_pass, pass ? pass : "", sizeof(_pass) - 1);
+
+    if (!_eventsRegistered) {
+        WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) {
+            _onEvent(event, info);
+        });
+        _eventsRegistered = true;
+    }
+
+    _startMs = millis();
+    _timeToIpMs = 0;
+    _attempts = 0;
+    _fastUsed = false;
+    _retryPending = false;
+    _backoff.reset();
+    _loadFast();
+
+    _logf("INFO", "WIFI", "Connecting SSID=%s%s", _ssid, _fastValid ? " (fast reconnect)" : "");
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(false);
+    _beginAttempt();
+    return true;
+}
+
+void MeoWifiManager::loop() {
+    if (_evDisconnected) {
+        _evDisconnected = false;
+        _handleDisconnected();
+    }
+    if (_evGotIp) {
+        _evGotIp = false;
+        _handleGotIp();
+    }
+    if (_retryPending && (int32_t)(millis() - _retryAtMs) >= 0) {
+        _retryPending = false;
+        _beginAttempt();
+    }
+}
+
+// Runs on the WiFi event task: only latch state here
+void MeoWifiManager::_onEvent(arduino_event_id_t event, const arduino_event_info_t& info) {
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+            for (int i = 0; i < 6; ++i) _evBssid[i] = info.wifi_sta_connected.bssid[i];
+            _evChannel = info.wifi_sta_connected.channel;
+            _evAssociated = true;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            _evGotIp = true;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+            _evReason = info.wifi_sta_disconnected.reason;
+            _evDisconnected = true;
+            break;
+        default:
+            break;
+    }
+}
+
+void MeoWifiManager::_beginAttempt() {
+    _attempts++;
+    _evAssociated = false;
+    _fastAttempt = _fastValid;
+    if (_fastAttempt) {
+        WiFi.begin(_ssid, _pass, _fast.channel, _fast.bssid, true);
+    } else {
+        WiFi.begin(_ssid, _pass);
+    }
+    if (_logger && _debugTagEnabled(MEO_LOG_WIFI)) {
+        _logf("DEBUG", "WIFI", "Attempt %lu (%s)", (unsigned long)_attempts, _fastAttempt ? "pinned" : "scan");
+    }
+}
+
+void MeoWifiManager::_handleGotIp() {
+    if (WiFi.status() != WL_CONNECTED) return; // stale event
+    _backoff.reset();
+    if (_timeToIpMs == 0) {
+        _timeToIpMs = millis() - _startMs;
+        if (_timeToIpMs == 0) _timeToIpMs = 1;
+        _fastUsed = _fastAttempt;
+        _logf("INFO", "WIFI", "Got IP in %lu ms (%s, %lu attempt(s))", (unsigned long)_timeToIpMs,
+              _fastUsed ? "fast" : "scan", (unsigned long)_attempts);
+    } else {
+        _log("INFO", "WIFI", "Reconnected");
+    }
+    if (_evAssociated) _saveFast();
+}
+
+void MeoWifiManager::_handleDisconnected() {
+    _lastReason = _evReason;
+    if (_retryPending) return; // duplicate event for an attempt already given up on
+    if (_fastAttempt && WiFi.status() != WL_CONNECTED) {
+        // Pinned AP gone or moved: forget it and scan right away
+        _logf("WARN", "WIFI", "Fast reconnect failed (reason %u); scanning", (unsigned)_lastReason);
+        _fastValid = false;
+        if (_storage) _storage->clearKey(FAST_KEY);
+        _beginAttempt();
+        return;
+    }
+    uint32_t delayMs = _backoff.next(esp_random());
+    _retryAtMs = millis() + delayMs;
+    _retryPending = true;
+    _logf("WARN", "WIFI", "Disconnected (reason %u); retry in %lu ms", (unsigned)_lastReason, (unsigned long)delayMs);
+}
+
+void MeoWifiManager::_loadFast() {
+    _fastValid = false;
+    if (!_storage) return;
+    FastInfo info;
+    if (!_storage->loadBytes(FAST_KEY, (uint8_t*)&info, sizeof(info))) return;
+    if (info.version != FAST_VERSION || info.ssidHash != _hash(_ssid) || info.channel == 0) return;
+    _fast = info;
+    _fastValid = true;
+}
+
+void MeoWifiManager::_saveFast() {
+    FastInfo info = {};
+    info.version = FAST_VERSION;
+    info.channel = _evChannel;
+    for (int i = 0; i < 6; ++i) info.bssid[i] = _evBssid[i];
+    info.ssidHash = _hash(_ssid);
+    if (info.channel == 0) return;
+    // Avoid an NVS write per reconnect when nothing changed
+    if (_fastValid && memcmp(&info, &_fast, sizeof(info)) == 0) return;
+    _fast = info;
+    _fastValid = true;
+    if (_storage && !_storage->saveBytes(FAST_KEY, (const uint8_t*)&info, sizeof(info))) {
+        _log("WARN", "WIFI", "Could not cache AP for fast reconnect");
+        return;
+    }
+    if (_logger && _debugTagEnabled(MEO_LOG_WIFI)) {
+        _logf("DEBUG", "WIFI", "Cached AP %02X:%02X:%02X:%02X:%02X:%02X ch%u",
+              info.bssid[0], info.bssid[1], info.bssid[2], info.bssid[3], info.bssid[4], info.bssid[5],
+              (unsigned)info.channel);
+    }
+}
+
+// FNV-1a
+uint32_t MeoWifiManager::_hash(const char* s) {
+    uint32_t h = 2166136261u;
+    while (*s) { h ^= (uint8_t)*s++; h *= 16777619u; }
+    return h;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "../Meo3_Type.h" // MeoLogFunction
+#include "../Meo3_BinLog.h" // meoLogEmit, MeoLogTag
+#include "../storage/Meo3_Storage.h"
+#include "../mqtt/Meo3_Backoff.h"
+
+/**
+ * MeoWifiManager: event-driven station bring-up.
+ * - connect() returns immediately; WiFi events are latched on the event task
+ *   and handled in loop(), so nothing here ever waits on the radio
+ * - Fast reconnect: BSSID + channel of the last good AP are cached in MeoStorage
+ *   and used on the next boot to skip the full scan; falls back to a scan if the
+ *   pinned AP does not answer
+ * - Reconnects itself with MeoBackoff (the core's auto-reconnect would keep
+ *   retrying a stale pinned BSSID)
+ */
+class MeoWifiManager {
+public:
+    MeoWifiManager() = default;
+
+    void setLogger(MeoLogFunction logger) { _logger = logger; }
+    void setDebugTags(const char* tagsCsv);
+    void setDebugMask(uint32_t mask) { _debugMask = mask; } // MeoLogTag bits
+    void setBinaryLog(MeoBinLog* log) { _binLog = log; }    // nullptr: format on the spot
+
+    // Optional: enables the BSSID/channel cache (storage must be begun)
+    void begin(MeoStorage* storage) { _storage = storage; }
+
+    // Start connecting; credentials are copied. Returns false on bad input.
+    bool connect(const char* ssid, const char* pass);
+    void loop();
+
+    bool hasTarget() const   { return _ssid[0] != '\0'; }
+    bool isConnected() const { return WiFi.status() == WL_CONNECTED; }
+
+    // Metrics (0 until known)
+    uint32_t startedMs() const      { return _startMs; }    // millis() at connect()
+    uint32_t timeToIpMs() const     { return _timeToIpMs; } // connect() -> first IP
+    bool     fastConnectUsed() const { return _fastUsed; }  // first IP came via cached BSSID
+    uint32_t attempts() const       { return _attempts; }
+    uint8_t  lastDisconnectReason() const { return _lastReason; }
+
+private:
+    // Persisted as "wifi_fast"; ssidHash ties the cache to the configured network
+    struct FastInfo {
+        uint8_t  version;
+        uint8_t  channel;
+        uint8_t  bssid[6];
+        uint32_t ssidHash;
+    };
+
+    char        _ssid[33] = {0};
+    char        _pass[65] = {0};
+    MeoStorage* _storage = nullptr;
+    FastInfo    _fast = {};
+    bool        _fastValid = false;
+    bool        _fastAttempt = false;  // current attempt is pinned to _fast
+    bool        _fastUsed = false;
+
+    bool       _eventsRegistered = false;
+    MeoBackoff _backoff{500, 30000};
+    bool       _retryPending = false;
+    uint32_t   _retryAtMs = 0;
+
+    uint32_t _startMs = 0;
+    uint32_t _timeToIpMs = 0;
+    uint32_t _attempts = 0;
+    uint8_t  _lastReason = 0;
+
+    // Written by the WiFi event task, consumed by loop()
+    volatile bool    _evAssociated = false;
+    volatile bool    _evGotIp = false;
+    volatile bool    _evDisconnected = false;
+    volatile uint8_t _evReason = 0;
+    volatile uint8_t _evChannel = 0;
+    volatile uint8_t _evBssid[6] = {0};
+
+    MeoLogFunction _logger = nullptr;
+    uint32_t       _debugMask = 0; // MeoLogTag bits, resolved by setDebugTags()
+    MeoBinLog*     _binLog = nullptr; // deferred mode: log calls go to this ring
+
+    void _onEvent(arduino_event_id_t event, const arduino_event_info_t& info);
+    void _beginAttempt();
+    void _handleGotIp();
+    void _handleDisconnected();
+    void _loadFast();
+    void _saveFast();
+    static uint32_t _hash(const char* s);
+
+    bool _debugTagEnabled(uint32_t tag) const { return meoLogDebugOn(_debugMask, tag); }
+    void _log(const char* level, const char* tag, const char* msg) const {
+        if (meoLogCompiled(level) && _logger) meoLogEmitMsg(_logger, _binLog, level, tag ? tag : "WIFI", msg);
+    }
+    template <typename... Args>
+    void _logf(const char* level, const char* tag, const char* fmt, Args... args) const {
+        if (meoLogCompiled(level) && _logger) meoLogEmit(_logger, _binLog, level, tag ? tag : "WIFI", fmt, args...);
+    }
+};
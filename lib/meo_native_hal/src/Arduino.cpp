@@ -0,0 +1,208 @@
+#include "Arduino.h"
+
+#include <chrono>
+#include <random>
+#include <thread>
+#include <unistd.h>
+
+HardwareSerial Serial;
+EspClass       ESP;
+
+static const std::chrono::steady_clock::time_point s_boot = std::chrono::steady_clock::now();
+static std::mt19937 s_rng((uint32_t)std::chrono::steady_clock::now().time_since_epoch().count());
+
+uint32_t millis() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - s_boot).count();
+}
+
+uint32_t micros() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - s_boot).count();
+}
+
+void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {
+    std::this_thread::yield();
+}
+
+long random(long maxExclusive) {
+    if (maxExclusive <= 0) return 0;
+    return (long)(s_rng() % (unsigned long)maxExclusive);
+}
+
+long random(long minInclusive, long maxExclusive) {
+    if (maxExclusive <= minInclusive) return minInclusive;
+    return minInclusive + random(maxExclusive - minInclusive);
+}
+
+void randomSeed(unsigned long seed) {
+    s_rng.seed((uint32_t)seed);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+void digitalWrite(uint8_t pin, uint8_t value) { (void)pin; (void)value; }
+int  digitalRead(uint8_t pin) { (void)pin; return LOW; }
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t len) {
+    return fwrite(buf, 1, len, stdout);
+}
+
+void HardwareSerial::flush() {
+    fflush(stdout);
+}
+
+void EspClass::restart() {
+    fflush(stdout);
+    // Exit code 3 lets a wrapper script tell a requested restart from a crash
+    _exit(3);
+}
+
+// ---- String ----
+
+static std::string formatInt(unsigned long long v, bool neg, unsigned char base) {
+    if (base < 2 || base > 16) base = 10;
+    char buf[72];
+    int i = sizeof(buf) - 1;
+    buf[i] = '\0';
+    do {
+        buf[--i] = "0123456789abcdef"[v % base];
+        v /= base;
+    } while (v && i > 1);
+    if (neg) buf[--i] = '-';
+    return std::string(buf + i);
+}
+
+String::String(int v, unsigned char base) : _s(base == 10 ? std::to_string(v) : formatInt((unsigned)v, false, base)) {}
+String::String(unsigned int v, unsigned char base) : _s(formatInt(v, false, base)) {}
+String::String(long v, unsigned char base) : _s(base == 10 ? std::to_string(v) : formatInt((unsigned long)v, false, base)) {}
+String::String(unsigned long v, unsigned char base) : _s(formatInt(v, false, base)) {}
+String::String(long long v, unsigned char base) : _s(base == 10 ? std::to_string(v) : formatInt((unsigned long long)v, false, base)) {}
+String::String(unsigned long long v, unsigned char base) : _s(formatInt(v, false, base)) {}
+
+String::String(float v, unsigned int decimals) : String((double)v, decimals) {}
+
+String::String(double v, unsigned int decimals) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+    _s = buf;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    size_t at = _s.find(c, from);
+    return at == std::string::npos ? -1 : (int)at;
+}
+
+int String::indexOf(const char* s, unsigned int from) const {
+    size_t at = _s.find(s ? s : "", from);
+    return at == std::string::npos ? -1 : (int)at;
+}
+
+String String::substring(unsigned int from) const {
+    return from < _s.size() ? String(_s.substr(from)) : String();
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= _s.size()) return String();
+    return String(_s.substr(from, to - from));
+}
+
+void String::trim() {
+    size_t b = _s.find_first_not_of(" \t\r\n");
+    if (b == std::string::npos) { _s.clear(); return; }
+    size_t e = _s.find_last_not_of(" \t\r\n");
+    _s = _s.substr(b, e - b + 1);
+}
+
+String operator+(const String& a, const String& b) { String r(a); r.concat(b); return r; }
+String operator+(const String& a, const char* b)   { String r(a); r.concat(b); return r; }
+String operator+(const char* a, const String& b)   { String r(a); r.concat(b); return r; }
+
+// ---- Print / Stream ----
+
+size_t Print::write(const uint8_t* buf, size_t len) {
+    size_t n = 0;
+    while (len--) {
+        if (!write(*buf++)) break;
+        n++;
+    }
+    return n;
+}
+
+size_t Print::print(long v, int base) { return print(String(v, (unsigned char)base)); }
+size_t Print::print(unsigned long v, int base) { return print(String(v, (unsigned char)base)); }
+size_t Print::print(long long v, int base) { return print(String(v, (unsigned char)base)); }
+size_t Print::print(unsigned long long v, int base) { return print(String(v, (unsigned char)base)); }
+size_t Print::print(double v, int digits) { return print(String(v, (unsigned int)digits)); }
+
+size_t Print::printf(const char* fmt, ...) {
+    char stackBuf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(stackBuf, sizeof(stackBuf), fmt, ap);
+    va_end(ap);
+    if (n < 0) return 0;
+    if ((size_t)n < sizeof(stackBuf)) return write((const uint8_t*)stackBuf, (size_t)n);
+
+    std::string big((size_t)n + 1, '\0');
+    va_start(ap, fmt);
+    vsnprintf(&big[0], big.size(), fmt, ap);
+    va_end(ap);
+    return write((const uint8_t*)big.data(), (size_t)n);
+}
+
+int Stream::_timedRead() {
+    uint32_t start = millis();
+    do {
+        int c = read();
+        if (c >= 0) return c;
+        yield();
+    } while (millis() - start < _timeout);
+    return -1;
+}
+
+size_t Stream::readBytes(char* buf, size_t len) {
+    size_t n = 0;
+    while (n < len) {
+        int c = _timedRead();
+        if (c < 0) break;
+        buf[n++] = (char)c;
+    }
+    return n;
+}
+
+String Stream::readStringUntil(char terminator) {
+    String s;
+    int c;
+    while ((c = _timedRead()) >= 0 && c != terminator) s += (char)c;
+    return s;
+}
+
+// ---- IPAddress ----
+
+bool IPAddress::fromString(const char* s) {
+    unsigned a, b, c, d;
+    char tail;
+    if (!s || sscanf(s, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4) return false;
+    if (a > 255 || b > 255 || c > 255 || d > 255) return false;
+    _a[0] = (uint8_t)a; _a[1] = (uint8_t)b; _a[2] = (uint8_t)c; _a[3] = (uint8_t)d;
+    return true;
+}
+
+String IPAddress::toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _a[0], _a[1], _a[2], _a[3]);
+    return String(buf);
+}
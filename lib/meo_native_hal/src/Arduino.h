@@ -0,0 +1,76 @@
+#pragma once
+
+// Host stand-in for the Arduino-ESP32 core: only what Meo3_Arduino and its
+// dependencies (PubSubClient, ArduinoJson) use. Not for ESP targets.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "IPAddress.h"
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define HIGH   0x1
+#define LOW    0x0
+#define INPUT  0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+static const uint8_t LED_BUILTIN = 2;
+
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#define F(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+
+uint32_t millis();
+uint32_t micros();
+void     delay(uint32_t ms);
+void     delayMicroseconds(uint32_t us);
+void     yield();
+
+long random(long maxExclusive);
+long random(long minInclusive, long maxExclusive);
+void randomSeed(unsigned long seed);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int  digitalRead(uint8_t pin);
+
+// Serial -> stdout
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void end() {}
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buf, size_t len) override;
+    int  available() override { return 0; }
+    int  read() override { return -1; }
+    int  peek() override { return -1; }
+    void flush() override;
+    operator bool() const { return true; }
+    using Print::write;
+};
+extern HardwareSerial Serial;
+
+// ESP.restart() and friends
+class EspClass {
+public:
+    void     restart();
+    uint32_t getFreeHeap() { return 0; }
+    uint32_t getMaxAllocHeap() { return 0; }
+    uint32_t getCpuFreqMHz() { return 0; }
+};
+extern EspClass ESP;
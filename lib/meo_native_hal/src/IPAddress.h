@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+#include "WString.h"
+
+class IPAddress {
+public:
+    IPAddress() : _a{0, 0, 0, 0} {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _a{a, b, c, d} {}
+    // Network byte order packed as on ESP32 (first octet in the lowest byte)
+    IPAddress(uint32_t v) : _a{(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)} {}
+
+    operator uint32_t() const {
+        return (uint32_t)_a[0] | ((uint32_t)_a[1] << 8) | ((uint32_t)_a[2] << 16) | ((uint32_t)_a[3] << 24);
+    }
+    uint8_t  operator[](int i) const { return _a[i]; }
+    uint8_t& operator[](int i) { return _a[i]; }
+    bool operator==(const IPAddress& o) const { return (uint32_t)*this == (uint32_t)o; }
+    bool operator!=(const IPAddress& o) const { return !(*this == o); }
+
+    bool   fromString(const char* s);
+    String toString() const;
+
+private:
+    uint8_t _a[4];
+};
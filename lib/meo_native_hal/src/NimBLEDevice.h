@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+// BLE does not exist on the host: every call is a no-op and no client ever
+// connects, so provisioning falls through to the stored/seeded credentials.
+
+namespace NIMBLE_PROPERTY {
+enum : uint16_t { READ = 0x0002, WRITE_NR = 0x0004, WRITE = 0x0008, NOTIFY = 0x0010, INDICATE = 0x0020 };
+}
+
+class NimBLEUUID {
+public:
+    NimBLEUUID() {}
+    NimBLEUUID(const char* s) : _s(s ? s : "") {}
+    NimBLEUUID(const std::string& s) : _s(s) {}
+    bool equals(const NimBLEUUID& o) const { return _s == o._s; }
+    bool operator==(const NimBLEUUID& o) const { return equals(o); }
+    std::string toString() const { return _s; }
+private:
+    std::string _s;
+};
+
+class NimBLEAttValue : public std::string {
+public:
+    NimBLEAttValue() {}
+    NimBLEAttValue(const std::string& s) : std::string(s) {}
+};
+
+class NimBLECharacteristic;
+class NimBLEConnInfo;
+
+class NimBLECharacteristicCallbacks {
+public:
+    virtual ~NimBLECharacteristicCallbacks() {}
+    virtual void onWrite(NimBLECharacteristic* c) { (void)c; }
+    virtual void onWrite(NimBLECharacteristic* c, NimBLEConnInfo& info) { (void)c; (void)info; }
+    virtual void onRead(NimBLECharacteristic* c) { (void)c; }
+};
+
+class NimBLECharacteristic {
+public:
+    explicit NimBLECharacteristic(const NimBLEUUID& uuid) : _uuid(uuid) {}
+    void setValue(const std::string& v) { _value = v; }
+    void setValue(const uint8_t* data, size_t len) { _value.assign((const char*)data, len); }
+    void setValue(const char* s) { _value = s ? s : ""; }
+    NimBLEAttValue getValue() const { return NimBLEAttValue(_value); }
+    NimBLEUUID getUUID() const { return _uuid; }
+    void setCallbacks(NimBLECharacteristicCallbacks* cb) { (void)cb; }
+    void notify() {}
+private:
+    NimBLEUUID  _uuid;
+    std::string _value;
+};
+
+class NimBLEService {
+public:
+    explicit NimBLEService(const NimBLEUUID& uuid) : _uuid(uuid) {}
+    NimBLEUUID getUUID() const { return _uuid; }
+    NimBLECharacteristic* createCharacteristic(const NimBLEUUID& uuid, uint32_t props = 0) {
+        (void)props;
+        return new NimBLECharacteristic(uuid);
+    }
+    bool start() { return true; }
+private:
+    NimBLEUUID _uuid;
+};
+
+class NimBLEServerCallbacks {
+public:
+    virtual ~NimBLEServerCallbacks() {}
+};
+
+class NimBLEServer {
+public:
+    NimBLEService* createService(const NimBLEUUID& uuid) { return new NimBLEService(uuid); }
+    void setCallbacks(NimBLEServerCallbacks* cb) { (void)cb; }
+    size_t getConnectedCount() const { return 0; }
+};
+
+class NimBLEAdvertising {
+public:
+    bool addServiceUUID(const NimBLEUUID& uuid) { (void)uuid; return true; }
+    void setScanResponse(bool on) { (void)on; }
+    bool start(uint32_t durationMs = 0) { (void)durationMs; return true; }
+    bool stop() { return true; }
+};
+
+class NimBLEDevice {
+public:
+    static bool init(const std::string& name) { (void)name; return true; }
+    static bool deinit(bool clearAll = false) { (void)clearAll; return true; }
+    static NimBLEServer* createServer() { static NimBLEServer s; return &s; }
+    static NimBLEAdvertising* getAdvertising() { static NimBLEAdvertising a; return &a; }
+    static bool startAdvertising() { return true; }
+    static bool stopAdvertising() { return true; }
+    static bool setPower(int dbm) { (void)dbm; return true; }
+};
@@ -0,0 +1,144 @@
+#include "Preferences.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+// File format: repeated [u8 keyLen][key][u32 valueLen][value]
+
+static std::string nvsDir() {
+    const char* dir = getenv("MEO_NATIVE_NVS");
+    return (dir && dir[0]) ? dir : ".meo_nvs";
+}
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partition) {
+    (void)partition;
+    if (!name || !name[0] || strlen(name) > 15) return false; // NVS namespace limit
+    std::string dir = nvsDir();
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) return false;
+    _path = dir + "/" + name + ".bin";
+    _readOnly = readOnly;
+    _open = true;
+    _load();
+    _seedFromEnv();
+    return true;
+}
+
+void Preferences::end() {
+    _open = false;
+    _kv.clear();
+}
+
+bool Preferences::clear() {
+    if (!_open || _readOnly) return false;
+    _kv.clear();
+    return _save();
+}
+
+bool Preferences::remove(const char* key) {
+    if (!_open || _readOnly || !key) return false;
+    if (_kv.erase(key) == 0) return false;
+    return _save();
+}
+
+bool Preferences::isKey(const char* key) {
+    return _open && key && _kv.count(key) > 0;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+    if (!_open || _readOnly || !key || strlen(key) > 15 || (!value && len)) return 0;
+    const uint8_t* p = (const uint8_t*)value;
+    _kv[key].assign(p, p + len);
+    return _save() ? len : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+    if (!_open || !key) return 0;
+    auto it = _kv.find(key);
+    if (it == _kv.end() || it->second.size() > maxLen) return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    if (!_open || !key) return 0;
+    auto it = _kv.find(key);
+    return it == _kv.end() ? 0 : it->second.size();
+}
+
+size_t Preferences::putString(const char* key, const char* value) {
+    if (!value) return 0;
+    size_t len = strlen(value);
+    // Stored with the terminator, as NVS does
+    return putBytes(key, value, len + 1) ? len : 0;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    if (!_open || !key) return defaultValue;
+    auto it = _kv.find(key);
+    if (it == _kv.end() || it->second.empty()) return defaultValue;
+    const std::vector<uint8_t>& v = it->second;
+    size_t len = v.back() == 0 ? v.size() - 1 : v.size();
+    return String(std::string((const char*)v.data(), len));
+}
+
+bool Preferences::_load() {
+    _kv.clear();
+    FILE* f = fopen(_path.c_str(), "rb");
+    if (!f) return false;
+    for (;;) {
+        uint8_t keyLen;
+        if (fread(&keyLen, 1, 1, f) != 1) break;
+        std::string key(keyLen, '\0');
+        uint32_t valueLen;
+        if (fread(&key[0], 1, keyLen, f) != keyLen || fread(&valueLen, 4, 1, f) != 1) break;
+        std::vector<uint8_t> value(valueLen);
+        if (valueLen && fread(value.data(), 1, valueLen, f) != valueLen) break;
+        _kv[key] = value;
+    }
+    fclose(f);
+    return true;
+}
+
+bool Preferences::_save() {
+    std::string tmp = _path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = true;
+    for (const auto& kv : _kv) {
+        uint8_t keyLen = (uint8_t)kv.first.size();
+        uint32_t valueLen = (uint32_t)kv.second.size();
+        ok = ok && fwrite(&keyLen, 1, 1, f) == 1
+                && fwrite(kv.first.data(), 1, keyLen, f) == keyLen
+                && fwrite(&valueLen, 4, 1, f) == 1
+                && (valueLen == 0 || fwrite(kv.second.data(), 1, valueLen, f) == valueLen);
+    }
+    ok = (fclose(f) == 0) && ok;
+    // Atomic replace, so a killed process never leaves a torn namespace
+    return ok && rename(tmp.c_str(), _path.c_str()) == 0;
+}
+
+void Preferences::_seedFromEnv() {
+    const char* env = getenv("MEO_NATIVE_PREFS");
+    if (!env || _readOnly) return;
+    std::string all(env);
+    bool changed = false;
+    size_t pos = 0;
+    while (pos <= all.size()) {
+        size_t end = all.find(';', pos);
+        if (end == std::string::npos) end = all.size();
+        std::string item = all.substr(pos, end - pos);
+        size_t eq = item.find('=');
+        if (eq != std::string::npos && eq > 0) {
+            std::string key = item.substr(0, eq);
+            std::string value = item.substr(eq + 1);
+            if (key.size() <= 15 && !_kv.count(key)) {
+                _kv[key].assign(value.c_str(), value.c_str() + value.size() + 1);
+                changed = true;
+            }
+        }
+        pos = end + 1;
+    }
+    if (changed) _save();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+/**
+ * Preferences (native): one file per namespace under $MEO_NATIVE_NVS
+ * (default ./.meo_nvs), rewritten on every put/remove so state survives a
+ * restart like NVS does.
+ * - $MEO_NATIVE_PREFS="key=value;key=value" seeds string keys on begin() when
+ *   they are not already stored (handy for tx_key/user_id in CI)
+ */
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false, const char* partition = nullptr);
+    void end();
+
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putBytes(const char* key, const void* value, size_t len);
+    size_t getBytes(const char* key, void* buf, size_t maxLen);
+    size_t getBytesLength(const char* key);
+
+    size_t putString(const char* key, const char* value);
+    size_t putString(const char* key, const String& value) { return putString(key, value.c_str()); }
+    String getString(const char* key, const String& defaultValue = String());
+
+    size_t   putShort(const char* key, int16_t value) { return putBytes(key, &value, sizeof(value)); }
+    int16_t  getShort(const char* key, int16_t defaultValue = 0) { return _getPod(key, defaultValue); }
+    size_t   putInt(const char* key, int32_t value) { return putBytes(key, &value, sizeof(value)); }
+    int32_t  getInt(const char* key, int32_t defaultValue = 0) { return _getPod(key, defaultValue); }
+    size_t   putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) { return _getPod(key, defaultValue); }
+    size_t   putBool(const char* key, bool value) { uint8_t v = value; return putBytes(key, &v, 1); }
+    bool     getBool(const char* key, bool defaultValue = false) { return _getPod<uint8_t>(key, defaultValue) != 0; }
+
+private:
+    std::string _path;
+    bool        _open = false;
+    bool        _readOnly = false;
+    std::map<std::string, std::vector<uint8_t>> _kv;
+
+    bool _load();
+    bool _save();
+    void _seedFromEnv();
+
+    template <typename T> T _getPod(const char* key, T defaultValue) {
+        T v;
+        return getBytes(key, &v, sizeof(v)) == sizeof(v) ? v : defaultValue;
+    }
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Print.h"
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long ms) { _timeout = ms; }
+    unsigned long getTimeout() const { return _timeout; }
+
+    // Blocks up to the stream timeout for each byte
+    size_t readBytes(char* buf, size_t len);
+    size_t readBytes(uint8_t* buf, size_t len) { return readBytes((char*)buf, len); }
+    String readStringUntil(char terminator);
+
+protected:
+    unsigned long _timeout = 1000;
+    int _timedRead();
+};
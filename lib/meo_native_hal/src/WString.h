@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// Arduino String over std::string
+class String {
+public:
+    String() {}
+    String(const char* s) : _s(s ? s : "") {}
+    String(const std::string& s) : _s(s) {}
+    String(char c) : _s(1, c) {}
+    String(int v, unsigned char base = 10);
+    String(unsigned int v, unsigned char base = 10);
+    String(long v, unsigned char base = 10);
+    String(unsigned long v, unsigned char base = 10);
+    String(long long v, unsigned char base = 10);
+    String(unsigned long long v, unsigned char base = 10);
+    String(float v, unsigned int decimals = 2);
+    String(double v, unsigned int decimals = 2);
+
+    const char* c_str() const { return _s.c_str(); }
+    unsigned int length() const { return (unsigned int)_s.size(); }
+    bool isEmpty() const { return _s.empty(); }
+    void reserve(unsigned int n) { _s.reserve(n); }
+
+    bool concat(const String& s) { _s += s._s; return true; }
+    bool concat(const char* s) { if (s) _s += s; return true; }
+    bool concat(const char* s, unsigned int n) { if (s) _s.append(s, n); return true; }
+    bool concat(char c) { _s += c; return true; }
+
+    String& operator+=(const String& s) { concat(s); return *this; }
+    String& operator+=(const char* s) { concat(s); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+
+    bool equals(const String& s) const { return _s == s._s; }
+    bool equals(const char* s) const { return _s == (s ? s : ""); }
+    bool operator==(const String& s) const { return equals(s); }
+    bool operator==(const char* s) const { return equals(s); }
+    bool operator!=(const String& s) const { return !equals(s); }
+    bool operator!=(const char* s) const { return !equals(s); }
+    bool operator<(const String& s) const { return _s < s._s; }
+
+    char  operator[](unsigned int i) const { return i < _s.size() ? _s[i] : '\0'; }
+    char& operator[](unsigned int i) { return _s[i]; }
+
+    int    indexOf(char c, unsigned int from = 0) const;
+    int    indexOf(const char* s, unsigned int from = 0) const;
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    long   toInt() const { return strtol(_s.c_str(), nullptr, 10); }
+    float  toFloat() const { return strtof(_s.c_str(), nullptr); }
+    void   trim();
+
+    const std::string& str() const { return _s; }
+
+private:
+    std::string _s;
+};
+
+String operator+(const String& a, const String& b);
+String operator+(const String& a, const char* b);
+String operator+(const char* a, const String& b);
@@ -0,0 +1,104 @@
+#include "WiFi.h"
+#include "esp_system.h"
+
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <netinet/in.h>
+
+WiFiClass WiFi;
+
+static bool firstInterface(IPAddress& ip, IPAddress& mask) {
+    struct ifaddrs* list = nullptr;
+    if (getifaddrs(&list) != 0) return false;
+    bool found = false;
+    for (struct ifaddrs* it = list; it && !found; it = it->ifa_next) {
+        if (!it->ifa_addr || it->ifa_addr->sa_family != AF_INET) continue;
+        if (it->ifa_flags & IFF_LOOPBACK) continue;
+        ip   = IPAddress((uint32_t)((struct sockaddr_in*)it->ifa_addr)->sin_addr.s_addr);
+        mask = it->ifa_netmask ? IPAddress((uint32_t)((struct sockaddr_in*)it->ifa_netmask)->sin_addr.s_addr)
+                               : IPAddress(255, 255, 255, 0);
+        found = true;
+    }
+    freeifaddrs(list);
+    return found;
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* pass, int32_t channel,
+                             const uint8_t* bssid, bool connect) {
+    (void)pass;
+    _ssid = ssid ? ssid : "";
+    if (!connect) return _status;
+
+    arduino_event_info_t info;
+    memset(&info, 0, sizeof(info));
+    size_t n = _ssid.size() < 32 ? _ssid.size() : 32;
+    memcpy(info.wifi_sta_connected.ssid, _ssid.data(), n);
+    info.wifi_sta_connected.ssid_len = (uint8_t)n;
+    static const uint8_t fakeBssid[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    memcpy(info.wifi_sta_connected.bssid, bssid ? bssid : fakeBssid, 6);
+    info.wifi_sta_connected.channel = (uint8_t)(channel > 0 ? channel : 1);
+
+    _status = WL_CONNECTED;
+    _fire(ARDUINO_EVENT_WIFI_STA_CONNECTED, info);
+    memset(&info, 0, sizeof(info));
+    _fire(ARDUINO_EVENT_WIFI_STA_GOT_IP, info);
+    return _status;
+}
+
+bool WiFiClass::disconnect(bool wifiOff, bool eraseAp) {
+    (void)eraseAp;
+    if (wifiOff) _mode = WIFI_OFF;
+    if (_status != WL_CONNECTED) return true;
+    _status = WL_DISCONNECTED;
+    arduino_event_info_t info;
+    memset(&info, 0, sizeof(info));
+    info.wifi_sta_disconnected.reason = 8; // WIFI_REASON_ASSOC_LEAVE
+    _fire(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, info);
+    return true;
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventFuncCb cb) {
+    _handlers.push_back(cb);
+    return (wifi_event_id_t)_handlers.size();
+}
+
+void WiFiClass::removeEvent(wifi_event_id_t id) {
+    if (id > 0 && (size_t)id <= _handlers.size()) _handlers[id - 1] = nullptr;
+}
+
+void WiFiClass::_fire(arduino_event_id_t id, const arduino_event_info_t& info) {
+    for (auto& h : _handlers) {
+        if (h) h(id, info);
+    }
+}
+
+String WiFiClass::macAddress() const {
+    uint8_t mac[6];
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    char buf[18];
+    snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    return String(buf);
+}
+
+IPAddress WiFiClass::localIP() const {
+    IPAddress ip, mask;
+    if (_status != WL_CONNECTED || !firstInterface(ip, mask)) return IPAddress();
+    return ip;
+}
+
+IPAddress WiFiClass::subnetMask() const {
+    IPAddress ip, mask;
+    if (_status != WL_CONNECTED || !firstInterface(ip, mask)) return IPAddress();
+    return mask;
+}
+
+IPAddress WiFiClass::gatewayIP() const {
+    // No portable route lookup; assume the conventional .1 on the local subnet
+    IPAddress ip, mask;
+    if (_status != WL_CONNECTED || !firstInterface(ip, mask)) return IPAddress();
+    IPAddress gw((uint32_t)ip & (uint32_t)mask);
+    gw[3] = (uint8_t)(gw[3] | 1);
+    return gw;
+}
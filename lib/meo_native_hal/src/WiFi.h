@@ -0,0 +1,87 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "Arduino.h"
+#include "WiFiClient.h"
+#include "WiFiClientSecure.h"
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+typedef enum {
+    ARDUINO_EVENT_WIFI_STA_START = 2,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED = 4,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED = 5,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP = 7,
+    ARDUINO_EVENT_WIFI_STA_LOST_IP = 8
+} arduino_event_id_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t authmode;
+} wifi_event_sta_connected_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t reason;
+} wifi_event_sta_disconnected_t;
+
+typedef union {
+    wifi_event_sta_connected_t    wifi_sta_connected;
+    wifi_event_sta_disconnected_t wifi_sta_disconnected;
+} arduino_event_info_t;
+
+typedef std::function<void(arduino_event_id_t, arduino_event_info_t)> WiFiEventFuncCb;
+typedef int wifi_event_id_t;
+
+/**
+ * WiFiClass (native): the host is already on a network.
+ * - begin() "associates" immediately and fires CONNECTED then GOT_IP from the
+ *   calling thread, with a fixed fake BSSID on the requested channel
+ * - localIP() is the first non-loopback IPv4 interface address
+ */
+class WiFiClass {
+public:
+    wl_status_t begin(const char* ssid, const char* pass = nullptr, int32_t channel = 0,
+                      const uint8_t* bssid = nullptr, bool connect = true);
+    bool disconnect(bool wifiOff = false, bool eraseAp = false);
+    bool mode(wifi_mode_t m) { _mode = m; return true; }
+    bool setAutoReconnect(bool on) { (void)on; return true; }
+    bool setSleep(bool on) { (void)on; return true; }
+
+    wifi_event_id_t onEvent(WiFiEventFuncCb cb);
+    void            removeEvent(wifi_event_id_t id);
+
+    wl_status_t status() const { return _status; }
+    bool        isConnected() const { return _status == WL_CONNECTED; }
+    String      SSID() const { return String(_ssid.c_str()); }
+    int8_t      RSSI() const { return _status == WL_CONNECTED ? -40 : 0; }
+    String      macAddress() const;
+    IPAddress   localIP() const;
+    IPAddress   subnetMask() const;
+    IPAddress   gatewayIP() const;
+
+private:
+    wl_status_t  _status = WL_IDLE_STATUS;
+    wifi_mode_t  _mode = WIFI_OFF;
+    std::string  _ssid;
+    std::vector<WiFiEventFuncCb> _handlers;
+
+    void _fire(arduino_event_id_t id, const arduino_event_info_t& info);
+};
+
+extern WiFiClass WiFi;
@@ -0,0 +1,189 @@
+#include "WiFiClient.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // macOS: SO_NOSIGPIPE is set on the socket instead
+#endif
+
+WiFiClient::Socket::~Socket() {
+    if (fd >= 0) close(fd);
+}
+
+WiFiClient::WiFiClient(int fd) : _sock(std::make_shared<Socket>()) {
+    _sock->fd = fd;
+}
+
+static int connectWithTimeout(const struct sockaddr* addr, socklen_t addrLen, int32_t timeoutMs) {
+    int fd = socket(addr->sa_family, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+    int rc = connect(fd, addr, addrLen);
+    if (rc != 0 && errno == EINPROGRESS) {
+        struct pollfd p = {fd, POLLOUT, 0};
+        rc = poll(&p, 1, timeoutMs > 0 ? timeoutMs : -1);
+        if (rc == 1) {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            rc = err == 0 ? 0 : -1;
+        } else {
+            rc = -1;
+        }
+    }
+    if (rc != 0) {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+    int nodelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    return fd;
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip, port, (int32_t)_timeoutMs);
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+    return connect(host, port, (int32_t)_timeoutMs);
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port, int32_t timeoutMs) {
+    return connect(ip.toString().c_str(), port, timeoutMs);
+}
+
+int WiFiClient::connect(const char* host, uint16_t port, int32_t timeoutMs) {
+    stop();
+    if (!host || !host[0]) return 0;
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", (unsigned)port);
+
+    struct addrinfo* res = nullptr;
+    if (getaddrinfo(host, service, &hints, &res) != 0) return 0;
+    int fd = -1;
+    for (struct addrinfo* it = res; it && fd < 0; it = it->ai_next) {
+        fd = connectWithTimeout(it->ai_addr, it->ai_addrlen, timeoutMs);
+    }
+    freeaddrinfo(res);
+    if (fd < 0) return 0;
+
+    _sock = std::make_shared<Socket>();
+    _sock->fd = fd;
+    return 1;
+}
+
+size_t WiFiClient::write(const uint8_t* buf, size_t len) {
+    if (!*this) return 0;
+    size_t sent = 0;
+    while (sent < len) {
+        ssize_t n = send(_sock->fd, buf + sent, len - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            stop();
+            break;
+        }
+        sent += (size_t)n;
+    }
+    return sent;
+}
+
+int WiFiClient::available() {
+    if (!*this) return 0;
+    int n = 0;
+    if (ioctl(_sock->fd, FIONREAD, &n) != 0) return 0;
+    return n;
+}
+
+int WiFiClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* buf, size_t len) {
+    if (!*this || len == 0) return -1;
+    if (available() <= 0) return -1; // Arduino read() never blocks
+    ssize_t n = recv(_sock->fd, buf, len, 0);
+    if (n <= 0) {
+        if (n == 0) stop();
+        return -1;
+    }
+    return (int)n;
+}
+
+int WiFiClient::peek() {
+    if (!*this || available() <= 0) return -1;
+    uint8_t c;
+    return recv(_sock->fd, &c, 1, MSG_PEEK) == 1 ? c : -1;
+}
+
+void WiFiClient::stop() {
+    _sock.reset();
+}
+
+uint8_t WiFiClient::connected() {
+    if (!*this) return 0;
+    if (available() > 0) return 1;
+    // Readable with zero bytes pending means the peer closed
+    struct pollfd p = {_sock->fd, POLLIN, 0};
+    if (poll(&p, 1, 0) < 0) return 0;
+    if (p.revents & (POLLERR | POLLHUP | POLLNVAL)) return 0;
+    if (p.revents & POLLIN) {
+        uint8_t c;
+        if (recv(_sock->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 0) return 0;
+    }
+    return 1;
+}
+
+// ---- WiFiServer ----
+
+void WiFiServer::begin() {
+    stop();
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(_port);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0) {
+        close(fd);
+        return;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    _fd = fd;
+}
+
+WiFiClient WiFiServer::available() {
+    if (_fd < 0) return WiFiClient();
+    int fd = accept(_fd, nullptr, nullptr);
+    if (fd < 0) return WiFiClient();
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK);
+    return WiFiClient(fd);
+}
+
+void WiFiServer::stop() {
+    if (_fd >= 0) close(_fd);
+    _fd = -1;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+#include "Arduino.h"
+#include "Client.h"
+
+// TCP client over a POSIX socket. Copies share the socket, as on ESP32.
+class WiFiClient : public Client {
+public:
+    WiFiClient() {}
+    explicit WiFiClient(int fd);
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char* host, uint16_t port) override;
+    int connect(IPAddress ip, uint16_t port, int32_t timeoutMs);
+    int connect(const char* host, uint16_t port, int32_t timeoutMs);
+
+    size_t  write(uint8_t c) override { return write(&c, 1); }
+    size_t  write(const uint8_t* buf, size_t len) override;
+    int     available() override;
+    int     read() override;
+    int     read(uint8_t* buf, size_t len) override;
+    int     peek() override;
+    void    flush() override {}
+    void    stop() override;
+    uint8_t connected() override;
+    operator bool() override { return _sock && _sock->fd >= 0; }
+
+    void setTimeout(uint32_t seconds) { _timeoutMs = seconds * 1000; } // ESP32 takes seconds here
+    int  setNoDelay(bool nodelay) { (void)nodelay; return 0; }         // always on here (see connect)
+    int  fd() const { return _sock ? _sock->fd : -1; }
+
+    using Print::write;
+
+protected:
+    struct Socket {
+        int fd = -1;
+        ~Socket();
+    };
+    std::shared_ptr<Socket> _sock;
+    uint32_t _timeoutMs = 3000;
+};
+
+class WiFiServer {
+public:
+    explicit WiFiServer(uint16_t port) : _port(port) {}
+    ~WiFiServer() { stop(); }
+
+    void       begin();
+    WiFiClient available(); // non-blocking accept
+    void       stop();
+    operator bool() const { return _fd >= 0; }
+
+private:
+    uint16_t _port;
+    int      _fd = -1;
+};
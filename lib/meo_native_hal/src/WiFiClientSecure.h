@@ -0,0 +1,15 @@
+#pragma once
+
+#include "WiFiClient.h"
+
+// No TLS on the host: this is a plain TCP client that accepts the ESP32
+// WiFiClientSecure configuration calls. Point native builds at a plain-text
+// broker port (e.g. mosquitto on 1883).
+class WiFiClientSecure : public WiFiClient {
+public:
+    void setInsecure() {}
+    void setCACert(const char* rootCA) { (void)rootCA; }
+    void setCertificate(const char* cert) { (void)cert; }
+    void setPrivateKey(const char* key) { (void)key; }
+    void setHandshakeTimeout(unsigned long seconds) { (void)seconds; }
+};
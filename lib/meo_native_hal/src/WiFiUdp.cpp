@@ -0,0 +1,104 @@
+#include "WiFiUdp.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+bool WiFiUDP::_open() {
+    if (_fd >= 0) return true;
+    _fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (_fd < 0) return false;
+    int one = 1;
+    setsockopt(_fd, SOL_SOCKET, SO_BROADCAST, &one, sizeof(one));
+    setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL, 0) | O_NONBLOCK);
+    return true;
+}
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+    stop();
+    if (!_open()) return 0;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        stop();
+        return 0;
+    }
+    return 1;
+}
+
+void WiFiUDP::stop() {
+    if (_fd >= 0) close(_fd);
+    _fd = -1;
+    _tx.clear();
+    _rx.clear();
+    _rxPos = 0;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port) {
+    if (!_open()) return 0;
+    _tx.clear();
+    _txIp = ip;
+    _txPort = port;
+    return 1;
+}
+
+int WiFiUDP::beginPacket(const char* host, uint16_t port) {
+    IPAddress ip;
+    if (!ip.fromString(host)) {
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        struct addrinfo* res = nullptr;
+        if (getaddrinfo(host, nullptr, &hints, &res) != 0 || !res) return 0;
+        ip = IPAddress((uint32_t)((struct sockaddr_in*)res->ai_addr)->sin_addr.s_addr);
+        freeaddrinfo(res);
+    }
+    return beginPacket(ip, port);
+}
+
+size_t WiFiUDP::write(const uint8_t* buf, size_t len) {
+    _tx.insert(_tx.end(), buf, buf + len);
+    return len;
+}
+
+int WiFiUDP::endPacket() {
+    if (_fd < 0) return 0;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = (uint32_t)_txIp;
+    addr.sin_port = htons(_txPort);
+    ssize_t n = sendto(_fd, _tx.data(), _tx.size(), 0, (struct sockaddr*)&addr, sizeof(addr));
+    _tx.clear();
+    return n >= 0 ? 1 : 0;
+}
+
+int WiFiUDP::parsePacket() {
+    if (_fd < 0) return 0;
+    uint8_t buf[1500];
+    struct sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+    ssize_t n = recvfrom(_fd, buf, sizeof(buf), 0, (struct sockaddr*)&from, &fromLen);
+    if (n <= 0) return 0;
+    _rx.assign(buf, buf + n);
+    _rxPos = 0;
+    _remoteIp = IPAddress((uint32_t)from.sin_addr.s_addr);
+    _remotePort = ntohs(from.sin_port);
+    return (int)n;
+}
+
+int WiFiUDP::read(uint8_t* buf, size_t len) {
+    size_t n = _rx.size() - _rxPos;
+    if (n > len) n = len;
+    memcpy(buf, _rx.data() + _rxPos, n);
+    _rxPos += n;
+    return (int)n;
+}
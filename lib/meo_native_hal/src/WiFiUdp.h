@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include "Arduino.h"
+
+// UDP over a POSIX socket; enough for broadcast discovery
+class WiFiUDP : public Stream {
+public:
+    ~WiFiUDP() { stop(); }
+
+    uint8_t begin(uint16_t port);
+    void    stop();
+
+    int    beginPacket(IPAddress ip, uint16_t port);
+    int    beginPacket(const char* host, uint16_t port);
+    int    endPacket();
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t len) override;
+
+    int       parsePacket();
+    int       available() override { return (int)(_rx.size() - _rxPos); }
+    int       read() override { return _rxPos < _rx.size() ? _rx[_rxPos++] : -1; }
+    int       read(uint8_t* buf, size_t len);
+    int       peek() override { return _rxPos < _rx.size() ? _rx[_rxPos] : -1; }
+    IPAddress remoteIP() const { return _remoteIp; }
+    uint16_t  remotePort() const { return _remotePort; }
+
+    using Print::write;
+
+private:
+    int _fd = -1;
+    std::vector<uint8_t> _tx;
+    std::vector<uint8_t> _rx;
+    size_t    _rxPos = 0;
+    IPAddress _txIp;
+    uint16_t  _txPort = 0;
+    IPAddress _remoteIp;
+    uint16_t  _remotePort = 0;
+
+    bool _open();
+};
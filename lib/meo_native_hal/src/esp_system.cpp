@@ -0,0 +1,54 @@
+#include "esp_system.h"
+
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static std::mutex   s_rngLock;
+static std::mt19937 s_rng(std::random_device{}());
+
+uint32_t esp_random(void) {
+    std::lock_guard<std::mutex> lock(s_rngLock);
+    return (uint32_t)s_rng();
+}
+
+void esp_fill_random(void* buf, size_t len) {
+    uint8_t* p = (uint8_t*)buf;
+    while (len) {
+        uint32_t r = esp_random();
+        size_t n = len < 4 ? len : 4;
+        memcpy(p, &r, n);
+        p += n;
+        len -= n;
+    }
+}
+
+esp_err_t esp_read_mac(uint8_t* mac, esp_mac_type_t type) {
+    if (!mac) return ESP_FAIL;
+    const char* env = getenv("MEO_NATIVE_MAC");
+    unsigned m[6];
+    if (env && sscanf(env, "%x:%x:%x:%x:%x:%x", &m[0], &m[1], &m[2], &m[3], &m[4], &m[5]) == 6) {
+        for (int i = 0; i < 6; ++i) mac[i] = (uint8_t)m[i];
+    } else {
+        char host[128] = {0};
+        gethostname(host, sizeof(host) - 1);
+        uint32_t h = 2166136261u;
+        for (const char* p = host; *p; ++p) h = (h ^ (uint8_t)*p) * 16777619u;
+        // Locally administered, unicast
+        mac[0] = 0x02; mac[1] = 0x4D;
+        mac[2] = (uint8_t)(h >> 24); mac[3] = (uint8_t)(h >> 16);
+        mac[4] = (uint8_t)(h >> 8);  mac[5] = (uint8_t)h;
+    }
+    // Mirror the ESP32 layout: derived interfaces differ in the last octet
+    mac[5] = (uint8_t)(mac[5] + (uint8_t)type);
+    return ESP_OK;
+}
+
+void esp_restart(void) {
+    fflush(stdout);
+    _exit(3);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int esp_err_t;
+#define ESP_OK   0
+#define ESP_FAIL -1
+
+typedef enum {
+    ESP_MAC_WIFI_STA,
+    ESP_MAC_WIFI_SOFTAP,
+    ESP_MAC_BT,
+    ESP_MAC_ETH
+} esp_mac_type_t;
+
+uint32_t  esp_random(void);
+void      esp_fill_random(void* buf, size_t len);
+// $MEO_NATIVE_MAC ("aa:bb:cc:dd:ee:ff") or a stable hash of the hostname
+esp_err_t esp_read_mac(uint8_t* mac, esp_mac_type_t type);
+void      esp_restart(void);
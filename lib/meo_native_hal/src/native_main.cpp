@@ -0,0 +1,28 @@
+// Entry point for env:native: drives the sketch's setup()/loop() like the
+// Arduino core does. $MEO_NATIVE_RUN_MS (optional) ends the run cleanly after
+// that many milliseconds, for CI. Unit tests (pio test) bring their own main().
+
+#include "Arduino.h"
+
+#ifndef PIO_UNIT_TESTING
+
+void setup();
+void loop();
+
+int main() {
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+    const char* runMs = getenv("MEO_NATIVE_RUN_MS");
+    uint32_t limit = runMs ? (uint32_t)strtoul(runMs, nullptr, 10) : 0;
+
+    setup();
+    for (;;) {
+        loop();
+        if (limit && millis() >= limit) break;
+        // loop() on the ESP32 core yields to the idle task; do the same
+        delay(1);
+    }
+    fflush(stdout);
+    return 0;
+}
+
+#endif // PIO_UNIT_TESTING
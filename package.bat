@@ -17,8 +17,10 @@ if exist "library.properties" copy "library.properties" "%FOLDER_NAME%\" >nul
 if exist "README.md" copy "README.md" "%FOLDER_NAME%\" >nul
 if exist "keywords.txt" copy "keywords.txt" "%FOLDER_NAME%\" >nul
 
-:: 4. Delete main.cpp if it snuck in (Safety)
+:: 4. Delete main.cpp and the host tools if they snuck in (Safety)
 if exist "%FOLDER_NAME%\src\main.cpp" del "%FOLDER_NAME%\src\main.cpp"
+if exist "%FOLDER_NAME%\src\bench" rmdir /s /q "%FOLDER_NAME%\src\bench"
+if exist "%FOLDER_NAME%\src\loadgen" rmdir /s /q "%FOLDER_NAME%\src\loadgen"
 
 :: 5. Zip the Parent Folder
 powershell -Command "Compress-Archive -Path '%FOLDER_NAME%' -DestinationPath '%ZIP_NAME%' -Force"
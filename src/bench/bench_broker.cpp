@@ -0,0 +1,163 @@
+#include "bench_broker.h"
+
+int MeoBenchBroker::_open() {
+    _connected = true;
+    _rxLen = _rxPos = 0;
+    _parse = Parse::TYPE;
+    return 1;
+}
+
+void MeoBenchBroker::stop() {
+    _connected = false;
+    _rxLen = _rxPos = 0;
+    _parse = Parse::TYPE;
+}
+
+int MeoBenchBroker::read(uint8_t* buf, size_t len) {
+    size_t n = _rxLen - _rxPos;
+    if (n == 0) return -1;
+    if (n > len) n = len;
+    memcpy(buf, _rx + _rxPos, n);
+    _rxPos += n;
+    return (int)n;
+}
+
+size_t MeoBenchBroker::write(const uint8_t* buf, size_t len) {
+    if (!_connected) return 0;
+    _bytesIn += len;
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t b = buf[i];
+        switch (_parse) {
+            case Parse::TYPE:
+                _type = b >> 4;
+                _qos = (b >> 1) & 0x03;
+                _packetId = 0;
+                _remaining = 0;
+                _lenMul = 1;
+                _pktLen = 0;
+                _parse = Parse::LENGTH;
+                break;
+            case Parse::LENGTH:
+                _remaining += (uint32_t)(b & 0x7F) * _lenMul;
+                _lenMul *= 128;
+                if (b & 0x80) break;
+                if (_remaining == 0) {
+                    _onPacket();
+                    _parse = Parse::TYPE;
+                } else {
+                    _parse = Parse::BODY;
+                }
+                break;
+            case Parse::BODY: {
+                // Only the first bytes matter; skip the rest of the body in one go
+                if (_pktLen < sizeof(_pkt)) _pkt[_pktLen] = b;
+                // QoS 1/2 PUBLISH: packet id follows the topic
+                uint32_t idAt = (_type == 3 && _qos && _pktLen >= 2)
+                                    ? 2 + (((uint32_t)_pkt[0] << 8) | _pkt[1]) : 0;
+                if (idAt && (_pktLen == idAt || _pktLen == idAt + 1)) {
+                    _packetId = (uint16_t)((_packetId << 8) | b);
+                }
+                _pktLen++;
+                size_t skip = 0;
+                if (_pktLen >= sizeof(_pkt)) {
+                    skip = len - i - 1;
+                    if (skip > _remaining - 1) skip = _remaining - 1;
+                    if (idAt && _pktLen < idAt + 2) {
+                        size_t toId = idAt > _pktLen ? idAt - _pktLen : 0;
+                        if (skip > toId) skip = toId;
+                    }
+                }
+                i += skip;
+                _pktLen += (uint32_t)skip;
+                _remaining -= 1 + (uint32_t)skip;
+                if (_remaining == 0) {
+                    _onPacket();
+                    _parse = Parse::TYPE;
+                }
+                break;
+            }
+        }
+    }
+    return len;
+}
+
+void MeoBenchBroker::_onPacket() {
+    switch (_type) {
+        case 1: { // CONNECT -> CONNACK; body starts 00 04 'MQTT' <level>
+            _v5 = _pktLen > 6 && _pkt[6] == 5;
+            if (_v5 && !_accept5) {
+                _v5 = false;
+                const uint8_t nack[] = {0x20, 0x02, 0x00, 0x01}; // 3.1.1: unacceptable protocol level
+                _queue(nack, sizeof(nack));
+            } else if (_v5) {
+                const uint8_t ack[] = {0x20, 0x06, 0x00, 0x00, 0x03, 0x22,
+                                       (uint8_t)(_aliasMax >> 8), (uint8_t)_aliasMax};
+                _queue(ack, sizeof(ack));
+            } else {
+                const uint8_t ack[] = {0x20, 0x02, 0x00, 0x00};
+                _queue(ack, sizeof(ack));
+            }
+            break;
+        }
+        case 3: // PUBLISH; QoS 1 gets its PUBACK
+            _publishes++;
+            if (_qos == 1) {
+                const uint8_t ack[] = {0x40, 0x02, (uint8_t)(_packetId >> 8), (uint8_t)_packetId};
+                _queue(ack, sizeof(ack));
+            }
+            break;
+        case 8: { // SUBSCRIBE -> SUBACK granting QoS 0
+            if (_v5) {
+                const uint8_t ack[] = {0x90, 0x04, _pkt[0], _pkt[1], 0x00, 0x00};
+                _queue(ack, sizeof(ack));
+            } else {
+                const uint8_t ack[] = {0x90, 0x03, _pkt[0], _pkt[1], 0x00};
+                _queue(ack, sizeof(ack));
+            }
+            break;
+        }
+        case 12: { // PINGREQ -> PINGRESP
+            const uint8_t ack[] = {0xD0, 0x00};
+            _queue(ack, sizeof(ack));
+            break;
+        }
+        case 14: // DISCONNECT
+            _connected = false;
+            break;
+        default:
+            break;
+    }
+}
+
+bool MeoBenchBroker::_queue(const uint8_t* data, size_t len) {
+    if (_rxPos == _rxLen) _rxPos = _rxLen = 0;
+    if (_rxLen + len > sizeof(_rx) && _rxPos) {
+        memmove(_rx, _rx + _rxPos, _rxLen - _rxPos);
+        _rxLen -= _rxPos;
+        _rxPos = 0;
+    }
+    if (_rxLen + len > sizeof(_rx)) return false;
+    memcpy(_rx + _rxLen, data, len);
+    _rxLen += len;
+    return true;
+}
+
+bool MeoBenchBroker::inject(const char* topic, const uint8_t* payload, size_t len) {
+    size_t topicLen = strlen(topic);
+    uint32_t remaining = (uint32_t)(2 + topicLen + (_v5 ? 1 : 0) + len);
+    uint8_t head[5 + 2];
+    size_t h = 0;
+    head[h++] = 0x30;
+    do {
+        uint8_t digit = remaining % 128;
+        remaining /= 128;
+        head[h++] = (uint8_t)(digit | (remaining ? 0x80 : 0));
+    } while (remaining);
+    head[h++] = (uint8_t)(topicLen >> 8);
+    head[h++] = (uint8_t)topicLen;
+
+    const uint8_t noProps = 0;
+    if (_rxLen - _rxPos + h + topicLen + 1 + len > sizeof(_rx)) return false;
+    return _queue(head, h) && _queue((const uint8_t*)topic, topicLen) &&
+           (!_v5 || _queue(&noProps, 1)) && _queue(payload, len);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+
+#ifndef MEO_BENCH_BROKER_RX
+#define MEO_BENCH_BROKER_RX 4096
+#endif
+
+/**
+ * MeoBenchBroker: in-memory MQTT 3.1.1 peer used as a MeoMqttClient transport.
+ * - Answers CONNECT, SUBSCRIBE and PINGREQ; counts and discards PUBLISH,
+ *   acknowledging QoS 1 with PUBACK
+ * - Speaks MQTT 5 when the client asks for it (granting topic aliases), or
+ *   refuses it like a 3.1.1-only broker
+ * - inject() queues a PUBLISH for the client to read (invoke round trips)
+ * - No sockets and no heap, so benchmarks measure the library and
+ *   PubSubClient, not the network
+ */
+class MeoBenchBroker : public Client {
+public:
+    int     connect(IPAddress ip, uint16_t port) override { (void)ip; (void)port; return _open(); }
+    int     connect(const char* host, uint16_t port) override { (void)host; (void)port; return _open(); }
+    size_t  write(uint8_t c) override { return write(&c, 1); }
+    size_t  write(const uint8_t* buf, size_t len) override;
+    int     available() override { return (int)(_rxLen - _rxPos); }
+    int     read() override { return _rxPos < _rxLen ? _rx[_rxPos++] : -1; }
+    int     read(uint8_t* buf, size_t len) override;
+    int     peek() override { return _rxPos < _rxLen ? _rx[_rxPos] : -1; }
+    void    flush() override {}
+    void    stop() override;
+    uint8_t connected() override { return _connected; }
+    operator bool() override { return _connected; }
+
+    // Queue a QoS 0 PUBLISH towards the client; false if the rx buffer is full
+    bool inject(const char* topic, const uint8_t* payload, size_t len);
+
+    // MQTT 5: accept protocol level 5 (default) and grant this many topic aliases
+    void setMqtt5(bool accept, uint16_t topicAliasMax = 10) { _accept5 = accept; _aliasMax = topicAliasMax; }
+    bool mqtt5() const { return _v5; }
+
+    uint32_t publishes() const { return _publishes; }
+    uint32_t bytesIn() const   { return _bytesIn; }
+
+    using Print::write;
+
+private:
+    enum class Parse : uint8_t { TYPE, LENGTH, BODY };
+
+    bool     _connected = false;
+    bool     _accept5 = true;
+    bool     _v5 = false;       // current session is MQTT 5
+    uint16_t _aliasMax = 10;
+    uint8_t  _rx[MEO_BENCH_BROKER_RX];
+    size_t   _rxLen = 0;
+    size_t   _rxPos = 0;
+
+    Parse    _parse = Parse::TYPE;
+    uint8_t  _type = 0;
+    uint8_t  _qos = 0;
+    uint16_t _packetId = 0;
+    uint32_t _remaining = 0;
+    uint32_t _lenMul = 1;
+    uint8_t  _pkt[8]; // start of the current packet body (enough for packet ids)
+    uint32_t _pktLen = 0;
+
+    uint32_t _publishes = 0;
+    uint32_t _bytesIn = 0;
+
+    int  _open();
+    void _onPacket();
+    bool _queue(const uint8_t* data, size_t len);
+};
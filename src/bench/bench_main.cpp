@@ -0,0 +1,458 @@
+// Microbenchmarks for the publish, declare and invoke-dispatch hot paths.
+// Built by env:bench_native / env:bench_esp32; prints one JSON line
+// ({"suite":"meo3-bench",...}) for tools/bench_compare.py.
+
+#include <Arduino.h>
+#include <Meo3_Device.h>
+#include <feature/Meo3_Feature.h>
+
+#include "bench_broker.h"
+#include "bench_probe.h"
+
+// Stack given to each case (the declare document lives on it)
+#ifndef MEO_BENCH_STACK
+#define MEO_BENCH_STACK 16384
+#endif
+// Wall time each case is scaled to
+#ifndef MEO_BENCH_TARGET_MS
+#define MEO_BENCH_TARGET_MS 200
+#endif
+// Events published for each latency histogram
+#ifndef MEO_BENCH_HIST_EVENTS
+#define MEO_BENCH_HIST_EVENTS 2000
+#endif
+
+#if defined(ESP_PLATFORM)
+#define MEO_BENCH_PLATFORM "esp32"
+#else
+#define MEO_BENCH_PLATFORM "native"
+#endif
+
+static const uint16_t KEY_COUNTS[]    = {1, 8, 32};
+static const uint16_t METHOD_COUNTS[] = {8, 64, 256};
+static const uint16_t MAX_KEYS        = 32;
+static const uint16_t MAX_METHODS     = 256;
+
+static const char* EVENT_NAME = "bench_event";
+static const char* QOS1_TOPIC = "meo/bench/qos1";
+
+class MeoBench {
+public:
+    typedef bool (*Op)(MeoBench& b);
+
+    void run();
+    // MQTT bytes the library has written to both in-memory brokers
+    uint32_t wireBytes() const { return _broker.bytesIn() + _featureBroker.bytesIn(); }
+
+private:
+    // Feature layer: its own client and broker, created before any MeoDevice
+    MeoBenchBroker _featureBroker;
+    MeoMqttClient  _featureClient;
+    MeoFeature     _feature;
+
+    MeoDevice*     _dev = nullptr;
+    MeoBenchBroker _broker;
+
+    // Current case inputs
+    uint16_t _keys = 0;
+    uint16_t _methods = 0;
+    uint32_t _cursor = 0;
+    MeoStaticEventFields<MAX_KEYS> _fields;
+    const char* _strKeys[MAX_KEYS];
+    const char* _strValues[MAX_KEYS];
+    char     _invokeTopic[MEO_TOPIC_MAX_LEN];
+    char     _invokeJson[768];
+    size_t   _invokeLen = 0;
+    char     _scratch[768];
+    volatile uint32_t _handled = 0;
+    bool     _respond = false;
+    bool     _firstRow = true;
+
+    static char _names[MAX_METHODS][12];
+    static char _keyNames[MAX_KEYS][4];
+    static char _values[MAX_KEYS][8];
+
+    bool _bringUp(uint16_t methods, MeoMqttProtocol protocol = MeoMqttProtocol::V3_1_1);
+    void _setKeys(uint16_t keys);
+    void _setInvoke(uint16_t keys, uint16_t methodIndex, MeoPayloadEncoding enc = MeoPayloadEncoding::JSON);
+    void _measure(const char* name, Op op);
+    void _histograms();
+
+    static void _onInvoke(const MeoFeatureCall& call, void* ctx);
+
+    static bool _opNoop(MeoBench& b)            { (void)b; return true; }
+    static bool _opPublishEvent(MeoBench& b)    { return b._dev->publishEvent(EVENT_NAME, b._fields); }
+    static bool _opPublishStrings(MeoBench& b)  { return b._dev->publishEvent(EVENT_NAME, b._strKeys, b._strValues, (uint8_t)b._keys); }
+    static bool _opFeaturePublish(MeoBench& b)  { return b._feature.publishEvent(EVENT_NAME, b._strKeys, b._strValues, (uint8_t)b._keys); }
+    static bool _opDeclare(MeoBench& b)         { return b._dev->_publishDeclare(b._dev->_mqtt); }
+    static bool _opLookup(MeoBench& b);
+    static bool _opDispatch(MeoBench& b);
+    static bool _opRoundTrip(MeoBench& b);
+    static bool _opPublishQos1(MeoBench& b);
+    static bool _opPublishBinLog(MeoBench& b);
+    static bool _opEncodeJson(MeoBench& b)    { return b._fields.serializeJson(b._scratch, sizeof(b._scratch)) != 0; }
+    static bool _opEncodeMsgPack(MeoBench& b) { return b._fields.serializeMsgPack((uint8_t*)b._scratch, sizeof(b._scratch)) != 0; }
+    static bool _opDecode(MeoBench& b);
+};
+
+char MeoBench::_names[MAX_METHODS][12];
+char MeoBench::_keyNames[MAX_KEYS][4];
+char MeoBench::_values[MAX_KEYS][8];
+
+static MeoBench bench;
+
+// ---- cases ----
+
+bool MeoBench::_opLookup(MeoBench& b) {
+    const char* name = _names[b._cursor++ % b._methods];
+    return b._dev->_methods.find(name) != nullptr;
+}
+
+bool MeoBench::_opDispatch(MeoBench& b) {
+    // Dispatch parses in place, so every call gets a fresh copy of the payload
+    memcpy(b._scratch, b._invokeJson, b._invokeLen);
+    uint32_t before = b._handled;
+    b._dev->_dispatchInvoke(b._invokeTopic, (const uint8_t*)b._scratch, (unsigned)b._invokeLen);
+    return b._handled == before + 1;
+}
+
+bool MeoBench::_opRoundTrip(MeoBench& b) {
+    uint32_t before = b._broker.publishes();
+    if (!b._broker.inject(b._invokeTopic, (const uint8_t*)b._invokeJson, b._invokeLen)) return false;
+    b._dev->_mqtt.loop();
+    return b._broker.publishes() == before + 1; // the feature_response
+}
+
+bool MeoBench::_opPublishQos1(MeoBench& b) {
+    MeoMqttClient& mqtt = b._dev->_mqtt;
+    uint32_t before = mqtt.inflightStats().acked;
+    if (!mqtt.publishQos1(QOS1_TOPIC, b._fields)) return false;
+    mqtt.loop(); // reads the PUBACK and completes the slot
+    return mqtt.inflightStats().acked == before + 1;
+}
+
+// The consumer's pops are counted, its formatting (done later in loop()) is not
+bool MeoBench::_opPublishBinLog(MeoBench& b) {
+    bool ok = b._dev->publishEvent(EVENT_NAME, b._fields);
+    b._dev->_binLog->drain(nullptr, MEO_BINLOG_SLOTS);
+    return ok;
+}
+
+// Invoke payload parse alone, in whichever encoding _setInvoke() produced
+bool MeoBench::_opDecode(MeoBench& b) {
+    memcpy(b._scratch, b._invokeJson, b._invokeLen);
+    StaticJsonDocument<512> doc;
+    DeserializationError err = meoIsMsgPackMap((const uint8_t*)b._scratch, b._invokeLen)
+                                   ? deserializeMsgPack(doc, b._scratch, b._invokeLen)
+                                   : deserializeJson(doc, b._scratch, b._invokeLen);
+    return err == DeserializationError::Ok && doc["params"].size() == b._keys;
+}
+
+void MeoBench::_onInvoke(const MeoFeatureCall& call, void* ctx) {
+    MeoBench* self = reinterpret_cast<MeoBench*>(ctx);
+    self->_handled++;
+    if (self->_respond) self->_dev->sendFeatureResponse(call, true, "ok");
+}
+
+// ---- setup ----
+
+bool MeoBench::_bringUp(uint16_t methods, MeoMqttProtocol protocol) {
+    delete _dev;
+    _dev = new MeoDevice();
+    _dev->setDeviceInfo("Bench Device", "MEO");
+    _dev->setMqttProtocol(protocol);
+    _dev->setGateway("bench", 1883);
+    _dev->addFeatureEvent(EVENT_NAME);
+    for (uint16_t i = 0; i < methods; ++i) {
+        if (!_dev->addFeatureMethod(_names[i], &MeoBench::_onInvoke, this)) return false;
+    }
+    _dev->_deviceId    = "A1B2C3D4E5F6";
+    _dev->_userId      = "bench-user";
+    _dev->_transmitKey = "bench-key";
+    if (!_dev->_buildTopics()) return false;
+    _dev->_configureMqtt();
+    _dev->setMqttTransport(&_broker);
+    for (int i = 0; i < 16 && _dev->mqttState() != MeoMqttState::DECLARED; ++i) {
+        _dev->_mqtt.loop();
+    }
+    _methods = methods;
+    _cursor = 0;
+    return _dev->mqttState() == MeoMqttState::DECLARED;
+}
+
+void MeoBench::_setKeys(uint16_t keys) {
+    _keys = keys;
+    _fields.clear();
+    for (uint16_t i = 0; i < keys; ++i) {
+        _fields.add(_keyNames[i], (long)(1000 + i * 7));
+        _strKeys[i] = _keyNames[i];
+        _strValues[i] = _values[i];
+    }
+}
+
+void MeoBench::_setInvoke(uint16_t keys, uint16_t methodIndex, MeoPayloadEncoding enc) {
+    snprintf(_invokeTopic, sizeof(_invokeTopic), "%s/feature/%s/invoke",
+             _dev->_topics.base(), _names[methodIndex]);
+    if (enc == MeoPayloadEncoding::MSGPACK) {
+        // {"params":{k00:1000,...}}: keys are fixstr, values uint 16
+        uint8_t* p = (uint8_t*)_invokeJson;
+        size_t n = 0;
+        p[n++] = 0x81;
+        p[n++] = 0xA6;
+        memcpy(p + n, "params", 6);
+        n += 6;
+        if (keys < 16) {
+            p[n++] = (uint8_t)(0x80 | keys);
+        } else {
+            p[n++] = 0xDE;
+            p[n++] = (uint8_t)(keys >> 8);
+            p[n++] = (uint8_t)keys;
+        }
+        for (uint16_t i = 0; i < keys; ++i) {
+            size_t keyLen = strlen(_keyNames[i]);
+            p[n++] = (uint8_t)(0xA0 | keyLen);
+            memcpy(p + n, _keyNames[i], keyLen);
+            n += keyLen;
+            uint16_t v = (uint16_t)(1000 + i * 7);
+            p[n++] = 0xCD;
+            p[n++] = (uint8_t)(v >> 8);
+            p[n++] = (uint8_t)v;
+        }
+        _invokeLen = n;
+        return;
+    }
+    size_t n = (size_t)snprintf(_invokeJson, sizeof(_invokeJson), "{\"params\":{");
+    for (uint16_t i = 0; i < keys; ++i) {
+        n += (size_t)snprintf(_invokeJson + n, sizeof(_invokeJson) - n, "%s\"%s\":%u",
+                              i ? "," : "", _keyNames[i], (unsigned)(1000 + i * 7));
+    }
+    n += (size_t)snprintf(_invokeJson + n, sizeof(_invokeJson) - n, "}}");
+    _invokeLen = n;
+}
+
+// ---- measurement ----
+
+struct CaseRun {
+    MeoBench::Op op;
+    MeoBench*    bench;
+    uint32_t     iters;
+    uint64_t     ns;
+    MeoBenchHeap heap;
+    uint32_t     wire;
+    bool         ok;
+};
+
+static void runCase(void* arg) {
+    CaseRun* r = reinterpret_cast<CaseRun*>(arg);
+    MeoBench& b = *r->bench;
+    r->ok = r->op(b); // warm-up
+
+    // Grow the batch until it takes ~1/8 of the target, then scale to the target
+    uint32_t iters = 1;
+    uint64_t ns = 0;
+    for (;;) {
+        uint64_t t0 = meoBenchNowNs();
+        for (uint32_t i = 0; i < iters; ++i) r->op(b);
+        ns = meoBenchNowNs() - t0;
+        if (ns * 8 >= (uint64_t)MEO_BENCH_TARGET_MS * 1000000ull || iters >= (1u << 22)) break;
+        iters *= 4;
+    }
+    uint64_t target = (uint64_t)MEO_BENCH_TARGET_MS * 1000000ull;
+    uint64_t scaled = ns ? (uint64_t)iters * target / ns : iters;
+    r->iters = scaled < 1 ? 1 : (scaled > (1u << 24) ? (1u << 24) : (uint32_t)scaled);
+
+    bool ok = r->ok;
+    uint32_t wire0 = b.wireBytes();
+    meoBenchHeapBegin();
+    uint64_t t0 = meoBenchNowNs();
+    for (uint32_t i = 0; i < r->iters; ++i) ok = r->op(b) && ok;
+    r->ns = meoBenchNowNs() - t0;
+    r->heap = meoBenchHeapEnd();
+    r->wire = b.wireBytes() - wire0;
+    r->ok = ok;
+}
+
+void MeoBench::_measure(const char* name, Op op) {
+    CaseRun r = {op, this, 0, 0, MeoBenchHeap(), 0, false};
+    size_t stack = meoBenchRunOnStack(&runCase, &r, MEO_BENCH_STACK);
+    double nsPerOp = r.iters ? (double)r.ns / r.iters : 0.0;
+
+    Serial.printf("%s{\"name\":\"%s\",\"keys\":%u,\"methods\":%u,\"iters\":%lu,\"ns_per_op\":%.1f,",
+                  _firstRow ? "" : ",", name, (unsigned)_keys, (unsigned)_methods,
+                  (unsigned long)r.iters, nsPerOp);
+    if (meoBenchHeapTracked()) {
+        Serial.printf("\"allocs_per_op\":%.3f,\"bytes_per_op\":%.1f,\"heap_peak\":%ld,",
+                      r.iters ? (double)r.heap.allocs / r.iters : 0.0,
+                      r.iters ? (double)r.heap.bytes / r.iters : 0.0,
+                      (long)r.heap.peak);
+    } else {
+        Serial.print("\"allocs_per_op\":null,\"bytes_per_op\":null,\"heap_peak\":null,");
+    }
+    Serial.printf("\"wire_bytes_per_op\":%.1f,\"stack_peak\":%lu,\"ok\":%s}",
+                  r.iters ? (double)r.wire / r.iters : 0.0, (unsigned long)stack, r.ok ? "true" : "false");
+    _firstRow = false;
+}
+
+// Inline vs network-task publish latency (runs last: the network task never stops)
+void MeoBench::_histograms() {
+    char a[160], b[160], c[160];
+    MeoLatencyHistogram h;
+    _setKeys(8);
+
+    _dev->takePublishLatency(h); // drop what the earlier runs recorded
+    for (uint32_t i = 0; i < MEO_BENCH_HIST_EVENTS; ++i) _dev->publishEvent(EVENT_NAME, _fields);
+    _dev->takePublishLatency(h);
+    h.formatJson(a, sizeof(a));
+
+    _dev->takeTxQueueLatency(h);
+    _dev->_netTaskRunning = true;
+    if (!meoStartTask("meo_net", &MeoDevice::_netTask, _dev, 8192, 2, 0)) {
+        _dev->_netTaskRunning = false;
+        Serial.printf("],\"histograms\":{\"inline_publish_us\":%s}}\n", a);
+        return;
+    }
+    for (uint32_t i = 0; i < MEO_BENCH_HIST_EVENTS; ++i) {
+        _dev->publishEvent(EVENT_NAME, _fields);
+        // Bursts of 8, then let the network task catch up
+        if ((i & 7) == 7) {
+            while (!_dev->_txRing->empty()) meoSleepMs(1);
+        }
+    }
+    while (!_dev->_txRing->empty()) meoSleepMs(1);
+    meoSleepMs(20);
+    _dev->takePublishLatency(h);
+    h.formatJson(b, sizeof(b));
+    _dev->takeTxQueueLatency(h);
+    h.formatJson(c, sizeof(c));
+    Serial.printf("],\"histograms\":{\"inline_publish_us\":%s,\"threaded_publish_us\":%s,"
+                  "\"threaded_tx_queue_us\":%s,\"threaded_tx_drops\":%lu}}\n",
+                  a, b, c, (unsigned long)_dev->txRingDrops());
+}
+
+void MeoBench::run() {
+    for (uint16_t i = 0; i < MAX_METHODS; ++i) snprintf(_names[i], sizeof(_names[i]), "method_%03u", i);
+    for (uint16_t i = 0; i < MAX_KEYS; ++i) {
+        snprintf(_keyNames[i], sizeof(_keyNames[i]), "k%02u", i);
+        snprintf(_values[i], sizeof(_values[i]), "%u", (unsigned)(1000 + i * 7));
+    }
+
+    Serial.printf("{\"suite\":\"meo3-bench\",\"schema\":1,\"platform\":\"%s\","
+                  "\"config\":{\"max_methods\":%u,\"max_event_fields\":%u,\"stack\":%u,\"heap_tracking\":%s},"
+                  "\"results\":[",
+                  MEO_BENCH_PLATFORM, (unsigned)MEO_MAX_FEATURE_METHODS, (unsigned)MEO_MAX_EVENT_FIELDS,
+                  (unsigned)MEO_BENCH_STACK, meoBenchHeapTracked() ? "true" : "false");
+
+    // MeoFeature (standalone transport)
+    _featureClient.configure("bench", 1883);
+    _featureClient.setCredentials("A1B2C3D4E5F6", "bench-key");
+    _featureClient.setTransport(&_featureBroker);
+    _featureClient.connect();
+    _feature.attach(&_featureClient, "bench-user", "A1B2C3D4E5F6");
+    _methods = 0;
+    _setKeys(0);
+    _measure("noop", &_opNoop);
+    for (uint16_t keys : KEY_COUNTS) {
+        if (keys > MEO_MAX_EVENT_FIELDS) continue; // string API caps at MEO_MAX_EVENT_FIELDS
+        _setKeys(keys);
+        _measure("feature_publish_event", &_opFeaturePublish);
+    }
+
+    // MeoDevice paths, per method-table size
+    uint16_t roundTripMethods = 0;
+    for (uint16_t methods : METHOD_COUNTS) {
+        if (methods > MEO_MAX_FEATURE_METHODS) continue;
+        if (!_bringUp(methods)) continue;
+        if (methods == METHOD_COUNTS[0]) {
+            for (uint16_t keys : KEY_COUNTS) {
+                _setKeys(keys);
+                _measure("publish_event", &_opPublishEvent);
+                if (keys <= MEO_MAX_EVENT_FIELDS) _measure("publish_event_strings", &_opPublishStrings);
+                if (keys <= 8) _measure("publish_qos1", &_opPublishQos1); // fits MEO_MQTT_INFLIGHT_PACKET
+                // Logger attached, DEBUG on only for tags off the publish path: the tag checks
+                _dev->setLogger([](const char*, const char*) {});
+                _dev->setDebugTags("WIFI,PROV");
+                _measure("publish_event_logged", &_opPublishEvent);
+                // DEBUG on for the publish path: formatted on the spot vs recorded for later
+                _dev->setDebugTags("DEVICE,MQTT");
+                _measure("publish_event_debug", &_opPublishEvent);
+                _dev->setBinaryLogging(true);
+                _measure("publish_event_binlog", &_opPublishBinLog);
+                _dev->setBinaryLogging(false);
+                _dev->setDebugTags(nullptr);
+                _dev->setLogger(nullptr);
+                // Same event as MessagePack, and the bare encoders
+                _dev->setPayloadEncoding(MeoPayloadEncoding::MSGPACK);
+                _measure("publish_event_msgpack", &_opPublishEvent);
+                _dev->setPayloadEncoding(MeoPayloadEncoding::JSON);
+                _measure("encode_json", &_opEncodeJson);
+                _measure("encode_msgpack", &_opEncodeMsgPack);
+                if (keys <= 8) {
+                    // Budget-driven batches (the window never expires inside a case); ns and
+                    // wire bytes are per event, one MQTT message per MEO_EVENT_BATCH_BYTES
+                    _dev->setEventBatching(60000);
+                    _measure("publish_event_batched", &_opPublishEvent);
+                    _dev->setEventBatching(0);
+                }
+            }
+        }
+        _setKeys(0);
+        _measure("declare", &_opDeclare);
+        _measure("method_lookup", &_opLookup);
+        _respond = false;
+        for (uint16_t keys : KEY_COUNTS) {
+            _setKeys(keys);
+            _setInvoke(keys, (uint16_t)(methods / 2));
+            _measure("dispatch_invoke", &_opDispatch);
+            if (methods == METHOD_COUNTS[0]) {
+                _measure("decode_json", &_opDecode);
+                _setInvoke(keys, (uint16_t)(methods / 2), MeoPayloadEncoding::MSGPACK);
+                _measure("decode_msgpack", &_opDecode);
+                _measure("dispatch_invoke_msgpack", &_opDispatch);
+            }
+        }
+        if (methods <= 64) roundTripMethods = methods;
+    }
+
+    // Same traffic over MQTT 5: event and response topics go out as aliases
+    if (roundTripMethods && _bringUp(roundTripMethods, MeoMqttProtocol::V5) && _dev->_mqtt.usesMqtt5()) {
+        for (uint16_t keys : KEY_COUNTS) {
+            _setKeys(keys);
+            _measure("publish_event_mqtt5", &_opPublishEvent);
+        }
+        _respond = true;
+        for (uint16_t keys : KEY_COUNTS) {
+            _setKeys(keys);
+            _setInvoke(keys, (uint16_t)(roundTripMethods / 2));
+            _measure("invoke_roundtrip_mqtt5", &_opRoundTrip);
+        }
+        _respond = false;
+    }
+
+    // Invoke -> handler -> feature_response through PubSubClient
+    if (roundTripMethods && _bringUp(roundTripMethods)) {
+        _respond = true;
+        for (uint16_t keys : KEY_COUNTS) {
+            _setKeys(keys);
+            _setInvoke(keys, (uint16_t)(roundTripMethods / 2));
+            _measure("invoke_roundtrip", &_opRoundTrip);
+        }
+        _respond = false;
+        _histograms();
+    } else {
+        Serial.print("]}\n");
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(200);
+    bench.run();
+    Serial.flush();
+#if !defined(ESP_PLATFORM)
+    _Exit(0); // the network task is still running: skip static destructors
+#endif
+}
+
+void loop() {
+    delay(1000);
+}
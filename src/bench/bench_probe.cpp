@@ -0,0 +1,197 @@
+#include "bench_probe.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+#if defined(ESP_PLATFORM)
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#else
+#include <chrono>
+#include <malloc.h>
+#include <pthread.h>
+#include <limits.h>
+#endif
+
+// ---- clock ----
+
+uint64_t meoBenchNowNs() {
+#if defined(ESP_PLATFORM)
+    return (uint64_t)esp_timer_get_time() * 1000ull;
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// ---- heap ----
+
+static thread_local bool t_tracking = false;
+static int64_t      s_live = 0;
+static MeoBenchHeap s_heap;
+
+#if defined(MEO_BENCH_TRACK_HEAP)
+
+static size_t blockSize(void* p) {
+#if defined(ESP_PLATFORM)
+    return heap_caps_get_allocated_size(p);
+#else
+    return malloc_usable_size(p);
+#endif
+}
+
+static void noteAlloc(void* p, size_t requested) {
+    if (!p || !t_tracking) return;
+    s_heap.allocs++;
+    s_heap.bytes += requested;
+    s_live += (int64_t)blockSize(p);
+    if (s_live > s_heap.peak) s_heap.peak = s_live;
+}
+
+static void noteFree(void* p) {
+    if (p && t_tracking) s_live -= (int64_t)blockSize(p);
+}
+
+extern "C" {
+void* __real_malloc(size_t n);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* p, size_t n);
+void  __real_free(void* p);
+
+void* __wrap_malloc(size_t n) {
+    void* p = __real_malloc(n);
+    noteAlloc(p, n);
+    return p;
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+    void* p = __real_calloc(n, size);
+    noteAlloc(p, n * size);
+    return p;
+}
+
+void* __wrap_realloc(void* old, size_t n) {
+    noteFree(old);
+    void* p = __real_realloc(old, n);
+    noteAlloc(p, n);
+    return p;
+}
+
+void __wrap_free(void* p) {
+    noteFree(p);
+    __real_free(p);
+}
+}
+
+// A shared libstdc++ calls the unwrapped malloc: route new/delete through ours
+void* operator new(size_t n) {
+    void* p = malloc(n ? n : 1);
+    if (!p) {
+#if defined(__cpp_exceptions)
+        throw std::bad_alloc();
+#else
+        abort();
+#endif
+    }
+    return p;
+}
+void* operator new[](size_t n) { return operator new(n); }
+void  operator delete(void* p) noexcept { free(p); }
+void  operator delete[](void* p) noexcept { free(p); }
+void  operator delete(void* p, size_t) noexcept { free(p); }
+void  operator delete[](void* p, size_t) noexcept { free(p); }
+
+bool meoBenchHeapTracked() { return true; }
+
+#else
+
+bool meoBenchHeapTracked() { return false; }
+
+#endif
+
+void meoBenchHeapBegin() {
+    s_heap = MeoBenchHeap();
+    s_live = 0;
+    t_tracking = true;
+}
+
+MeoBenchHeap meoBenchHeapEnd() {
+    t_tracking = false;
+    return s_heap;
+}
+
+// ---- stack ----
+
+#if defined(ESP_PLATFORM)
+
+struct EspRun {
+    MeoBenchFn        fn;
+    void*             ctx;
+    SemaphoreHandle_t done;
+    UBaseType_t       freeMin;
+};
+
+static void espTrampoline(void* arg) {
+    EspRun* run = (EspRun*)arg;
+    run->fn(run->ctx);
+    run->freeMin = uxTaskGetStackHighWaterMark(nullptr);
+    xSemaphoreGive(run->done);
+    vTaskDelete(nullptr);
+}
+
+size_t meoBenchRunOnStack(MeoBenchFn fn, void* ctx, size_t stackBytes) {
+    EspRun run = {fn, ctx, xSemaphoreCreateBinary(), 0};
+    if (!run.done) return 0;
+    BaseType_t ok = xTaskCreatePinnedToCore(espTrampoline, "meo_bench", stackBytes, &run,
+                                            uxTaskPriorityGet(nullptr), nullptr, xPortGetCoreID());
+    if (ok != pdPASS) { vSemaphoreDelete(run.done); return 0; }
+    xSemaphoreTake(run.done, portMAX_DELAY);
+    vSemaphoreDelete(run.done);
+    // ESP-IDF counts stack in bytes
+    return stackBytes > run.freeMin ? stackBytes - run.freeMin : 0;
+}
+
+#else
+
+static const uint8_t STACK_PAINT = 0xA5;
+
+struct HostRun {
+    MeoBenchFn fn;
+    void*      ctx;
+};
+
+static void* hostTrampoline(void* arg) {
+    HostRun* run = (HostRun*)arg;
+    run->fn(run->ctx);
+    return nullptr;
+}
+
+size_t meoBenchRunOnStack(MeoBenchFn fn, void* ctx, size_t stackBytes) {
+    if (stackBytes < (size_t)PTHREAD_STACK_MIN) stackBytes = PTHREAD_STACK_MIN;
+    stackBytes = (stackBytes + 4095) & ~(size_t)4095;
+    void* stack = nullptr;
+    if (posix_memalign(&stack, 4096, stackBytes) != 0) return 0;
+    memset(stack, STACK_PAINT, stackBytes);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, stackBytes);
+    HostRun run = {fn, ctx};
+    pthread_t th;
+    bool started = pthread_create(&th, &attr, hostTrampoline, &run) == 0;
+    pthread_attr_destroy(&attr);
+    if (started) pthread_join(th, nullptr);
+
+    // The stack grows down: untouched paint is at the low end
+    size_t untouched = 0;
+    const uint8_t* p = (const uint8_t*)stack;
+    while (untouched < stackBytes && p[untouched] == STACK_PAINT) untouched++;
+    free(stack);
+    return started ? stackBytes - untouched : 0;
+}
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Benchmark probes: clock, heap accounting and stack depth.
+ * - Heap accounting needs the malloc family wrapped at link time
+ *   (-Wl,--wrap=malloc,... and -D MEO_BENCH_TRACK_HEAP, see the bench envs);
+ *   only allocations made by the measuring task are counted
+ * - Stack depth is measured by running the case on a fresh stack:
+ *   a painted pthread stack on the host, a FreeRTOS task high-water mark on ESP32
+ */
+
+struct MeoBenchHeap {
+    uint32_t allocs = 0;   // malloc/calloc/realloc/new calls
+    uint64_t bytes = 0;    // bytes requested
+    int64_t  peak = 0;     // high-water of live bytes above the starting point
+};
+
+uint64_t meoBenchNowNs();
+
+bool meoBenchHeapTracked();
+void meoBenchHeapBegin();
+MeoBenchHeap meoBenchHeapEnd();
+
+typedef void (*MeoBenchFn)(void* ctx);
+// Run fn(ctx) to completion on a new stack of stackBytes; returns the peak
+// number of stack bytes used (0 if it could not be measured)
+size_t meoBenchRunOnStack(MeoBenchFn fn, void* ctx, size_t stackBytes);
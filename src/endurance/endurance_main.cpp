@@ -0,0 +1,244 @@
+// Endurance run for MeoLogStore: a counter workload against a file-backed flash
+// region (MeoFileFlash), optionally with power cuts mid-write. Built by
+// env:endurance_native; configured from the environment (see README "State
+// store"). Prints one JSON line ({"suite":"meo3-endurance",...}) with wear per
+// sector, write amplification, recovery after each cut and a lifetime estimate.
+
+#include <Arduino.h>
+#include <metrics/Meo3_Histogram.h>
+#include <storage/Meo3_LogStore.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+// Written once: must survive every compaction
+static const char* CONFIG_KEY   = "config";
+static const char* CONFIG_VALUE = "endurance";
+static const uint32_t MAX_KEYS = 24;
+
+struct EnduranceConfig {
+    const char* path = ".meo_endurance.flash";
+    uint32_t sectors = 16;      // 64 KB, like the meostate partition
+    uint32_t keys = 8;          // counters, saved round-robin
+    uint32_t valueBytes = 8;    // counter in the first 8 bytes, padding after
+    uint32_t writes = 1000000;
+    uint32_t periodS = 5;       // save interval per counter, for the lifetime estimate
+    uint32_t cutEvery = 0;      // power cut during every Nth put (0 = off)
+    uint32_t loops = 4;         // loop() calls between puts
+    uint32_t cycles = 100000;   // rated erase cycles per sector
+    bool     fresh = false;     // start from a blank region with no wear history
+};
+
+static uint32_t envU32(const char* name, uint32_t def) {
+    const char* v = getenv(name);
+    return (v && *v) ? (uint32_t)strtoul(v, nullptr, 10) : def;
+}
+
+static const char* envStr(const char* name, const char* def) {
+    const char* v = getenv(name);
+    return (v && *v) ? v : def;
+}
+
+class MeoEndurance {
+public:
+    void run();
+
+private:
+    EnduranceConfig _cfg;
+    MeoFileFlash    _flash;
+    MeoLogStore*    _store = nullptr;
+    uint64_t        _acked[MAX_KEYS] = {}; // last value each put() confirmed
+    uint32_t        _seed = 0x2545F491u;
+
+    MeoLatencyHistogram _putUs;
+    MeoLogStoreStats    _total; // summed over remounts
+    uint32_t _cuts = 0, _recovered = 0, _lost = 0, _failed = 0;
+
+    void _loadConfig();
+    uint32_t _random();
+    void _key(uint32_t k, char* out, size_t len) { snprintf(out, len, "ctr%02u", (unsigned)k); }
+    void _encode(uint64_t counter, uint8_t* out);
+    bool _mount();
+    void _unmount();
+    bool _check(uint32_t inFlightKey, uint64_t inFlight);
+    void _report(uint32_t startErases[], uint32_t ms);
+};
+
+static MeoEndurance endurance;
+
+void MeoEndurance::_loadConfig() {
+    _cfg.path       = envStr("MEO_ENDURANCE_FILE", _cfg.path);
+    _cfg.sectors    = envU32("MEO_ENDURANCE_SECTORS", _cfg.sectors);
+    _cfg.keys       = envU32("MEO_ENDURANCE_KEYS", _cfg.keys);
+    _cfg.valueBytes = envU32("MEO_ENDURANCE_VALUE_BYTES", _cfg.valueBytes);
+    _cfg.writes     = envU32("MEO_ENDURANCE_WRITES", _cfg.writes);
+    _cfg.periodS    = envU32("MEO_ENDURANCE_PERIOD_S", _cfg.periodS);
+    _cfg.cutEvery   = envU32("MEO_ENDURANCE_CUT_EVERY", _cfg.cutEvery);
+    _cfg.loops      = envU32("MEO_ENDURANCE_LOOPS", _cfg.loops);
+    _cfg.cycles     = envU32("MEO_ENDURANCE_CYCLES", _cfg.cycles);
+    _cfg.fresh      = envU32("MEO_ENDURANCE_FRESH", 0) != 0;
+    if (_cfg.keys == 0) _cfg.keys = 1;
+    if (_cfg.keys > MAX_KEYS) _cfg.keys = MAX_KEYS;
+    if (_cfg.keys >= MEO_LOGSTORE_KEYS) _cfg.keys = MEO_LOGSTORE_KEYS - 1; // one slot for CONFIG_KEY
+    if (_cfg.valueBytes < 8) _cfg.valueBytes = 8;
+    if (_cfg.valueBytes > MEO_LOGSTORE_VALUE_MAX) _cfg.valueBytes = MEO_LOGSTORE_VALUE_MAX;
+    if (_cfg.periodS == 0) _cfg.periodS = 1;
+}
+
+uint32_t MeoEndurance::_random() {
+    _seed ^= _seed << 13;
+    _seed ^= _seed >> 17;
+    _seed ^= _seed << 5;
+    return _seed;
+}
+
+void MeoEndurance::_encode(uint64_t counter, uint8_t* out) {
+    memcpy(out, &counter, 8);
+    memset(out + 8, (uint8_t)counter, _cfg.valueBytes - 8);
+}
+
+bool MeoEndurance::_mount() {
+    _store = new MeoLogStore();
+    return _store->begin(&_flash);
+}
+
+void MeoEndurance::_unmount() {
+    MeoLogStoreStats s = _store->stats();
+    _total.puts += s.puts;
+    _total.unchanged += s.unchanged;
+    _total.relocated += s.relocated;
+    _total.erases += s.erases;
+    _total.stalls += s.stalls;
+    _total.bytesWritten += s.bytesWritten;
+    delete _store;
+    _store = nullptr;
+}
+
+// After a remount every counter must read back its last confirmed value, or the
+// value of the put that was cut if that record made it out whole
+bool MeoEndurance::_check(uint32_t inFlightKey, uint64_t inFlight) {
+    bool ok = true;
+    uint8_t value[MEO_LOGSTORE_VALUE_MAX];
+    uint8_t want[MEO_LOGSTORE_VALUE_MAX];
+    size_t len = 0;
+    for (uint32_t k = 0; k < _cfg.keys; ++k) {
+        char key[16];
+        _key(k, key, sizeof(key));
+        bool found = _store->get(key, value, sizeof(value), &len) && len == _cfg.valueBytes;
+        uint64_t got = 0;
+        if (found) memcpy(&got, value, 8);
+        _encode(got, want);
+        bool intact = found && memcmp(value, want, len) == 0;
+        if (intact && k == inFlightKey && got == inFlight) _acked[k] = got;
+        if (!(intact && got == _acked[k]) && !(_acked[k] == 0 && !found)) ok = false;
+    }
+    char config[16] = {0};
+    if (!_store->get(CONFIG_KEY, config, sizeof(config) - 1) || strcmp(config, CONFIG_VALUE) != 0) ok = false;
+    return ok;
+}
+
+void MeoEndurance::run() {
+    _loadConfig();
+    if (_cfg.fresh) {
+        remove(_cfg.path);
+        remove((std::string(_cfg.path) + ".wear").c_str());
+    }
+    if (!_flash.begin(_cfg.path, (size_t)_cfg.sectors * 4096) || !_mount()) {
+        Serial.printf("endurance: cannot open %s (%u sectors)\n", _cfg.path, (unsigned)_cfg.sectors);
+        _Exit(1);
+    }
+    // Carry on from what a previous run left behind
+    for (uint32_t k = 0; k < _cfg.keys; ++k) {
+        char key[16];
+        _key(k, key, sizeof(key));
+        uint8_t value[MEO_LOGSTORE_VALUE_MAX];
+        if (_store->get(key, value, sizeof(value))) memcpy(&_acked[k], value, 8);
+    }
+    _store->put(CONFIG_KEY, CONFIG_VALUE, strlen(CONFIG_VALUE));
+
+    uint32_t startErases[MEO_LOGSTORE_SECTORS];
+    for (uint32_t s = 0; s < _cfg.sectors && s < MEO_LOGSTORE_SECTORS; ++s) startErases[s] = _flash.erases(s);
+
+    uint32_t t0 = millis();
+    uint8_t value[MEO_LOGSTORE_VALUE_MAX];
+    for (uint32_t i = 0; i < _cfg.writes; ++i) {
+        uint32_t k = i % _cfg.keys;
+        char key[16];
+        _key(k, key, sizeof(key));
+        uint64_t next = _acked[k] + 1;
+        _encode(next, value);
+        if (_cfg.cutEvery && i % _cfg.cutEvery == _cfg.cutEvery - 1) {
+            _flash.cutPowerAfter(_random() % (2 * _cfg.valueBytes + 64));
+        }
+
+        uint32_t us = micros();
+        bool ok = _store->put(key, value, _cfg.valueBytes);
+        for (uint32_t l = 0; l < _cfg.loops && _flash.powered(); ++l) _store->loop();
+        _putUs.record(micros() - us);
+        if (ok) _acked[k] = next; // durable once put() returns true
+
+        if (!_flash.powered()) {
+            _cuts++;
+            _unmount();
+            _flash.powerOn();
+            if (!_mount()) {
+                Serial.println("endurance: remount failed");
+                _Exit(1);
+            }
+            if (_check(k, next)) _recovered++;
+            else _lost++;
+            continue;
+        }
+        if (!ok) _failed++;
+    }
+    _report(startErases, millis() - t0);
+    _unmount();
+    _flash.end();
+}
+
+void MeoEndurance::_report(uint32_t startErases[], uint32_t ms) {
+    MeoLogStoreStats s = _store->stats();
+    uint64_t puts = _total.puts + s.puts;
+    uint64_t bytes = (uint64_t)_total.bytesWritten + s.bytesWritten;
+    uint64_t payload = (uint64_t)_cfg.writes * _cfg.valueBytes;
+
+    // Lifetime: the most erased sector of this run sets the pace
+    uint32_t runMax = 0;
+    for (uint32_t i = 0; i < _cfg.sectors && i < MEO_LOGSTORE_SECTORS; ++i) {
+        uint32_t d = _flash.erases(i) - startErases[i];
+        if (d > runMax) runMax = d;
+    }
+    double putsPerDay = (double)_cfg.keys * 86400.0 / _cfg.periodS;
+    double erasesPerDay = _cfg.writes ? (double)runMax * putsPerDay / _cfg.writes : 0.0;
+    double years = erasesPerDay > 0 ? _cfg.cycles / erasesPerDay / 365.0 : 0.0;
+
+    char wear[256], putUs[160];
+    _flash.formatWearJson(wear, sizeof(wear), _cfg.cycles);
+    _putUs.formatJson(putUs, sizeof(putUs));
+    Serial.printf("{\"suite\":\"meo3-endurance\",\"schema\":1,\"sectors\":%u,\"keys\":%u,\"value_bytes\":%u,"
+                  "\"writes\":%u,\"ms\":%u,"
+                  "\"store\":{\"puts\":%llu,\"relocated\":%u,\"erases\":%u,\"stalls\":%u,\"failed\":%u},"
+                  "\"bytes_per_put\":%.1f,\"write_amplification\":%.2f,\"put_us\":%s,"
+                  "\"power_cuts\":{\"cuts\":%u,\"recovered\":%u,\"lost\":%u},"
+                  "\"wear\":%s,"
+                  "\"lifetime\":{\"period_s\":%u,\"max_sector_erases_per_day\":%.2f,\"years\":%.1f}}\n",
+                  (unsigned)_cfg.sectors, (unsigned)_cfg.keys, (unsigned)_cfg.valueBytes,
+                  (unsigned)_cfg.writes, (unsigned)ms,
+                  (unsigned long long)puts, (unsigned)(_total.relocated + s.relocated),
+                  (unsigned)(_total.erases + s.erases), (unsigned)(_total.stalls + s.stalls), (unsigned)_failed,
+                  puts ? (double)bytes / puts : 0.0, payload ? (double)bytes / payload : 0.0, putUs,
+                  (unsigned)_cuts, (unsigned)_recovered, (unsigned)_lost,
+                  wear, (unsigned)_cfg.periodS, erasesPerDay, years);
+}
+
+void setup() {
+    Serial.begin(115200);
+    endurance.run();
+    Serial.flush();
+    _Exit(0);
+}
+
+void loop() {
+}
@@ -0,0 +1,438 @@
+// Load generator: N simulated MeoDevices with distinct MAC-derived ids against
+// one broker, plus a gateway-side client that sends invokes and times the
+// feature_response. Built by env:loadgen_native; configured from the
+// environment (see README "Load testing"). Prints a progress line per second
+// and one JSON line ({"suite":"meo3-load",...}) at the end.
+
+#include <Arduino.h>
+#include <Meo3_Device.h>
+#include <WiFiClient.h>
+#include <esp_system.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static const char* EVENT_NAME  = "load";
+static const char* METHOD_NAME = "echo";
+
+// Locally administered unicast prefix; the last three bytes are the device index
+static const uint8_t MAC_PREFIX[3] = {0x02, 0x4D, 0x45};
+
+struct LoadConfig {
+    const char* host = "127.0.0.1";
+    uint16_t port = 1883;
+    uint32_t devices = 100;
+    uint32_t threads = 4;
+    float    eventHz = 1.0f;     // per device
+    float    invokeHz = 50.0f;   // total, round-robin over connected devices
+    uint32_t seconds = 30;
+    uint32_t stormAtS = 0;       // drop every connection at this second (0 = off)
+    uint32_t backoffMinMs = 1000;
+    uint32_t backoffMaxMs = 60000;
+    const char* userId = "load";
+    const char* txKey = "load-key";
+    bool     watchEvents = false; // gateway also counts events the broker delivers
+    uint32_t batchMs = 0;         // event batching window (0 = one message per event)
+    uint32_t batchBytes = MEO_EVENT_BATCH_BYTES;
+};
+
+static uint32_t envU32(const char* name, uint32_t def) {
+    const char* v = getenv(name);
+    return (v && *v) ? (uint32_t)strtoul(v, nullptr, 10) : def;
+}
+
+static float envFloat(const char* name, float def) {
+    const char* v = getenv(name);
+    return (v && *v) ? strtof(v, nullptr) : def;
+}
+
+static const char* envStr(const char* name, const char* def) {
+    const char* v = getenv(name);
+    return (v && *v) ? v : def;
+}
+
+// One simulated node; touched only by the worker that owns it
+struct SimDevice {
+    MeoDevice  dev;
+    WiFiClient sock;       // owned here so a storm can drop it from the worker
+    char       id[13] = {0};
+    uint32_t   nextEventMs = 0;
+    uint32_t   downSinceMs = 0;
+    uint32_t   stormSeen = 0;
+    uint32_t   seq = 0;
+    std::atomic<bool> up{false};
+};
+
+class MeoLoadGen {
+public:
+    void begin();
+    void tick();
+
+private:
+    LoadConfig _cfg;
+    std::vector<SimDevice*> _sims;
+    std::vector<std::thread> _workers;
+    uint32_t _startMs = 0;
+    uint32_t _lastReportMs = 0;
+    uint32_t _reportSecond = 0;
+
+    // Gateway side
+    MeoMqttClient _gw;
+    WiFiClient    _gwSock;
+    char          _gwResponseTopic[MEO_TOPIC_MAX_LEN];
+    char          _gwEventTopic[MEO_TOPIC_MAX_LEN];
+    std::thread   _gwThread;
+
+    // Counters (workers + gateway write, tick() reads)
+    std::atomic<uint32_t> _eventsSent{0};
+    std::atomic<uint32_t> _eventsFailed{0};
+    std::atomic<uint32_t> _eventsRx{0};
+    std::atomic<uint32_t> _invokesSent{0};
+    std::atomic<uint32_t> _responses{0};
+    std::atomic<uint32_t> _up{0};
+    std::atomic<uint32_t> _drops{0};
+    std::atomic<uint32_t> _stormEpoch{0};
+    std::atomic<bool>     _stop{false};
+    uint32_t _allUpMs = 0;
+    uint32_t _stormStartMs = 0;
+    uint32_t _stormRecoveredMs = 0;
+    uint32_t _attemptsBeforeStorm = 0;
+    uint32_t _lastSent = 0, _lastRx = 0, _lastResp = 0; // previous progress line
+
+    // Invoke latency: gateway thread only. Recovery/startup: guarded by _histLock.
+    MeoLatencyHistogram _invokeLatency;
+    MeoLatencyHistogram _recoveryMs;   // recorded in ms: a storm outlives the us range
+    MeoLatencyHistogram _startupMs;
+    std::mutex          _histLock;
+
+    void _loadConfig();
+    bool _provision();
+    void _worker(size_t first, size_t step);
+    void _stepSim(SimDevice& s, uint32_t now, uint32_t eventPeriodMs);
+    void _gateway();
+    void _sendInvoke(SimDevice& s);
+    void _report(bool final);
+    uint32_t _totalAttempts() const;
+    void     _totalTraffic(uint32_t& messages, uint32_t& bytes) const;
+
+    static void _onEcho(const MeoFeatureCall& call, void* ctx);
+    static bool _gwSession(MeoMqttState step, void* ctx);
+    static void _gwMessage(const char* topic, const uint8_t* payload, unsigned int length, void* ctx);
+};
+
+static MeoLoadGen loadgen;
+
+// ---- setup ----
+
+void MeoLoadGen::_loadConfig() {
+    _cfg.host         = envStr("MEO_LOAD_BROKER", _cfg.host);
+    _cfg.port         = (uint16_t)envU32("MEO_LOAD_PORT", _cfg.port);
+    _cfg.devices      = envU32("MEO_LOAD_DEVICES", _cfg.devices);
+    _cfg.threads      = envU32("MEO_LOAD_THREADS", _cfg.threads);
+    _cfg.eventHz      = envFloat("MEO_LOAD_EVENT_HZ", _cfg.eventHz);
+    _cfg.invokeHz     = envFloat("MEO_LOAD_INVOKE_HZ", _cfg.invokeHz);
+    _cfg.seconds      = envU32("MEO_LOAD_SECONDS", _cfg.seconds);
+    _cfg.stormAtS     = envU32("MEO_LOAD_STORM_AT", _cfg.stormAtS);
+    _cfg.backoffMinMs = envU32("MEO_LOAD_BACKOFF_MIN_MS", _cfg.backoffMinMs);
+    _cfg.backoffMaxMs = envU32("MEO_LOAD_BACKOFF_MAX_MS", _cfg.backoffMaxMs);
+    _cfg.userId       = envStr("MEO_LOAD_USER", _cfg.userId);
+    _cfg.txKey        = envStr("MEO_LOAD_TX_KEY", _cfg.txKey);
+    _cfg.watchEvents  = envU32("MEO_LOAD_WATCH_EVENTS", 0) != 0;
+    _cfg.batchMs      = envU32("MEO_LOAD_BATCH_MS", _cfg.batchMs);
+    _cfg.batchBytes   = envU32("MEO_LOAD_BATCH_BYTES", _cfg.batchBytes);
+    if (_cfg.devices == 0) _cfg.devices = 1;
+    if (_cfg.devices > 0xFFFFFF) _cfg.devices = 0xFFFFFF; // three MAC bytes
+    if (_cfg.threads == 0) _cfg.threads = 1;
+    if (_cfg.threads > _cfg.devices) _cfg.threads = _cfg.devices;
+}
+
+// Every simulated device shares one NVS namespace: seed the credentials once
+bool MeoLoadGen::_provision() {
+    setenv("MEO_NATIVE_NVS", ".meo_nvs_load", 0);
+    MeoStorage storage;
+    return storage.begin() &&
+           storage.saveCString("tx_key", _cfg.txKey) &&
+           storage.saveCString("user_id", _cfg.userId) &&
+           storage.commit();
+}
+
+void MeoLoadGen::begin() {
+    _loadConfig();
+    if (!_provision()) {
+        Serial.println("loadgen: could not seed credentials");
+        _Exit(1);
+    }
+    Serial.printf("loadgen: %u devices, %u threads, %.2f ev/s/device, %.1f invokes/s, batch %u ms, %u s -> %s:%u\n",
+                  (unsigned)_cfg.devices, (unsigned)_cfg.threads, _cfg.eventHz, _cfg.invokeHz,
+                  (unsigned)_cfg.batchMs, (unsigned)_cfg.seconds, _cfg.host, (unsigned)_cfg.port);
+
+    _startMs = millis();
+    _sims.reserve(_cfg.devices);
+    for (uint32_t i = 0; i < _cfg.devices; ++i) {
+        SimDevice* s = new SimDevice();
+        uint8_t mac[6] = {MAC_PREFIX[0], MAC_PREFIX[1], MAC_PREFIX[2],
+                          (uint8_t)(i >> 16), (uint8_t)(i >> 8), (uint8_t)i};
+        snprintf(s->id, sizeof(s->id), "%02X%02X%02X%02X%02X%02X",
+                 mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+        s->dev.setDeviceInfo("MEO Load Node", "MEO");
+        s->dev.setMacAddress(mac);
+        s->dev.setGateway(_cfg.host, _cfg.port);
+        s->dev.setMqttTransport(&s->sock);
+        s->dev.setMqttBackoff(_cfg.backoffMinMs, _cfg.backoffMaxMs);
+        s->dev.setOfflineQueue(false);
+        s->dev.addFeatureEvent(EVENT_NAME);
+        if (_cfg.batchMs) s->dev.setEventBatching(_cfg.batchMs, _cfg.batchBytes);
+        s->dev.addFeatureMethod(METHOD_NAME, &MeoLoadGen::_onEcho, s);
+        s->dev.beginWifi("loadgen", "loadgen");
+        if (!s->dev.start()) {
+            Serial.printf("loadgen: device %s did not start\n", s->id);
+            _Exit(1);
+        }
+        _sims.push_back(s);
+    }
+
+    for (uint32_t t = 0; t < _cfg.threads; ++t) {
+        _workers.emplace_back(&MeoLoadGen::_worker, this, (size_t)t, (size_t)_cfg.threads);
+    }
+    _gwThread = std::thread(&MeoLoadGen::_gateway, this);
+    _lastReportMs = millis();
+}
+
+// ---- devices ----
+
+void MeoLoadGen::_onEcho(const MeoFeatureCall& call, void* ctx) {
+    SimDevice* s = reinterpret_cast<SimDevice*>(ctx);
+    // Echo the gateway's send timestamp back as the response message
+    char msg[16];
+    snprintf(msg, sizeof(msg), "%lu", (unsigned long)call.getInt("t"));
+    s->dev.sendFeatureResponse(call, true, msg);
+}
+
+void MeoLoadGen::_worker(size_t first, size_t step) {
+    uint32_t eventPeriodMs = _cfg.eventHz > 0 ? (uint32_t)(1000.0f / _cfg.eventHz) : 0;
+    if (_cfg.eventHz > 0 && eventPeriodMs == 0) eventPeriodMs = 1;
+    // Spread first events over one period so the fleet does not publish in lockstep
+    for (size_t i = first; i < _sims.size(); i += step) {
+        _sims[i]->nextEventMs = millis() + (eventPeriodMs ? esp_random() % eventPeriodMs : 0);
+    }
+    while (!_stop.load(std::memory_order_relaxed)) {
+        uint32_t passStart = millis();
+        for (size_t i = first; i < _sims.size(); i += step) {
+            _stepSim(*_sims[i], millis(), eventPeriodMs);
+        }
+        if (millis() == passStart) delay(1); // idle pass: give the scheduler back
+    }
+}
+
+void MeoLoadGen::_stepSim(SimDevice& s, uint32_t now, uint32_t eventPeriodMs) {
+    uint32_t epoch = _stormEpoch.load(std::memory_order_relaxed);
+    if (epoch != s.stormSeen) {
+        s.stormSeen = epoch;
+        s.sock.stop(); // the state machine sees the session drop on its next step
+    }
+
+    s.dev.loop();
+
+    bool declared = s.dev.mqttState() == MeoMqttState::DECLARED;
+    if (declared && !s.up.load(std::memory_order_relaxed)) {
+        s.up.store(true, std::memory_order_relaxed);
+        _up.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(_histLock);
+        if (s.downSinceMs) _recoveryMs.record(now - s.downSinceMs);
+        else               _startupMs.record(now - _startMs);
+    } else if (!declared && s.up.load(std::memory_order_relaxed)) {
+        s.up.store(false, std::memory_order_relaxed);
+        _up.fetch_sub(1, std::memory_order_relaxed);
+        _drops.fetch_add(1, std::memory_order_relaxed);
+        s.downSinceMs = now ? now : 1;
+    }
+
+    if (!declared || !eventPeriodMs || (int32_t)(now - s.nextEventMs) < 0) return;
+    s.nextEventMs += eventPeriodMs;
+    if ((int32_t)(now - s.nextEventMs) > (int32_t)eventPeriodMs) s.nextEventMs = now; // fell behind: no burst
+    MeoStaticEventFields<2> fields;
+    fields.add("seq", s.seq++);
+    fields.add("uptime_ms", now);
+    if (s.dev.publishEvent(EVENT_NAME, fields)) _eventsSent.fetch_add(1, std::memory_order_relaxed);
+    else                                        _eventsFailed.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t MeoLoadGen::_totalAttempts() const {
+    // Racy read of per-device counters; good enough for a report
+    uint32_t n = 0;
+    for (const SimDevice* s : _sims) n += s->dev.mqttConnectAttempts();
+    return n;
+}
+
+// Event messages on the wire (a batch counts once) and all MQTT bytes the devices wrote
+void MeoLoadGen::_totalTraffic(uint32_t& messages, uint32_t& bytes) const {
+    uint32_t batched = 0, batches = 0;
+    bytes = 0;
+    for (const SimDevice* s : _sims) {
+        const MeoEventBatchStats& b = s->dev.eventBatchStats();
+        batched += b.events;
+        batches += b.batches;
+        bytes += s->dev.mqttBytesSent();
+    }
+    messages = _eventsSent.load() - batched + batches;
+}
+
+// ---- gateway ----
+
+bool MeoLoadGen::_gwSession(MeoMqttState step, void* ctx) {
+    MeoLoadGen* self = reinterpret_cast<MeoLoadGen*>(ctx);
+    if (step != MeoMqttState::SUBSCRIBED) return true;
+    if (!self->_gw.subscribe(self->_gwResponseTopic)) return false;
+    return !self->_cfg.watchEvents || self->_gw.subscribe(self->_gwEventTopic);
+}
+
+void MeoLoadGen::_gwMessage(const char* topic, const uint8_t* payload, unsigned int length, void* ctx) {
+    MeoLoadGen* self = reinterpret_cast<MeoLoadGen*>(ctx);
+    size_t topicLen = strlen(topic);
+    static const char RESPONSE[] = "/feature_response";
+    if (topicLen < sizeof(RESPONSE) - 1 || strcmp(topic + topicLen - (sizeof(RESPONSE) - 1), RESPONSE) != 0) {
+        uint32_t events = 1;
+        if (self->_cfg.batchMs) {
+            // Batch: one array entry per event
+            static const char ENTRY[] = "{\"event\":";
+            events = 0;
+            for (unsigned i = 0; i + sizeof(ENTRY) - 1 <= length; ++i) {
+                if (memcmp(payload + i, ENTRY, sizeof(ENTRY) - 1) == 0) events++;
+            }
+        }
+        self->_eventsRx.fetch_add(events, std::memory_order_relaxed);
+        return;
+    }
+    StaticJsonDocument<256> doc;
+    if (deserializeJson(doc, (const char*)payload, length) != DeserializationError::Ok) return;
+    const char* message = doc["message"].as<const char*>();
+    if (!message || !doc["success"].as<bool>()) return;
+    uint32_t sentUs = (uint32_t)strtoul(message, nullptr, 10);
+    self->_invokeLatency.record(micros() - sentUs);
+    self->_responses.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MeoLoadGen::_sendInvoke(SimDevice& s) {
+    char topic[MEO_TOPIC_MAX_LEN];
+    int n = snprintf(topic, sizeof(topic), "meo/%s/%s/feature/%s/invoke", _cfg.userId, s.id, METHOD_NAME);
+    if (n <= 0 || (size_t)n >= sizeof(topic)) return;
+    char payload[48];
+    snprintf(payload, sizeof(payload), "{\"params\":{\"t\":%lu}}", (unsigned long)micros());
+    if (_gw.publish(topic, payload)) _invokesSent.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MeoLoadGen::_gateway() {
+    snprintf(_gwResponseTopic, sizeof(_gwResponseTopic), "meo/%s/+/event/feature_response", _cfg.userId);
+    snprintf(_gwEventTopic, sizeof(_gwEventTopic), "meo/%s/+/event/%s", _cfg.userId,
+             _cfg.batchMs ? "batch" : EVENT_NAME);
+    _gw.configure(_cfg.host, _cfg.port);
+    _gw.setCredentials("loadgen-gateway", _cfg.txKey);
+    _gw.setTransport(&_gwSock);
+    _gw.setBackoff(200, 2000);
+    _gw.setSessionHandler(&MeoLoadGen::_gwSession, this);
+    _gw.setMessageHandler(&MeoLoadGen::_gwMessage, this);
+    _gw.setAutoConnect(true);
+
+    double intervalUs = _cfg.invokeHz > 0 ? 1e6 / _cfg.invokeHz : 0;
+    double nextUs = micros();
+    size_t cursor = 0;
+    while (!_stop.load(std::memory_order_relaxed)) {
+        _gw.loop();
+        if (intervalUs <= 0 || _gw.state() != MeoMqttState::DECLARED) { delay(1); continue; }
+        double now = micros();
+        if (now < nextUs) { delayMicroseconds(200); continue; }
+        nextUs += intervalUs;
+        if (now - nextUs > 1e6) nextUs = now; // more than a second behind: drop the backlog
+        // Next connected device, at most one full lap
+        for (size_t tried = 0; tried < _sims.size(); ++tried) {
+            SimDevice& s = *_sims[cursor];
+            cursor = (cursor + 1) % _sims.size();
+            if (s.up.load(std::memory_order_relaxed)) { _sendInvoke(s); break; }
+        }
+    }
+}
+
+// ---- reporting ----
+
+void MeoLoadGen::tick() {
+    uint32_t now = millis();
+    uint32_t up = _up.load(std::memory_order_relaxed);
+    if (!_allUpMs && up == _sims.size()) _allUpMs = now - _startMs;
+
+    if (_cfg.stormAtS && !_stormStartMs && now - _startMs >= _cfg.stormAtS * 1000) {
+        _attemptsBeforeStorm = _totalAttempts();
+        _stormStartMs = now;
+        _stormEpoch.fetch_add(1, std::memory_order_relaxed);
+        Serial.printf("loadgen: storm: dropping %u connections\n", (unsigned)up);
+    } else if (_stormStartMs && !_stormRecoveredMs && now - _stormStartMs > 100 && up == _sims.size()) {
+        _stormRecoveredMs = now - _stormStartMs;
+    }
+
+    if (now - _lastReportMs >= 1000) {
+        _lastReportMs += 1000;
+        _reportSecond++;
+        _report(false);
+    }
+    if (now - _startMs >= _cfg.seconds * 1000) {
+        _stop.store(true);
+        _report(true);
+        Serial.flush();
+        _Exit(0); // simulated devices own sockets and threads: skip static destructors
+    }
+}
+
+void MeoLoadGen::_report(bool final) {
+    uint32_t sent = _eventsSent.load(), rx = _eventsRx.load(), resp = _responses.load();
+    if (!final) {
+        Serial.printf("t=%3us up=%u/%u ev_tx=%u/s ev_rx=%u/s inv=%u/s p50=%uus p99=%uus drops=%u\n",
+                      (unsigned)_reportSecond, (unsigned)_up.load(), (unsigned)_sims.size(),
+                      (unsigned)(sent - _lastSent), (unsigned)(rx - _lastRx), (unsigned)(resp - _lastResp),
+                      (unsigned)_invokeLatency.percentileUs(50), (unsigned)_invokeLatency.percentileUs(99),
+                      (unsigned)_drops.load());
+        _lastSent = sent; _lastRx = rx; _lastResp = resp;
+        return;
+    }
+
+    float secs = (millis() - _startMs) / 1000.0f;
+    char invoke[160], startup[160], recovery[160];
+    _invokeLatency.formatJson(invoke, sizeof(invoke));
+    {
+        std::lock_guard<std::mutex> lock(_histLock);
+        _startupMs.formatJson(startup, sizeof(startup));
+        _recoveryMs.formatJson(recovery, sizeof(recovery));
+    }
+    uint32_t attempts = _totalAttempts();
+    uint32_t messages = 0, bytes = 0;
+    _totalTraffic(messages, bytes);
+    Serial.printf("{\"suite\":\"meo3-load\",\"schema\":1,\"broker\":\"%s:%u\",\"devices\":%u,\"threads\":%u,\"seconds\":%.1f,"
+                  "\"event_hz\":%.3f,\"invoke_hz\":%.1f,\"batch_ms\":%u,"
+                  "\"events\":{\"sent\":%u,\"failed\":%u,\"rx\":%u,\"sent_per_s\":%.1f,\"rx_per_s\":%.1f,"
+                  "\"messages\":%u,\"messages_per_s\":%.1f,\"mqtt_bytes\":%u,\"bytes_per_event\":%.1f},"
+                  "\"invokes\":{\"sent\":%u,\"responses\":%u,\"latency_us\":%s},"
+                  "\"startup\":{\"all_up_ms\":%u,\"ready_ms\":%s},"
+                  "\"storm\":{\"at_s\":%u,\"recovered_ms\":%u,\"drops\":%u,\"attempts\":%u,\"recovery_ms\":%s},"
+                  "\"connect_attempts\":%u}\n",
+                  _cfg.host, (unsigned)_cfg.port,
+                  (unsigned)_sims.size(), (unsigned)_cfg.threads, secs, _cfg.eventHz, _cfg.invokeHz,
+                  (unsigned)_cfg.batchMs,
+                  (unsigned)sent, (unsigned)_eventsFailed.load(), (unsigned)rx,
+                  secs > 0 ? sent / secs : 0.0f, secs > 0 ? rx / secs : 0.0f,
+                  (unsigned)messages, secs > 0 ? messages / secs : 0.0f,
+                  (unsigned)bytes, sent ? (float)bytes / sent : 0.0f,
+                  (unsigned)_invokesSent.load(), (unsigned)resp, invoke,
+                  (unsigned)_allUpMs, startup,
+                  (unsigned)_cfg.stormAtS, (unsigned)_stormRecoveredMs, (unsigned)_drops.load(),
+                  (unsigned)(_stormStartMs ? attempts - _attemptsBeforeStorm : 0), recovery,
+                  (unsigned)attempts);
+}
+
+void setup() {
+    Serial.begin(115200);
+    loadgen.begin();
+}
+
+void loop() {
+    loadgen.tick();
+}
@@ -10,17 +10,18 @@ void onTurnOn(const MeoFeatureCall& call) {
     Serial.println("Feature 'turn_on_led' invoked");
     digitalWrite(LED_BUILTIN, HIGH);
 
-    int first = 0, second = 0;
-    for (const auto& kv : call.params) {
-        Serial.printf("  %s = %s\n", kv.first.c_str(), kv.second.c_str());
-        if (kv.first == "first")  first  = atoi(kv.second.c_str());
-        if (kv.first == "second") second = atoi(kv.second.c_str());
-    }
+    // Accepts both {"first": 2} and {"first": "2"}
+    long first  = call.getInt("first");
+    long second = call.getInt("second");
+    Serial.printf("  first = %ld, second = %ld\n", first, second);
     char msg[64];
-    snprintf(msg, sizeof(msg), "LED on, sum=%d", first + second);
+    snprintf(msg, sizeof(msg), "LED on, sum=%ld", first + second);
     meo.sendFeatureResponse(call, true, msg);
 }
 
+// Humidity moves in percent, not degrees
+static const MeoFieldDeadband HUMIDITY_DEADBAND[] = {{"humidity", 0, 2}};
+
 // Optional logger
 void meoLogger(const char* level, const char* message) {
     Serial.print("[");
@@ -40,10 +41,21 @@ void setup() {
     meo.setLogger(meoLogger);
     meo.setDeviceInfo("MEO Test Device", "ThingAI Lab");
     meo.setCloudCompatibleInfo("product-1234", "build-20240601");
+#if defined(MEO_NATIVE)
+    // Host build has no TLS: talk to a local plain-text broker
+    meo.setGateway("127.0.0.1", 1883);
+#else
     meo.setGateway("2cd0d770fc9e4de99263e34330dc866e.s1.eu.hivemq.cloud", 8883);
+#endif
     meo.setDebugTags("DEVICE,MQTT,PROV");
     meo.addFeatureMethod("turn_on_led", onTurnOn);
-    meo.addFeatureEvent("humid_temp_update");
+    // Report on a 0.5 C / 2 % change, at least once a minute
+    MeoEventPolicy policy;
+    policy.absolute      = 0.5f;
+    policy.fields        = HUMIDITY_DEADBAND;
+    policy.fieldCount    = 1;
+    policy.maxIntervalMs = 60000;
+    meo.addFeatureEvent("humid_temp_update", policy);
 
     meo.start();
 }
@@ -54,11 +66,12 @@ void loop() {
     static uint32_t last = 0;
     if (millis() - last > 5000 && meo.isMqttConnected()) {
         last = millis();
-        MeoEventPayload p;
-        p["temperature"] = std::to_string(random(200, 300) / 10);
-        p["humidity"]    = std::to_string(random(400, 600) / 10);
+        MeoStaticEventFields<2> p;
+        p.add("temperature", random(200, 300) / 10.0f);
+        p.add("humidity",    random(400, 600) / 10.0f);
+        // Returns true when the policy skips an unchanged reading, too
         bool success = meo.publishEvent("humid_temp_update", p);
-        meoLogger("INFO", success ? "Published humid_temp_update event" : "Failed to publish event");
+        if (!success) meoLogger("INFO", "Failed to publish event");
     }
 }
 
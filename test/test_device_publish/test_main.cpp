@@ -0,0 +1,208 @@
+// MeoDevice::publishEvent() end to end: start() from seeded storage, connect and
+// declare against a scripted broker, then no heap use per event (a counting
+// global operator new catches any allocation between the publishes).
+
+#include <unity.h>
+#include <Meo3_Device.h>
+
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char* NVS_DIR  = "test_device_publish.nvs";
+static const char* NVS_FILE = "test_device_publish.nvs/meo.bin";
+
+static const uint32_t EVENTS = 200;
+
+static size_t allocations = 0;
+
+void* operator new(size_t n) {
+    allocations++;
+    void* p = malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// Broker end of the socket, without heap of its own: answers CONNECT and
+// PINGREQ, counts and discards everything else
+class ScriptedBroker : public Client {
+public:
+    uint32_t publishes = 0;
+
+    int connect(IPAddress ip, uint16_t port) override { (void)ip; return connect("", port); }
+    int connect(const char* host, uint16_t port) override {
+        (void)host; (void)port;
+        _open = true;
+        _rxLen = _rxPos = 0;
+        _parse = Parse::TYPE;
+        return 1;
+    }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t len) override {
+        if (!_open) return 0;
+        for (size_t i = 0; i < len; ++i) _feed(buf[i]);
+        return len;
+    }
+    int     available() override { return (int)(_rxLen - _rxPos); }
+    int     read() override { return _rxPos < _rxLen ? _rx[_rxPos++] : -1; }
+    int     read(uint8_t* buf, size_t len) override {
+        size_t n = 0;
+        while (n < len && _rxPos < _rxLen) buf[n++] = _rx[_rxPos++];
+        return (int)n;
+    }
+    int     peek() override { return _rxPos < _rxLen ? _rx[_rxPos] : -1; }
+    void    flush() override {}
+    void    stop() override { _open = false; }
+    uint8_t connected() override { return _open; }
+    operator bool() override { return _open; }
+    using Print::write;
+
+private:
+    enum class Parse : uint8_t { TYPE, LENGTH, BODY };
+
+    bool     _open = false;
+    uint8_t  _rx[64];
+    size_t   _rxLen = 0;
+    size_t   _rxPos = 0;
+    Parse    _parse = Parse::TYPE;
+    uint8_t  _type = 0;
+    uint32_t _remaining = 0;
+    uint32_t _mul = 1;
+
+    void _push(const uint8_t* bytes, size_t len) {
+        if (_rxPos == _rxLen) _rxLen = _rxPos = 0;
+        for (size_t i = 0; i < len && _rxLen < sizeof(_rx); ++i) _rx[_rxLen++] = bytes[i];
+    }
+    void _feed(uint8_t b) {
+        switch (_parse) {
+            case Parse::TYPE:
+                _type = b & 0xF0;
+                _remaining = 0;
+                _mul = 1;
+                _parse = Parse::LENGTH;
+                break;
+            case Parse::LENGTH:
+                _remaining += (b & 0x7F) * _mul;
+                _mul *= 128;
+                if (b & 0x80) break;
+                _parse = _remaining ? Parse::BODY : Parse::TYPE;
+                if (!_remaining) _onPacket();
+                break;
+            case Parse::BODY:
+                if (--_remaining) break;
+                _parse = Parse::TYPE;
+                _onPacket();
+                break;
+        }
+    }
+    void _onPacket() {
+        static const uint8_t CONNACK[]  = {0x20, 0x02, 0x00, 0x00};
+        static const uint8_t PINGRESP[] = {0xD0, 0x00};
+        switch (_type) {
+            case 0x10: _push(CONNACK, sizeof(CONNACK)); break;
+            case 0xC0: _push(PINGRESP, sizeof(PINGRESP)); break;
+            case 0x30: publishes++; break;
+            default: break;
+        }
+    }
+};
+
+// start() with WiFi and credentials already in storage, then loop() until declared
+static bool bringUp(MeoDevice& dev, ScriptedBroker& broker) {
+    static const uint8_t MAC[6] = {0xA1, 0xB2, 0xC3, 0xD4, 0xE5, 0xF6};
+    dev.setDeviceInfo("Test Device", "MEO");
+    dev.setMacAddress(MAC);
+    dev.setGateway("broker.test", 1883);
+    dev.setMqttTransport(&broker);
+    if (!dev.start()) return false;
+    for (int i = 0; i < 64 && dev.mqttState() != MeoMqttState::DECLARED; ++i) {
+        dev.loop();
+        delay(1);
+    }
+    return dev.mqttState() == MeoMqttState::DECLARED;
+}
+
+static void fill(MeoEventFields& ev, uint32_t i) {
+    ev.clear();
+    ev.add("temp", 20.0f + (float)(i % 10));
+    ev.add("humidity", (int)(40 + i % 20));
+    ev.add("on", (i & 1) != 0);
+    ev.add("mode", "eco");
+}
+
+void setUp(void) {
+    setenv("MEO_NATIVE_NVS", NVS_DIR, 1);
+    setenv("MEO_NATIVE_PREFS", "wifi_ssid=test;wifi_pass=x;tx_key=key;user_id=u", 1);
+    remove(NVS_FILE);
+}
+
+void tearDown(void) {
+    remove(NVS_FILE);
+}
+
+static void publishesWithoutHeap(MeoPayloadEncoding enc) {
+    ScriptedBroker broker;
+    MeoDevice dev;
+    dev.setPayloadEncoding(enc);
+    TEST_ASSERT_TRUE(dev.addFeatureEvent("climate"));
+    TEST_ASSERT_TRUE(bringUp(dev, broker));
+
+    MeoStaticEventFields<4> ev;
+    fill(ev, 0);
+    TEST_ASSERT_TRUE(dev.publishEvent("climate", ev)); // first use of every path
+    uint32_t before = broker.publishes;
+
+    allocations = 0;
+    for (uint32_t i = 0; i < EVENTS; ++i) {
+        fill(ev, i);
+        if (!dev.publishEvent("climate", ev)) break;
+    }
+    size_t counted = allocations;
+    TEST_ASSERT_EQUAL_UINT32(0, counted);
+    TEST_ASSERT_EQUAL_UINT32(EVENTS, broker.publishes - before);
+}
+
+static void test_publish_event_json_no_heap(void) {
+    publishesWithoutHeap(MeoPayloadEncoding::JSON);
+}
+
+static void test_publish_event_msgpack_no_heap(void) {
+    publishesWithoutHeap(MeoPayloadEncoding::MSGPACK);
+}
+
+// The reporting policy's check/commit on the same path, sent or suppressed
+static void test_publish_event_with_policy_no_heap(void) {
+    ScriptedBroker broker;
+    MeoDevice dev;
+    MeoEventPolicy policy;
+    policy.absolute = 5;
+    TEST_ASSERT_TRUE(dev.addFeatureEvent("climate", policy));
+    TEST_ASSERT_TRUE(bringUp(dev, broker));
+
+    // A 0-9 sawtooth against a deadband of 5: some pass, some are dropped
+    MeoStaticEventFields<1> ev;
+    ev.add("temp", 20.0f);
+    TEST_ASSERT_TRUE(dev.publishEvent("climate", ev));
+
+    allocations = 0;
+    for (uint32_t i = 0; i < EVENTS; ++i) {
+        ev.clear();
+        ev.add("temp", 20.0f + (float)(i % 10));
+        if (!dev.publishEvent("climate", ev)) break;
+    }
+    size_t counted = allocations;
+    TEST_ASSERT_EQUAL_UINT32(0, counted);
+    MeoEventPolicyStats stats = dev.eventPolicyStats("climate");
+    TEST_ASSERT_EQUAL_UINT32(EVENTS + 1, stats.sent + stats.suppressed);
+    TEST_ASSERT_GREATER_THAN(0, stats.suppressed);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_publish_event_json_no_heap);
+    RUN_TEST(test_publish_event_msgpack_no_heap);
+    RUN_TEST(test_publish_event_with_policy_no_heap);
+    return UNITY_END();
+}
@@ -0,0 +1,202 @@
+// MeoEventBatch: array layout in both encodings, budget edges (an entry that
+// exactly fills the limit fits, one byte more does not), and failed adds
+// leaving the batch unchanged.
+
+#include <unity.h>
+#include <queue/Meo3_EventBatch.h>
+
+#include <string.h>
+#include <string>
+
+static std::string payload(MeoEventBatch& b) {
+    size_t len = 0;
+    const char* p = b.finish(len);
+    return std::string(p, len);
+}
+
+static void assertPayload(const std::string& expected, MeoEventBatch& b) {
+    std::string out = payload(b);
+    TEST_ASSERT_EQUAL_UINT32(expected.size(), out.size());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected.data(), out.data(), expected.size());
+}
+
+static std::string bytes(std::initializer_list<int> b) {
+    std::string s;
+    for (int c : b) s.push_back((char)c);
+    return s;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_empty_batch(void) {
+    MeoEventBatch b;
+    TEST_ASSERT_TRUE(b.empty());
+    TEST_ASSERT_EQUAL_UINT32(MEO_EVENT_BATCH_BYTES, b.limit());
+    size_t len = 1;
+    b.finish(len);
+    TEST_ASSERT_EQUAL_UINT32(0, len);
+}
+
+static void test_json_layout(void) {
+    MeoEventBatch b;
+    MeoStaticEventFields<2> v;
+    v.add("v", 1);
+    v.add("ok", true);
+    MeoStaticEventFields<1> none;
+    TEST_ASSERT_TRUE(b.add("temp", v, 5));
+    TEST_ASSERT_TRUE(b.add("door", none, 4294967295u));
+    TEST_ASSERT_EQUAL_UINT16(2, b.count());
+    TEST_ASSERT_EQUAL_UINT32(5, b.firstMs());
+
+    const char* expected = "[{\"event\":\"temp\",\"ts\":5,\"data\":{\"v\":1,\"ok\":true}},"
+                           "{\"event\":\"door\",\"ts\":4294967295,\"data\":{}}]";
+    assertPayload(expected, b);
+    // finish() does not consume: the same payload again, and more can follow
+    assertPayload(expected, b);
+    TEST_ASSERT_EQUAL_UINT32(strlen(expected) - 1, b.bytes());
+
+    b.clear();
+    TEST_ASSERT_TRUE(b.empty());
+    TEST_ASSERT_TRUE(b.add("door", none, 9));
+    TEST_ASSERT_EQUAL_UINT32(9, b.firstMs());
+    assertPayload("[{\"event\":\"door\",\"ts\":9,\"data\":{}}]", b);
+}
+
+// Names are copied verbatim, so ones that would need escaping are refused
+static void test_json_refuses_escaped_names(void) {
+    MeoEventBatch b;
+    MeoStaticEventFields<1> none;
+    TEST_ASSERT_FALSE(b.add("a\"b", none, 0));
+    TEST_ASSERT_FALSE(b.add("a\\b", none, 0));
+    TEST_ASSERT_FALSE(b.add(nullptr, none, 0));
+    TEST_ASSERT_TRUE(b.empty());
+}
+
+static void test_json_budget_edge(void) {
+    MeoStaticEventFields<1> v;
+    v.add("v", 12345);
+    const std::string one = "[{\"event\":\"e\",\"ts\":1,\"data\":{\"v\":12345}}]";
+
+    MeoEventBatch b;
+    b.setLimit(one.size());
+    TEST_ASSERT_TRUE(b.add("e", v, 1));
+    assertPayload(one, b);
+
+    b.setLimit(one.size() - 1);
+    TEST_ASSERT_FALSE(b.add("e", v, 1));
+    TEST_ASSERT_TRUE(b.empty());
+}
+
+// A refused add leaves the earlier entries as they were
+static void test_full_batch_unchanged(void) {
+    MeoStaticEventFields<1> v;
+    v.add("v", 1);
+    MeoEventBatch b;
+    b.setLimit(100);
+    int added = 0;
+    while (b.add("event", v, (uint32_t)added)) added++;
+    TEST_ASSERT_GREATER_THAN(1, added);
+    std::string before = payload(b);
+    TEST_ASSERT_LESS_OR_EQUAL(100, before.size());
+    TEST_ASSERT_FALSE(b.add("e", v, 99));
+    TEST_ASSERT_EQUAL_UINT16(added, b.count());
+    assertPayload(before, b);
+}
+
+static void test_limit_is_clamped(void) {
+    MeoEventBatch b;
+    b.setLimit(100000);
+    TEST_ASSERT_EQUAL_UINT32(MEO_EVENT_BATCH_BYTES, b.limit());
+    b.setLimit(1);
+    TEST_ASSERT_EQUAL_UINT32(16, b.limit());
+}
+
+// Largest batch the full budget holds, written to the last byte
+static void test_full_budget(void) {
+    MeoStaticEventFields<1> v;
+    v.add("v", 1);
+    for (MeoPayloadEncoding enc : {MeoPayloadEncoding::JSON, MeoPayloadEncoding::MSGPACK}) {
+        MeoEventBatch b;
+        b.setEncoding(enc);
+        while (b.add("e", v, 0)) {}
+        std::string out = payload(b);
+        TEST_ASSERT_LESS_OR_EQUAL(MEO_EVENT_BATCH_BYTES, out.size());
+        TEST_ASSERT_GREATER_THAN(MEO_EVENT_BATCH_BYTES - 40, out.size());
+    }
+}
+
+static void test_msgpack_layout(void) {
+    MeoEventBatch b;
+    b.setEncoding(MeoPayloadEncoding::MSGPACK);
+    MeoStaticEventFields<1> v;
+    v.add("v", 1);
+    TEST_ASSERT_TRUE(b.add("t", v, 0x01020304));
+    const std::string entry = bytes({0x83, 0xA5, 'e', 'v', 'e', 'n', 't', 0xA1, 't',
+                                     0xA2, 't', 's', 0xCE, 0x01, 0x02, 0x03, 0x04,
+                                     0xA4, 'd', 'a', 't', 'a', 0x81, 0xA1, 'v', 0x01});
+    assertPayload(bytes({0xDC, 0x00, 0x01}) + entry, b);
+
+    TEST_ASSERT_TRUE(b.add("t", v, 0x01020304));
+    assertPayload(bytes({0xDC, 0x00, 0x02}) + entry + entry, b);
+}
+
+// Names of 32 characters or more take a str 8 header; past 255 they are refused
+static void test_msgpack_long_names(void) {
+    MeoEventBatch b;
+    b.setEncoding(MeoPayloadEncoding::MSGPACK);
+    MeoStaticEventFields<1> none;
+    std::string name(40, 'n');
+    TEST_ASSERT_TRUE(b.add(name.c_str(), none, 0));
+    std::string out = payload(b);
+    std::string head = bytes({0xD9, 40}) + name;
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(head.data(), out.data() + 3 + 7, head.size());
+    TEST_ASSERT_EQUAL_UINT32(3 + 7 + 2 + 40 + 8 + 5 + 1, out.size());
+
+    std::string huge(256, 'n');
+    TEST_ASSERT_FALSE(b.add(huge.c_str(), none, 0));
+    TEST_ASSERT_EQUAL_UINT16(1, b.count());
+}
+
+static void test_msgpack_budget_edge(void) {
+    MeoStaticEventFields<1> v;
+    v.add("v", 1);
+    // 3 array header + 26 entry
+    MeoEventBatch b;
+    b.setEncoding(MeoPayloadEncoding::MSGPACK);
+    b.setLimit(29);
+    TEST_ASSERT_TRUE(b.add("t", v, 0));
+    size_t len = 0;
+    b.finish(len);
+    TEST_ASSERT_EQUAL_UINT32(29, len);
+
+    b.setLimit(28);
+    TEST_ASSERT_FALSE(b.add("t", v, 0));
+    TEST_ASSERT_TRUE(b.empty());
+}
+
+// Switching encoding drops what was pending in the old one
+static void test_set_encoding_clears(void) {
+    MeoEventBatch b;
+    MeoStaticEventFields<1> none;
+    TEST_ASSERT_TRUE(b.add("a", none, 0));
+    b.setEncoding(MeoPayloadEncoding::MSGPACK);
+    TEST_ASSERT_TRUE(b.empty());
+    TEST_ASSERT_EQUAL_UINT32(0, b.bytes());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_batch);
+    RUN_TEST(test_json_layout);
+    RUN_TEST(test_json_refuses_escaped_names);
+    RUN_TEST(test_json_budget_edge);
+    RUN_TEST(test_full_batch_unchanged);
+    RUN_TEST(test_limit_is_clamped);
+    RUN_TEST(test_full_budget);
+    RUN_TEST(test_msgpack_layout);
+    RUN_TEST(test_msgpack_long_names);
+    RUN_TEST(test_msgpack_budget_edge);
+    RUN_TEST(test_set_encoding_clears);
+    return UNITY_END();
+}
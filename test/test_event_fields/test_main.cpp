@@ -0,0 +1,258 @@
+// MeoEventFields: typed fields, capacity, and the JSON and MessagePack writers
+// (escaping, integer and string widths, measure == serialize == stream).
+
+#include <unity.h>
+#include <Meo3_EventFields.h>
+
+#include <math.h>
+#include <string.h>
+#include <string>
+
+// Collects streamed output
+class StringSink : public MeoByteSink {
+public:
+    std::string out;
+    void append(const char* data, size_t len) override { out.append(data, len); }
+};
+
+// measureJson(), serializeJson() and writeJson() must agree byte for byte
+static void assertJson(const char* expected, const MeoEventFields& ev) {
+    char buf[256];
+    size_t len = strlen(expected);
+    TEST_ASSERT_EQUAL_UINT32(len, ev.measureJson());
+    TEST_ASSERT_EQUAL_UINT32(len, ev.serializeJson(buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING(expected, buf);
+    StringSink sink;
+    TEST_ASSERT_EQUAL_UINT32(len, ev.writeJson(sink));
+    TEST_ASSERT_EQUAL_STRING(expected, sink.out.c_str());
+}
+
+// Same for the MessagePack writer, against the expected bytes
+static void assertMsgPack(const std::string& expected, const MeoEventFields& ev) {
+    uint8_t buf[512];
+    TEST_ASSERT_EQUAL_UINT32(expected.size(), ev.measureMsgPack());
+    TEST_ASSERT_EQUAL_UINT32(expected.size(), ev.serializeMsgPack(buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected.data(), buf, expected.size());
+    StringSink sink;
+    TEST_ASSERT_EQUAL_UINT32(expected.size(), ev.writeMsgPack(sink));
+    TEST_ASSERT_TRUE(expected == sink.out);
+}
+
+// Bytes from a list of values (keeps embedded zeros)
+static std::string bytes(std::initializer_list<int> b) {
+    std::string s;
+    for (int c : b) s.push_back((char)c);
+    return s;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_empty_object(void) {
+    MeoStaticEventFields<2> ev;
+    assertJson("{}", ev);
+}
+
+static void test_types(void) {
+    MeoStaticEventFields<6> ev;
+    TEST_ASSERT_TRUE(ev.add("temperature", 23.5f));
+    TEST_ASSERT_TRUE(ev.add("humidity", 51));
+    TEST_ASSERT_TRUE(ev.add("on", true));
+    TEST_ASSERT_TRUE(ev.add("off", false));
+    TEST_ASSERT_TRUE(ev.add("mode", "auto"));
+    TEST_ASSERT_TRUE(ev.add("label", (const char*)nullptr));
+    assertJson("{\"temperature\":23.5,\"humidity\":51,\"on\":true,\"off\":false,"
+               "\"mode\":\"auto\",\"label\":null}", ev);
+}
+
+static void test_integer_range(void) {
+    MeoStaticEventFields<4> ev;
+    ev.add("zero", 0);
+    ev.add("neg", -42);
+    ev.add("max", (long long)9223372036854775807LL);
+    ev.add("min", (long long)(-9223372036854775807LL - 1));
+    assertJson("{\"zero\":0,\"neg\":-42,\"max\":9223372036854775807,\"min\":-9223372036854775808}", ev);
+}
+
+static void test_floats(void) {
+    MeoStaticEventFields<5> ev;
+    ev.add("a", 0.1f);
+    ev.add("b", -1250000.0f);
+    ev.add("c", 1e-7f);
+    ev.add("nan", NAN);
+    ev.add("inf", INFINITY);
+    assertJson("{\"a\":0.1,\"b\":-1250000,\"c\":1e-07,\"nan\":null,\"inf\":null}", ev);
+}
+
+static void test_string_escaping(void) {
+    MeoStaticEventFields<2> ev;
+    ev.add("q\"k", "line\nquote\" back\\ tab\t\x01 cr\r");
+    ev.add("utf8", "\xC3\xA9t\xC3\xA9");
+    assertJson("{\"q\\\"k\":\"line\\nquote\\\" back\\\\ tab\\t\\u0001 cr\\r\",\"utf8\":\"\xC3\xA9t\xC3\xA9\"}", ev);
+}
+
+static void test_capacity_and_clear(void) {
+    MeoStaticEventFields<2> ev;
+    TEST_ASSERT_EQUAL_UINT8(2, ev.capacity());
+    TEST_ASSERT_TRUE(ev.add("a", 1));
+    TEST_ASSERT_TRUE(ev.add("b", 2));
+    TEST_ASSERT_FALSE(ev.add("c", 3));
+    TEST_ASSERT_FALSE(ev.add(nullptr, 3));
+    TEST_ASSERT_EQUAL_UINT8(2, ev.count());
+    assertJson("{\"a\":1,\"b\":2}", ev);
+
+    ev.clear();
+    TEST_ASSERT_EQUAL_UINT8(0, ev.count());
+    TEST_ASSERT_FALSE(ev.add(nullptr, 1));
+    TEST_ASSERT_TRUE(ev.add("c", 3));
+    assertJson("{\"c\":3}", ev);
+}
+
+static void test_serialize_needs_room_for_nul(void) {
+    MeoStaticEventFields<1> ev;
+    ev.add("a", 1); // {"a":1} = 7 bytes
+    char buf[8];
+    TEST_ASSERT_EQUAL_UINT32(7, ev.serializeJson(buf, 8));
+    TEST_ASSERT_EQUAL_STRING("{\"a\":1}", buf);
+    TEST_ASSERT_EQUAL_UINT32(0, ev.serializeJson(buf, 7));
+    TEST_ASSERT_EQUAL_STRING("", buf);
+    TEST_ASSERT_EQUAL_UINT32(0, ev.serializeJson(nullptr, 8));
+    TEST_ASSERT_EQUAL_UINT32(0, ev.serializeJson(buf, 0));
+}
+
+// Keys and values are borrowed: the output reflects the strings at write time
+static void test_values_are_borrowed(void) {
+    char value[8] = "before";
+    MeoStaticEventFields<1> ev;
+    ev.add("v", (const char*)value);
+    strcpy(value, "after");
+    assertJson("{\"v\":\"after\"}", ev);
+}
+
+static void test_msgpack_types(void) {
+    MeoStaticEventFields<5> ev;
+    ev.add("t", 23.5f);
+    ev.add("on", true);
+    ev.add("off", false);
+    ev.add("m", "auto");
+    ev.add("n", (const char*)nullptr);
+    assertMsgPack(bytes({0x85,
+                         0xA1, 't', 0xCA, 0x41, 0xBC, 0x00, 0x00,
+                         0xA2, 'o', 'n', 0xC3,
+                         0xA3, 'o', 'f', 'f', 0xC2,
+                         0xA1, 'm', 0xA4, 'a', 'u', 't', 'o',
+                         0xA1, 'n', 0xC0}), ev);
+}
+
+// Each integer takes the smallest type that holds it
+static void test_msgpack_integer_widths(void) {
+    struct Case { long long v; std::string enc; };
+    const Case cases[] = {
+        {0,            bytes({0x00})},
+        {127,          bytes({0x7F})},
+        {128,          bytes({0xCC, 0x80})},
+        {255,          bytes({0xCC, 0xFF})},
+        {256,          bytes({0xCD, 0x01, 0x00})},
+        {65535,        bytes({0xCD, 0xFF, 0xFF})},
+        {65536,        bytes({0xCE, 0x00, 0x01, 0x00, 0x00})},
+        {4294967295LL, bytes({0xCE, 0xFF, 0xFF, 0xFF, 0xFF})},
+        {4294967296LL, bytes({0xCF, 0, 0, 0, 0x01, 0, 0, 0, 0})},
+        {-1,           bytes({0xFF})},
+        {-32,          bytes({0xE0})},
+        {-33,          bytes({0xD0, 0xDF})},
+        {-128,         bytes({0xD0, 0x80})},
+        {-129,         bytes({0xD1, 0xFF, 0x7F})},
+        {-32768,       bytes({0xD1, 0x80, 0x00})},
+        {-32769,       bytes({0xD2, 0xFF, 0xFF, 0x7F, 0xFF})},
+        {-2147483648LL, bytes({0xD2, 0x80, 0x00, 0x00, 0x00})},
+        {-2147483649LL, bytes({0xD3, 0xFF, 0xFF, 0xFF, 0xFF, 0x7F, 0xFF, 0xFF, 0xFF})},
+        {-9223372036854775807LL - 1, bytes({0xD3, 0x80, 0, 0, 0, 0, 0, 0, 0})},
+    };
+    for (const Case& c : cases) {
+        MeoStaticEventFields<1> ev;
+        ev.add("v", c.v);
+        assertMsgPack(bytes({0x81, 0xA1, 'v'}) + c.enc, ev);
+    }
+}
+
+static void test_msgpack_string_widths(void) {
+    std::string s31(31, 'a'), s32(32, 'b'), s256(256, 'c');
+    MeoStaticEventFields<3> ev;
+    ev.add("a", s31.c_str());
+    ev.add("b", s32.c_str());
+    ev.add("c", s256.c_str());
+    assertMsgPack(bytes({0x83, 0xA1, 'a', 0xBF}) + s31 +
+                  bytes({0xA1, 'b', 0xD9, 0x20}) + s32 +
+                  bytes({0xA1, 'c', 0xDA, 0x01, 0x00}) + s256, ev);
+}
+
+// No escaping: quotes, control characters and UTF-8 go through as they are
+static void test_msgpack_strings_raw(void) {
+    MeoStaticEventFields<1> ev;
+    ev.add("q\"", "a\nb\x01\xC3\xA9");
+    assertMsgPack(bytes({0x81, 0xA2, 'q', '"', 0xA6, 'a', '\n', 'b', 0x01, 0xC3, 0xA9}), ev);
+}
+
+// 16 or more fields need a map 16 header
+static void test_msgpack_map16(void) {
+    static const char* keys[16] = {"a", "b", "c", "d", "e", "f", "g", "h",
+                                   "i", "j", "k", "l", "m", "n", "o", "p"};
+    MeoStaticEventFields<16> ev;
+    std::string expected = bytes({0x8F});
+    for (int i = 0; i < 15; ++i) {
+        ev.add(keys[i], i);
+        expected += bytes({0xA1, keys[i][0], i});
+    }
+    assertMsgPack(expected, ev);
+
+    ev.add(keys[15], 15);
+    expected = bytes({0xDE, 0x00, 0x10});
+    for (int i = 0; i < 16; ++i) expected += bytes({0xA1, keys[i][0], i});
+    assertMsgPack(expected, ev);
+}
+
+static void test_msgpack_serialize_exact_fit(void) {
+    MeoStaticEventFields<1> ev;
+    ev.add("a", 1); // 0x81 0xA1 'a' 0x01: no NUL, so 4 bytes is enough
+    uint8_t buf[4];
+    TEST_ASSERT_EQUAL_UINT32(4, ev.serializeMsgPack(buf, 4));
+    TEST_ASSERT_EQUAL_UINT32(0, ev.serializeMsgPack(buf, 3));
+    TEST_ASSERT_EQUAL_UINT32(0, ev.serializeMsgPack(nullptr, 4));
+}
+
+static void test_encoding_wrappers(void) {
+    MeoStaticEventFields<1> ev;
+    ev.add("a", 1);
+    uint8_t buf[8];
+    TEST_ASSERT_EQUAL_UINT32(7, ev.measure(MeoPayloadEncoding::JSON));
+    TEST_ASSERT_EQUAL_UINT32(7, ev.serialize(MeoPayloadEncoding::JSON, buf, sizeof(buf)));
+    TEST_ASSERT_FALSE(meoIsMsgPackMap(buf, 7));
+    TEST_ASSERT_EQUAL_UINT32(4, ev.measure(MeoPayloadEncoding::MSGPACK));
+    TEST_ASSERT_EQUAL_UINT32(4, ev.serialize(MeoPayloadEncoding::MSGPACK, buf, sizeof(buf)));
+    TEST_ASSERT_TRUE(meoIsMsgPackMap(buf, 4));
+
+    const uint8_t map16[] = {0xDE, 0x00, 0x10}, space[] = {' ', '{'};
+    TEST_ASSERT_TRUE(meoIsMsgPackMap(map16, sizeof(map16)));
+    TEST_ASSERT_FALSE(meoIsMsgPackMap(space, sizeof(space)));
+    TEST_ASSERT_FALSE(meoIsMsgPackMap(map16, 0));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_object);
+    RUN_TEST(test_types);
+    RUN_TEST(test_integer_range);
+    RUN_TEST(test_floats);
+    RUN_TEST(test_string_escaping);
+    RUN_TEST(test_capacity_and_clear);
+    RUN_TEST(test_serialize_needs_room_for_nul);
+    RUN_TEST(test_values_are_borrowed);
+    RUN_TEST(test_msgpack_types);
+    RUN_TEST(test_msgpack_integer_widths);
+    RUN_TEST(test_msgpack_string_widths);
+    RUN_TEST(test_msgpack_strings_raw);
+    RUN_TEST(test_msgpack_map16);
+    RUN_TEST(test_msgpack_serialize_exact_fit);
+    RUN_TEST(test_encoding_wrappers);
+    return UNITY_END();
+}
@@ -0,0 +1,308 @@
+// MeoEventFilter: deadbands (absolute, percent, per field) measured from the
+// last value sent, send-on-change, rate limit and heartbeat, and check/commit
+// so only what went out moves the reference.
+
+#include <unity.h>
+#include <feature/Meo3_EventPolicy.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// check() and, when it passes, commit(): what publishEvent() does on success
+static bool offer(MeoEventFilter& f, const MeoEventFields& ev, uint32_t nowMs) {
+    if (!f.check(ev, nowMs)) {
+        f.suppressed();
+        return false;
+    }
+    f.commit(ev, nowMs);
+    return true;
+}
+
+static bool offerFloat(MeoEventFilter& f, const char* key, float v, uint32_t nowMs) {
+    MeoStaticEventFields<1> ev;
+    ev.add(key, v);
+    return offer(f, ev, nowMs);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_no_policy_sends_everything(void) {
+    MeoEventFilter f(MeoEventPolicy{});
+    for (int i = 0; i < 3; ++i) TEST_ASSERT_TRUE(offerFloat(f, "t", 20.0f, 0));
+    TEST_ASSERT_EQUAL_UINT32(3, f.stats().sent);
+}
+
+static void test_absolute_deadband_edge(void) {
+    MeoEventPolicy p;
+    p.absolute = 0.5f;
+    MeoEventFilter f(p);
+    TEST_ASSERT_TRUE(offerFloat(f, "t", 20.0f, 0));   // first value always goes
+    TEST_ASSERT_FALSE(offerFloat(f, "t", 20.25f, 1));
+    TEST_ASSERT_FALSE(offerFloat(f, "t", 19.75f, 2));
+    TEST_ASSERT_TRUE(offerFloat(f, "t", 20.5f, 3));   // exactly the deadband
+    TEST_ASSERT_TRUE(offerFloat(f, "t", 20.0f, 4));   // and back down
+    TEST_ASSERT_EQUAL_UINT32(3, f.stats().sent);
+    TEST_ASSERT_EQUAL_UINT32(2, f.stats().suppressed);
+}
+
+// Slow drift still crosses the deadband: it is measured from the last value
+// sent, not the last value offered
+static void test_drift_accumulates(void) {
+    MeoEventPolicy p;
+    p.absolute = 1.0f;
+    MeoEventFilter f(p);
+    TEST_ASSERT_TRUE(offerFloat(f, "t", 0.0f, 0));
+    TEST_ASSERT_FALSE(offerFloat(f, "t", 0.25f, 1));
+    TEST_ASSERT_FALSE(offerFloat(f, "t", 0.5f, 2));
+    TEST_ASSERT_FALSE(offerFloat(f, "t", 0.75f, 3));
+    TEST_ASSERT_TRUE(offerFloat(f, "t", 1.0f, 4));
+}
+
+static void test_percent_deadband(void) {
+    MeoEventPolicy p;
+    p.percent = 5;
+    MeoEventFilter f(p);
+    TEST_ASSERT_TRUE(offerFloat(f, "w", 200.0f, 0));
+    TEST_ASSERT_FALSE(offerFloat(f, "w", 209.0f, 1));
+    TEST_ASSERT_FALSE(offerFloat(f, "w", 191.0f, 2));
+    TEST_ASSERT_TRUE(offerFloat(f, "w", 210.0f, 3));
+    // From 0, any move passes the percent test
+    TEST_ASSERT_TRUE(offerFloat(f, "w", 0.0f, 4));
+    TEST_ASSERT_FALSE(offerFloat(f, "w", 0.0f, 5));
+    TEST_ASSERT_TRUE(offerFloat(f, "w", 0.001f, 6));
+}
+
+// Either deadband is enough when both are set
+static void test_absolute_or_percent(void) {
+    MeoEventPolicy p;
+    p.absolute = 10;
+    p.percent = 50;
+    MeoEventFilter f(p);
+    TEST_ASSERT_TRUE(offerFloat(f, "v", 4.0f, 0));
+    TEST_ASSERT_TRUE(offerFloat(f, "v", 6.0f, 1));    // 50% of 4
+    TEST_ASSERT_FALSE(offerFloat(f, "v", 8.0f, 2));   // 33% of 6, under 10
+    TEST_ASSERT_TRUE(offerFloat(f, "v", 100.0f, 3));
+    TEST_ASSERT_FALSE(offerFloat(f, "v", 109.0f, 4)); // 9%, under 10
+    TEST_ASSERT_TRUE(offerFloat(f, "v", 110.0f, 5));  // absolute
+}
+
+static void test_per_field_override(void) {
+    static const MeoFieldDeadband bands[] = {{"humidity", 5.0f, 0}};
+    MeoEventPolicy p;
+    p.absolute = 0.5f;
+    p.fields = bands;
+    p.fieldCount = 1;
+    MeoEventFilter f(p);
+
+    MeoStaticEventFields<2> ev;
+    ev.add("temp", 20.0f);
+    ev.add("humidity", 50.0f);
+    TEST_ASSERT_TRUE(offer(f, ev, 0));
+
+    MeoStaticEventFields<2> small; // humidity moves 4, under its own band
+    small.add("temp", 20.25f);
+    small.add("humidity", 54.0f);
+    TEST_ASSERT_FALSE(offer(f, small, 1));
+
+    MeoStaticEventFields<2> temp; // temp crosses the default band
+    temp.add("temp", 20.5f);
+    temp.add("humidity", 54.0f);
+    TEST_ASSERT_TRUE(offer(f, temp, 2));
+
+    MeoStaticEventFields<2> hum;
+    hum.add("temp", 20.5f);
+    hum.add("humidity", 59.0f);
+    TEST_ASSERT_TRUE(offer(f, hum, 3)); // 5 from the 54 that went out with temp
+}
+
+static void test_integer_deadband(void) {
+    MeoEventPolicy p;
+    p.absolute = 10;
+    MeoEventFilter f(p);
+    MeoStaticEventFields<1> a, b, c;
+    a.add("n", 100);
+    b.add("n", 109);
+    c.add("n", 90);
+    TEST_ASSERT_TRUE(offer(f, a, 0));
+    TEST_ASSERT_FALSE(offer(f, b, 1));
+    TEST_ASSERT_TRUE(offer(f, c, 2));
+}
+
+static void test_on_change_strings_and_bools(void) {
+    MeoEventPolicy p;
+    p.onChange = true;
+    MeoEventFilter f(p);
+    char mode[8] = "auto";
+    MeoStaticEventFields<2> ev;
+    ev.add("mode", (const char*)mode);
+    ev.add("on", true);
+    TEST_ASSERT_TRUE(offer(f, ev, 0));
+    TEST_ASSERT_FALSE(offer(f, ev, 1));
+    strcpy(mode, "eco"); // same buffer, new contents
+    TEST_ASSERT_TRUE(offer(f, ev, 2));
+    TEST_ASSERT_FALSE(offer(f, ev, 3));
+
+    MeoStaticEventFields<2> off;
+    off.add("mode", "eco");
+    off.add("on", false);
+    TEST_ASSERT_TRUE(offer(f, off, 4));
+
+    MeoStaticEventFields<2> null;
+    null.add("mode", (const char*)nullptr);
+    null.add("on", false);
+    TEST_ASSERT_TRUE(offer(f, null, 5));
+    TEST_ASSERT_FALSE(offer(f, null, 6));
+}
+
+// Fields are matched by key: a new order is not a change, a new key or type is
+static void test_fields_matched_by_key(void) {
+    MeoEventPolicy p;
+    p.onChange = true;
+    MeoEventFilter f(p);
+    MeoStaticEventFields<2> ab, ba, ac, typed;
+    ab.add("a", 1);
+    ab.add("b", 2);
+    ba.add("b", 2);
+    ba.add("a", 1);
+    ac.add("a", 1);
+    ac.add("c", 2);
+    typed.add("a", 1.0f);
+    typed.add("c", 2);
+    TEST_ASSERT_TRUE(offer(f, ab, 0));
+    TEST_ASSERT_FALSE(offer(f, ba, 1));
+    TEST_ASSERT_TRUE(offer(f, ac, 2));
+    TEST_ASSERT_TRUE(offer(f, typed, 3));
+
+    MeoStaticEventFields<1> fewer;
+    fewer.add("a", 1.0f);
+    TEST_ASSERT_TRUE(offer(f, fewer, 4));
+}
+
+// Past MEO_EVENT_POLICY_FIELDS there is no last value to compare: a change in
+// the extra field must not be suppressed, so such an event always counts as changed
+static void test_fields_past_limit_count_as_changed(void) {
+    char keys[MEO_EVENT_POLICY_FIELDS + 1][8];
+    for (int i = 0; i <= MEO_EVENT_POLICY_FIELDS; ++i) snprintf(keys[i], sizeof(keys[i]), "f%d", i);
+    MeoEventPolicy p;
+    p.onChange = true;
+    p.minIntervalMs = 100;
+    MeoEventFilter f(p);
+    MeoStaticEventFields<MEO_EVENT_POLICY_FIELDS + 1> a, b;
+    for (int i = 0; i < MEO_EVENT_POLICY_FIELDS; ++i) {
+        a.add(keys[i], i);
+        b.add(keys[i], i);
+    }
+    a.add(keys[MEO_EVENT_POLICY_FIELDS], 1);
+    b.add(keys[MEO_EVENT_POLICY_FIELDS], 2);
+    TEST_ASSERT_TRUE(offer(f, a, 0));
+    TEST_ASSERT_TRUE(offer(f, b, 100));
+    TEST_ASSERT_TRUE(offer(f, b, 200));
+    TEST_ASSERT_FALSE(offer(f, b, 250)); // the rate limit still applies
+
+    // At the limit every field is compared
+    MeoEventFilter g(p);
+    MeoStaticEventFields<MEO_EVENT_POLICY_FIELDS> full;
+    for (int i = 0; i < MEO_EVENT_POLICY_FIELDS; ++i) full.add(keys[i], i);
+    TEST_ASSERT_TRUE(offer(g, full, 0));
+    TEST_ASSERT_FALSE(offer(g, full, 100));
+}
+
+static void test_nan(void) {
+    MeoEventPolicy p;
+    p.absolute = 1;
+    MeoEventFilter f(p);
+    TEST_ASSERT_TRUE(offerFloat(f, "t", 1.0f, 0));
+    TEST_ASSERT_TRUE(offerFloat(f, "t", NAN, 1));
+    TEST_ASSERT_FALSE(offerFloat(f, "t", NAN, 2));
+    TEST_ASSERT_TRUE(offerFloat(f, "t", 1.0f, 3));
+}
+
+static void test_min_interval(void) {
+    MeoEventPolicy p;
+    p.minIntervalMs = 1000;
+    MeoEventFilter f(p);
+    TEST_ASSERT_TRUE(offerFloat(f, "t", 1.0f, 5000));
+    TEST_ASSERT_FALSE(offerFloat(f, "t", 2.0f, 5999));
+    TEST_ASSERT_TRUE(offerFloat(f, "t", 3.0f, 6000));
+    // millis() wrapping past 2^32 keeps the interval
+    MeoEventFilter w(p);
+    TEST_ASSERT_TRUE(offerFloat(w, "t", 1.0f, 0xFFFFFF00u));
+    TEST_ASSERT_FALSE(offerFloat(w, "t", 1.0f, 0x000002E7u)); // 999 ms later
+    TEST_ASSERT_TRUE(offerFloat(w, "t", 1.0f, 0x000002E8u));
+}
+
+static void test_heartbeat(void) {
+    MeoEventPolicy p;
+    p.absolute = 1;
+    p.maxIntervalMs = 60000;
+    MeoEventFilter f(p);
+    TEST_ASSERT_TRUE(offerFloat(f, "t", 20.0f, 0));
+    TEST_ASSERT_FALSE(offerFloat(f, "t", 20.0f, 59999));
+    TEST_ASSERT_TRUE(offerFloat(f, "t", 20.0f, 60000));
+    TEST_ASSERT_EQUAL_UINT32(1, f.stats().heartbeats);
+    // A real change resets the heartbeat clock and is not counted as one
+    TEST_ASSERT_TRUE(offerFloat(f, "t", 25.0f, 90000));
+    TEST_ASSERT_FALSE(offerFloat(f, "t", 25.0f, 149999));
+    TEST_ASSERT_TRUE(offerFloat(f, "t", 25.0f, 150000));
+    TEST_ASSERT_EQUAL_UINT32(2, f.stats().heartbeats);
+    TEST_ASSERT_EQUAL_UINT32(4, f.stats().sent);
+}
+
+// The rate limit wins over a change
+static void test_min_interval_with_deadband(void) {
+    MeoEventPolicy p;
+    p.absolute = 1;
+    p.minIntervalMs = 100;
+    MeoEventFilter f(p);
+    TEST_ASSERT_TRUE(offerFloat(f, "t", 0.0f, 0));
+    TEST_ASSERT_FALSE(offerFloat(f, "t", 50.0f, 50));
+    TEST_ASSERT_TRUE(offerFloat(f, "t", 50.0f, 100));
+}
+
+// A check() that passes but is never committed (publish failed) leaves the
+// reference where it was, so the same value passes again
+static void test_uncommitted_send_is_retried(void) {
+    MeoEventPolicy p;
+    p.absolute = 1;
+    p.maxIntervalMs = 1000;
+    MeoEventFilter f(p);
+    TEST_ASSERT_TRUE(offerFloat(f, "t", 0.0f, 0));
+
+    MeoStaticEventFields<1> ev;
+    ev.add("t", 5.0f);
+    TEST_ASSERT_TRUE(f.check(ev, 10));  // publish fails: no commit
+    TEST_ASSERT_TRUE(f.check(ev, 20));
+    f.commit(ev, 20);
+    TEST_ASSERT_FALSE(f.check(ev, 30));
+    TEST_ASSERT_EQUAL_UINT32(2, f.stats().sent);
+
+    // A heartbeat that failed to publish is not counted
+    MeoStaticEventFields<1> same;
+    same.add("t", 5.0f);
+    TEST_ASSERT_TRUE(f.check(same, 1020));
+    TEST_ASSERT_TRUE(f.check(same, 1030));
+    f.commit(same, 1030);
+    TEST_ASSERT_EQUAL_UINT32(1, f.stats().heartbeats);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_no_policy_sends_everything);
+    RUN_TEST(test_absolute_deadband_edge);
+    RUN_TEST(test_drift_accumulates);
+    RUN_TEST(test_percent_deadband);
+    RUN_TEST(test_absolute_or_percent);
+    RUN_TEST(test_per_field_override);
+    RUN_TEST(test_integer_deadband);
+    RUN_TEST(test_on_change_strings_and_bools);
+    RUN_TEST(test_fields_matched_by_key);
+    RUN_TEST(test_fields_past_limit_count_as_changed);
+    RUN_TEST(test_nan);
+    RUN_TEST(test_min_interval);
+    RUN_TEST(test_heartbeat);
+    RUN_TEST(test_min_interval_with_deadband);
+    RUN_TEST(test_uncommitted_send_is_retried);
+    return UNITY_END();
+}
@@ -0,0 +1,228 @@
+// MeoEventQueue: replay order, drain budget, drop policies, and overflow into a
+// MeoFlashSpill on an emulated flash region (MeoFileFlash, 4 x 256 B sectors).
+
+#include <unity.h>
+#include <queue/Meo3_EventQueue.h>
+#include <queue/Meo3_FlashSpill.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static const char* FLASH_PATH = "test_event_queue.flash";
+
+// Every record is 64 bytes in RAM: 4 header + "t\0" + 58 payload, so 32 fit in
+// MEO_QUEUE_RAM_BYTES (2048). On a 256 B sector the spill takes 3 per sector.
+static const size_t PAYLOAD = 58;
+static const uint32_t RAM_RECORDS = MEO_QUEUE_RAM_BYTES / 64;
+
+static bool push(MeoEventQueue& q, uint32_t id) {
+    uint8_t payload[PAYLOAD];
+    memset(payload, (uint8_t)id, sizeof(payload));
+    memcpy(payload, &id, sizeof(id));
+    return q.push("t", payload, sizeof(payload));
+}
+
+struct Replay {
+    std::vector<uint32_t> ids;
+    uint32_t corrupt = 0;
+    int refuseAfter = -1; // send() fails once this many were taken
+};
+
+static bool collect(const char* topic, const uint8_t* payload, size_t len, void* ctx) {
+    Replay* r = (Replay*)ctx;
+    if (r->refuseAfter >= 0 && (int)r->ids.size() >= r->refuseAfter) return false;
+    uint32_t id = 0;
+    if (strcmp(topic, "t") != 0 || len != PAYLOAD) {
+        r->corrupt++;
+    } else {
+        memcpy(&id, payload, sizeof(id));
+        for (size_t i = sizeof(id); i < len; ++i) {
+            if (payload[i] != (uint8_t)id) { r->corrupt++; break; }
+        }
+    }
+    r->ids.push_back(id);
+    return true;
+}
+
+static void assertRun(const Replay& r, uint32_t first, uint32_t count) {
+    TEST_ASSERT_EQUAL_UINT32(0, r.corrupt);
+    TEST_ASSERT_EQUAL_UINT32(count, r.ids.size());
+    for (uint32_t i = 0; i < count && i < r.ids.size(); ++i) TEST_ASSERT_EQUAL_UINT32(first + i, r.ids[i]);
+}
+
+static MeoFileFlash flash;
+static MeoFlashSpill spill;
+
+void setUp(void) {
+    remove(FLASH_PATH);
+    TEST_ASSERT_TRUE(flash.begin(FLASH_PATH, 4 * 256, 256));
+    TEST_ASSERT_TRUE(spill.begin(&flash));
+}
+
+void tearDown(void) {
+    flash.end();
+    remove(FLASH_PATH);
+    remove((std::string(FLASH_PATH) + ".wear").c_str());
+}
+
+static void test_fifo_and_budget(void) {
+    MeoEventQueue q;
+    for (uint32_t i = 0; i < 5; ++i) TEST_ASSERT_TRUE(push(q, i));
+    TEST_ASSERT_EQUAL_UINT32(5, q.count());
+
+    Replay r;
+    TEST_ASSERT_EQUAL_UINT32(2, q.drain(&collect, &r, 2));
+    TEST_ASSERT_EQUAL_UINT32(3, q.count());
+    // A refused send leaves the message at the front
+    r.refuseAfter = 3;
+    TEST_ASSERT_EQUAL_UINT32(1, q.drain(&collect, &r, 10));
+    TEST_ASSERT_EQUAL_UINT32(2, q.count());
+    r.refuseAfter = -1;
+    TEST_ASSERT_EQUAL_UINT32(2, q.drain(&collect, &r, 10));
+    assertRun(r, 0, 5);
+    TEST_ASSERT_TRUE(q.empty());
+    TEST_ASSERT_EQUAL_UINT32(5, q.stats().replayed);
+}
+
+static void test_ram_ring_wraps_intact(void) {
+    MeoEventQueue q;
+    Replay r;
+    uint32_t next = 0;
+    // A standing backlog of 10 keeps head and tail apart while both walk
+    // round the 2048 B ring in steps of 7 records
+    for (int i = 0; i < 10; ++i) TEST_ASSERT_TRUE(push(q, next++));
+    for (int round = 0; round < 50; ++round) {
+        for (int i = 0; i < 7; ++i) TEST_ASSERT_TRUE(push(q, next++));
+        TEST_ASSERT_EQUAL_UINT32(7, q.drain(&collect, &r, 7));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, q.stats().droppedOldest);
+    q.drain(&collect, &r, (size_t)-1);
+    assertRun(r, 0, next);
+}
+
+static void test_ram_only_drop_oldest(void) {
+    MeoEventQueue q;
+    for (uint32_t i = 0; i < RAM_RECORDS + 8; ++i) TEST_ASSERT_TRUE(push(q, i));
+    MeoQueueStats s = q.stats();
+    TEST_ASSERT_EQUAL_UINT32(RAM_RECORDS, s.ramDepth);
+    TEST_ASSERT_EQUAL_UINT32(8, s.droppedOldest);
+
+    Replay r;
+    q.drain(&collect, &r, (size_t)-1);
+    assertRun(r, 8, RAM_RECORDS);
+}
+
+static void test_ram_only_drop_newest(void) {
+    MeoEventQueue q;
+    q.setPolicy(MeoQueuePolicy::DROP_NEWEST);
+    uint32_t accepted = 0;
+    for (uint32_t i = 0; i < RAM_RECORDS + 8; ++i) accepted += push(q, i);
+    TEST_ASSERT_EQUAL_UINT32(RAM_RECORDS, accepted);
+    TEST_ASSERT_EQUAL_UINT32(8, q.stats().droppedNewest);
+
+    Replay r;
+    q.drain(&collect, &r, (size_t)-1);
+    assertRun(r, 0, RAM_RECORDS);
+}
+
+static void test_oversized_rejected(void) {
+    MeoEventQueue q;
+    static uint8_t big[MEO_QUEUE_MAX_RECORD];
+    TEST_ASSERT_FALSE(q.push("t", big, sizeof(big)));
+    TEST_ASSERT_FALSE(q.push(nullptr, big, 1));
+    TEST_ASSERT_EQUAL_UINT32(1, q.stats().droppedNewest);
+    TEST_ASSERT_TRUE(q.empty());
+}
+
+// Oldest records move to flash, so replay still comes out oldest first
+static void test_spill_keeps_order(void) {
+    MeoEventQueue q;
+    q.setSpill(&spill);
+    for (uint32_t i = 0; i < RAM_RECORDS + 8; ++i) TEST_ASSERT_TRUE(push(q, i));
+    MeoQueueStats s = q.stats();
+    TEST_ASSERT_EQUAL_UINT32(8, s.spilled);
+    TEST_ASSERT_EQUAL_UINT32(8, s.spillDepth);
+    TEST_ASSERT_EQUAL_UINT32(RAM_RECORDS + 8, q.count());
+    TEST_ASSERT_EQUAL_UINT32(0, s.droppedOldest);
+
+    Replay r;
+    q.drain(&collect, &r, (size_t)-1);
+    assertRun(r, 0, RAM_RECORDS + 8);
+    TEST_ASSERT_TRUE(q.empty());
+}
+
+// New messages arriving mid-replay queue behind what is already spilled
+static void test_push_during_replay(void) {
+    MeoEventQueue q;
+    q.setSpill(&spill);
+    uint32_t next = 0;
+    for (; next < RAM_RECORDS + 6; ++next) TEST_ASSERT_TRUE(push(q, next));
+    Replay r;
+    TEST_ASSERT_EQUAL_UINT32(3, q.drain(&collect, &r, 3)); // still inside the spill
+    for (int i = 0; i < 4; ++i, ++next) TEST_ASSERT_TRUE(push(q, next));
+    TEST_ASSERT_EQUAL_UINT32(0, q.stats().droppedOldest);
+    q.drain(&collect, &r, (size_t)-1);
+    assertRun(r, 0, next);
+}
+
+// Spill full: the oldest spilled records go, a sector's worth at a time
+static void test_spill_full_drop_oldest(void) {
+    MeoEventQueue q;
+    q.setSpill(&spill);
+    const uint32_t TOTAL = 80;
+    for (uint32_t i = 0; i < TOTAL; ++i) TEST_ASSERT_TRUE(push(q, i));
+    MeoQueueStats s = q.stats();
+    TEST_ASSERT_GREATER_THAN(0, s.droppedOldest);
+    TEST_ASSERT_EQUAL_UINT32(TOTAL, q.count() + s.droppedOldest);
+
+    Replay r;
+    q.drain(&collect, &r, (size_t)-1);
+    // What survives is the newest run, contiguous and in order
+    assertRun(r, TOTAL - (uint32_t)r.ids.size(), (uint32_t)r.ids.size());
+}
+
+static void test_spill_full_drop_newest(void) {
+    MeoEventQueue q;
+    q.setSpill(&spill);
+    q.setPolicy(MeoQueuePolicy::DROP_NEWEST);
+    const uint32_t TOTAL = 80;
+    uint32_t accepted = 0;
+    for (uint32_t i = 0; i < TOTAL; ++i) accepted += push(q, i);
+    MeoQueueStats s = q.stats();
+    TEST_ASSERT_LESS_THAN(TOTAL, accepted);
+    TEST_ASSERT_EQUAL_UINT32(TOTAL - accepted, s.droppedNewest);
+    TEST_ASSERT_EQUAL_UINT32(0, s.droppedOldest);
+
+    Replay r;
+    q.drain(&collect, &r, (size_t)-1);
+    assertRun(r, 0, accepted);
+}
+
+static void test_clear_empties_spill(void) {
+    MeoEventQueue q;
+    q.setSpill(&spill);
+    for (uint32_t i = 0; i < RAM_RECORDS + 4; ++i) push(q, i);
+    q.clear();
+    TEST_ASSERT_TRUE(q.empty());
+    TEST_ASSERT_EQUAL_UINT32(0, spill.count());
+    TEST_ASSERT_TRUE(push(q, 7));
+    Replay r;
+    q.drain(&collect, &r, (size_t)-1);
+    assertRun(r, 7, 1);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fifo_and_budget);
+    RUN_TEST(test_ram_ring_wraps_intact);
+    RUN_TEST(test_ram_only_drop_oldest);
+    RUN_TEST(test_ram_only_drop_newest);
+    RUN_TEST(test_oversized_rejected);
+    RUN_TEST(test_spill_keeps_order);
+    RUN_TEST(test_push_during_replay);
+    RUN_TEST(test_spill_full_drop_oldest);
+    RUN_TEST(test_spill_full_drop_newest);
+    RUN_TEST(test_clear_empties_spill);
+    return UNITY_END();
+}
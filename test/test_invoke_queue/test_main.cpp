@@ -0,0 +1,236 @@
+// MeoInvokeQueue accounting: synchronous, deferred and rejected invokes, with
+// std::thread standing in for the worker and for tasks that answer later.
+
+#include <unity.h>
+#include <feature/Meo3_InvokeQueue.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static int motorKey, ledKey; // method identities (opaque to the queue)
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static MeoInvokePush push(MeoInvokeQueue& q, const void* key, const char* params = "{}") {
+    return q.push(key, key == &motorKey ? "motor" : "led", params, strlen(params));
+}
+
+static void test_sync_invoke_releases_its_slot(void) {
+    MeoInvokeQueue q;
+    TEST_ASSERT_EQUAL(MeoInvokePush::OK, push(q, &ledKey, "{\"on\":true}"));
+    MeoInvokeRecord rec;
+    TEST_ASSERT_TRUE(q.pop(rec, 0));
+    TEST_ASSERT_EQUAL_STRING("led", rec.feature);
+    TEST_ASSERT_EQUAL_STRING("{\"on\":true}", rec.params);
+    TEST_ASSERT_NOT_EQUAL(0u, rec.token);
+    TEST_ASSERT_EQUAL_UINT32(1, q.stats().inFlight);
+
+    q.release(rec.token);
+    MeoInvokeStats s = q.stats();
+    TEST_ASSERT_EQUAL_UINT32(0, s.inFlight);
+    TEST_ASSERT_EQUAL_UINT32(1, s.completed);
+    // A second release of the same invoke changes nothing
+    q.release(rec.token);
+    TEST_ASSERT_EQUAL_UINT32(1, q.stats().completed);
+}
+
+static void test_tokens_are_unique(void) {
+    MeoInvokeQueue q;
+    uint32_t seen[MEO_INVOKE_QUEUE_DEPTH];
+    for (int i = 0; i < MEO_INVOKE_QUEUE_DEPTH; ++i) TEST_ASSERT_EQUAL(MeoInvokePush::OK, push(q, &ledKey));
+    for (int i = 0; i < MEO_INVOKE_QUEUE_DEPTH; ++i) {
+        MeoInvokeRecord rec;
+        TEST_ASSERT_TRUE(q.pop(rec, 0));
+        for (int j = 0; j < i; ++j) TEST_ASSERT_NOT_EQUAL(seen[j], rec.token);
+        seen[i] = rec.token;
+        q.release(rec.token);
+    }
+}
+
+// The old accounting freed "some deferred invoke of this feature" on every response
+static void test_rejection_does_not_free_a_deferred_invoke(void) {
+    MeoInvokeQueue q;
+    TEST_ASSERT_TRUE(q.setLimit(&motorKey, 1));
+
+    TEST_ASSERT_EQUAL(MeoInvokePush::OK, push(q, &motorKey));
+    MeoInvokeRecord rec;
+    TEST_ASSERT_TRUE(q.pop(rec, 0));
+    q.defer(rec.token);
+    TEST_ASSERT_EQUAL_UINT32(1, q.stats().deferred);
+
+    // The second motor invoke is refused; its "Busy" answer carries no token
+    TEST_ASSERT_EQUAL(MeoInvokePush::BUSY, push(q, &motorKey));
+    TEST_ASSERT_FALSE(q.complete(0));
+    TEST_ASSERT_EQUAL_UINT32(1, q.stats().inFlight);
+    TEST_ASSERT_EQUAL(MeoInvokePush::BUSY, push(q, &motorKey));
+
+    // The deferred answer frees exactly its own slot, once
+    TEST_ASSERT_TRUE(q.complete(rec.token));
+    TEST_ASSERT_FALSE(q.complete(rec.token));
+    MeoInvokeStats s = q.stats();
+    TEST_ASSERT_EQUAL_UINT32(0, s.inFlight);
+    TEST_ASSERT_EQUAL_UINT32(0, s.deferred);
+    TEST_ASSERT_EQUAL_UINT32(2, s.rejectedBusy);
+    TEST_ASSERT_EQUAL_UINT32(2, s.unknownToken);
+    TEST_ASSERT_EQUAL(MeoInvokePush::OK, push(q, &motorKey));
+}
+
+// A worker that runs a synchronous handler must not also be freed by that handler's answer
+static void test_sync_answer_then_release_counts_once(void) {
+    MeoInvokeQueue q;
+    TEST_ASSERT_TRUE(q.setLimit(&motorKey, 2));
+    TEST_ASSERT_EQUAL(MeoInvokePush::OK, push(q, &motorKey));
+    TEST_ASSERT_EQUAL(MeoInvokePush::OK, push(q, &motorKey));
+
+    MeoInvokeRecord a, b;
+    TEST_ASSERT_TRUE(q.pop(a, 0));
+    q.defer(a.token);
+    TEST_ASSERT_TRUE(q.pop(b, 0));
+    TEST_ASSERT_FALSE(q.complete(0)); // b answers inline: no token
+    q.release(b.token);
+
+    MeoInvokeStats s = q.stats();
+    TEST_ASSERT_EQUAL_UINT32(1, s.inFlight);
+    TEST_ASSERT_EQUAL_UINT32(1, s.deferred);
+    TEST_ASSERT_TRUE(q.complete(a.token));
+    TEST_ASSERT_EQUAL_UINT32(0, q.stats().inFlight);
+}
+
+// Answer from another task before the worker marked the invoke deferred
+static void test_complete_before_defer(void) {
+    MeoInvokeQueue q;
+    TEST_ASSERT_EQUAL(MeoInvokePush::OK, push(q, &motorKey));
+    MeoInvokeRecord rec;
+    TEST_ASSERT_TRUE(q.pop(rec, 0));
+    TEST_ASSERT_TRUE(q.complete(rec.token));
+    TEST_ASSERT_EQUAL_UINT32(1, q.stats().inFlight);
+    q.defer(rec.token);
+    TEST_ASSERT_EQUAL_UINT32(0, q.stats().inFlight);
+    TEST_ASSERT_EQUAL_UINT32(0, q.stats().deferred);
+    TEST_ASSERT_FALSE(q.complete(rec.token));
+}
+
+static void test_full_queue_and_inflight_table(void) {
+    MeoInvokeQueue q;
+    for (int i = 0; i < MEO_INVOKE_QUEUE_DEPTH; ++i) TEST_ASSERT_EQUAL(MeoInvokePush::OK, push(q, &ledKey));
+    TEST_ASSERT_EQUAL(MeoInvokePush::FULL, push(q, &ledKey));
+    TEST_ASSERT_EQUAL_UINT32(MEO_INVOKE_QUEUE_DEPTH, q.stats().maxDepth);
+
+    // Deferred invokes leave the queue but keep their in-flight slots
+    size_t deferred = 0;
+    while (deferred < MEO_INVOKE_MAX_INFLIGHT) {
+        MeoInvokeRecord rec;
+        if (q.pop(rec, 0)) {
+            q.defer(rec.token);
+            deferred++;
+        } else if (push(q, &ledKey) != MeoInvokePush::OK) {
+            break;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(MEO_INVOKE_MAX_INFLIGHT, q.stats().inFlight);
+    TEST_ASSERT_EQUAL(MeoInvokePush::FULL, push(q, &ledKey));
+
+    char big[MEO_INVOKE_MAX_PAYLOAD + 1];
+    memset(big, 'x', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    TEST_ASSERT_EQUAL(MeoInvokePush::TOO_LARGE, push(q, &ledKey, big));
+}
+
+// Producers (MQTT callbacks), one worker, and responders answering deferred motor
+// invokes later: the motor limit must hold throughout and everything must drain.
+static void test_threads_deferred_reject_sync(void) {
+    static const int PRODUCERS = 3, PER_PRODUCER = 2000, MOTOR_LIMIT = 2;
+    MeoInvokeQueue q;
+    TEST_ASSERT_TRUE(q.setLimit(&motorKey, MOTOR_LIMIT));
+
+    std::atomic<int> motorBusy{0}, motorPeak{0}, rejected{0}, accepted{0}, answered{0};
+    std::atomic<bool> stop{false};
+    std::mutex pendingLock;
+    std::vector<uint32_t> pending; // deferred tokens waiting for their answer
+
+    std::thread worker([&] {
+        MeoInvokeRecord rec;
+        while (!stop) {
+            if (!q.pop(rec, 5)) continue;
+            if (rec.key == &motorKey) {
+                int now = ++motorBusy;
+                int peak = motorPeak;
+                while (now > peak && !motorPeak.compare_exchange_weak(peak, now)) {}
+                // Handler hands the token to a responder, which may answer
+                // before the worker gets to defer()
+                {
+                    std::lock_guard<std::mutex> lk(pendingLock);
+                    pending.push_back(rec.token);
+                }
+                q.defer(rec.token);
+            } else {
+                q.release(rec.token); // LED: answered inline
+                answered++;
+            }
+        }
+    });
+    std::thread responder([&] {
+        while (!stop) {
+            uint32_t token = 0;
+            {
+                std::lock_guard<std::mutex> lk(pendingLock);
+                if (!pending.empty()) {
+                    token = pending.front();
+                    pending.erase(pending.begin());
+                }
+            }
+            if (!token) {
+                std::this_thread::yield();
+                continue;
+            }
+            motorBusy--;
+            if (q.complete(token)) answered++;
+        }
+    });
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&, p] {
+            for (int i = 0; i < PER_PRODUCER; ++i) {
+                const void* key = ((i + p) % 3 == 0) ? &ledKey : &motorKey;
+                if (push(q, key) == MeoInvokePush::OK) {
+                    accepted++;
+                } else {
+                    rejected++;
+                    q.complete(0); // the rejection's answer: must not free anything
+                }
+                if (i % 64 == 0) std::this_thread::yield();
+            }
+        });
+    }
+    for (std::thread& t : producers) t.join();
+    for (int i = 0; i < 5000 && q.stats().inFlight; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    stop = true;
+    worker.join();
+    responder.join();
+
+    MeoInvokeStats s = q.stats();
+    TEST_ASSERT_LESS_OR_EQUAL(MOTOR_LIMIT, motorPeak.load());
+    TEST_ASSERT_GREATER_THAN(0, rejected.load());
+    TEST_ASSERT_EQUAL_UINT32(0, s.inFlight);
+    TEST_ASSERT_EQUAL_UINT32(0, s.deferred);
+    TEST_ASSERT_EQUAL_UINT32(accepted.load(), s.enqueued);
+    TEST_ASSERT_EQUAL_UINT32(accepted.load(), s.completed);
+    TEST_ASSERT_EQUAL_UINT32(accepted.load(), answered.load());
+    TEST_ASSERT_EQUAL_UINT32(rejected.load(), s.rejectedBusy + s.rejectedFull);
+    TEST_ASSERT_EQUAL_UINT32(rejected.load(), s.unknownToken);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sync_invoke_releases_its_slot);
+    RUN_TEST(test_tokens_are_unique);
+    RUN_TEST(test_rejection_does_not_free_a_deferred_invoke);
+    RUN_TEST(test_sync_answer_then_release_counts_once);
+    RUN_TEST(test_complete_before_defer);
+    RUN_TEST(test_full_queue_and_inflight_table);
+    RUN_TEST(test_threads_deferred_reject_sync);
+    return UNITY_END();
+}
@@ -0,0 +1,278 @@
+// MeoLogStore on a MeoFileFlash region (8 x 512 B sectors): values, remount,
+// compaction and wear spread, and power cuts at every byte of a put, a
+// compaction step and an erase, each followed by a remount that must read
+// every key back as its last acknowledged value (or the cut one, whole).
+
+#include <unity.h>
+#include <storage/Meo3_LogStore.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+static const char*    FLASH_PATH = "test_log_store.flash";
+static const size_t   SECTOR = 512;
+static const size_t   SECTORS = 8;
+static const uint32_t KEYS = 6;
+
+static MeoFileFlash flash;
+
+// Counts erases that a power cut stopped part way
+class CutCounter : public MeoFlash {
+public:
+    explicit CutCounter(MeoFileFlash& f) : _f(f) {}
+    uint32_t erasesCut = 0;
+
+    size_t size() const override { return _f.size(); }
+    size_t sectorSize() const override { return _f.sectorSize(); }
+    bool read(size_t offset, void* out, size_t len) override { return _f.read(offset, out, len); }
+    bool write(size_t offset, const void* data, size_t len) override { return _f.write(offset, data, len); }
+    bool eraseSector(size_t sectorIndex) override {
+        bool powered = _f.powered();
+        bool ok = _f.eraseSector(sectorIndex);
+        if (powered && !_f.powered()) erasesCut++;
+        return ok;
+    }
+
+private:
+    MeoFileFlash& _f;
+};
+
+static void keyName(uint32_t k, char* out) { snprintf(out, 16, "k%u", (unsigned)k); }
+
+// 12-byte value: the counter, then a pattern derived from it
+static void encode(uint32_t counter, uint8_t* out) {
+    memcpy(out, &counter, 4);
+    for (int i = 4; i < 12; ++i) out[i] = (uint8_t)(counter * 31 + i);
+}
+
+void setUp(void) {
+    remove(FLASH_PATH);
+    TEST_ASSERT_TRUE(flash.begin(FLASH_PATH, SECTORS * SECTOR, SECTOR));
+}
+
+void tearDown(void) {
+    flash.end();
+    remove(FLASH_PATH);
+    remove((std::string(FLASH_PATH) + ".wear").c_str());
+}
+
+static void test_put_get_remove(void) {
+    MeoLogStore store;
+    TEST_ASSERT_TRUE(store.begin(&flash));
+    uint32_t v = 7;
+    TEST_ASSERT_TRUE(store.putValue("energy_wh", v));
+    TEST_ASSERT_TRUE(store.put("mode", "eco", 3));
+    TEST_ASSERT_TRUE(store.contains("mode"));
+    TEST_ASSERT_EQUAL_UINT8(2, store.keys());
+
+    uint32_t got = 0;
+    TEST_ASSERT_TRUE(store.getValue("energy_wh", got));
+    TEST_ASSERT_EQUAL_UINT32(7, got);
+    char mode[8] = {0};
+    size_t len = 0;
+    TEST_ASSERT_TRUE(store.get("mode", mode, sizeof(mode), &len));
+    TEST_ASSERT_EQUAL_UINT32(3, len);
+    TEST_ASSERT_EQUAL_STRING("eco", mode);
+    TEST_ASSERT_FALSE(store.get("mode", mode, 2)); // too small
+
+    // Same value again: no record
+    uint32_t before = store.stats().puts;
+    TEST_ASSERT_TRUE(store.putValue("energy_wh", v));
+    TEST_ASSERT_EQUAL_UINT32(before, store.stats().puts);
+    TEST_ASSERT_EQUAL_UINT32(1, store.stats().unchanged);
+
+    TEST_ASSERT_TRUE(store.remove("mode"));
+    TEST_ASSERT_FALSE(store.contains("mode"));
+    TEST_ASSERT_FALSE(store.get("mode", mode, sizeof(mode)));
+    TEST_ASSERT_FALSE(store.getValue("missing", got));
+}
+
+static void test_limits(void) {
+    MeoLogStore store;
+    TEST_ASSERT_TRUE(store.begin(&flash));
+    uint8_t big[MEO_LOGSTORE_VALUE_MAX + 1] = {0};
+    TEST_ASSERT_TRUE(store.put("max", big, MEO_LOGSTORE_VALUE_MAX));
+    TEST_ASSERT_FALSE(store.put("over", big, sizeof(big)));
+    TEST_ASSERT_TRUE(store.put("fifteen_chars__", "x", 1));
+    TEST_ASSERT_FALSE(store.put("sixteen_chars___", "x", 1));
+    TEST_ASSERT_FALSE(store.put(nullptr, "x", 1));
+    TEST_ASSERT_FALSE(store.put("", "x", 1));
+
+    MeoFileFlash tiny;
+    TEST_ASSERT_TRUE(tiny.begin("test_log_store_tiny.flash", 2 * SECTOR, SECTOR));
+    MeoLogStore small;
+    TEST_ASSERT_FALSE(small.begin(&tiny)); // needs three sectors
+    tiny.end();
+    remove("test_log_store_tiny.flash");
+    remove("test_log_store_tiny.flash.wear");
+}
+
+static void test_values_survive_remount(void) {
+    {
+        MeoLogStore store;
+        TEST_ASSERT_TRUE(store.begin(&flash));
+        for (uint32_t i = 1; i <= 50; ++i) TEST_ASSERT_TRUE(store.putValue("counter", i));
+        TEST_ASSERT_TRUE(store.put("gone", "x", 1));
+        TEST_ASSERT_TRUE(store.remove("gone"));
+    }
+    MeoLogStore store;
+    TEST_ASSERT_TRUE(store.begin(&flash));
+    uint32_t got = 0;
+    TEST_ASSERT_TRUE(store.getValue("counter", got));
+    TEST_ASSERT_EQUAL_UINT32(50, got);
+    TEST_ASSERT_FALSE(store.contains("gone"));
+    TEST_ASSERT_EQUAL_UINT32(0, store.stats().torn);
+}
+
+// Many times the region's size in puts: every key keeps its latest value,
+// static ones included, and erases spread over all sectors
+static void test_compaction_and_wear(void) {
+    MeoLogStore store;
+    TEST_ASSERT_TRUE(store.begin(&flash));
+    TEST_ASSERT_TRUE(store.put("static", "keep", 4));
+    uint8_t value[12];
+    for (uint32_t i = 1; i <= 5000; ++i) {
+        char key[16];
+        keyName(i % KEYS, key);
+        encode(i, value);
+        TEST_ASSERT_TRUE(store.put(key, value, sizeof(value)));
+        store.loop();
+    }
+    for (uint32_t k = 0; k < KEYS; ++k) {
+        char key[16];
+        keyName(k, key);
+        uint8_t got[12], want[12];
+        TEST_ASSERT_TRUE(store.get(key, got, sizeof(got)));
+        uint32_t last = 5000 - (5000 - k) % KEYS;
+        encode(last, want);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(want, got, sizeof(want));
+    }
+    char keep[4];
+    TEST_ASSERT_TRUE(store.get("static", keep, sizeof(keep)));
+    TEST_ASSERT_EQUAL_MEMORY("keep", keep, 4);
+
+    MeoFlashWear w = flash.wear();
+    TEST_ASSERT_GREATER_THAN(SECTORS * 5, w.totalErases);
+    TEST_ASSERT_LESS_OR_EQUAL(2, w.maxErases - w.minErases);
+    TEST_ASSERT_EQUAL_UINT32(0, w.violations);
+}
+
+// Power cuts after a varying number of programmed bytes, carried across puts
+// and loop() steps, so they land in record writes, sector opens, copies and
+// erases at every offset
+static void test_power_cuts(void) {
+    CutCounter region(flash);
+    MeoLogStore* store = new MeoLogStore();
+    TEST_ASSERT_TRUE(store->begin(&region));
+    TEST_ASSERT_TRUE(store->put("static", "keep", 4));
+
+    uint32_t acked[KEYS] = {0};
+    uint32_t cuts = 0, tornSeen = 0;
+    bool armed = false;
+    uint8_t value[12];
+    for (uint32_t i = 1; i <= 6000; ++i) {
+        uint32_t k = i % KEYS;
+        char key[16];
+        keyName(k, key);
+        encode(i, value);
+        if (!armed) {
+            // Alternate short budgets (inside a record) and long ones (up to an erase)
+            flash.cutPowerAfter((i * 7) % (i % 2 ? 40 : SECTOR + 64));
+            armed = true;
+        }
+
+        bool ok = store->put(key, value, sizeof(value));
+        for (int l = 0; l < 3 && flash.powered(); ++l) store->loop();
+        if (ok) acked[k] = i; // durable once put() returns true
+        if (flash.powered()) {
+            TEST_ASSERT_TRUE(ok);
+            continue;
+        }
+
+        cuts++;
+        armed = false;
+        delete store;
+        flash.powerOn();
+        store = new MeoLogStore();
+        TEST_ASSERT_TRUE(store->begin(&region));
+        tornSeen += store->stats().torn;
+
+        for (uint32_t j = 0; j < KEYS; ++j) {
+            char name[16];
+            keyName(j, name);
+            uint8_t got[12], want[12];
+            size_t len = 0;
+            bool found = store->get(name, got, sizeof(got), &len);
+            uint32_t counter = 0;
+            if (found) memcpy(&counter, got, 4);
+            // The put that was cut may or may not have made it, but only whole
+            if (j == k && found && counter == i) acked[j] = i;
+            if (!acked[j]) {
+                TEST_ASSERT_FALSE(found);
+                continue;
+            }
+            TEST_ASSERT_TRUE(found);
+            TEST_ASSERT_EQUAL_UINT32(sizeof(got), len);
+            encode(acked[j], want);
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(want, got, sizeof(want));
+        }
+        char keep[4];
+        TEST_ASSERT_TRUE(store->get("static", keep, sizeof(keep)));
+        TEST_ASSERT_EQUAL_MEMORY("keep", keep, 4);
+    }
+    delete store;
+
+    TEST_ASSERT_GREATER_THAN(200, cuts);
+    TEST_ASSERT_GREATER_THAN(0, region.erasesCut);
+    TEST_ASSERT_GREATER_THAN(0, tornSeen);
+    TEST_ASSERT_EQUAL_UINT32(0, flash.wear().violations);
+}
+
+// A cut in the middle of an erase leaves a half-blank sector behind; the next
+// mount must erase it again before use, not append into it
+static void test_cut_mid_erase(void) {
+    CutCounter region(flash);
+    MeoLogStore* store = new MeoLogStore();
+    TEST_ASSERT_TRUE(store->begin(&region));
+    uint8_t value[12];
+    uint32_t i = 1;
+    // Fill until compaction has work queued
+    for (; i <= 400; ++i) {
+        encode(i, value);
+        TEST_ASSERT_TRUE(store->put("a", value, sizeof(value)));
+    }
+    // Only an erase programs half a sector in one go: step loop() until one
+    // starts and is cut half way
+    flash.cutPowerAfter(SECTOR / 2);
+    for (int l = 0; l < 200 && flash.powered(); ++l) store->loop();
+    TEST_ASSERT_FALSE(flash.powered());
+    TEST_ASSERT_EQUAL_UINT32(1, region.erasesCut);
+    delete store;
+    flash.powerOn();
+
+    store = new MeoLogStore();
+    TEST_ASSERT_TRUE(store->begin(&region));
+    for (uint32_t n = 0; n < 2000; ++n, ++i) {
+        encode(i, value);
+        TEST_ASSERT_TRUE(store->put("a", value, sizeof(value)));
+        store->loop();
+    }
+    uint8_t got[12];
+    TEST_ASSERT_TRUE(store->get("a", got, sizeof(got)));
+    encode(i - 1, value);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(value, got, sizeof(value));
+    TEST_ASSERT_EQUAL_UINT32(0, flash.wear().violations);
+    delete store;
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_put_get_remove);
+    RUN_TEST(test_limits);
+    RUN_TEST(test_values_survive_remount);
+    RUN_TEST(test_compaction_and_wear);
+    RUN_TEST(test_power_cuts);
+    RUN_TEST(test_cut_mid_erase);
+    return UNITY_END();
+}
@@ -0,0 +1,108 @@
+// MeoMethodTable: lookup by full and length-bounded name, duplicates,
+// capacity, registration order, and probing when slots collide.
+
+#include <unity.h>
+#include <feature/Meo3_MethodTable.h>
+
+#include <stdio.h>
+
+typedef int (*Handler)(int);
+
+static int one(int x) { return x + 1; }
+static int two(int x) { return x + 2; }
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_add_and_find(void) {
+    MeoMethodTable<Handler, 4> t;
+    int ctx = 0;
+    TEST_ASSERT_TRUE(t.add("on", &one, &ctx));
+    TEST_ASSERT_TRUE(t.add("off", &two, nullptr));
+    TEST_ASSERT_EQUAL_UINT32(2, t.size());
+
+    const auto* e = t.find("on");
+    TEST_ASSERT_NOT_NULL(e);
+    TEST_ASSERT_EQUAL_STRING("on", e->name);
+    TEST_ASSERT_EQUAL_PTR(&ctx, e->ctx);
+    TEST_ASSERT_EQUAL(2, e->handler(1));
+    TEST_ASSERT_EQUAL_UINT16(0, e->order);
+    TEST_ASSERT_EQUAL_UINT16(1, t.find("off")->order);
+
+    TEST_ASSERT_NULL(t.find("o"));
+    TEST_ASSERT_NULL(t.find("onn"));
+    TEST_ASSERT_NULL(t.find(nullptr));
+}
+
+// Topic segments are looked up in place, without a NUL after them
+static void test_find_by_length(void) {
+    MeoMethodTable<Handler, 4> t;
+    t.add("set", &one, nullptr);
+    t.add("setpoint", &two, nullptr);
+    const char* topic = "setpoint/invoke";
+    TEST_ASSERT_EQUAL_STRING("setpoint", t.find(topic, 8)->name);
+    TEST_ASSERT_EQUAL_STRING("set", t.find(topic, 3)->name);
+    TEST_ASSERT_NULL(t.find(topic, 4));
+    TEST_ASSERT_NULL(t.find(topic, 0));
+}
+
+static void test_rejects_bad_names_and_duplicates(void) {
+    MeoMethodTable<Handler, 4> t;
+    TEST_ASSERT_FALSE(t.add(nullptr, &one, nullptr));
+    TEST_ASSERT_FALSE(t.add("", &one, nullptr));
+    TEST_ASSERT_TRUE(t.add("led", &one, nullptr));
+    char copy[] = "led"; // same name, other storage
+    TEST_ASSERT_FALSE(t.add(copy, &two, nullptr));
+    TEST_ASSERT_EQUAL_UINT32(1, t.size());
+    TEST_ASSERT_EQUAL(2, t.find("led")->handler(1));
+}
+
+static void test_capacity_and_clear(void) {
+    MeoMethodTable<Handler, 3> t;
+    TEST_ASSERT_EQUAL_UINT32(3, t.capacity());
+    TEST_ASSERT_TRUE(t.add("a", &one, nullptr));
+    TEST_ASSERT_TRUE(t.add("b", &one, nullptr));
+    TEST_ASSERT_TRUE(t.add("c", &one, nullptr));
+    TEST_ASSERT_FALSE(t.add("d", &one, nullptr));
+    TEST_ASSERT_NULL(t.find("d"));
+
+    t.clear();
+    TEST_ASSERT_EQUAL_UINT32(0, t.size());
+    TEST_ASSERT_NULL(t.find("a"));
+    TEST_ASSERT_TRUE(t.add("d", &two, nullptr));
+    TEST_ASSERT_NOT_NULL(t.find("d"));
+}
+
+// A full table of generated names: every one is found and keeps its order,
+// names never added are not, so probing ends at an empty slot
+static void test_full_table_probing(void) {
+    static char names[64][20]; // "method_" and any int
+    static MeoMethodTable<Handler, 64> t;
+    t.clear();
+    for (int i = 0; i < 64; ++i) {
+        snprintf(names[i], sizeof(names[i]), "method_%d", i);
+        TEST_ASSERT_TRUE(t.add(names[i], &one, &names[i]));
+    }
+    for (int i = 0; i < 64; ++i) {
+        const auto* e = t.find(names[i]);
+        TEST_ASSERT_NOT_NULL(e);
+        TEST_ASSERT_EQUAL_PTR(names[i], e->name);
+        TEST_ASSERT_EQUAL_UINT16(i, e->order);
+        TEST_ASSERT_EQUAL_PTR(names[i], t.at(i).name);
+    }
+    char other[20];
+    for (int i = 64; i < 200; ++i) {
+        snprintf(other, sizeof(other), "method_%d", i);
+        TEST_ASSERT_NULL(t.find(other));
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_add_and_find);
+    RUN_TEST(test_find_by_length);
+    RUN_TEST(test_rejects_bad_names_and_duplicates);
+    RUN_TEST(test_capacity_and_clear);
+    RUN_TEST(test_full_table_probing);
+    return UNITY_END();
+}
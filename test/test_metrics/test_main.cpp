@@ -0,0 +1,134 @@
+// MeoMetrics snapshots: JSON layout, splitting across messages when the buffer
+// is too small (labelled objects continue in the next part), and histogram
+// windows that are reset only once written.
+
+#include <unity.h>
+#include <metrics/Meo3_Metrics.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Every part of one snapshot
+static std::vector<std::string> parts(MeoMetrics& m, size_t bufLen) {
+    std::vector<std::string> out;
+    std::vector<char> buf(bufLen);
+    uint8_t cursor = 0;
+    do {
+        size_t len = m.snapshot(buf.data(), buf.size(), cursor);
+        if (len == 0) break;
+        TEST_ASSERT_LESS_THAN(bufLen, len);
+        TEST_ASSERT_EQUAL_UINT32(strlen(buf.data()), len);
+        out.push_back(std::string(buf.data(), len));
+    } while (cursor != 0 && out.size() < 100);
+    return out;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_layout(void) {
+    MeoMetrics m;
+    MeoMetricId up = m.addGauge("up");
+    MeoMetricId ok = m.addCounter("ok");
+    MeoMetricId led = m.addCounter("inv", "led");
+    MeoMetricId h = m.addHistogram("h");
+    m.addCounter("inv", "fan"); // zero: left out
+    m.set(up, -5);
+    m.add(ok, 3);
+    m.add(led, 2);
+    m.record(h, 100);
+
+    std::vector<std::string> p = parts(m, 512);
+    TEST_ASSERT_EQUAL_UINT32(1, p.size());
+    TEST_ASSERT_EQUAL_STRING("{\"up\":-5,\"ok\":3,\"inv\":{\"led\":2},"
+                             "\"h\":{\"n\":1,\"mean\":100,\"p50\":100,\"p90\":100,\"p99\":100,\"max\":100}}",
+                             p[0].c_str());
+    // The histogram window was reset by the snapshot
+    p = parts(m, 512);
+    TEST_ASSERT_EQUAL_STRING("{\"up\":-5,\"ok\":3,\"inv\":{\"led\":2},\"h\":{\"n\":0}}", p[0].c_str());
+}
+
+// Many labelled counters in a small buffer: every label arrives exactly once,
+// each part is a closed object, and the object reopens in the next part
+static void test_split_across_parts(void) {
+    static char labels[40][20];
+    MeoMetrics m;
+    MeoMetricId up = m.addGauge("uptime_s");
+    m.set(up, 7);
+    for (int i = 0; i < 40; ++i) {
+        snprintf(labels[i], sizeof(labels[i]), "method%02d", i);
+        m.add(m.addCounter("invokes", labels[i]), (uint32_t)(1000 + i));
+    }
+    m.addCounter("after");
+
+    std::vector<std::string> p = parts(m, 128);
+    TEST_ASSERT_GREATER_THAN(3, p.size());
+    std::string all;
+    for (const std::string& s : p) {
+        TEST_ASSERT_EQUAL('{', s.front());
+        TEST_ASSERT_EQUAL('}', s.back());
+        int depth = 0;
+        for (char c : s) depth += c == '{' ? 1 : c == '}' ? -1 : 0;
+        TEST_ASSERT_EQUAL(0, depth);
+        all += s;
+    }
+    TEST_ASSERT_EQUAL(0, (int)p[0].find("{\"uptime_s\":7,\"invokes\":{\"method00\":1000"));
+    TEST_ASSERT_EQUAL(0, (int)p[1].find("{\"invokes\":{"));
+    for (int i = 0; i < 40; ++i) {
+        char want[32];
+        snprintf(want, sizeof(want), "\"%s\":%d", labels[i], 1000 + i);
+        size_t at = all.find(want);
+        TEST_ASSERT_TRUE(at != std::string::npos);
+        TEST_ASSERT_TRUE(all.find(want, at + 1) == std::string::npos);
+    }
+    TEST_ASSERT_TRUE(p.back().find("\"after\":0}") != std::string::npos);
+
+    // The next snapshot starts from the top again
+    p = parts(m, 512);
+    TEST_ASSERT_EQUAL(0, (int)p[0].find("{\"uptime_s\":7,"));
+}
+
+// A histogram that does not fit keeps its window for the next attempt
+static void test_histogram_kept_until_written(void) {
+    MeoMetrics m;
+    MeoMetricId h = m.addHistogram("handler_us");
+    for (uint32_t v = 1; v <= 50; ++v) m.record(h, v * 1000);
+
+    char small[24];
+    uint8_t cursor = 0;
+    TEST_ASSERT_EQUAL_UINT32(0, m.snapshot(small, sizeof(small), cursor));
+    TEST_ASSERT_EQUAL_UINT8(0, cursor);
+
+    std::vector<std::string> p = parts(m, 512);
+    TEST_ASSERT_EQUAL_UINT32(1, p.size());
+    TEST_ASSERT_EQUAL(0, (int)p[0].find("{\"handler_us\":{\"n\":50,\"mean\":25500,"));
+}
+
+// drop() removes what peek() saw and keeps what was recorded after it
+static void test_records_between_peek_and_drop_kept(void) {
+    MeoMetricHistogram h;
+    h.record(10);
+    h.record(20);
+    MeoLatencyHistogram seen;
+    h.peek(seen);
+    TEST_ASSERT_EQUAL_UINT32(2, seen.count());
+    h.record(5000);
+    h.drop(seen);
+
+    MeoLatencyHistogram rest;
+    h.take(rest);
+    TEST_ASSERT_EQUAL_UINT32(1, rest.count());
+    TEST_ASSERT_EQUAL_UINT32(5000, rest.meanUs());
+    TEST_ASSERT_EQUAL_UINT32(5000, rest.maxUs());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_layout);
+    RUN_TEST(test_split_across_parts);
+    RUN_TEST(test_histogram_kept_until_written);
+    RUN_TEST(test_records_between_peek_and_drop_kept);
+    return UNITY_END();
+}
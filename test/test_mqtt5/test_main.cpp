@@ -0,0 +1,94 @@
+// MeoMqtt5 session against a scripted peer: what the broker's CONNACK
+// properties change, and for how long.
+
+#include <unity.h>
+#include <mqtt/Meo3_Mqtt5.h>
+
+#include <vector>
+
+// Broker end of the socket: records what the client writes, replies from a script
+class Peer : public Client {
+public:
+    std::vector<uint8_t> out;
+    bool open = false;
+
+    int connect(IPAddress ip, uint16_t port) override { (void)ip; return connect("", port); }
+    int connect(const char* host, uint16_t port) override {
+        (void)host; (void)port;
+        open = true;
+        return 1;
+    }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t len) override {
+        if (!open) return 0;
+        out.insert(out.end(), buf, buf + len);
+        return len;
+    }
+    int     available() override { return (int)(_rx.size() - _rxPos); }
+    int     read() override { return _rxPos < _rx.size() ? _rx[_rxPos++] : -1; }
+    int     read(uint8_t* buf, size_t len) override {
+        size_t n = 0;
+        while (n < len && _rxPos < _rx.size()) buf[n++] = _rx[_rxPos++];
+        return (int)n;
+    }
+    int     peek() override { return _rxPos < _rx.size() ? _rx[_rxPos] : -1; }
+    void    flush() override {}
+    void    stop() override { open = false; }
+    uint8_t connected() override { return open; }
+    operator bool() override { return open; }
+    using Print::write;
+
+    void push(std::initializer_list<uint8_t> bytes) { _rx.insert(_rx.end(), bytes); }
+
+private:
+    std::vector<uint8_t> _rx;
+    size_t _rxPos = 0;
+};
+
+static MeoMqtt5Result connect(MeoMqtt5& m) {
+    return m.connect("broker.test", 1883, "A1B2C3D4E5F6", nullptr, nullptr, nullptr, 0, false, nullptr);
+}
+
+// Keep Alive field of the CONNECT at the start of `out` (short remaining length)
+static uint16_t connectKeepAlive(const std::vector<uint8_t>& out) {
+    TEST_ASSERT_GREATER_THAN(11, out.size());
+    TEST_ASSERT_EQUAL_HEX8(0x10, out[0]);
+    return (uint16_t)(out[10] << 8 | out[11]);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Server Keep Alive binds the session it came with; the next CONNECT offers the
+// configured value again, and a CONNACK without it leaves that value in force
+static void test_server_keep_alive_lasts_one_session(void) {
+    Peer peer;
+    MeoMqtt5 m;
+    m.setClient(&peer);
+    m.setKeepAlive(60);
+
+    peer.push({0x20, 0x06, 0x00, 0x00, 0x03, 0x13, 0x00, 0x01}); // Server Keep Alive 1 s
+    TEST_ASSERT_EQUAL(MeoMqtt5Result::OK, connect(m));
+    TEST_ASSERT_EQUAL_UINT16(60, connectKeepAlive(peer.out));
+    TEST_ASSERT_EQUAL_UINT16(1, m.keepAlive());
+
+    // The broker's interval drives PINGREQ
+    delay(1100);
+    peer.out.clear();
+    TEST_ASSERT_TRUE(m.loop());
+    TEST_ASSERT_EQUAL_UINT32(2, peer.out.size());
+    TEST_ASSERT_EQUAL_HEX8(0xC0, peer.out[0]);
+
+    m.disconnect();
+    peer.out.clear();
+    peer.push({0x20, 0x03, 0x00, 0x00, 0x00}); // no properties
+    TEST_ASSERT_EQUAL(MeoMqtt5Result::OK, connect(m));
+    TEST_ASSERT_EQUAL_UINT16(60, connectKeepAlive(peer.out));
+    TEST_ASSERT_EQUAL_UINT16(60, m.keepAlive());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_server_keep_alive_lasts_one_session);
+    return UNITY_END();
+}
@@ -0,0 +1,438 @@
+// MeoMqttClient connection state machine against a scripted socket: each
+// attempt's transport connect and CONNACK come from a script, every packet the
+// client writes is recorded.
+
+#include <unity.h>
+#include <mqtt/Meo3_Mqtt.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+// One connect attempt as the broker side plays it
+struct Attempt {
+    bool    open;    // transport connect succeeds
+    int     connack; // CONNACK return code, -1 = never answer
+};
+
+// Broker end of the socket. CONNECT is answered from inside write(), so the
+// CONNACK is there while PubSubClient waits for it, as with a real peer
+class ScriptedBroker : public Client {
+public:
+    std::vector<Attempt> script;
+    std::vector<uint8_t> sent; // first byte of every packet the client wrote
+    bool     open = false;
+    bool     v5 = false; // answer CONNECT with an MQTT 5 CONNACK
+    uint32_t connects = 0;
+
+    int connect(IPAddress ip, uint16_t port) override { (void)ip; return connect("", port); }
+    int connect(const char* host, uint16_t port) override {
+        (void)host; (void)port;
+        _attempt = connects < script.size() ? script[connects] : Attempt{false, -1};
+        connects++;
+        open = _attempt.open;
+        _rx.clear();
+        _rxPos = 0;
+        _parse = Parse::TYPE;
+        return open ? 1 : 0;
+    }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t len) override {
+        if (!open) return 0;
+        for (size_t i = 0; i < len; ++i) _feed(buf[i]);
+        return len;
+    }
+    int     available() override { return (int)(_rx.size() - _rxPos); }
+    int     read() override { return _rxPos < _rx.size() ? _rx[_rxPos++] : -1; }
+    int     read(uint8_t* buf, size_t len) override {
+        size_t n = 0;
+        while (n < len && _rxPos < _rx.size()) buf[n++] = _rx[_rxPos++];
+        return (int)n;
+    }
+    int     peek() override { return _rxPos < _rx.size() ? _rx[_rxPos] : -1; }
+    void    flush() override {}
+    void    stop() override { open = false; }
+    uint8_t connected() override { return open; }
+    operator bool() override { return open; }
+    using Print::write;
+
+    // Bytes towards the client
+    void push(std::initializer_list<uint8_t> bytes) { _rx.insert(_rx.end(), bytes); }
+    // QoS 0 PUBLISH (topic and payload under 128 bytes together)
+    void pushPublish(const std::string& topic, const std::string& payload) {
+        _rx.push_back(0x30);
+        _rx.push_back((uint8_t)(2 + topic.size() + payload.size()));
+        _rx.push_back(0);
+        _rx.push_back((uint8_t)topic.size());
+        _rx.insert(_rx.end(), topic.begin(), topic.end());
+        _rx.insert(_rx.end(), payload.begin(), payload.end());
+    }
+    // MQTT 5 QoS 0 PUBLISH with a response topic and correlation data (empty = left out)
+    void pushPublish5(const std::string& topic, const std::string& payload,
+                      const std::string& responseTopic, const std::string& correlation) {
+        std::vector<uint8_t> props;
+        auto prop = [&props](uint8_t id, const std::string& v) {
+            if (v.empty()) return;
+            props.push_back(id);
+            props.push_back((uint8_t)(v.size() >> 8));
+            props.push_back((uint8_t)v.size());
+            props.insert(props.end(), v.begin(), v.end());
+        };
+        prop(0x08, responseTopic);
+        prop(0x09, correlation);
+        auto varint = [](std::vector<uint8_t>& out, size_t n) {
+            do {
+                out.push_back((uint8_t)((n & 0x7F) | (n >= 128 ? 0x80 : 0)));
+                n >>= 7;
+            } while (n);
+        };
+        std::vector<uint8_t> body = {0, (uint8_t)topic.size()};
+        body.insert(body.end(), topic.begin(), topic.end());
+        varint(body, props.size());
+        body.insert(body.end(), props.begin(), props.end());
+        body.insert(body.end(), payload.begin(), payload.end());
+        _rx.push_back(0x30);
+        varint(_rx, body.size());
+        _rx.insert(_rx.end(), body.begin(), body.end());
+    }
+    size_t count(uint8_t type) const {
+        size_t n = 0;
+        for (uint8_t t : sent) n += (t & 0xF0) == type;
+        return n;
+    }
+
+private:
+    enum class Parse : uint8_t { TYPE, LENGTH, BODY };
+
+    Attempt  _attempt{false, -1};
+    std::vector<uint8_t> _rx;
+    size_t   _rxPos = 0;
+    Parse    _parse = Parse::TYPE;
+    uint32_t _remaining = 0;
+    uint32_t _mul = 1;
+
+    void _feed(uint8_t b) {
+        switch (_parse) {
+            case Parse::TYPE:
+                sent.push_back(b);
+                _remaining = 0;
+                _mul = 1;
+                _parse = Parse::LENGTH;
+                break;
+            case Parse::LENGTH:
+                _remaining += (b & 0x7F) * _mul;
+                _mul *= 128;
+                if (b & 0x80) break;
+                _parse = _remaining ? Parse::BODY : Parse::TYPE;
+                if (!_remaining) _onPacket();
+                break;
+            case Parse::BODY:
+                if (--_remaining) break;
+                _parse = Parse::TYPE;
+                _onPacket();
+                break;
+        }
+    }
+    void _onPacket() {
+        if ((sent.back() & 0xF0) == 0x10 && _attempt.connack >= 0) {
+            if (v5) push({0x20, 0x03, 0x00, (uint8_t)_attempt.connack, 0x00});
+            else push({0x20, 0x02, 0x00, (uint8_t)_attempt.connack});
+        }
+    }
+};
+
+struct Transitions {
+    std::vector<MeoMqttState> to;
+    bool sessionOk = true;
+    uint32_t sessionCalls = 0;
+};
+
+static void onState(MeoMqttState from, MeoMqttState to, uint32_t elapsedMs, void* ctx) {
+    (void)from; (void)elapsedMs;
+    ((Transitions*)ctx)->to.push_back(to);
+}
+
+static bool onSession(MeoMqttState step, void* ctx) {
+    Transitions* t = (Transitions*)ctx;
+    t->sessionCalls++;
+    (void)step;
+    return t->sessionOk;
+}
+
+static void setUpClient(MeoMqttClient& c, ScriptedBroker& broker, Transitions& t) {
+    c.configure("broker.test", 1883);
+    c.setCredentials("A1B2C3D4E5F6", "secret");
+    c.setTransport(&broker);
+    c.setBackoff(20, 40);
+    c.setAttemptBudget(1000);
+    c.setStateHandler(&onState, &t);
+    c.setSessionHandler(&onSession, &t);
+    c.setAutoConnect(true);
+}
+
+// Run loop() until `state` is reached or `ms` pass
+static bool runUntil(MeoMqttClient& c, MeoMqttState state, uint32_t ms) {
+    uint32_t t0 = millis();
+    while (millis() - t0 < ms) {
+        c.loop();
+        if (c.state() == state) return true;
+        delay(1);
+    }
+    return false;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_connects_one_step_per_loop(void) {
+    MeoMqttClient c;
+    ScriptedBroker broker;
+    Transitions t;
+    broker.script = {{true, 0}};
+    setUpClient(c, broker, t);
+
+    c.loop(); // IDLE -> TCP
+    TEST_ASSERT_EQUAL(MeoMqttState::TCP, c.state());
+    c.loop(); // socket open -> CONNECT
+    TEST_ASSERT_EQUAL(MeoMqttState::CONNECT, c.state());
+    TEST_ASSERT_EQUAL_UINT32(1, broker.connects);
+    c.loop(); // CONNECT/CONNACK, then subscribe
+    TEST_ASSERT_EQUAL(MeoMqttState::SUBSCRIBED, c.state());
+    c.loop(); // declare
+    TEST_ASSERT_EQUAL(MeoMqttState::DECLARED, c.state());
+
+    TEST_ASSERT_TRUE(c.isConnected());
+    TEST_ASSERT_EQUAL_UINT32(1, c.connectAttempts());
+    TEST_ASSERT_EQUAL_UINT32(2, t.sessionCalls);
+    TEST_ASSERT_EQUAL_UINT32(1, broker.count(0x10));
+    TEST_ASSERT_EQUAL_UINT32(4, t.to.size());
+}
+
+static void test_transport_failure_backs_off_then_retries(void) {
+    MeoMqttClient c;
+    ScriptedBroker broker;
+    Transitions t;
+    broker.script = {{false, -1}, {true, 0}};
+    setUpClient(c, broker, t);
+
+    c.loop();
+    c.loop();
+    TEST_ASSERT_EQUAL(MeoMqttState::BACKOFF, c.state());
+    TEST_ASSERT_EQUAL_UINT32(0, broker.count(0x10));
+    // Still inside the backoff delay: nothing happens
+    c.loop();
+    TEST_ASSERT_EQUAL(MeoMqttState::BACKOFF, c.state());
+    TEST_ASSERT_EQUAL_UINT32(1, broker.connects);
+
+    TEST_ASSERT_TRUE(runUntil(c, MeoMqttState::DECLARED, 500));
+    TEST_ASSERT_EQUAL_UINT32(2, c.connectAttempts());
+    TEST_ASSERT_EQUAL_UINT32(2, broker.connects);
+}
+
+static void test_refused_connack_backs_off(void) {
+    MeoMqttClient c;
+    ScriptedBroker broker;
+    Transitions t;
+    broker.script = {{true, 5}, {true, 0}}; // 5: not authorized
+    setUpClient(c, broker, t);
+
+    c.loop();
+    c.loop();
+    c.loop();
+    TEST_ASSERT_EQUAL(MeoMqttState::BACKOFF, c.state());
+    TEST_ASSERT_FALSE(broker.open);
+    TEST_ASSERT_FALSE(c.isConnected());
+    TEST_ASSERT_EQUAL_UINT32(0, t.sessionCalls);
+    TEST_ASSERT_TRUE(runUntil(c, MeoMqttState::DECLARED, 500));
+}
+
+static void test_session_handler_failure_drops_session(void) {
+    MeoMqttClient c;
+    ScriptedBroker broker;
+    Transitions t;
+    t.sessionOk = false;
+    broker.script = {{true, 0}};
+    setUpClient(c, broker, t);
+
+    TEST_ASSERT_TRUE(runUntil(c, MeoMqttState::BACKOFF, 200));
+    TEST_ASSERT_EQUAL_UINT32(1, t.sessionCalls);
+    TEST_ASSERT_FALSE(broker.open);
+}
+
+static void test_lost_socket_reconnects(void) {
+    MeoMqttClient c;
+    ScriptedBroker broker;
+    Transitions t;
+    broker.script = {{true, 0}, {true, 0}};
+    setUpClient(c, broker, t);
+    TEST_ASSERT_TRUE(runUntil(c, MeoMqttState::DECLARED, 200));
+
+    broker.stop(); // peer went away
+    c.loop();
+    TEST_ASSERT_EQUAL(MeoMqttState::BACKOFF, c.state());
+    TEST_ASSERT_TRUE(runUntil(c, MeoMqttState::DECLARED, 500));
+    TEST_ASSERT_EQUAL_UINT32(2, broker.count(0x10));
+}
+
+// A silent broker is given up on after the attempt budget, not the socket timeout
+static void test_silent_broker_bounded_by_budget(void) {
+    MeoMqttClient c;
+    ScriptedBroker broker;
+    Transitions t;
+    broker.script = {{true, -1}};
+    setUpClient(c, broker, t);
+    c.setSocketTimeout(5);
+
+    c.loop();
+    c.loop();
+    uint32_t t0 = millis();
+    c.loop(); // CONNECT, then waits for the CONNACK
+    uint32_t waited = millis() - t0;
+    TEST_ASSERT_EQUAL(MeoMqttState::BACKOFF, c.state());
+    TEST_ASSERT_GREATER_OR_EQUAL(900, waited);
+    TEST_ASSERT_LESS_THAN(2500, waited);
+}
+
+// Once connected, a packet that stalls midway is waited on for the configured
+// socket timeout (1 s here), not the CONNECT step's budget (3 s)
+static void test_session_keeps_socket_timeout(void) {
+    MeoMqttClient c;
+    ScriptedBroker broker;
+    Transitions t;
+    broker.script = {{true, 0}};
+    setUpClient(c, broker, t);
+    c.setSocketTimeout(1);
+    c.setAttemptBudget(3000);
+    TEST_ASSERT_TRUE(runUntil(c, MeoMqttState::DECLARED, 200));
+
+    broker.push({0x30}); // PUBLISH header, then nothing
+    uint32_t t0 = millis();
+    c.loop();
+    uint32_t waited = millis() - t0;
+    TEST_ASSERT_GREATER_OR_EQUAL(900, waited);
+    TEST_ASSERT_LESS_THAN(2000, waited);
+}
+
+// Messages seen by one client's handler
+struct Inbox {
+    std::string prefix;     // every topic for this client starts with it
+    uint32_t received = 0;
+    uint32_t misrouted = 0;
+    MeoMqttClient* nested = nullptr; // loop() this client from inside the handler
+};
+
+static void onMessage(const char* topic, const uint8_t* payload, unsigned int length, void* ctx) {
+    (void)payload; (void)length;
+    Inbox* in = (Inbox*)ctx;
+    in->received++;
+    if (std::string(topic).compare(0, in->prefix.size(), in->prefix) != 0) in->misrouted++;
+    if (in->nested) in->nested->loop();
+}
+
+// PubSubClient's callback has no context: each client must still get only
+// its own messages while others run loop() on other threads
+static void test_messages_routed_per_client_across_threads(void) {
+    static const int CLIENTS = 4;
+    static const uint32_t MESSAGES = 2000;
+    Inbox inbox[CLIENTS];
+    bool declared[CLIENTS] = {false};
+    std::vector<std::thread> threads;
+    for (int n = 0; n < CLIENTS; ++n) {
+        threads.emplace_back([&, n] {
+            MeoMqttClient c;
+            ScriptedBroker broker;
+            Transitions t;
+            broker.script = {{true, 0}};
+            setUpClient(c, broker, t);
+            inbox[n].prefix = "dev" + std::to_string(n) + "/";
+            c.setMessageHandler(&onMessage, &inbox[n]);
+            declared[n] = runUntil(c, MeoMqttState::DECLARED, 500);
+            for (uint32_t i = 0; i < MESSAGES && declared[n]; ++i) {
+                broker.pushPublish(inbox[n].prefix + "invoke", "{}");
+                c.loop();
+            }
+        });
+    }
+    for (std::thread& th : threads) th.join();
+    for (int n = 0; n < CLIENTS; ++n) {
+        TEST_ASSERT_TRUE(declared[n]);
+        TEST_ASSERT_EQUAL_UINT32(MESSAGES, inbox[n].received);
+        TEST_ASSERT_EQUAL_UINT32(0, inbox[n].misrouted);
+    }
+}
+
+// A handler that loops another client gets routing back for the rest of its own loop()
+static void test_nested_loop_restores_routing(void) {
+    MeoMqttClient a, b;
+    ScriptedBroker brokerA, brokerB;
+    Transitions ta, tb;
+    brokerA.script = {{true, 0}};
+    brokerB.script = {{true, 0}};
+    setUpClient(a, brokerA, ta);
+    setUpClient(b, brokerB, tb);
+    Inbox inA, inB;
+    inA.prefix = "a/";
+    inB.prefix = "b/";
+    inA.nested = &b;
+    a.setMessageHandler(&onMessage, &inA);
+    b.setMessageHandler(&onMessage, &inB);
+    TEST_ASSERT_TRUE(runUntil(a, MeoMqttState::DECLARED, 200));
+    TEST_ASSERT_TRUE(runUntil(b, MeoMqttState::DECLARED, 200));
+
+    for (int i = 0; i < 10; ++i) {
+        brokerA.pushPublish("a/x", "1");
+        brokerB.pushPublish("b/x", "2");
+        a.loop(); // a's handler runs b.loop() inside
+        brokerA.pushPublish("a/y", "3");
+        a.loop();
+    }
+    TEST_ASSERT_EQUAL_UINT32(20, inA.received);
+    TEST_ASSERT_EQUAL_UINT32(10, inB.received);
+    TEST_ASSERT_EQUAL_UINT32(0, inA.misrouted);
+    TEST_ASSERT_EQUAL_UINT32(0, inB.misrouted);
+}
+
+// An MQTT 5 request whose reply address does not fit the client's copy is
+// dropped and counted, not handed to the handler without it
+static void test_mqtt5_request_with_oversized_reply_dropped(void) {
+    MeoMqttClient c;
+    ScriptedBroker broker;
+    Transitions t;
+    broker.v5 = true;
+    broker.script = {{true, 0}};
+    setUpClient(c, broker, t);
+    c.setProtocol(MeoMqttProtocol::V5);
+    Inbox in;
+    in.prefix = "dev/";
+    c.setMessageHandler(&onMessage, &in);
+    TEST_ASSERT_TRUE(runUntil(c, MeoMqttState::DECLARED, 200));
+    TEST_ASSERT_TRUE(c.usesMqtt5());
+
+    broker.pushPublish5("dev/fits", "{}", std::string(MEO_MQTT5_REPLY_TOPIC - 1, 'r'),
+                        std::string(MEO_MQTT5_CORRELATION, 'c'));
+    c.loop();
+    TEST_ASSERT_EQUAL_UINT32(1, in.received);
+
+    broker.pushPublish5("dev/topic", "{}", std::string(MEO_MQTT5_REPLY_TOPIC, 'r'), "");
+    c.loop();
+    broker.pushPublish5("dev/corr", "{}", "reply/to", std::string(MEO_MQTT5_CORRELATION + 1, 'c'));
+    c.loop();
+    TEST_ASSERT_EQUAL_UINT32(1, in.received);
+    TEST_ASSERT_EQUAL_UINT32(2, c.requestsDropped());
+    TEST_ASSERT_NULL(c.responseTopic());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_connects_one_step_per_loop);
+    RUN_TEST(test_transport_failure_backs_off_then_retries);
+    RUN_TEST(test_refused_connack_backs_off);
+    RUN_TEST(test_session_handler_failure_drops_session);
+    RUN_TEST(test_lost_socket_reconnects);
+    RUN_TEST(test_silent_broker_bounded_by_budget);
+    RUN_TEST(test_session_keeps_socket_timeout);
+    RUN_TEST(test_messages_routed_per_client_across_threads);
+    RUN_TEST(test_nested_loop_restores_routing);
+    RUN_TEST(test_mqtt5_request_with_oversized_reply_dropped);
+    return UNITY_END();
+}
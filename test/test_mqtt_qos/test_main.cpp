@@ -0,0 +1,373 @@
+// MeoInflightWindow: packet ids, PUBACK completion, DUP retransmits, expiry
+// timing and the lazily allocated packet buffers. Sends go to a recording stub.
+
+#include <unity.h>
+#include <mqtt/Meo3_MqttQos.h>
+
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+struct Wire {
+    bool up = true;
+    std::vector<std::vector<uint8_t>> packets;
+};
+
+struct Done {
+    int calls = 0;
+    uint16_t id = 0;
+    bool acked = false;
+};
+
+static bool wireSend(const uint8_t* packet, size_t len, void* ctx) {
+    Wire* w = (Wire*)ctx;
+    if (!w->up) return false;
+    w->packets.emplace_back(packet, packet + len);
+    return true;
+}
+
+static void onDone(uint16_t id, bool acked, void* ctx) {
+    Done* d = (Done*)ctx;
+    d->calls++;
+    d->id = id;
+    d->acked = acked;
+}
+
+static uint16_t addText(MeoInflightWindow& w, Wire& wire, Done* done, const char* payload = "42") {
+    return w.add("meo/dev/event", (const uint8_t*)payload, strlen(payload), false,
+                 done ? &onDone : nullptr, done, &wireSend, &wire);
+}
+
+static uint16_t packetId(const std::vector<uint8_t>& p) {
+    size_t n = 1;
+    while (p[n] & 0x80) n++;
+    n++;
+    size_t topicLen = ((size_t)p[n] << 8) | p[n + 1];
+    n += 2 + topicLen;
+    return (uint16_t)((p[n] << 8) | p[n + 1]);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_publish_encoding_and_ack(void) {
+    MeoInflightWindow w;
+    Wire wire;
+    Done done;
+    uint16_t id = addText(w, wire, &done);
+    TEST_ASSERT_NOT_EQUAL(0, id);
+    TEST_ASSERT_EQUAL_UINT32(1, wire.packets.size());
+
+    const std::vector<uint8_t>& p = wire.packets[0];
+    TEST_ASSERT_EQUAL_HEX8(0x32, p[0]); // PUBLISH, QoS 1, no DUP
+    TEST_ASSERT_EQUAL_UINT32(p.size() - 2, p[1]);
+    TEST_ASSERT_EQUAL_UINT16(id, packetId(p));
+    TEST_ASSERT_EQUAL_MEMORY("42", &p[p.size() - 2], 2);
+    TEST_ASSERT_EQUAL_UINT8(1, w.inflight());
+
+    // The completion runs from poll(), not from ack()
+    TEST_ASSERT_TRUE(w.ack(id));
+    TEST_ASSERT_FALSE(w.ack(id));
+    TEST_ASSERT_EQUAL(0, done.calls);
+    w.poll(millis(), &wireSend, &wire);
+    TEST_ASSERT_EQUAL(1, done.calls);
+    TEST_ASSERT_EQUAL_UINT16(id, done.id);
+    TEST_ASSERT_TRUE(done.acked);
+    TEST_ASSERT_EQUAL_UINT8(0, w.inflight());
+    TEST_ASSERT_EQUAL_UINT32(1, w.stats().acked);
+}
+
+static void test_ids_skip_zero_and_inflight(void) {
+    MeoInflightWindow w;
+    Wire wire;
+    uint16_t held = addText(w, wire, nullptr);
+    uint16_t last = held;
+    // Wrap the id counter all the way round; the held id must never be reused
+    for (uint32_t i = 0; i < 70000; ++i) {
+        uint16_t id = addText(w, wire, nullptr);
+        TEST_ASSERT_NOT_EQUAL(0, id);
+        TEST_ASSERT_NOT_EQUAL(held, id);
+        TEST_ASSERT_NOT_EQUAL(last, id);
+        last = id;
+        TEST_ASSERT_TRUE(w.ack(id));
+        w.poll(millis(), &wireSend, &wire);
+        wire.packets.clear();
+    }
+    TEST_ASSERT_EQUAL_UINT8(1, w.inflight());
+}
+
+static void test_retransmit_sets_dup(void) {
+    MeoInflightWindow w;
+    Wire wire;
+    uint32_t t0 = millis();
+    uint16_t id = addText(w, wire, nullptr);
+
+    w.poll(t0 + MEO_MQTT_RETRY_MS - 1, &wireSend, &wire);
+    TEST_ASSERT_EQUAL_UINT32(1, wire.packets.size());
+    w.poll(t0 + MEO_MQTT_RETRY_MS + 10, &wireSend, &wire);
+    TEST_ASSERT_EQUAL_UINT32(2, wire.packets.size());
+    TEST_ASSERT_EQUAL_HEX8(0x3A, wire.packets[1][0]); // DUP set
+    TEST_ASSERT_EQUAL_UINT16(id, packetId(wire.packets[1]));
+    TEST_ASSERT_EQUAL_UINT32(1, w.stats().retransmits);
+}
+
+// The last resend must get a full retry period for its PUBACK before the publish fails
+static void test_last_retry_gets_its_period(void) {
+    MeoInflightWindow w;
+    Wire wire;
+    Done done;
+    uint32_t t = millis();
+    addText(w, wire, &done);
+    for (int i = 0; i < MEO_MQTT_MAX_RETRIES; ++i) {
+        t += MEO_MQTT_RETRY_MS;
+        w.poll(t, &wireSend, &wire);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1 + MEO_MQTT_MAX_RETRIES, wire.packets.size());
+
+    // Right after the final resend: still waiting
+    w.poll(t + 1, &wireSend, &wire);
+    w.poll(t + MEO_MQTT_RETRY_MS - 1, &wireSend, &wire);
+    TEST_ASSERT_EQUAL(0, done.calls);
+    TEST_ASSERT_EQUAL_UINT32(1 + MEO_MQTT_MAX_RETRIES, wire.packets.size());
+
+    w.poll(t + MEO_MQTT_RETRY_MS, &wireSend, &wire);
+    TEST_ASSERT_EQUAL(1, done.calls);
+    TEST_ASSERT_FALSE(done.acked);
+    TEST_ASSERT_EQUAL_UINT32(1, w.stats().failed);
+    TEST_ASSERT_EQUAL_UINT32(1 + MEO_MQTT_MAX_RETRIES, wire.packets.size());
+}
+
+// A late PUBACK for the final resend still counts
+static void test_ack_after_last_retry(void) {
+    MeoInflightWindow w;
+    Wire wire;
+    Done done;
+    uint32_t t = millis();
+    uint16_t id = addText(w, wire, &done);
+    for (int i = 0; i < MEO_MQTT_MAX_RETRIES; ++i) {
+        t += MEO_MQTT_RETRY_MS;
+        w.poll(t, &wireSend, &wire);
+    }
+    w.poll(t + MEO_MQTT_RETRY_MS / 2, &wireSend, &wire);
+    TEST_ASSERT_TRUE(w.ack(id));
+    w.poll(t + MEO_MQTT_RETRY_MS, &wireSend, &wire);
+    TEST_ASSERT_EQUAL(1, done.calls);
+    TEST_ASSERT_TRUE(done.acked);
+}
+
+// Never transmitted (link down the whole time): fails on the time cap
+static void test_link_down_expires_on_time(void) {
+    MeoInflightWindow w;
+    Wire wire;
+    Done done;
+    wire.up = false;
+    uint32_t t0 = millis();
+    TEST_ASSERT_NOT_EQUAL(0, addText(w, wire, &done));
+    w.poll(t0 + (uint32_t)MEO_MQTT_RETRY_MS * MEO_MQTT_MAX_RETRIES, &wireSend, &wire);
+    TEST_ASSERT_EQUAL(0, done.calls);
+    w.poll(t0 + (uint32_t)MEO_MQTT_RETRY_MS * (MEO_MQTT_MAX_RETRIES + 1), &wireSend, &wire);
+    TEST_ASSERT_EQUAL(1, done.calls);
+    TEST_ASSERT_FALSE(done.acked);
+    TEST_ASSERT_EQUAL_UINT32(0, wire.packets.size());
+}
+
+static void test_rewind_resends_on_next_poll(void) {
+    MeoInflightWindow w;
+    Wire wire;
+    addText(w, wire, nullptr);
+    w.rewind();
+    w.poll(millis(), &wireSend, &wire);
+    TEST_ASSERT_EQUAL_UINT32(2, wire.packets.size());
+    TEST_ASSERT_EQUAL_HEX8(0x3A, wire.packets[1][0]);
+}
+
+static void test_window_full_and_fail_all(void) {
+    MeoInflightWindow w;
+    Wire wire;
+    Done done;
+    for (int i = 0; i < MEO_MQTT_INFLIGHT; ++i) TEST_ASSERT_NOT_EQUAL(0, addText(w, wire, &done));
+    TEST_ASSERT_TRUE(w.full());
+    TEST_ASSERT_EQUAL(0, addText(w, wire, &done));
+    TEST_ASSERT_EQUAL_UINT32(1, w.stats().rejected);
+    TEST_ASSERT_EQUAL_UINT8(MEO_MQTT_INFLIGHT, w.stats().maxInflight);
+
+    w.failAll();
+    TEST_ASSERT_EQUAL(MEO_MQTT_INFLIGHT, done.calls);
+    TEST_ASSERT_EQUAL_UINT8(0, w.inflight());
+    TEST_ASSERT_EQUAL_UINT32(MEO_MQTT_INFLIGHT, w.stats().failed);
+}
+
+static void test_oversized_packet_rejected(void) {
+    MeoInflightWindow w;
+    Wire wire;
+    char big[MEO_MQTT_INFLIGHT_PACKET];
+    memset(big, 'x', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    TEST_ASSERT_EQUAL(0, addText(w, wire, nullptr, big));
+    TEST_ASSERT_EQUAL_UINT32(1, w.stats().rejected);
+    TEST_ASSERT_EQUAL_UINT32(0, wire.packets.size());
+}
+
+static void test_fields_payload(void) {
+    MeoInflightWindow w;
+    Wire wire;
+    MeoStaticEventFields<2> ev;
+    ev.add("t", 21);
+    ev.add("on", true);
+    TEST_ASSERT_NOT_EQUAL(0, w.add("meo/dev/event", ev, false, nullptr, nullptr, &wireSend, &wire));
+    const std::vector<uint8_t>& p = wire.packets[0];
+    const char* json = "{\"t\":21,\"on\":true}";
+    TEST_ASSERT_EQUAL_MEMORY(json, &p[p.size() - strlen(json)], strlen(json));
+}
+
+// MQTT 5 PUBACK with a failure reason (0x87 not authorized): finished, not acked
+static void test_refused_ack_completes_as_failed(void) {
+    MeoInflightWindow w;
+    Wire wire;
+    Done done;
+    uint16_t id = addText(w, wire, &done);
+    TEST_ASSERT_TRUE(w.ack(id, 0x87));
+    w.poll(millis(), &wireSend, &wire);
+    TEST_ASSERT_EQUAL(1, done.calls);
+    TEST_ASSERT_FALSE(done.acked);
+    TEST_ASSERT_EQUAL_UINT32(0, w.stats().acked);
+    TEST_ASSERT_EQUAL_UINT32(1, w.stats().refused);
+    TEST_ASSERT_EQUAL_UINT8(0, w.inflight());
+
+    // 0x10 (no matching subscribers) is a success code
+    id = addText(w, wire, &done);
+    TEST_ASSERT_TRUE(w.ack(id, 0x10));
+    w.poll(millis(), &wireSend, &wire);
+    TEST_ASSERT_TRUE(done.acked);
+    TEST_ASSERT_EQUAL_UINT32(1, w.stats().acked);
+}
+
+// Bytes from the broker, handed out one read() at a time
+class FeedClient : public Client {
+public:
+    std::vector<uint8_t> rx;
+    size_t at = 0;
+    int     connect(IPAddress, uint16_t) override { return 1; }
+    int     connect(const char*, uint16_t) override { return 1; }
+    size_t  write(uint8_t) override { return 1; }
+    size_t  write(const uint8_t*, size_t len) override { return len; }
+    int     available() override { return (int)(rx.size() - at); }
+    int     read() override { return at < rx.size() ? rx[at++] : -1; }
+    int     read(uint8_t* buf, size_t len) override {
+        size_t n = 0;
+        while (n < len && at < rx.size()) buf[n++] = rx[at++];
+        return (int)n;
+    }
+    int     peek() override { return at < rx.size() ? rx[at] : -1; }
+    void    flush() override {}
+    void    stop() override {}
+    uint8_t connected() override { return 1; }
+    operator bool() override { return true; }
+};
+
+struct Acks {
+    std::vector<uint16_t> ids;
+    std::vector<uint8_t>  reasons;
+};
+
+static void onTapAck(uint16_t id, uint8_t reason, void* ctx) {
+    Acks* a = (Acks*)ctx;
+    a->ids.push_back(id);
+    a->reasons.push_back(reason);
+}
+
+// The tap reports 3.1.1 PUBACKs as success, reads the MQTT 5 reason code, and
+// skips other packets
+static void test_tap_reports_puback_reason(void) {
+    FeedClient inner;
+    inner.rx = {0x40, 0x02, 0x00, 0x07,                   // 3.1.1 PUBACK 7
+                0x30, 0x04, 0x00, 0x01, 't', 'x',         // PUBLISH
+                0x40, 0x03, 0x01, 0x02, 0x87,             // v5 PUBACK 258, not authorized
+                0x40, 0x04, 0x00, 0x09, 0x97, 0x00};      // v5 PUBACK 9, quota exceeded, no props
+    MeoMqttTap tap;
+    tap.setInner(&inner);
+    Acks acks;
+    tap.setAckHandler(&onTapAck, &acks);
+    uint8_t buf[5];
+    tap.read();
+    while (tap.read(buf, sizeof(buf)) > 0) {}
+    TEST_ASSERT_EQUAL_UINT32(3, acks.ids.size());
+    TEST_ASSERT_EQUAL_UINT16(7, acks.ids[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, acks.reasons[0]);
+    TEST_ASSERT_EQUAL_UINT16(258, acks.ids[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x87, acks.reasons[1]);
+    TEST_ASSERT_EQUAL_UINT16(9, acks.ids[2]);
+    TEST_ASSERT_EQUAL_HEX8(0x97, acks.reasons[2]);
+    TEST_ASSERT_EQUAL_UINT32(inner.rx.size(), tap.bytesIn());
+}
+
+// Only a window that publishes owns packet buffers
+static size_t allocations = 0;
+static bool   outOfHeap = false;
+
+void* operator new[](size_t n) {
+    allocations++;
+    void* p = malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t n, const std::nothrow_t&) noexcept {
+    allocations++;
+    return outOfHeap ? nullptr : malloc(n ? n : 1);
+}
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+static void test_buffers_allocated_on_first_use(void) {
+    size_t before = allocations;
+    {
+        MeoInflightWindow idle;
+        idle.poll(millis(), &wireSend, nullptr);
+        idle.failAll();
+        TEST_ASSERT_EQUAL_UINT32(before, allocations);
+    }
+    MeoInflightWindow w;
+    Wire wire;
+    addText(w, wire, nullptr);
+    addText(w, wire, nullptr);
+    TEST_ASSERT_EQUAL_UINT32(before + 1, allocations);
+}
+
+// No heap for the packet buffers: the publish is refused, nothing is sent, and
+// a later add() tries the allocation again
+static void test_allocation_failure_rejects_publish(void) {
+    MeoInflightWindow w;
+    Wire wire;
+    Done done;
+    outOfHeap = true;
+    TEST_ASSERT_EQUAL(0, addText(w, wire, &done));
+    outOfHeap = false;
+    TEST_ASSERT_EQUAL_UINT32(1, w.stats().rejected);
+    TEST_ASSERT_EQUAL_UINT8(0, w.inflight());
+    TEST_ASSERT_EQUAL_UINT32(0, wire.packets.size());
+    w.poll(millis(), &wireSend, &wire);
+    TEST_ASSERT_EQUAL(0, done.calls);
+
+    TEST_ASSERT_NOT_EQUAL(0, addText(w, wire, &done));
+    TEST_ASSERT_EQUAL_UINT32(1, wire.packets.size());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_publish_encoding_and_ack);
+    RUN_TEST(test_ids_skip_zero_and_inflight);
+    RUN_TEST(test_retransmit_sets_dup);
+    RUN_TEST(test_last_retry_gets_its_period);
+    RUN_TEST(test_ack_after_last_retry);
+    RUN_TEST(test_link_down_expires_on_time);
+    RUN_TEST(test_rewind_resends_on_next_poll);
+    RUN_TEST(test_window_full_and_fail_all);
+    RUN_TEST(test_oversized_packet_rejected);
+    RUN_TEST(test_fields_payload);
+    RUN_TEST(test_refused_ack_completes_as_failed);
+    RUN_TEST(test_tap_reports_puback_reason);
+    RUN_TEST(test_buffers_allocated_on_first_use);
+    RUN_TEST(test_allocation_failure_rejects_publish);
+    return UNITY_END();
+}
@@ -0,0 +1,116 @@
+// MeoSpscRing: record framing, wrap-around, full/oversized handling, and a
+// producer/consumer pair on std::threads standing in for the app and network tasks.
+
+#include <unity.h>
+#include <os/Meo3_SpscRing.h>
+
+#include <stdio.h>
+#include <thread>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_two_part_record(void) {
+    MeoSpscRing<64> ring;
+    TEST_ASSERT_TRUE(ring.empty());
+    TEST_ASSERT_TRUE(ring.push("head", 4, "body", 5));
+    TEST_ASSERT_FALSE(ring.empty());
+
+    char out[16];
+    TEST_ASSERT_EQUAL_UINT32(9, ring.pop(out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY("headbody", out, 9);
+    TEST_ASSERT_TRUE(ring.empty());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.pop(out, sizeof(out)));
+}
+
+static void test_full_ring_refuses(void) {
+    MeoSpscRing<32> ring;
+    uint8_t rec[6] = {0};
+    int pushed = 0;
+    while (ring.push(rec, sizeof(rec))) pushed++;
+    TEST_ASSERT_EQUAL(4, pushed); // 4 x (2 + 6) bytes
+    TEST_ASSERT_EQUAL_UINT32(32, ring.used());
+
+    uint8_t out[8];
+    TEST_ASSERT_EQUAL_UINT32(6, ring.pop(out, sizeof(out)));
+    TEST_ASSERT_TRUE(ring.push(rec, sizeof(rec)));
+}
+
+static void test_wrap_keeps_records_whole(void) {
+    MeoSpscRing<32> ring;
+    char out[32];
+    // Offsets walk round the buffer; a record that does not fit before the end
+    // is written at the start behind a skip marker
+    for (int i = 0; i < 200; ++i) {
+        char rec[12];
+        int len = 1 + i % 11;
+        for (int j = 0; j < len; ++j) rec[j] = (char)(i + j);
+        TEST_ASSERT_TRUE(ring.push(rec, (size_t)len));
+        TEST_ASSERT_EQUAL_UINT32((size_t)len, ring.pop(out, sizeof(out)));
+        TEST_ASSERT_EQUAL_MEMORY(rec, out, (size_t)len);
+        TEST_ASSERT_TRUE(ring.empty());
+    }
+}
+
+static void test_oversized_record_is_dropped_by_pop(void) {
+    MeoSpscRing<64> ring;
+    TEST_ASSERT_TRUE(ring.push("0123456789", 10));
+    TEST_ASSERT_TRUE(ring.push("ok", 2));
+    char out[4];
+    TEST_ASSERT_EQUAL_UINT32(0, ring.pop(out, sizeof(out)));
+    TEST_ASSERT_EQUAL_UINT32(2, ring.pop(out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY("ok", out, 2);
+}
+
+static void test_push_larger_than_ring(void) {
+    MeoSpscRing<32> ring;
+    uint8_t big[40] = {0};
+    TEST_ASSERT_FALSE(ring.push(big, sizeof(big)));
+    TEST_ASSERT_TRUE(ring.empty());
+}
+
+// Every record arrives once, in order and intact, while both sides run flat out
+static void test_threads_in_order(void) {
+    static const uint32_t RECORDS = 200000;
+    static MeoSpscRing<1024> ring;
+    uint32_t bad = 0, received = 0;
+
+    std::thread consumer([&] {
+        char out[64];
+        uint32_t expect = 0;
+        while (expect < RECORDS) {
+            size_t n = ring.pop(out, sizeof(out));
+            if (!n) {
+                std::this_thread::yield();
+                continue;
+            }
+            uint32_t seq;
+            memcpy(&seq, out, sizeof(seq));
+            char body[32];
+            int len = snprintf(body, sizeof(body), "event-%u", (unsigned)seq);
+            if (seq != expect || n != sizeof(seq) + (size_t)len || memcmp(out + sizeof(seq), body, len) != 0) bad++;
+            expect = seq + 1;
+            received++;
+        }
+    });
+    for (uint32_t i = 0; i < RECORDS; ++i) {
+        char body[32];
+        int len = snprintf(body, sizeof(body), "event-%u", (unsigned)i);
+        while (!ring.push(&i, sizeof(i), body, (size_t)len)) std::this_thread::yield();
+    }
+    consumer.join();
+    TEST_ASSERT_EQUAL_UINT32(0, bad);
+    TEST_ASSERT_EQUAL_UINT32(RECORDS, received);
+    TEST_ASSERT_TRUE(ring.empty());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_two_part_record);
+    RUN_TEST(test_full_ring_refuses);
+    RUN_TEST(test_wrap_keeps_records_whole);
+    RUN_TEST(test_oversized_record_is_dropped_by_pop);
+    RUN_TEST(test_push_larger_than_ring);
+    RUN_TEST(test_threads_in_order);
+    return UNITY_END();
+}
@@ -0,0 +1,222 @@
+// MeoStorage over the native Preferences (files under a scratch directory):
+// batched commits, migration of per-key entries from older firmware (removed
+// only once the blob is written), and the per-key fallback when the 512 B
+// image is full.
+
+#include <unity.h>
+#include <storage/Meo3_Storage.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* NVS_DIR  = "test_storage.nvs";
+static const char* NVS_FILE = "test_storage.nvs/meo.bin";
+
+// A value big enough that two of them do not fit MEO_STORAGE_BYTES together
+static const size_t BIG = MEO_STORAGE_BYTES / 2 + 16;
+
+static void fill(uint8_t* out, size_t len, uint8_t seed) {
+    for (size_t i = 0; i < len; ++i) out[i] = (uint8_t)(seed + i * 7);
+}
+
+// What another boot would find in NVS right now
+static bool nvsHasKey(const char* key) {
+    Preferences p;
+    p.begin("meo", true);
+    bool has = p.isKey(key);
+    p.end();
+    return has;
+}
+
+void setUp(void) {
+    setenv("MEO_NATIVE_NVS", NVS_DIR, 1);
+    remove(NVS_FILE);
+}
+
+void tearDown(void) {
+    remove(NVS_FILE);
+}
+
+static void test_saves_batched_into_one_write(void) {
+    {
+        MeoStorage s;
+        TEST_ASSERT_TRUE(s.begin());
+        TEST_ASSERT_TRUE(s.saveCString("ssid", "home"));
+        TEST_ASSERT_TRUE(s.saveCString("pass", "secret"));
+        TEST_ASSERT_TRUE(s.saveShort("port", 1883));
+        TEST_ASSERT_TRUE(s.saveCString("ssid", "home")); // unchanged
+        TEST_ASSERT_TRUE(s.dirty());
+        TEST_ASSERT_EQUAL_UINT32(0, s.stats().nvsWrites);
+        TEST_ASSERT_EQUAL_UINT32(3, s.stats().writes);
+        // Nothing reached NVS yet: a reset now would lose all three
+        TEST_ASSERT_FALSE(nvsHasKey("meo_cfg"));
+        TEST_ASSERT_TRUE(s.commit());
+        TEST_ASSERT_EQUAL_UINT32(1, s.stats().nvsWrites);
+        TEST_ASSERT_FALSE(s.dirty());
+    }
+    MeoStorage s;
+    TEST_ASSERT_TRUE(s.begin());
+    char ssid[16];
+    int16_t port = 0;
+    TEST_ASSERT_TRUE(s.loadCString("ssid", ssid, sizeof(ssid)));
+    TEST_ASSERT_EQUAL_STRING("home", ssid);
+    TEST_ASSERT_TRUE(s.loadShort("port", port));
+    TEST_ASSERT_EQUAL_INT16(1883, port);
+    TEST_ASSERT_EQUAL_UINT32(2, s.stats().nvsReads); // the blob: isKey + read
+}
+
+// A per-key entry from older firmware is read once, and only removed after the
+// blob that carries it has been written
+static void test_legacy_key_removed_after_commit(void) {
+    {
+        Preferences p;
+        p.begin("meo", false);
+        p.putString("user_id", "u42");
+        p.end();
+    }
+    MeoStorage s;
+    TEST_ASSERT_TRUE(s.begin());
+    std::string user;
+    TEST_ASSERT_TRUE(s.loadString("user_id", user));
+    TEST_ASSERT_EQUAL_STRING("u42", user.c_str());
+    TEST_ASSERT_TRUE(s.dirty());
+    TEST_ASSERT_TRUE(nvsHasKey("user_id"));
+
+    uint32_t reads = s.stats().nvsReads;
+    TEST_ASSERT_TRUE(s.loadString("user_id", user));
+    TEST_ASSERT_EQUAL_UINT32(reads, s.stats().nvsReads); // from RAM now
+
+    TEST_ASSERT_TRUE(s.commit());
+    TEST_ASSERT_FALSE(nvsHasKey("user_id"));
+    TEST_ASSERT_TRUE(nvsHasKey("meo_cfg"));
+
+    MeoStorage again;
+    TEST_ASSERT_TRUE(again.begin());
+    TEST_ASSERT_TRUE(again.loadString("user_id", user));
+    TEST_ASSERT_EQUAL_STRING("u42", user.c_str());
+}
+
+// Misses are remembered, so a key that is not there costs one lookup
+static void test_repeated_miss_stays_in_ram(void) {
+    MeoStorage s;
+    TEST_ASSERT_TRUE(s.begin());
+    std::string v;
+    TEST_ASSERT_FALSE(s.loadString("nope", v));
+    uint32_t reads = s.stats().nvsReads;
+    TEST_ASSERT_FALSE(s.loadString("nope", v));
+    TEST_ASSERT_EQUAL_UINT32(reads, s.stats().nvsReads);
+    TEST_ASSERT_TRUE(s.saveCString("nope", "now"));
+    TEST_ASSERT_TRUE(s.loadString("nope", v));
+    TEST_ASSERT_EQUAL_STRING("now", v.c_str());
+}
+
+// A save that does not fit the image goes to its own NVS entry, written at once
+static void test_full_image_falls_back_to_per_key(void) {
+    uint8_t a[BIG], b[BIG], got[BIG];
+    fill(a, sizeof(a), 1);
+    fill(b, sizeof(b), 2);
+    {
+        MeoStorage s;
+        TEST_ASSERT_TRUE(s.begin());
+        TEST_ASSERT_TRUE(s.saveBytes("a", a, sizeof(a)));
+        TEST_ASSERT_TRUE(s.saveBytes("b", b, sizeof(b)));
+        TEST_ASSERT_TRUE(nvsHasKey("b"));
+        TEST_ASSERT_TRUE(s.loadBytes("b", got, sizeof(got)));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(b, got, sizeof(b));
+        TEST_ASSERT_TRUE(s.loadBytes("a", got, sizeof(got)));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(a, got, sizeof(a));
+    }
+    MeoStorage s;
+    TEST_ASSERT_TRUE(s.begin());
+    TEST_ASSERT_TRUE(s.loadBytes("a", got, sizeof(got)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(a, got, sizeof(a));
+    TEST_ASSERT_TRUE(s.loadBytes("b", got, sizeof(got)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(b, got, sizeof(b));
+    // Still kept per key: the image has no room for it
+    TEST_ASSERT_TRUE(nvsHasKey("b"));
+
+    // Room again: the next load folds it in, the commit reclaims the entry
+    TEST_ASSERT_TRUE(s.clearKey("a"));
+    TEST_ASSERT_TRUE(s.commit());
+    TEST_ASSERT_TRUE(s.loadBytes("b", got, sizeof(got)));
+    TEST_ASSERT_TRUE(s.commit());
+    TEST_ASSERT_FALSE(nvsHasKey("b"));
+    TEST_ASSERT_TRUE(s.loadBytes("b", got, sizeof(got)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(b, got, sizeof(b));
+}
+
+// An older firmware's key is still served when the image has no room for it
+static void test_legacy_key_with_full_image(void) {
+    uint8_t big[BIG], old[BIG], got[BIG];
+    fill(big, sizeof(big), 3);
+    fill(old, sizeof(old), 4);
+    {
+        Preferences p;
+        p.begin("meo", false);
+        p.putBytes("legacy", old, sizeof(old));
+        p.end();
+    }
+    MeoStorage s;
+    TEST_ASSERT_TRUE(s.begin());
+    TEST_ASSERT_TRUE(s.saveBytes("big", big, sizeof(big)));
+    for (int i = 0; i < 2; ++i) {
+        memset(got, 0, sizeof(got));
+        TEST_ASSERT_TRUE(s.loadBytes("legacy", got, sizeof(got)));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(old, got, sizeof(old));
+    }
+    TEST_ASSERT_TRUE(s.commit());
+    TEST_ASSERT_TRUE(nvsHasKey("legacy")); // not in the blob, so not removed
+}
+
+// A cached key that grows past the image moves to NVS; the stale cached copy
+// must not come back after a remount
+static void test_grown_value_not_shadowed(void) {
+    uint8_t big[BIG], grown[BIG], got[BIG];
+    fill(big, sizeof(big), 5);
+    fill(grown, sizeof(grown), 6);
+    {
+        MeoStorage s;
+        TEST_ASSERT_TRUE(s.begin());
+        TEST_ASSERT_TRUE(s.saveBytes("big", big, sizeof(big)));
+        TEST_ASSERT_TRUE(s.saveBytes("k", grown, 4));
+        TEST_ASSERT_TRUE(s.commit());
+        TEST_ASSERT_TRUE(s.saveBytes("k", grown, sizeof(grown)));
+    }
+    MeoStorage s;
+    TEST_ASSERT_TRUE(s.begin());
+    TEST_ASSERT_TRUE(s.loadBytes("k", got, sizeof(got)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(grown, got, sizeof(grown));
+}
+
+static void test_clear_key_and_all(void) {
+    {
+        Preferences p;
+        p.begin("meo", false);
+        p.putString("tx_key", "old");
+        p.end();
+    }
+    MeoStorage s;
+    TEST_ASSERT_TRUE(s.begin());
+    TEST_ASSERT_TRUE(s.saveCString("ssid", "home"));
+    TEST_ASSERT_TRUE(s.clearKey("tx_key")); // only in NVS
+    TEST_ASSERT_FALSE(nvsHasKey("tx_key"));
+    std::string v;
+    TEST_ASSERT_FALSE(s.loadString("tx_key", v));
+
+    TEST_ASSERT_TRUE(s.clearAll());
+    TEST_ASSERT_FALSE(s.loadString("ssid", v));
+    TEST_ASSERT_FALSE(nvsHasKey("meo_cfg"));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_saves_batched_into_one_write);
+    RUN_TEST(test_legacy_key_removed_after_commit);
+    RUN_TEST(test_repeated_miss_stays_in_ram);
+    RUN_TEST(test_full_image_falls_back_to_per_key);
+    RUN_TEST(test_legacy_key_with_full_image);
+    RUN_TEST(test_grown_value_not_shadowed);
+    RUN_TEST(test_clear_key_and_all);
+    return UNITY_END();
+}
@@ -0,0 +1,132 @@
+// MeoTlsSessionCache: the session kept per host:port, rewritten in storage only
+// when it changes, and reloaded after a reboot (a fresh cache over the same NVS).
+
+#include <unity.h>
+#include <mqtt/Meo3_TlsSession.h>
+#include <storage/Meo3_Storage.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* NVS_DIR  = "test_tls_session.nvs";
+static const char* NVS_FILE = "test_tls_session.nvs/meo.bin";
+
+// Roughly a saved TLS 1.2 session with its peer certificate: past the 512 B image
+static const size_t SESSION = 1400;
+
+static void fill(uint8_t* out, size_t len, uint8_t seed) {
+    for (size_t i = 0; i < len; ++i) out[i] = (uint8_t)(seed + i * 13);
+}
+
+void setUp(void) {
+    setenv("MEO_NATIVE_NVS", NVS_DIR, 1);
+    remove(NVS_FILE);
+}
+
+void tearDown(void) {
+    remove(NVS_FILE);
+}
+
+static void test_kept_per_peer(void) {
+    MeoTlsSessionCache c;
+    uint8_t s[64];
+    fill(s, sizeof(s), 1);
+    size_t len = 0;
+    TEST_ASSERT_NULL(c.find("broker", 8883, len));
+    TEST_ASSERT_TRUE(c.put("broker", 8883, s, sizeof(s)));
+
+    const uint8_t* got = c.find("broker", 8883, len);
+    TEST_ASSERT_NOT_NULL(got);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(s), len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(s, got, sizeof(s));
+    TEST_ASSERT_NULL(c.find("broker", 8884, len));
+    TEST_ASSERT_NULL(c.find("other", 8883, len));
+    TEST_ASSERT_EQUAL_UINT32(0, len);
+
+    c.clear();
+    TEST_ASSERT_NULL(c.find("broker", 8883, len));
+    TEST_ASSERT_TRUE(c.empty());
+}
+
+static void test_oversized_session_not_kept(void) {
+    static uint8_t big[MEO_TLS_SESSION_BYTES + 1];
+    MeoTlsSessionCache c;
+    size_t len;
+    TEST_ASSERT_FALSE(c.put("broker", 8883, big, sizeof(big)));
+    TEST_ASSERT_FALSE(c.put("broker", 8883, big, 0));
+    TEST_ASSERT_NULL(c.find("broker", 8883, len));
+}
+
+// A reboot (new cache, new MeoStorage) finds the session again; a resumed
+// handshake that hands back the same bytes writes nothing
+static void test_persisted_and_rewritten_only_on_change(void) {
+    uint8_t s[SESSION], renewed[SESSION];
+    fill(s, sizeof(s), 2);
+    fill(renewed, sizeof(renewed), 3);
+    {
+        MeoStorage st;
+        TEST_ASSERT_TRUE(st.begin());
+        MeoTlsSessionCache c;
+        c.setStore(&st, "tls_gw");
+        TEST_ASSERT_TRUE(c.put("broker", 8883, s, sizeof(s)));
+        TEST_ASSERT_TRUE(c.put("broker", 8883, s, sizeof(s)));
+        TEST_ASSERT_EQUAL_UINT32(1, c.storeWrites());
+        TEST_ASSERT_TRUE(st.commit());
+    }
+    MeoStorage st;
+    TEST_ASSERT_TRUE(st.begin());
+    MeoTlsSessionCache c;
+    c.setStore(&st, "tls_gw");
+    size_t len = 0;
+    const uint8_t* got = c.find("broker", 8883, len);
+    TEST_ASSERT_NOT_NULL(got);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(s), len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(s, got, sizeof(s));
+    TEST_ASSERT_NULL(c.find("elsewhere", 8883, len));
+
+    TEST_ASSERT_TRUE(c.put("broker", 8883, s, sizeof(s)));
+    TEST_ASSERT_EQUAL_UINT32(0, c.storeWrites());
+    TEST_ASSERT_TRUE(c.put("broker", 8883, renewed, 200)); // new ticket, shorter
+    TEST_ASSERT_EQUAL_UINT32(1, c.storeWrites());
+    TEST_ASSERT_TRUE(st.commit());
+
+    MeoStorage again;
+    TEST_ASSERT_TRUE(again.begin());
+    MeoTlsSessionCache after;
+    after.setStore(&again, "tls_gw");
+    got = after.find("broker", 8883, len);
+    TEST_ASSERT_NOT_NULL(got);
+    TEST_ASSERT_EQUAL_UINT32(200, len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(renewed, got, 200);
+}
+
+// A rejected session is forgotten in NVS too
+static void test_clear_removes_stored_session(void) {
+    uint8_t s[SESSION];
+    fill(s, sizeof(s), 4);
+    {
+        MeoStorage st;
+        TEST_ASSERT_TRUE(st.begin());
+        MeoTlsSessionCache c;
+        c.setStore(&st, "tls_cloud");
+        TEST_ASSERT_TRUE(c.put("cloud", 8883, s, sizeof(s)));
+        c.clear();
+        TEST_ASSERT_TRUE(st.commit());
+    }
+    MeoStorage st;
+    TEST_ASSERT_TRUE(st.begin());
+    MeoTlsSessionCache c;
+    c.setStore(&st, "tls_cloud");
+    size_t len;
+    TEST_ASSERT_NULL(c.find("cloud", 8883, len));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_kept_per_peer);
+    RUN_TEST(test_oversized_session_not_kept);
+    RUN_TEST(test_persisted_and_rewritten_only_on_change);
+    RUN_TEST(test_clear_removes_stored_session);
+    return UNITY_END();
+}
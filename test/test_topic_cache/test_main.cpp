@@ -0,0 +1,108 @@
+// MeoTopicCache: topic layout, length limits, and no heap use once built
+// (a counting global operator new catches any allocation on the hot paths).
+
+#include <unity.h>
+#include <Meo3_Topic.h>
+
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+static size_t allocations = 0;
+
+void* operator new(size_t n) {
+    allocations++;
+    void* p = malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_topics_with_user(void) {
+    MeoTopicCache t;
+    TEST_ASSERT_TRUE(t.begin("u42", "A1B2C3D4E5F6"));
+    TEST_ASSERT_TRUE(t.isReady());
+    TEST_ASSERT_EQUAL_STRING("meo/u42/A1B2C3D4E5F6", t.base());
+    TEST_ASSERT_EQUAL_STRING("meo/u42/A1B2C3D4E5F6/status", t.status());
+    TEST_ASSERT_EQUAL_STRING("meo/u42/A1B2C3D4E5F6/declare", t.declare());
+    TEST_ASSERT_EQUAL_STRING("meo/u42/A1B2C3D4E5F6/feature", t.feature());
+    TEST_ASSERT_EQUAL_STRING("meo/u42/A1B2C3D4E5F6/feature/+/invoke", t.featureInvoke());
+    TEST_ASSERT_EQUAL_STRING("meo/u42/A1B2C3D4E5F6/event/feature_response", t.featureResponse());
+    TEST_ASSERT_EQUAL_STRING("meo/u42/A1B2C3D4E5F6/log", t.log());
+    TEST_ASSERT_EQUAL_STRING("meo/u42/A1B2C3D4E5F6/metrics", t.metrics());
+}
+
+static void test_user_segment_omitted(void) {
+    MeoTopicCache t;
+    TEST_ASSERT_TRUE(t.begin("", "A1B2C3D4E5F6"));
+    TEST_ASSERT_EQUAL_STRING("meo/A1B2C3D4E5F6/status", t.status());
+    TEST_ASSERT_TRUE(t.begin(nullptr, "DEV"));
+    TEST_ASSERT_EQUAL_STRING("meo/DEV/declare", t.declare());
+}
+
+static void test_missing_device_id(void) {
+    MeoTopicCache t;
+    TEST_ASSERT_FALSE(t.begin("u", nullptr));
+    TEST_ASSERT_FALSE(t.begin("u", ""));
+    TEST_ASSERT_FALSE(t.isReady());
+    char out[MEO_TOPIC_MAX_LEN];
+    TEST_ASSERT_FALSE(t.buildEventTopic("temp", out, sizeof(out)));
+}
+
+static void test_event_topic_and_truncation(void) {
+    MeoTopicCache t;
+    TEST_ASSERT_TRUE(t.begin("u", "DEV"));
+    char out[MEO_TOPIC_MAX_LEN];
+    TEST_ASSERT_TRUE(t.buildEventTopic("humid_temp_update", out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("meo/u/DEV/event/humid_temp_update", out);
+
+    // "meo/u/DEV/event/ab" is 18 characters: needs 19 bytes
+    char tight[19];
+    TEST_ASSERT_TRUE(t.buildEventTopic("ab", tight, sizeof(tight)));
+    TEST_ASSERT_EQUAL_STRING("meo/u/DEV/event/ab", tight);
+    TEST_ASSERT_FALSE(t.buildEventTopic("abc", tight, sizeof(tight)));
+}
+
+static void test_identity_too_long(void) {
+    char user[MEO_TOPIC_MAX_LEN];
+    memset(user, 'u', sizeof(user) - 1);
+    user[sizeof(user) - 1] = '\0';
+    MeoTopicCache t;
+    TEST_ASSERT_FALSE(t.begin(user, "DEV"));
+    TEST_ASSERT_FALSE(t.isReady());
+
+    // Base fits but the longest suffix does not
+    size_t room = MEO_TOPIC_MAX_LEN - 1 - strlen("meo//DEV") - strlen("/event/feature_response") + 1;
+    user[room] = '\0';
+    TEST_ASSERT_FALSE(t.begin(user, "DEV"));
+    user[room - 1] = '\0';
+    TEST_ASSERT_TRUE(t.begin(user, "DEV"));
+    TEST_ASSERT_EQUAL_UINT32(MEO_TOPIC_MAX_LEN - 1, strlen(t.featureResponse()));
+}
+
+static void test_no_heap_after_begin(void) {
+    MeoTopicCache t;
+    size_t before = allocations;
+    TEST_ASSERT_TRUE(t.begin("u42", "A1B2C3D4E5F6"));
+    char out[MEO_TOPIC_MAX_LEN];
+    for (int i = 0; i < 1000; ++i) {
+        TEST_ASSERT_TRUE(t.buildEventTopic("humid_temp_update", out, sizeof(out)));
+        TEST_ASSERT_NOT_NULL(t.featureResponse());
+    }
+    TEST_ASSERT_EQUAL_UINT32(before, allocations);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_topics_with_user);
+    RUN_TEST(test_user_segment_omitted);
+    RUN_TEST(test_missing_device_id);
+    RUN_TEST(test_event_topic_and_truncation);
+    RUN_TEST(test_identity_too_long);
+    RUN_TEST(test_no_heap_after_begin);
+    return UNITY_END();
+}
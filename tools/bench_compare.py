@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""Compare two meo3-bench result files (src/bench) and flag regressions.
+
+Inputs may be raw JSON or a captured serial log; the first line starting with
+{"suite":"meo3-bench" is used.
+
+    tools/bench_compare.py baseline.json current.json [--ns-tolerance 10]
+    tools/bench_compare.py current.json     # against bench/baseline_<platform>.json
+
+Exits 1 when a case got slower than the tolerance, started allocating more,
+sent more MQTT bytes, or stopped succeeding.
+"""
+
+import argparse
+import json
+import os
+import sys
+
+BASELINES = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "bench")
+
+
+def load(path):
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith('{"suite":"meo3-bench"'):
+                return json.loads(line)
+    sys.exit(f"{path}: no meo3-bench result line found")
+
+
+def key(row):
+    return (row["name"], row["keys"], row["methods"])
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("files", nargs="+", metavar="[baseline] current")
+    ap.add_argument("--ns-tolerance", type=float, default=10.0,
+                    help="allowed ns/op increase in percent (default 10)")
+    args = ap.parse_args()
+
+    if len(args.files) > 2:
+        ap.error("expected at most two files")
+    cur = load(args.files[-1])
+    if len(args.files) == 2:
+        base = load(args.files[0])
+    else:
+        path = os.path.join(BASELINES, f"baseline_{cur.get('platform')}.json")
+        if not os.path.exists(path):
+            sys.exit(f"no committed baseline for platform {cur.get('platform')!r} ({os.path.normpath(path)}); "
+                     "record one from a clean tree and commit it")
+        base = load(path)
+    if base.get("platform") != cur.get("platform"):
+        print(f"warning: comparing {base.get('platform')} against {cur.get('platform')}")
+
+    before = {key(r): r for r in base["results"]}
+    regressions = 0
+    print(f"{'case':<34} {'ns/op':>12} {'delta':>8} {'allocs/op':>10} {'stack':>7}")
+    for row in cur["results"]:
+        k = key(row)
+        label = f"{row['name']} k={row['keys']} m={row['methods']}"
+        old = before.pop(k, None)
+        if old is None:
+            print(f"{label:<34} {row['ns_per_op']:>12.1f} {'new':>8}")
+            continue
+
+        flags = []
+        delta = (row["ns_per_op"] / old["ns_per_op"] - 1.0) * 100.0 if old["ns_per_op"] else 0.0
+        if delta > args.ns_tolerance:
+            flags.append("slower")
+        if (row.get("allocs_per_op") or 0) > (old.get("allocs_per_op") or 0):
+            flags.append("allocs")
+        if (row.get("wire_bytes_per_op") or 0) > (old.get("wire_bytes_per_op") or 0):
+            flags.append("wire")
+        if old.get("ok") and not row.get("ok"):
+            flags.append("failing")
+        regressions += bool(flags)
+
+        allocs = row.get("allocs_per_op")
+        print(f"{label:<34} {row['ns_per_op']:>12.1f} {delta:>+7.1f}% "
+              f"{'-' if allocs is None else format(allocs, '.2f'):>10} {row['stack_peak']:>7}"
+              f"{'  <- ' + ','.join(flags) if flags else ''}")
+
+    for k in before:
+        print(f"{k[0]} k={k[1]} m={k[2]}: missing from current run")
+
+    print(f"\n{regressions} regression(s)")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+"""Decode binary log batches published on meo/.../log (MeoDevice::setBinaryLogging).
+
+Each input is one batch: a raw binary file, or a text file of hex payloads one
+per line (e.g. `mosquitto_sub -t 'meo/+/+/log' -F '%x'`, '-' for stdin).
+
+    tools/meo_log_decode.py batch.bin
+    mosquitto_sub -t 'meo/+/+/log' -F '%x' | tools/meo_log_decode.py --hex -
+
+Prints one line per record: seconds since boot, level, "[TAG] message".
+The format string is applied with Python % formatting after dropping C length
+modifiers, so output matches the device's own formatting for the usual specs.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+LEVELS = {0: "DEBUG", 1: "INFO", 2: "WARN", 3: "ERROR"}
+I32, U32, I64, U64, F64, STR, PTR, STR_ID = range(1, 9)
+SPEC = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d*))?[hlLqjzt]*([diouxXcsfFeEgGaAp%])")
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def byte(self):
+        if self.pos >= len(self.data):
+            raise ValueError("truncated batch")
+        b = self.data[self.pos]
+        self.pos += 1
+        return b
+
+    def varint(self):
+        value = shift = 0
+        while True:
+            b = self.byte()
+            value |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return value
+
+    def bytes(self, n):
+        if self.pos + n > len(self.data):
+            raise ValueError("truncated batch")
+        out = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return out
+
+    def done(self):
+        return self.pos >= len(self.data)
+
+
+def zigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+
+def c_format(fmt, args):
+    """printf-style formatting of recorded arguments; '?' where they do not match."""
+    it = iter(args)
+
+    def repl(m):
+        flags, width, prec, conv = m.groups()
+        if conv == "%":
+            return "%"
+        arg = next(it, None)
+        if arg is None:
+            return "?"
+        t, value = arg
+        spec = "%" + flags + width + ("." + prec if prec is not None else "")
+        try:
+            if conv in "diuxXocp" and t in (F64, STR):
+                return "?"
+            if conv in "di":
+                return (spec + "d") % value
+            if conv == "u":
+                return (spec + "d") % (value & (0xFFFFFFFF if t in (I32, U32) else 0xFFFFFFFFFFFFFFFF))
+            if conv in "xXo":
+                return (spec + conv) % (value & (0xFFFFFFFF if t in (I32, U32) else 0xFFFFFFFFFFFFFFFF))
+            if conv == "c":
+                return (spec + "c") % chr(value & 0xFF)
+            if conv in "fFeEgG" and t == F64:
+                return (spec + conv) % value
+            if conv in "aA" and t == F64:
+                return value.hex()
+            if conv == "s" and t == STR:
+                return (spec + "s") % value
+            if conv == "p":
+                return "0x%x" % value
+        except (TypeError, ValueError):
+            pass
+        return "?"
+
+    return SPEC.sub(repl, fmt)
+
+
+def decode(data):
+    """Yield (us, level, truncated, tag, message) per record; first item is the drop count."""
+    r = Reader(data)
+    if r.bytes(2) != b"ML":
+        raise ValueError("not a log batch")
+    version = r.byte()
+    if version != 1:
+        raise ValueError(f"unsupported batch version {version}")
+    yield r.varint()
+
+    strings = []
+    us = None
+    while not r.done():
+        kind = r.byte()
+        if kind == 0x01:
+            strings.append(r.bytes(r.varint()).decode("utf-8", "replace"))
+            continue
+        if kind != 0x02:
+            raise ValueError(f"unknown entry 0x{kind:02x} at {r.pos - 1}")
+        dt = r.varint()
+        us = dt if us is None else (us + dt) & 0xFFFFFFFF
+        level = r.byte()
+        tag = strings[r.varint()]
+        fmt = strings[r.varint()]
+        args = []
+        for _ in range(r.byte()):
+            t = r.byte()
+            if t in (I32, I64):
+                args.append((t, zigzag(r.varint())))
+            elif t in (U32, U64, PTR):
+                args.append((t, r.varint()))
+            elif t == F64:
+                args.append((t, struct.unpack("<d", r.bytes(8))[0]))
+            elif t == STR:
+                args.append((t, r.bytes(r.varint()).decode("utf-8", "replace")))
+            elif t == STR_ID:
+                args.append((STR, strings[r.varint()]))
+            else:
+                raise ValueError(f"unknown argument type {t}")
+        yield us, LEVELS.get(level & 0x7F, "?"), bool(level & 0x80), tag, c_format(fmt, args)
+
+
+def batches(path, hex_lines):
+    f = sys.stdin.buffer if path == "-" else open(path, "rb")
+    with f:
+        if not hex_lines:
+            yield f.read()
+            return
+        for line in f:
+            line = line.strip()
+            if line:
+                yield bytes.fromhex(line.decode("ascii"))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("inputs", nargs="+", help="batch files, '-' for stdin")
+    ap.add_argument("--hex", action="store_true", help="inputs hold one hex payload per line")
+    args = ap.parse_args()
+
+    bad = 0
+    for path in args.inputs:
+        for data in batches(path, args.hex):
+            try:
+                records = decode(data)
+                dropped = next(records)
+                if dropped:
+                    print(f"-- {dropped} records dropped on the device (ring full)")
+                for us, level, truncated, tag, msg in records:
+                    print(f"{us / 1e6:12.6f} {level:<5} [{tag}] {msg}{' (truncated)' if truncated else ''}")
+            except ValueError as e:
+                print(f"-- {path}: {e}", file=sys.stderr)
+                bad += 1
+    return 1 if bad else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())